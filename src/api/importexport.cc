@@ -19,6 +19,7 @@
 #include "../language.h"
 #include "../laidout.h"
 #include "../headwindow.h"
+#include "../profiler.h"
 
 #include <lax/fileutils.h>
 
@@ -159,7 +160,10 @@ int ImportFunction(ValueHash *context,
 		if (err==0 && value->type()==VALUE_Object) config=dynamic_cast<ImportConfig*>(((ObjectValue*)value)->object);
 
 		 //run the filter
-		if (config) err=filter->In(filename,config,log);
+		if (config) {
+			ProfileScope profile("import",filter->VersionName());
+			err=filter->In(filename,config,log);
+		}
 		if (value) value->dec_count();
 
 	} catch (const char *str) {
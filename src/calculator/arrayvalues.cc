@@ -0,0 +1,699 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include "arrayvalues.h"
+#include "../language.h"
+
+#include <lax/affine.h>
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+using namespace Laxkit;
+
+
+namespace Laidout {
+
+
+//----------------------------- element-wise helpers ----------------------------------
+//
+// These are kept as plain loops over contiguous doubles, with the op decided outside
+// the loop, so that the compiler can vectorize them.
+
+//! r[i] = a[i] op b[i], for op one of + - * /.
+static void array_op(char op, double *r, const double *a, const double *b, int n)
+{
+	switch (op) {
+		case '+': for (int c=0; c<n; c++) r[c]=a[c]+b[c]; break;
+		case '-': for (int c=0; c<n; c++) r[c]=a[c]-b[c]; break;
+		case '*': for (int c=0; c<n; c++) r[c]=a[c]*b[c]; break;
+		case '/': for (int c=0; c<n; c++) r[c]=a[c]/b[c]; break;
+	}
+}
+
+//! r[i] = a[i] op s, or if scalar_first, r[i] = s op a[i].
+static void array_scalar_op(char op, double *r, const double *a, double s, int n, int scalar_first)
+{
+	if (scalar_first) {
+		switch (op) {
+			case '+': for (int c=0; c<n; c++) r[c]=s+a[c]; break;
+			case '-': for (int c=0; c<n; c++) r[c]=s-a[c]; break;
+			case '*': for (int c=0; c<n; c++) r[c]=s*a[c]; break;
+			case '/': for (int c=0; c<n; c++) r[c]=s/a[c]; break;
+		}
+	} else {
+		switch (op) {
+			case '+': for (int c=0; c<n; c++) r[c]=a[c]+s; break;
+			case '-': for (int c=0; c<n; c++) r[c]=a[c]-s; break;
+			case '*': for (int c=0; c<n; c++) r[c]=a[c]*s; break;
+			case '/': for (int c=0; c<n; c++) r[c]=a[c]/s; break;
+		}
+	}
+}
+
+//! Dot products of n pairs of interleaved xy points.
+static void array_dots(double *r, const double *a, const double *b, int n)
+{
+	for (int c=0; c<n; c++) r[c]=a[2*c]*b[2*c] + a[2*c+1]*b[2*c+1];
+}
+
+//! Get an affine matrix from an Affine based value, or a set of 6 numbers.
+/*! Return 1 for m filled, else 0.
+ */
+static int value_to_matrix(Value *v, double *m)
+{
+	Affine *affine=dynamic_cast<Affine*>(v);
+	if (affine) {
+		memcpy(m,affine->m(),6*sizeof(double));
+		return 1;
+	}
+
+	SetValue *set=dynamic_cast<SetValue*>(v);
+	if (!set || set->values.n!=6) return 0;
+	int isnum=0;
+	for (int c=0; c<6; c++) {
+		m[c]=getNumberValue(set->values.e[c],&isnum);
+		if (!isnum) return 0;
+	}
+	return 1;
+}
+
+
+//----------------------------- DoubleArrayValue ----------------------------------
+/*! \class DoubleArrayValue
+ * \brief Packed list of real numbers.
+ *
+ * Unlike an ArrayValue of DoubleValue objects, the numbers are stored directly in
+ * one block, and arithmetic with other arrays or numbers happens element-wise
+ * without creating any per element objects. See ArrayValueOp().
+ *
+ * In scripts, create with doubles(n, start, step) or doubles(values={...}).
+ */
+
+DoubleArrayValue::DoubleArrayValue(int nn, const double *nd)
+{
+	d=NULL;
+	n=max=0;
+	if (nn>0) {
+		Resize(nn);
+		if (nd) memcpy(d,nd,nn*sizeof(double));
+	}
+}
+
+DoubleArrayValue::~DoubleArrayValue()
+{
+	delete[] d;
+}
+
+//! Make sure there is room for at least nmax elements.
+void DoubleArrayValue::Allocate(int nmax)
+{
+	if (nmax<=max) return;
+	double *nd=new double[nmax];
+	if (d) memcpy(nd,d,n*sizeof(double));
+	delete[] d;
+	d=nd;
+	max=nmax;
+}
+
+//! Set the number of elements. New elements are 0.
+void DoubleArrayValue::Resize(int nn)
+{
+	if (nn<0) nn=0;
+	Allocate(nn);
+	if (nn>n) memset(d+n,0,(nn-n)*sizeof(double));
+	n=nn;
+}
+
+//! Append v, and return the new number of elements.
+int DoubleArrayValue::Push(double v)
+{
+	if (n==max) Allocate(max ? 2*max : 16);
+	d[n++]=v;
+	return n;
+}
+
+int DoubleArrayValue::getValueStr(char *buffer,int len)
+{
+	int needed=3+n*25;
+	if (!buffer || len<needed) return needed;
+
+	int pos=sprintf(buffer,"{");
+	for (int c=0; c<n; c++) pos+=sprintf(buffer+pos,"%s%g",c ? "," : "",d[c]);
+	sprintf(buffer+pos,"}");
+	modified=0;
+	return 0;
+}
+
+Value *DoubleArrayValue::duplicate()
+{ return new DoubleArrayValue(n,d); }
+
+//! Return a new DoubleValue of element index.
+Value *DoubleArrayValue::dereference(int index)
+{
+	if (index<0 || index>=n) return NULL;
+	return new DoubleValue(d[index]);
+}
+
+
+ObjectDef default_DoubleArrayValue_ObjectDef(NULL,"DoubleArray",_("Double Array"),_("Packed list of real numbers"),
+							 "class", NULL, "{}",
+							 NULL, 0,
+							 NULL, NULL);
+
+ObjectDef *Get_DoubleArrayValue_ObjectDef()
+{
+	ObjectDef *def=&default_DoubleArrayValue_ObjectDef;
+	if (def->fields) return def;
+
+	def->pushFunction("n",_("Number of elements"),_("Number of elements"), NULL,
+					  NULL);
+
+	def->pushFunction("push",_("Push"),_("Append a number"), NULL,
+					  "value",_("Value"),_("Value"), "number",NULL,NULL,
+					  NULL);
+
+	def->pushFunction("sum",_("Sum"),_("Sum of all elements"), NULL,
+					  NULL);
+
+	def->pushFunction("min",_("Min"),_("Smallest element"), NULL,
+					  NULL);
+
+	def->pushFunction("max",_("Max"),_("Largest element"), NULL,
+					  NULL);
+
+	def->pushFunction("dot",_("Dot"),_("Sum of products of elements with another array of the same size"), NULL,
+					  "other",_("Other"),_("Another DoubleArray"), "DoubleArray",NULL,NULL,
+					  NULL);
+
+	return def;
+}
+
+ObjectDef *DoubleArrayValue::makeObjectDef()
+{
+	Get_DoubleArrayValue_ObjectDef()->inc_count();
+	return Get_DoubleArrayValue_ObjectDef();
+}
+
+/*! Return
+ *  0 for success, value returned.
+ * -1 for no value returned due to incompatible parameters, which aids in function overloading.
+ *  1 for parameters ok, but there was somehow an error, so no value returned.
+ */
+int DoubleArrayValue::Evaluate(const char *func,int len, ValueHash *context, ValueHash *parameters, CalcSettings *settings,
+						 Value **value_ret,
+						 ErrorLog *log)
+{
+	if (len==1 && *func=='n') { *value_ret=new IntValue(n); return 0; }
+
+	if (isName(func,len, "sum")) {
+		double sum=0;
+		for (int c=0; c<n; c++) sum+=d[c];
+		*value_ret=new DoubleValue(sum);
+		return 0;
+
+	} else if (isName(func,len, "min") || isName(func,len, "max")) {
+		if (!n) {
+			if (log) log->AddMessage(_("Array is empty!"),ERROR_Fail);
+			return 1;
+		}
+		double v=d[0];
+		if (*func=='m' && func[1]=='i') { for (int c=1; c<n; c++) if (d[c]<v) v=d[c]; }
+		else { for (int c=1; c<n; c++) if (d[c]>v) v=d[c]; }
+		*value_ret=new DoubleValue(v);
+		return 0;
+
+	} else if (isName(func,len, "push")) {
+		int isnum=0;
+		double v=getNumberValue(parameters ? parameters->find("value") : NULL, &isnum);
+		if (!isnum) return -1;
+		Push(v);
+		*value_ret=NULL;
+		return 0;
+
+	} else if (isName(func,len, "dot")) {
+		DoubleArrayValue *other=dynamic_cast<DoubleArrayValue*>(parameters ? parameters->find("other") : NULL);
+		if (!other) return -1;
+		if (other->n!=n) {
+			if (log) log->AddMessage(_("Arrays must be the same size!"),ERROR_Fail);
+			return 1;
+		}
+		double sum=0;
+		for (int c=0; c<n; c++) sum+=d[c]*other->d[c];
+		*value_ret=new DoubleValue(sum);
+		return 0;
+	}
+
+	return -1;
+}
+
+/*! Contructor for DoubleArrayValue objects.
+ *
+ * Either values is a set of numbers (or another DoubleArray) to copy, or
+ * there are n elements, with element i being start + i*step.
+ */
+int NewDoubleArrayValue(ValueHash *context, ValueHash *parameters, Value **value_ret, ErrorLog &log)
+{
+	*value_ret=NULL;
+	Value *values=(parameters ? parameters->find("values") : NULL);
+
+	if (values) {
+		DoubleArrayValue *other=dynamic_cast<DoubleArrayValue*>(values);
+		if (other) { *value_ret=other->duplicate(); return 0; }
+
+		SetValue *set=dynamic_cast<SetValue*>(values);
+		if (!set) {
+			log.AddMessage(_("values must be a set of numbers"),ERROR_Fail);
+			return 1;
+		}
+		DoubleArrayValue *array=new DoubleArrayValue(set->values.n);
+		int isnum=0;
+		for (int c=0; c<set->values.n; c++) {
+			array->d[c]=getNumberValue(set->values.e[c],&isnum);
+			if (!isnum) {
+				array->dec_count();
+				log.AddMessage(_("values must be a set of numbers"),ERROR_Fail);
+				return 1;
+			}
+		}
+		*value_ret=array;
+		return 0;
+	}
+
+	int err=0;
+	long n=0;
+	double start=0, step=0;
+	if (parameters) {
+		n=parameters->findInt("n",-1,&err);            if (err) n=0;
+		start=parameters->findIntOrDouble("start",-1,&err); if (err) start=0;
+		step =parameters->findIntOrDouble("step", -1,&err); if (err) step=0;
+	}
+	if (n<0) {
+		log.AddMessage(_("n must not be negative"),ERROR_Fail);
+		return 1;
+	}
+
+	DoubleArrayValue *array=new DoubleArrayValue(n);
+	for (int c=0; c<n; c++) array->d[c]=start+c*step;
+	*value_ret=array;
+	return 0;
+}
+
+
+//----------------------------- FlatvectorArrayValue ----------------------------------
+/*! \class FlatvectorArrayValue
+ * \brief Packed list of 2-d points.
+ *
+ * Points are stored as interleaved x,y doubles in one block. Arithmetic with other
+ * arrays, flatvectors, or numbers happens element-wise without creating any per point
+ * objects. See ArrayValueOp().
+ *
+ * LPathsData can make these from its points, and append polylines from them.
+ *
+ * In scripts, create with points(n), points(x=xarray, y=yarray), or points(values={...}).
+ */
+
+FlatvectorArrayValue::FlatvectorArrayValue(int nn, const double *nxy)
+{
+	xy=NULL;
+	n=max=0;
+	if (nn>0) {
+		Resize(nn);
+		if (nxy) memcpy(xy,nxy,2*nn*sizeof(double));
+	}
+}
+
+FlatvectorArrayValue::~FlatvectorArrayValue()
+{
+	delete[] xy;
+}
+
+//! Make sure there is room for at least nmax points.
+void FlatvectorArrayValue::Allocate(int nmax)
+{
+	if (nmax<=max) return;
+	double *nxy=new double[2*nmax];
+	if (xy) memcpy(nxy,xy,2*n*sizeof(double));
+	delete[] xy;
+	xy=nxy;
+	max=nmax;
+}
+
+//! Set the number of points. New points are (0,0).
+void FlatvectorArrayValue::Resize(int nn)
+{
+	if (nn<0) nn=0;
+	Allocate(nn);
+	if (nn>n) memset(xy+2*n,0,2*(nn-n)*sizeof(double));
+	n=nn;
+}
+
+//! Append (x,y), and return the new number of points.
+int FlatvectorArrayValue::Push(double x, double y)
+{
+	if (n==max) Allocate(max ? 2*max : 16);
+	xy[2*n]  =x;
+	xy[2*n+1]=y;
+	return ++n;
+}
+
+//! Apply affine matrix m to all the points.
+void FlatvectorArrayValue::Transform(const double *m)
+{
+	double x,y;
+	for (int c=0; c<2*n; c+=2) {
+		x=xy[c];
+		y=xy[c+1];
+		xy[c]  =m[0]*x + m[2]*y + m[4];
+		xy[c+1]=m[1]*x + m[3]*y + m[5];
+	}
+}
+
+int FlatvectorArrayValue::getValueStr(char *buffer,int len)
+{
+	int needed=3+n*50;
+	if (!buffer || len<needed) return needed;
+
+	int pos=sprintf(buffer,"{");
+	for (int c=0; c<n; c++) pos+=sprintf(buffer+pos,"%s(%g,%g)",c ? "," : "",xy[2*c],xy[2*c+1]);
+	sprintf(buffer+pos,"}");
+	modified=0;
+	return 0;
+}
+
+Value *FlatvectorArrayValue::duplicate()
+{ return new FlatvectorArrayValue(n,xy); }
+
+//! Return a new FlatvectorValue of point index.
+Value *FlatvectorArrayValue::dereference(int index)
+{
+	if (index<0 || index>=n) return NULL;
+	return new FlatvectorValue(e(index));
+}
+
+//! "x" and "y" return a new DoubleArrayValue with just those coordinates.
+Value *FlatvectorArrayValue::dereference(const char *extstring, int len)
+{
+	int which=-1;
+	if (extequal(extstring,len, "x")) which=0;
+	else if (extequal(extstring,len, "y")) which=1;
+	if (which<0) return NULL;
+
+	DoubleArrayValue *array=new DoubleArrayValue(n);
+	for (int c=0; c<n; c++) array->d[c]=xy[2*c+which];
+	return array;
+}
+
+
+ObjectDef default_FlatvectorArrayValue_ObjectDef(NULL,"FlatvectorArray",_("Flatvector Array"),_("Packed list of two dimensional vectors"),
+							 "class", NULL, "{}",
+							 NULL, 0,
+							 NULL, NULL);
+
+ObjectDef *Get_FlatvectorArrayValue_ObjectDef()
+{
+	ObjectDef *def=&default_FlatvectorArrayValue_ObjectDef;
+	if (def->fields) return def;
+
+	def->pushFunction("n",_("Number of points"),_("Number of points"), NULL,
+					  NULL);
+
+	def->pushFunction("push",_("Push"),_("Append a point"), NULL,
+					  "p",_("Point"),_("Point"), "flatvector",NULL,NULL,
+					  NULL);
+
+	def->pushFunction("dot",_("Dot"),_("DoubleArray of dot products with points of another array of the same size"), NULL,
+					  "other",_("Other"),_("Another FlatvectorArray"), "FlatvectorArray",NULL,NULL,
+					  NULL);
+
+	def->pushFunction("lengths",_("Lengths"),_("DoubleArray of the length of each point"), NULL,
+					  NULL);
+
+	def->pushFunction("transform",_("Transform"),_("Apply an affine transform to all points"), NULL,
+					  "matrix",_("Matrix"),_("An Affine, or a set of 6 numbers"), "any",NULL,NULL,
+					  NULL);
+
+	return def;
+}
+
+ObjectDef *FlatvectorArrayValue::makeObjectDef()
+{
+	Get_FlatvectorArrayValue_ObjectDef()->inc_count();
+	return Get_FlatvectorArrayValue_ObjectDef();
+}
+
+/*! Return
+ *  0 for success, value returned.
+ * -1 for no value returned due to incompatible parameters, which aids in function overloading.
+ *  1 for parameters ok, but there was somehow an error, so no value returned.
+ */
+int FlatvectorArrayValue::Evaluate(const char *func,int len, ValueHash *context, ValueHash *parameters, CalcSettings *settings,
+						 Value **value_ret,
+						 ErrorLog *log)
+{
+	if (len==1 && *func=='n') { *value_ret=new IntValue(n); return 0; }
+
+	if (isName(func,len, "lengths")) {
+		DoubleArrayValue *array=new DoubleArrayValue(n);
+		array_dots(array->d, xy,xy, n);
+		for (int c=0; c<n; c++) array->d[c]=sqrt(array->d[c]);
+		*value_ret=array;
+		return 0;
+
+	} else if (isName(func,len, "push")) {
+		FlatvectorValue *p=dynamic_cast<FlatvectorValue*>(parameters ? parameters->find("p") : NULL);
+		if (!p) return -1;
+		Push(p->v.x,p->v.y);
+		*value_ret=NULL;
+		return 0;
+
+	} else if (isName(func,len, "dot")) {
+		FlatvectorArrayValue *other=dynamic_cast<FlatvectorArrayValue*>(parameters ? parameters->find("other") : NULL);
+		if (!other) return -1;
+		if (other->n!=n) {
+			if (log) log->AddMessage(_("Arrays must be the same size!"),ERROR_Fail);
+			return 1;
+		}
+		DoubleArrayValue *array=new DoubleArrayValue(n);
+		array_dots(array->d, xy,other->xy, n);
+		*value_ret=array;
+		return 0;
+
+	} else if (isName(func,len, "transform")) {
+		double m[6];
+		if (!value_to_matrix(parameters ? parameters->find("matrix") : NULL, m)) return -1;
+		Transform(m);
+		*value_ret=NULL;
+		return 0;
+	}
+
+	return -1;
+}
+
+/*! Contructor for FlatvectorArrayValue objects.
+ *
+ * values can be a set of flatvectors, or another FlatvectorArray, to copy.
+ * Otherwise, x and y can each be a DoubleArray or a single number, which are combined
+ * into points. If neither x nor y is an array, then there are n points.
+ */
+int NewFlatvectorArrayValue(ValueHash *context, ValueHash *parameters, Value **value_ret, ErrorLog &log)
+{
+	*value_ret=NULL;
+	Value *values=(parameters ? parameters->find("values") : NULL);
+
+	if (values) {
+		FlatvectorArrayValue *other=dynamic_cast<FlatvectorArrayValue*>(values);
+		if (other) { *value_ret=other->duplicate(); return 0; }
+
+		SetValue *set=dynamic_cast<SetValue*>(values);
+		if (!set) {
+			log.AddMessage(_("values must be a set of flatvectors"),ERROR_Fail);
+			return 1;
+		}
+		FlatvectorArrayValue *array=new FlatvectorArrayValue(set->values.n);
+		for (int c=0; c<set->values.n; c++) {
+			FlatvectorValue *v=dynamic_cast<FlatvectorValue*>(set->values.e[c]);
+			if (!v) {
+				array->dec_count();
+				log.AddMessage(_("values must be a set of flatvectors"),ERROR_Fail);
+				return 1;
+			}
+			array->xy[2*c]  =v->v.x;
+			array->xy[2*c+1]=v->v.y;
+		}
+		*value_ret=array;
+		return 0;
+	}
+
+	int err=0;
+	long n=-1;
+	if (parameters) { n=parameters->findInt("n",-1,&err); if (err) n=-1; }
+
+	 //x and y are each either an array, or a number to use for all points
+	Value *xv=(parameters ? parameters->find("x") : NULL);
+	Value *yv=(parameters ? parameters->find("y") : NULL);
+	DoubleArrayValue *xa=dynamic_cast<DoubleArrayValue*>(xv);
+	DoubleArrayValue *ya=dynamic_cast<DoubleArrayValue*>(yv);
+	double x=0, y=0;
+	int isnum=1;
+	if (xv && !xa) x=getNumberValue(xv,&isnum);
+	if (isnum && yv && !ya) y=getNumberValue(yv,&isnum);
+	if (!isnum) {
+		log.AddMessage(_("x and y must be numbers or DoubleArrays"),ERROR_Fail);
+		return 1;
+	}
+
+	if (xa) n=xa->n;
+	if (ya) {
+		if (xa && xa->n!=ya->n) {
+			log.AddMessage(_("Arrays must be the same size!"),ERROR_Fail);
+			return 1;
+		}
+		n=ya->n;
+	}
+	if (n<0) n=0;
+
+	FlatvectorArrayValue *array=new FlatvectorArrayValue(n);
+	for (int c=0; c<n; c++) {
+		array->xy[2*c]  =(xa ? xa->d[c] : x);
+		array->xy[2*c+1]=(ya ? ya->d[c] : y);
+	}
+	*value_ret=array;
+	return 0;
+}
+
+
+//----------------------------- ArrayValueOp ----------------------------------
+
+//! Element-wise arithmetic with DoubleArrayValue and FlatvectorArrayValue.
+/*! op is one of '+', '-', '*', or '/'. Supported are:
+ * <pre>
+ *   DoubleArray     op DoubleArray (same size)    -> DoubleArray
+ *   DoubleArray     op number, number op DoubleArray -> DoubleArray
+ *   FlatvectorArray +- FlatvectorArray (same size) -> FlatvectorArray
+ *   FlatvectorArray +- flatvector, flatvector +- FlatvectorArray -> FlatvectorArray
+ *   FlatvectorArray *  FlatvectorArray or flatvector -> DoubleArray of dot products
+ *   FlatvectorArray * or / number, number * FlatvectorArray -> FlatvectorArray
+ *   FlatvectorArray * or / DoubleArray, DoubleArray * FlatvectorArray -> FlatvectorArray, each point scaled
+ * </pre>
+ *
+ * Return 0 for success, or -1 for incompatible values.
+ */
+int ArrayValueOp(char op, Value *num1, Value *num2, Value **value_ret)
+{
+	*value_ret=NULL;
+	if (!num1 || !num2) return -1;
+
+	DoubleArrayValue     *d1=dynamic_cast<DoubleArrayValue*>(num1);
+	DoubleArrayValue     *d2=dynamic_cast<DoubleArrayValue*>(num2);
+	FlatvectorArrayValue *f1=dynamic_cast<FlatvectorArrayValue*>(num1);
+	FlatvectorArrayValue *f2=dynamic_cast<FlatvectorArrayValue*>(num2);
+	FlatvectorValue      *v1=dynamic_cast<FlatvectorValue*>(num1);
+	FlatvectorValue      *v2=dynamic_cast<FlatvectorValue*>(num2);
+
+	int isnum1=0, isnum2=0;
+	double s1=0, s2=0;
+	if (!d1 && !f1 && !v1) s1=getNumberValue(num1,&isnum1);
+	if (!d2 && !f2 && !v2) s2=getNumberValue(num2,&isnum2);
+
+	if (d1 && d2) {
+		if (d1->n!=d2->n) return -1;
+		DoubleArrayValue *r=new DoubleArrayValue(d1->n);
+		array_op(op, r->d, d1->d, d2->d, d1->n);
+		*value_ret=r;
+
+	} else if (d1 && isnum2) {
+		DoubleArrayValue *r=new DoubleArrayValue(d1->n);
+		array_scalar_op(op, r->d, d1->d, s2, d1->n, 0);
+		*value_ret=r;
+
+	} else if (isnum1 && d2) {
+		DoubleArrayValue *r=new DoubleArrayValue(d2->n);
+		array_scalar_op(op, r->d, d2->d, s1, d2->n, 1);
+		*value_ret=r;
+
+	} else if (f1 && f2) {
+		if (f1->n!=f2->n) return -1;
+		if (op=='+' || op=='-') {
+			FlatvectorArrayValue *r=new FlatvectorArrayValue(f1->n);
+			array_op(op, r->xy, f1->xy, f2->xy, 2*f1->n);
+			*value_ret=r;
+		} else if (op=='*') {
+			DoubleArrayValue *r=new DoubleArrayValue(f1->n);
+			array_dots(r->d, f1->xy, f2->xy, f1->n);
+			*value_ret=r;
+		} else return -1;
+
+	} else if ((f1 && v2) || (v1 && f2)) {
+		FlatvectorArrayValue *f=(f1 ? f1 : f2);
+		double v[2];
+		v[0]=(v1 ? v1->v.x : v2->v.x);
+		v[1]=(v1 ? v1->v.y : v2->v.y);
+
+		if (op=='+' || op=='-') {
+			FlatvectorArrayValue *r=new FlatvectorArrayValue(f->n);
+			double sign=1, vsign=1;
+			if (op=='-') { if (f1) vsign=-1; else sign=-1; }
+			for (int c=0; c<2*f->n; c+=2) {
+				r->xy[c]  =sign*f->xy[c]   + vsign*v[0];
+				r->xy[c+1]=sign*f->xy[c+1] + vsign*v[1];
+			}
+			*value_ret=r;
+		} else if (op=='*') {
+			DoubleArrayValue *r=new DoubleArrayValue(f->n);
+			for (int c=0; c<f->n; c++) r->d[c]=f->xy[2*c]*v[0] + f->xy[2*c+1]*v[1];
+			*value_ret=r;
+		} else return -1;
+
+	} else if (f1 && isnum2) {
+		if (op!='*' && op!='/') return -1;
+		FlatvectorArrayValue *r=new FlatvectorArrayValue(f1->n);
+		array_scalar_op(op, r->xy, f1->xy, s2, 2*f1->n, 0);
+		*value_ret=r;
+
+	} else if (isnum1 && f2) {
+		if (op!='*') return -1;
+		FlatvectorArrayValue *r=new FlatvectorArrayValue(f2->n);
+		array_scalar_op(op, r->xy, f2->xy, s1, 2*f2->n, 1);
+		*value_ret=r;
+
+	} else if ((f1 && d2 && (op=='*' || op=='/')) || (d1 && f2 && op=='*')) {
+		FlatvectorArrayValue *f=(f1 ? f1 : f2);
+		DoubleArrayValue *d=(d1 ? d1 : d2);
+		if (f->n!=d->n) return -1;
+		FlatvectorArrayValue *r=new FlatvectorArrayValue(f->n);
+		if (op=='/') {
+			for (int c=0; c<f->n; c++) { r->xy[2*c]=f->xy[2*c]/d->d[c]; r->xy[2*c+1]=f->xy[2*c+1]/d->d[c]; }
+		} else {
+			for (int c=0; c<f->n; c++) { r->xy[2*c]=f->xy[2*c]*d->d[c]; r->xy[2*c+1]=f->xy[2*c+1]*d->d[c]; }
+		}
+		*value_ret=r;
+	}
+
+	if (*value_ret) return 0;
+	return -1;
+}
+
+
+} //namespace Laidout
+
@@ -0,0 +1,88 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef ARRAYVALUES_H
+#define ARRAYVALUES_H
+
+#include "values.h"
+
+
+namespace Laidout {
+
+
+//----------------------------- DoubleArrayValue ----------------------------------
+class DoubleArrayValue : public Value, virtual public FunctionEvaluator
+{
+  public:
+	double *d;
+	int n, max;
+
+	DoubleArrayValue(int nn=0, const double *nd=NULL);
+	virtual ~DoubleArrayValue();
+	virtual const char *whattype() { return "DoubleArrayValue"; }
+	virtual void Allocate(int nmax);
+	virtual void Resize(int nn);
+	virtual int Push(double v);
+
+	virtual int getValueStr(char *buffer,int len);
+	virtual Value *duplicate();
+	virtual int type() { return VALUE_DoubleArray; }
+ 	virtual ObjectDef *makeObjectDef();
+	virtual Value *dereference(int index);
+	virtual int Evaluate(const char *func,int len, ValueHash *context, ValueHash *parameters, CalcSettings *settings,
+						 Value **value_ret,
+						 Laxkit::ErrorLog *log);
+};
+
+
+//----------------------------- FlatvectorArrayValue ----------------------------------
+class FlatvectorArrayValue : public Value, virtual public FunctionEvaluator
+{
+  public:
+	double *xy; //x0,y0, x1,y1, ...
+	int n, max;
+
+	FlatvectorArrayValue(int nn=0, const double *nxy=NULL);
+	virtual ~FlatvectorArrayValue();
+	virtual const char *whattype() { return "FlatvectorArrayValue"; }
+	virtual void Allocate(int nmax);
+	virtual void Resize(int nn);
+	virtual int Push(double x, double y);
+	virtual flatvector e(int i) { return flatvector(xy[2*i],xy[2*i+1]); }
+	virtual void Transform(const double *m);
+
+	virtual int getValueStr(char *buffer,int len);
+	virtual Value *duplicate();
+	virtual int type() { return VALUE_FlatvectorArray; }
+ 	virtual ObjectDef *makeObjectDef();
+	virtual Value *dereference(const char *extstring, int len);
+	virtual Value *dereference(int index);
+	virtual int Evaluate(const char *func,int len, ValueHash *context, ValueHash *parameters, CalcSettings *settings,
+						 Value **value_ret,
+						 Laxkit::ErrorLog *log);
+};
+
+
+ObjectDef *Get_DoubleArrayValue_ObjectDef();
+ObjectDef *Get_FlatvectorArrayValue_ObjectDef();
+int NewDoubleArrayValue(ValueHash *context, ValueHash *parameters, Value **value_ret, Laxkit::ErrorLog &log);
+int NewFlatvectorArrayValue(ValueHash *context, ValueHash *parameters, Value **value_ret, Laxkit::ErrorLog &log);
+int ArrayValueOp(char op, Value *num1, Value *num2, Value **value_ret);
+
+
+} //namespace Laidout
+
+#endif
+
@@ -18,11 +18,13 @@
 #include <lax/fileutils.h>
 #include <lax/units.h>
 #include "calculator.h"
+#include "arrayvalues.h"
 #include "../language.h"
 #include "../laidout.h"
 #include "../stylemanager.h"
 #include "../headwindow.h"
 #include "../version.h"
+#include "../profiler.h"
 
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -87,6 +89,88 @@ CalcSettings::~CalcSettings()
 }
 
 
+//----------------------------- ScriptCache -------------------------------------
+/*! \class ScriptCache
+ * \brief Remembers what scanning found at each position of a script.
+ *
+ * The calculator interprets straight from the source text, so loop bodies and function
+ * bodies get rescanned every time through. Whitespace and comment skipping, name and
+ * operator lengths, number parsing, block skipping, and which operator levels an operator
+ * belongs to only depend on the text, so the first scan at each position is remembered
+ * here, and subsequent scans just jump ahead. Since the same position and line counting
+ * results are used, error messages are identical.
+ *
+ * LaidoutCalculator keeps a few of these around, matched by the text, so that
+ * repeatedly called script functions reuse their tables.
+ */
+
+ScriptCache::ScriptCache(const char *ntext, int nexprslen, unsigned long nhash)
+{
+	text=newstr(ntext);
+	textlen=strlen(text);
+	exprslen=nexprslen;
+	hash=nhash;
+	last_used=0;
+	in_use=0;
+	ops_generation=0;
+
+	ws_end=ws_lines=NULL;
+	name_len=NULL;
+	op_len=NULL;
+	op_levels=NULL;
+	block_end=block_lines=NULL;
+	block_ch=NULL;
+	int_end=NULL;  int_value=NULL;
+	real_end=NULL; real_value=NULL;
+	names=NULL;
+}
+
+ScriptCache::~ScriptCache()
+{
+	delete[] text;
+	delete[] ws_end;
+	delete[] ws_lines;
+	delete[] name_len;
+	delete[] op_len;
+	delete[] op_levels;
+	delete[] block_end;
+	delete[] block_lines;
+	delete[] block_ch;
+	delete[] int_end;
+	delete[] int_value;
+	delete[] real_end;
+	delete[] real_value;
+	delete[] names;
+}
+
+//! FNV-1a hash of str.
+unsigned long ScriptCache::Hash(const char *str)
+{
+	unsigned long h=2166136261UL;
+	for ( ; *str; str++) { h^=(unsigned char)*str; h*=16777619UL; }
+	return h;
+}
+
+//! Make sure table exists, with one entry per position, and return it.
+/*! New tables are filled with -1.
+ */
+int *ScriptCache::Table(int *&table)
+{
+	if (!table) {
+		table=new int[textlen+2];
+		for (int c=0; c<textlen+2; c++) table[c]=-1;
+	}
+	return table;
+}
+
+//! Forget which operator levels ops belong to, for when operators are added or removed.
+void ScriptCache::ClearOps()
+{
+	delete[] op_levels;
+	op_levels=NULL;
+}
+
+
 
 
 //---------------------------------- OperatorFunction ------------------------------------------
@@ -435,7 +519,19 @@ AliasEntry::~AliasEntry()
 //------------------------------- BlockInfo ---------------------------------------
 /*! \class BlockInfo
  * \brief Scope information for LaidoutCalculator.
+ *
+ * dict is kept sorted. Larger dicts are looked up through nameindex.
+ */
+
+//! Below this many entries, FindName() does a binary search instead of using nameindex.
+#define BLOCKINFO_MIN_INDEXED 8
+
+/*! Incremented whenever any dict gets a name, or a BlockInfo with names is destroyed,
+ * which is when per call site name lookups in ScriptCache become invalid.
+ * Scopes without names, like most loop and if blocks, are invisible to lookups,
+ * so pushing and popping them on every iteration does not change this.
  */
+unsigned long BlockInfo::generation=1;
 
 BlockInfo::BlockInfo()
 {
@@ -502,6 +598,7 @@ BlockInfo::BlockInfo(CalculatorModule *mod, BlockTypes scopetype, int loop_start
 
 BlockInfo::~BlockInfo()
 {
+	if (dict.n) generation++;
 	if (scope_namespace) scope_namespace->dec_count();
 	if (containing_object) containing_object->dec_count();
 	if (list) list->dec_count();
@@ -581,7 +678,9 @@ int BlockInfo::AddValue(const char *name, Value *v)
 			oo=new OverloadedEntry(name,0);
 			oo->entries.push(entry);
 			dict.push(oo,1,pos); //replace old entry with overloaded entry
+			nameindex.valid=0;
 		}
+		generation++;
 		Entry *newentry=new ValueEntry(name, 0,NULL,NULL, containing_object, v);
 
 		oo->entries.push(newentry,1,-1);
@@ -591,6 +690,8 @@ int BlockInfo::AddValue(const char *name, Value *v)
 	 //entry not found, so add!
 	Entry *entry=new ValueEntry(name, 0,NULL,NULL, containing_object, v);
 	dict.push(entry,1,pos);
+	nameindex.valid=0;
+	generation++;
 
 	return 0;
 }
@@ -660,7 +761,9 @@ int BlockInfo::AddName(CalculatorModule *mod, ObjectDef *item, Value *container_
 			oo=new OverloadedEntry(item->name,0);
 			oo->entries.push(entry);
 			dict.push(oo,1,pos); //replace old entry with overloaded entry
+			nameindex.valid=0;
 		}
+		generation++;
 		Entry *newentry=createNewEntry(item,mod,container_v);
 		oo->entries.push(newentry,1,-1);
 		return -1;
@@ -670,6 +773,8 @@ int BlockInfo::AddName(CalculatorModule *mod, ObjectDef *item, Value *container_
 	Entry *entry=createNewEntry(item,mod,container_v);
 	if (!entry) return 1; //cannot add this item!
 	dict.push(entry,1,pos);
+	nameindex.valid=0;
+	generation++;
 
 	return 0;
 }
@@ -723,32 +828,42 @@ int BlockInfo::isSameEntry(ObjectDef *item, Entry *entry)
 	return 0;
 }
 
-Entry *BlockInfo::FindName(const char *name,int len)
+//! Return the index in dict of name, or -1 if not there.
+int BlockInfo::FindIndex(const char *name,int len)
 {
+	if (dict.n>=BLOCKINFO_MIN_INDEXED) {
+		if (!nameindex.valid) {
+			nameindex.Clear();
+			for (int c=0; c<dict.n; c++) nameindex.Add(dict.e[c]->name,c);
+			nameindex.valid=1;
+		}
+		return nameindex.Find(name,len);
+	}
+
 	int s=0,e=dict.n-1,m=0;
 	int nlen;
 
 	if (s<=e) {
 		int cmp=strncmp(name,dict.e[s]->name,len);
 		if (cmp==0) {
-			if ((int)strlen(dict.e[s]->name)==len) return dict.e[s];
+			if ((int)strlen(dict.e[s]->name)==len) return s;
 			cmp=1;
 		}
-		if (cmp<0) return NULL; //it is less than lowest element
+		if (cmp<0) return -1; //it is less than lowest element
 		
 		cmp=strncmp(name,dict.e[e]->name,len);
 		if (cmp==0) {
-			if ((int)strlen(dict.e[e]->name)==len) return dict.e[e];
+			if ((int)strlen(dict.e[e]->name)==len) return e;
 			cmp=1;
 		}
-		if (cmp>0) return NULL; //it is greater than greatest element
+		if (cmp>0) return -1; //it is greater than greatest element
 		
 		while (s<e) {
 			m=(s+e)/2;
 			cmp=strncmp(name,dict.e[m]->name,len);
 			nlen=strlen(dict.e[m]->name);
 			if (cmp==0 && len<nlen) cmp=-1;
-			if (cmp==0) return dict.e[m];
+			if (cmp==0) return m;
 
 			if (cmp<0) {
 				e=m-1;
@@ -756,22 +871,30 @@ Entry *BlockInfo::FindName(const char *name,int len)
 				nlen=strlen(dict.e[e]->name);
 				cmp=strncmp(name,dict.e[e]->name,len);
 				if (cmp==0 && len<nlen) cmp=-1;
-				if (cmp==0) return dict.e[e];
+				if (cmp==0) return e;
 
-				if (cmp>0) return NULL; //between m-1 and m, not in list
+				if (cmp>0) return -1; //between m-1 and m, not in list
 			} else {
 				s=m+1;
 
 				nlen=strlen(dict.e[s]->name);
 				cmp=strncmp(name,dict.e[s]->name,len);
 				if (cmp==0 && len<nlen) cmp=-1;
-				if (cmp==0) return dict.e[s];
+				if (cmp==0) return s;
 
-				if (cmp<0) return NULL; //between m-1 and m, not in list
+				if (cmp<0) return -1; //between m-1 and m, not in list
 			}
 		}
 	}
-	return NULL;
+	return -1;
+}
+
+//! Return the entry for name in dict, or NULL. If index_ret!=NULL, it gets the index in dict, or -1.
+Entry *BlockInfo::FindName(const char *name,int len, int *index_ret)
+{
+	int i=FindIndex(name,len);
+	if (index_ret) *index_ret=i;
+	return i>=0 ? dict.e[i] : NULL;
 }
 
 
@@ -1103,6 +1226,9 @@ LaidoutCalculator::LaidoutCalculator()
 	curline=0;
 	curexprs=NULL;
 	curexprslen=0;
+	scriptcache=NULL;
+	scriptcache_tick=0;
+	ops_generation=0;
 	calcerror=0;
 	calcmes=NULL;
 	messagebuffer=NULL;
@@ -1490,6 +1616,8 @@ int LaidoutCalculator::evaluate(const char *in, int len, ValueHash *context, Val
 	int oldlen=curexprslen;
 	int oldline=curline;
 	char *texprs=newnstr(curexprs,curexprslen);
+	ScriptCache *oldcache=scriptcache;
+	if (oldcache) oldcache->in_use++;
 
 
 	 //2. establish parameters and process the call
@@ -1520,6 +1648,8 @@ int LaidoutCalculator::evaluate(const char *in, int len, ValueHash *context, Val
 	from       =oldfrom;
 	curline    =oldline;
 	errorlog   =old_errorlog;
+	scriptcache=oldcache; //pinned above, so it is still around and still for texprs
+	if (oldcache) oldcache->in_use--;
 
 	return status;
 }
@@ -1669,17 +1799,13 @@ void LaidoutCalculator::calcerr(const char *error,const char *where,int w, int s
  */
 char *LaidoutCalculator::getnamestring(int *n)  //  alphanumeric or _ 
 {
-	if (!isalpha(curexprs[from]) && curexprs[from]!='_') { *n=0; return NULL; }
-
-	char *tname=NULL;
-	int c=0;
-	while (from+c<curexprslen && (isalnum(curexprs[from+c]) || curexprs[from+c]=='_')) c++;
-	if (c!=0) {
-		tname=new char[c+1];
-		strncpy(tname,curexprs+from,c);
-		tname[c]='\0';
-	}
+	int c=getnamestringlen();
 	if (n) *n=c;
+	if (!c) return NULL;
+
+	char *tname=new char[c+1];
+	strncpy(tname,curexprs+from,c);
+	tname[c]='\0';
 	return tname;
 }
 
@@ -1697,10 +1823,17 @@ const char *LaidoutCalculator::getnamestringc(int *n)  //  alphanumeric or _
  */
 int LaidoutCalculator::getnamestringlen()  //  alphanumeric or _ 
 {
-	if (!isalpha(curexprs[from]) && curexprs[from]!='_') return 0;
+	int *lens=NULL;
+	if (scriptcache && from>=0 && from<=scriptcache->textlen) {
+		lens=scriptcache->Table(scriptcache->name_len);
+		if (lens[from]>=0) return lens[from];
+	}
 
 	int c=0;
-	while (from+c<curexprslen && (isalnum(curexprs[from+c]) || curexprs[from+c]=='_')) c++;
+	if (isalpha(curexprs[from]) || curexprs[from]=='_') {
+		while (from+c<curexprslen && (isalnum(curexprs[from+c]) || curexprs[from+c]=='_')) c++;
+	}
+	if (lens) lens[from]=c;
 	return c;
 }
 
@@ -1712,6 +1845,16 @@ int LaidoutCalculator::getnamestringlen()  //  alphanumeric or _
 const char *LaidoutCalculator::getopstring(int *n)
 {
 	skipwscomment();
+
+	int *lens=NULL;
+	if (scriptcache && from>=0 && from<=scriptcache->textlen) {
+		lens=scriptcache->Table(scriptcache->op_len);
+		if (lens[from]>=0) {
+			*n=lens[from];
+			return *n ? curexprs+from : NULL;
+		}
+	}
+
 	char ch=curexprs[from];
 	int pos=from;
 	*n=0;
@@ -1732,6 +1875,7 @@ const char *LaidoutCalculator::getopstring(int *n)
 		pos++;
 		ch=curexprs[pos];
 	}
+	if (lens) lens[from]=*n;
 	if (*n) return curexprs+from;
 	return NULL;
 }
@@ -1754,6 +1898,17 @@ void LaidoutCalculator::skipwscomment()
 //	} while (isspace(curexprs[from]) || curexprs[from]=='#');
 
 	//----------------for //comments  and /* comments */
+	int start=from, startline=curline;
+	int *ends=NULL;
+	if (scriptcache && start>=0 && start<=scriptcache->textlen) {
+		ends=scriptcache->Table(scriptcache->ws_end);
+		if (ends[start]>=0) {
+			from=ends[start];
+			curline+=scriptcache->ws_lines[start];
+			return;
+		}
+	}
+
 	do {
 		 //skip actual whitespace
 		while (isspace(curexprs[from]) && from<curexprslen) {
@@ -1787,6 +1942,11 @@ void LaidoutCalculator::skipwscomment()
 			   || (curexprs[from]=='/' && curexprs[from+1]=='*')
 			   || (curexprs[from]=='/' && curexprs[from+1]=='/')
 			   ));
+
+	if (ends) {
+		scriptcache->Table(scriptcache->ws_lines)[start]=curline-startline;
+		ends[start]=from;
+	}
 }
 
 /*! Skip whitespace and skip final comments in the form "#....\n".
@@ -1956,8 +2116,34 @@ void LaidoutCalculator::skipRemainingBlock(char ch)
 
 //! Assuming just after an opening of ch, skip to after a ch.
 /*! ch should be one of: )}].
+ *
+ * Blocks that have been skipped before without error are jumped over using scriptcache.
  */
 void LaidoutCalculator::skipBlock(char ch)
+{
+	int start=from, startline=curline, olderror=calcerror;
+	bool cacheable=(scriptcache && start>=0 && start<=scriptcache->textlen);
+	if (cacheable && scriptcache->block_ch) {
+		int *ends=scriptcache->Table(scriptcache->block_end);
+		if (ends[start]>=0 && scriptcache->block_ch[start]==ch) {
+			from=ends[start];
+			curline+=scriptcache->block_lines[start];
+			return;
+		}
+	}
+
+	scanBlock(ch);
+
+	if (cacheable && !olderror && !calcerror) {
+		if (!scriptcache->block_ch) scriptcache->block_ch=new char[scriptcache->textlen+2];
+		scriptcache->Table(scriptcache->block_end)[start]=from;
+		scriptcache->Table(scriptcache->block_lines)[start]=curline-startline;
+		scriptcache->block_ch[start]=ch;
+	}
+}
+
+//! The actual scanning for skipBlock().
+void LaidoutCalculator::scanBlock(char ch)
 {
 	char *str;
 	int tfrom=-1;
@@ -2276,6 +2462,42 @@ void LaidoutCalculator::newcurexprs(const char *newex,int len)
 	curexprslen=strlen(curexprs);
 	from=0;
 	curline=0;
+	scriptcache=findScriptCache();
+}
+
+//! Return the ScriptCache matching curexprs, creating a new one if necessary.
+/*! Only the most recently used few are kept, plus any that an outer evaluate() will return to.
+ */
+ScriptCache *LaidoutCalculator::findScriptCache()
+{
+	if (!curexprs) return NULL;
+
+	unsigned long hash=ScriptCache::Hash(curexprs);
+	ScriptCache *cache=NULL;
+	for (int c=0; c<scriptcaches.n; c++) {
+		if (scriptcaches.e[c]->hash==hash
+				&& scriptcaches.e[c]->exprslen==curexprslen
+				&& !strcmp(scriptcaches.e[c]->text,curexprs)) {
+			cache=scriptcaches.e[c];
+			break;
+		}
+	}
+
+	if (!cache) {
+		if (scriptcaches.n>=16) {
+			int oldest=-1;
+			for (int c=0; c<scriptcaches.n; c++) {
+				if (scriptcaches.e[c]->in_use) continue;
+				if (oldest<0 || scriptcaches.e[c]->last_used<scriptcaches.e[oldest]->last_used) oldest=c;
+			}
+			if (oldest>=0) scriptcaches.remove(oldest);
+		}
+		cache=new ScriptCache(curexprs,curexprslen,hash);
+		scriptcaches.push(cache);
+	}
+
+	cache->last_used=++scriptcache_tick;
+	return cache;
 }
 
 void LaidoutCalculator::showDef(char *&temp, ObjectDef *sd)
@@ -3211,7 +3433,7 @@ Value *LaidoutCalculator::evalLevel(int level)
 
 	op=getopstring(&n);
 	while (n) { 
-		opfunc=oplevels.e[level]->hasOp(op,n,dir, &index,-1);
+		opfunc=(opAtLevel(n,level) ? oplevels.e[level]->hasOp(op,n,dir, &index,-1) : NULL);
 		if (!opfunc) {
 			n--; //search for smaller ops
 			break;
@@ -3234,8 +3456,8 @@ Value *LaidoutCalculator::evalLevel(int level)
 			status=opfunc->function->Op(op,n,dir, num,  num2,  &calcsettings, &num_ret, NULL);
 		} else {
 			 //need to resolve any LValue states, operator is NOT as assignment
-			if (!num1v && num->type()==VALUE_LValue)  num1v=dynamic_cast<LValue*>(num )->Resolve(); else { num1v=num;  num1v->inc_count(); }
-			if (!num2v && num2->type()==VALUE_LValue) num2v=dynamic_cast<LValue*>(num2)->Resolve(); else { num2v=num2; num2v->inc_count(); }
+			if (num->type()==VALUE_LValue)  num1v=dynamic_cast<LValue*>(num )->Resolve(); else { num1v=num;  num1v->inc_count(); }
+			if (num2->type()==VALUE_LValue) num2v=dynamic_cast<LValue*>(num2)->Resolve(); else { num2v=num2; num2v->inc_count(); }
 			status=opfunc->function->Op(op,n,dir, num1v,num2v, &calcsettings, &num_ret, NULL);
 		}
 
@@ -3246,11 +3468,10 @@ Value *LaidoutCalculator::evalLevel(int level)
 		if (!calcerror && !num_ret) calcerr(_("Cannot compute with given values."));
 		num->dec_count();  num=NULL;
 		num2->dec_count(); num2=NULL;
-		if (calcerror) {
-			if (num1v) num1v->dec_count();
-			if (num2v) num2v->dec_count();
-			return NULL;
-		}
+		 //release each step's operands now, so long chains don't hold on to them
+		if (num1v) { num1v->dec_count(); num1v=NULL; }
+		if (num2v) { num2v->dec_count(); num2v=NULL; }
+		if (calcerror) return NULL;
 		num=num_ret;
 		
 		op=getopstring(&n);
@@ -3261,6 +3482,34 @@ Value *LaidoutCalculator::evalLevel(int level)
 	return num;
 }
 
+//! Return whether the n character operator at from might be in oplevels.e[level].
+/*! Which levels have the operator is found once per position, so evalLevel()
+ * does not have to search every level the operator is not in.
+ */
+bool LaidoutCalculator::opAtLevel(int n, int level)
+{
+	if (!scriptcache || oplevels.n>31 || from<0 || from>scriptcache->textlen) return true;
+
+	if (scriptcache->ops_generation!=ops_generation) {
+		scriptcache->ClearOps();
+		scriptcache->ops_generation=ops_generation;
+	}
+	if (!scriptcache->op_levels) {
+		scriptcache->op_levels=new unsigned int[scriptcache->textlen+2];
+		for (int c=0; c<scriptcache->textlen+2; c++) scriptcache->op_levels[c]=~0u;
+	}
+
+	unsigned int &mask=scriptcache->op_levels[from];
+	if (mask==~0u) {
+		int index;
+		mask=0;
+		for (int c=0; c<oplevels.n; c++) {
+			if (oplevels.e[c]->hasOp(curexprs+from,n,oplevels.e[c]->direction, &index,-1)) mask|=(1u<<c);
+		}
+	}
+	return (mask&(1u<<level))!=0;
+}
+
 //! Read in a simple number, no processing of operators.
 /*! If the number is an integer or real, then read in units also.
  */
@@ -3660,6 +3909,13 @@ Value *LaidoutCalculator::ApplyDefaultSets(SetValue *set)
 //! Read in a double.
 double LaidoutCalculator::realnumber()
 {
+	int start=from;
+	bool cacheable=(scriptcache && start>=0 && start<=scriptcache->textlen);
+	if (cacheable && scriptcache->Table(scriptcache->real_end)[start]>=0) {
+		from=scriptcache->real_end[start];
+		return scriptcache->real_value[start];
+	}
+
 	char *endptr,*startptr=curexprs+from;
 	double r=strtod(startptr,&endptr);
 	if (endptr==startptr) {
@@ -3667,12 +3923,25 @@ double LaidoutCalculator::realnumber()
 		return 0;
 	}
 	from+=endptr-startptr;
+
+	if (cacheable) {
+		if (!scriptcache->real_value) scriptcache->real_value=new double[scriptcache->textlen+2];
+		scriptcache->real_value[start]=r;
+		scriptcache->real_end[start]=from;
+	}
 	return r;
 }
 
 //! Read in an integer.
 long LaidoutCalculator::intnumber()
 {
+	int start=from;
+	bool cacheable=(scriptcache && start>=0 && start<=scriptcache->textlen);
+	if (cacheable && scriptcache->Table(scriptcache->int_end)[start]>=0) {
+		from=scriptcache->int_end[start];
+		return scriptcache->int_value[start];
+	}
+
 	char *endptr,*startptr=curexprs+from;
 	//long c=strtol(startptr,&endptr,base);
 	long c=strtol(startptr,&endptr,10);
@@ -3681,6 +3950,12 @@ long LaidoutCalculator::intnumber()
 		return 0;
 	}
 	from+=endptr-startptr;
+
+	if (cacheable) {
+		if (!scriptcache->int_value) scriptcache->int_value=new long[scriptcache->textlen+2];
+		scriptcache->int_value[start]=c;
+		scriptcache->int_end[start]=from;
+	}
 	return c;
 }
 
@@ -3762,18 +4037,46 @@ Value *LaidoutCalculator::getstring()
 /*! scope is index in scopes.
  *  module is module id of that scope's namespace.
  *  index is index in name dict of that scope.
+ *
+ * When word is in the current expression, the result is remembered in scriptcache for
+ * that position, and reused until BlockInfo::generation changes, that is, until any
+ * name is added to a scope, or a scope with names is popped.
  */
 Entry *LaidoutCalculator::findNameEntry(const char *word,int len, int *scope, int *module, int *index)
 {
+	NameLookup *lookup=NULL;
+	if (scriptcache && curexprs && word>=curexprs && word-curexprs<=scriptcache->textlen) {
+		if (!scriptcache->names) {
+			scriptcache->names=new NameLookup[scriptcache->textlen+2];
+			memset(scriptcache->names,0,(scriptcache->textlen+2)*sizeof(NameLookup));
+		}
+		lookup=&scriptcache->names[word-curexprs];
+
+		if (lookup->generation==BlockInfo::generation && lookup->len==len) {
+			if (!lookup->entry) return NULL;
+			*scope=lookup->scope;
+			*module=scopes.e[lookup->scope]->scope_namespace->object_id;
+			if (index) *index=lookup->index;
+			return lookup->entry;
+		}
+		lookup->generation=BlockInfo::generation;
+		lookup->len=len;
+		lookup->entry=NULL;
+	}
+
 	Entry *entry=NULL;
-	int i=-1; //index in scope->entries.. for overloading?
+	int i=-1; //index in scope->dict
 	for (int c=scopes.n-1; c>=0; c--) {
-		//entry=scopes.e[c]->FindName(word,len, &i);
-		entry=scopes.e[c]->FindName(word,len);
+		entry=scopes.e[c]->FindName(word,len, &i);
 		if (entry) {
 			*scope=c;
 			*module=scopes.e[c]->scope_namespace->object_id;
 			if (index) *index=i;
+			if (lookup) {
+				lookup->scope=c;
+				lookup->index=i;
+				lookup->entry=entry;
+			}
 			return entry;
 		}
 	}
@@ -4116,6 +4419,15 @@ int LaidoutCalculator::functionCall(const char *word,int n, Value **v_ret,
 {
 	if (calcerror) return 1;
 
+	 //when profiling, time this call as "function" or "ContainingType.function"
+	char profilename[256];
+	if (Profiler::GetDefault()) {
+		if (function->name) snprintf(profilename,sizeof(profilename),"%s%s%s",
+						containingvalue ? containingvalue->whattype() : "", containingvalue ? "." : "", function->name);
+		else snprintf(profilename,sizeof(profilename),"%.*s",n>0 && n<200 ? n : 200, word ? word : "?");
+	}
+	ProfileScope profilescope("script", Profiler::GetDefault() ? profilename : NULL);
+
 	 //call the actual function
 	ErrorLog log;
 	Value *value=NULL;
@@ -4233,6 +4545,7 @@ int LaidoutCalculator::functionCall(const char *word,int n, Value **v_ret,
  */
 int LaidoutCalculator::removeOperators(int module_id)
 {
+	ops_generation++;
 	int n=0;
 	for (int c=leftops.ops.n-1; c>=0; c--) {
 		if (leftops.ops.e[c]->module_id==module_id) { leftops.ops.remove(c); n++; }
@@ -4255,6 +4568,7 @@ int LaidoutCalculator::removeOperators(int module_id)
 
 int LaidoutCalculator::addOperator(const char *op,int dir,int priority, int module_id, OpFuncEvaluator *opfunc,ObjectDef *def)
 {
+	ops_generation++;
 	if (dir==OPS_Left) leftops.pushOp(op, dir, opfunc, def, module_id);
 	else if (dir==OPS_Right) rightops.pushOp(op, dir, opfunc, def, module_id);
 	else {
@@ -4448,6 +4762,8 @@ void LaidoutCalculator::InstallBaseTypes()
 	global_scope.scope_namespace->push(Get_ValueHash_ObjectDef(),0);
 	global_scope.scope_namespace->push(Get_SetValue_ObjectDef(),0);
 	global_scope.scope_namespace->push(Get_StringValue_ObjectDef(),0);
+	global_scope.scope_namespace->push(Get_DoubleArrayValue_ObjectDef(),0);
+	global_scope.scope_namespace->push(Get_FlatvectorArrayValue_ObjectDef(),0);
 
 	//global_scope.scope_namespace->push(Get_BooleanValue_ObjectDef(),0);
 	//global_scope.scope_namespace->push(Get_IntValue_ObjectDef(),0);
@@ -4537,6 +4853,18 @@ void LaidoutCalculator::InstallInnate()
     innates->pushFunction("transpose",NULL,_("transpose of an array"),                  this, "a",NULL,NULL,NULL,NULL,NULL, NULL); // "array");
     innates->pushFunction("inverse",  NULL,_("inverse of square array"),                this, "x",NULL,NULL,NULL,NULL,NULL, NULL); // "array");
     innates->pushFunction("random",   NULL,_("Return a random number from 0 to 1"),     this, NULL);
+    innates->pushFunction("doubles",  NULL,_("Packed array of n reals, start + i*step, or copied from values"), this,
+									   "n",    NULL,NULL,"int",   NULL,NULL,
+									   "start",NULL,NULL,"number",NULL,NULL,
+									   "step", NULL,NULL,"number",NULL,NULL,
+									   "values",NULL,NULL,"any",  NULL,NULL,
+									   NULL);
+    innates->pushFunction("points",   NULL,_("Packed array of n flatvectors, made from x and y arrays or numbers, or copied from values"), this,
+									   "n",    NULL,NULL,"int",   NULL,NULL,
+									   "x",    NULL,NULL,"any",   NULL,NULL,
+									   "y",    NULL,NULL,"any",   NULL,NULL,
+									   "values",NULL,NULL,"any",  NULL,NULL,
+									   NULL);
     innates->pushFunction("randomint",NULL,_("Return a random integer from min to max"),this, // "min:int, max:int");
 									   "min",NULL,NULL,"int",NULL,NULL,
 									   "max",NULL,NULL,"int",NULL,NULL,
@@ -4569,6 +4897,14 @@ int LaidoutCalculator::Evaluate(const char *word,int len, ValueHash *context, Va
 	if (len==1 && !strncmp(word,"e",1))   { *value_ret=new DoubleValue(exp(1));        return 0; }
 	if (len==3 && !strncmp(word,"tau",3)) { *value_ret=new DoubleValue((1+sqrt(5))/2); return 0; }
 
+	 //packed array constructors
+	if ((len==7 && !strncmp(word,"doubles",7)) || (len==6 && !strncmp(word,"points",6))) {
+		ErrorLog locallog;
+		ErrorLog &log=(Log ? *Log : locallog);
+		if (*word=='d') return NewDoubleArrayValue(context,pp,value_ret,log);
+		return NewFlatvectorArrayValue(context,pp,value_ret,log);
+	}
+
 	if (pp==NULL || pp->n()==0) {
 		if (len==6 && !strncmp(word,"random",6)) { *value_ret=new DoubleValue(random()/(double)RAND_MAX); return 0; }
 		return -1;
@@ -4732,6 +5068,10 @@ int LaidoutCalculator::Op(const char *the_op,int len, int dir, Value *num1, Valu
 			else if (num1->type()==VALUE_Real) *value_ret= new DoubleValue(-dynamic_cast<DoubleValue*>(num1)->d);
 			else if (num1->type()==VALUE_Flatvector) *value_ret= new FlatvectorValue(-dynamic_cast<FlatvectorValue*>(num1)->v);
 			else if (num1->type()==VALUE_Spacevector) *value_ret= new SpacevectorValue(-dynamic_cast<SpacevectorValue*>(num1)->v);
+			else if (num1->type()==VALUE_DoubleArray || num1->type()==VALUE_FlatvectorArray) {
+				IntValue minusone(-1);
+				ArrayValueOp('*',num1,&minusone, value_ret);
+			}
 			if (*value_ret) return 0;
 			return -1; //can't negative that type
 		}
@@ -4798,31 +5138,34 @@ int LaidoutCalculator::add(Value *num1,Value *num2, Value **ret)
 
 	if (num1==NULL) { return -1; }
 	if (num2==NULL) { return -1; }
+	int t1=num1->type(), t2=num2->type();
+	if (t1==VALUE_DoubleArray || t1==VALUE_FlatvectorArray || t2==VALUE_DoubleArray || t2==VALUE_FlatvectorArray)
+		return ArrayValueOp('+',num1,num2, ret);
 //	if (strcmp(num1->units,num2->units)) {
 //		 //must correct units
 //		***
 //		if one has units, but the other doesn't, then assume same units
 //	}
 
-	if (num1->type()==VALUE_Int && num2->type()==VALUE_Int) { //i+i
+	if (t1==VALUE_Int && t2==VALUE_Int) { //i+i
 		*ret=new IntValue(((IntValue *) num1)->i+((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Int) { //d+i
+	} else if (t1==VALUE_Real && t2==VALUE_Int) { //d+i
 		*ret=new DoubleValue(((DoubleValue *) num1)->d+(double)((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Int && num2->type()==VALUE_Real) { //i+d
+	} else if (t1==VALUE_Int && t2==VALUE_Real) { //i+d
 		*ret=new DoubleValue(((DoubleValue *) num2)->d+(double)((IntValue*)num1)->i);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Real) { //d+d
+	} else if (t1==VALUE_Real && t2==VALUE_Real) { //d+d
 		*ret=new DoubleValue(((DoubleValue *) num1)->d+((DoubleValue*)num2)->d);
 
-	} else if (num1->type()==VALUE_Flatvector && num2->type()==VALUE_Flatvector) { //fv+fv
+	} else if (t1==VALUE_Flatvector && t2==VALUE_Flatvector) { //fv+fv
 		*ret=new FlatvectorValue(((FlatvectorValue *) num1)->v+((FlatvectorValue*)num2)->v);
 
-	} else if (num1->type()==VALUE_Spacevector && num2->type()==VALUE_Spacevector) { //sv+sv
+	} else if (t1==VALUE_Spacevector && t2==VALUE_Spacevector) { //sv+sv
 		*ret=new SpacevectorValue(((SpacevectorValue *) num1)->v+((SpacevectorValue*)num2)->v);
 
-	} else if (num1->type()==VALUE_String && num2->type()==VALUE_String) {
+	} else if (t1==VALUE_String && t2==VALUE_String) {
 		char str[strlen(((StringValue *)num1)->str) + strlen(((StringValue *)num1)->str) + 1];
 		strcpy(str,((StringValue *)num1)->str);
 		strcat(str,((StringValue *)num2)->str);
@@ -4840,28 +5183,31 @@ int LaidoutCalculator::subtract(Value *num1,Value *num2, Value **ret)
 
 	if (num1==NULL) { return -1; }
 	if (num2==NULL) { return -1; }
+	int t1=num1->type(), t2=num2->type();
+	if (t1==VALUE_DoubleArray || t1==VALUE_FlatvectorArray || t2==VALUE_DoubleArray || t2==VALUE_FlatvectorArray)
+		return ArrayValueOp('-',num1,num2, ret);
 //	if (strcmp(num1->units,num2->units)) {
 //		 //must correct units
 //		***
 //		if one has units, but the other doesn't, then assume same units
 //	}
 
-	if (num1->type()==VALUE_Int && num2->type()==VALUE_Int) { //i+i
+	if (t1==VALUE_Int && t2==VALUE_Int) { //i+i
 		*ret=new IntValue(((IntValue *) num1)->i-((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Int) { //d+i
+	} else if (t1==VALUE_Real && t2==VALUE_Int) { //d+i
 		*ret=new DoubleValue(((DoubleValue *) num1)->d-(double)((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Int && num2->type()==VALUE_Real) { //i+d
+	} else if (t1==VALUE_Int && t2==VALUE_Real) { //i+d
 		*ret=new DoubleValue((double)(((IntValue *) num1)->i)-((DoubleValue*)num2)->d);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Real) { //d+d
+	} else if (t1==VALUE_Real && t2==VALUE_Real) { //d+d
 		*ret=new DoubleValue(((DoubleValue *) num1)->d-((DoubleValue*)num2)->d);
 
-	} else if (num1->type()==VALUE_Flatvector && num2->type()==VALUE_Flatvector) { //fv+fv
+	} else if (t1==VALUE_Flatvector && t2==VALUE_Flatvector) { //fv+fv
 		*ret=new FlatvectorValue(((FlatvectorValue *) num1)->v-((FlatvectorValue*)num2)->v);
 
-	} else if (num1->type()==VALUE_Spacevector && num2->type()==VALUE_Spacevector) { //sv+sv
+	} else if (t1==VALUE_Spacevector && t2==VALUE_Spacevector) { //sv+sv
 		*ret=new SpacevectorValue(((SpacevectorValue *) num1)->v-((SpacevectorValue*)num2)->v);
 	}
 
@@ -4876,55 +5222,58 @@ int LaidoutCalculator::multiply(Value *num1,Value *num2, Value **ret)
 
 	if (num1==NULL) { return -1; }
 	if (num2==NULL) { return -1; }
+	int t1=num1->type(), t2=num2->type();
+	if (t1==VALUE_DoubleArray || t1==VALUE_FlatvectorArray || t2==VALUE_DoubleArray || t2==VALUE_FlatvectorArray)
+		return ArrayValueOp('*',num1,num2, ret);
 //	if (strcmp(num1->units,num2->units)) {
 //		 //must correct units
 //		***
 //		if one has units, but the other doesn't, then assume same units
 //	}
 
-	if (num1->type()==VALUE_Int && num2->type()==VALUE_Int) { //i+i
+	if (t1==VALUE_Int && t2==VALUE_Int) { //i+i
 		*ret=new IntValue(((IntValue *) num1)->i * ((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Int) { //d+i
+	} else if (t1==VALUE_Real && t2==VALUE_Int) { //d+i
 		*ret=new DoubleValue(((DoubleValue *) num1)->d * (double)((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Int && num2->type()==VALUE_Real) { //i+d
+	} else if (t1==VALUE_Int && t2==VALUE_Real) { //i+d
 		*ret=new DoubleValue(((DoubleValue *) num2)->d * (double)((IntValue*)num1)->i);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Real) { //d+d
+	} else if (t1==VALUE_Real && t2==VALUE_Real) { //d+d
 		*ret=new DoubleValue(((DoubleValue *) num1)->d * ((DoubleValue*)num2)->d);
 
 
-	} else if ((num1->type()==VALUE_Real || num1->type()==VALUE_Int) && num2->type()==VALUE_Flatvector) { //i*v
+	} else if ((t1==VALUE_Real || t1==VALUE_Int) && t2==VALUE_Flatvector) { //i*v
 		*ret=new FlatvectorValue(((FlatvectorValue *) num2)->v * ((IntValue*)num1)->i);
 
-	} else if ((num1->type()==VALUE_Real || num1->type()==VALUE_Int) && num2->type()==VALUE_Flatvector) { //d*v
+	} else if ((t1==VALUE_Real || t1==VALUE_Int) && t2==VALUE_Flatvector) { //d*v
 		*ret=new FlatvectorValue(((FlatvectorValue *) num2)->v * ((DoubleValue*)num1)->d);
 
-	} else if ((num2->type()==VALUE_Real || num2->type()==VALUE_Int) && num1->type()==VALUE_Flatvector) { //v*i
+	} else if ((t2==VALUE_Real || t2==VALUE_Int) && t1==VALUE_Flatvector) { //v*i
 		*ret=new FlatvectorValue(((FlatvectorValue *) num1)->v * ((IntValue*)num2)->i);
 
-	} else if ((num2->type()==VALUE_Real || num2->type()==VALUE_Int) && num1->type()==VALUE_Flatvector) { //v*d
+	} else if ((t2==VALUE_Real || t2==VALUE_Int) && t1==VALUE_Flatvector) { //v*d
 		*ret=new FlatvectorValue(((FlatvectorValue *) num1)->v * ((DoubleValue*)num2)->d);
 
-	} else if (num1->type()==VALUE_Flatvector && num2->type()==VALUE_Flatvector) { //v*v 2-d
+	} else if (t1==VALUE_Flatvector && t2==VALUE_Flatvector) { //v*v 2-d
 		 //dot product
 		*ret=new DoubleValue(((FlatvectorValue *) num1)->v * ((FlatvectorValue*)num2)->v);
 
 
-	} else if ((num1->type()==VALUE_Real || num1->type()==VALUE_Int) && num2->type()==VALUE_Spacevector) { //i*v
+	} else if ((t1==VALUE_Real || t1==VALUE_Int) && t2==VALUE_Spacevector) { //i*v
 		*ret=new SpacevectorValue(((SpacevectorValue *) num2)->v * ((IntValue*)num1)->i);
 
-	} else if ((num1->type()==VALUE_Real || num1->type()==VALUE_Int) && num2->type()==VALUE_Spacevector) { //d*v
+	} else if ((t1==VALUE_Real || t1==VALUE_Int) && t2==VALUE_Spacevector) { //d*v
 		*ret=new SpacevectorValue(((SpacevectorValue *) num2)->v * ((DoubleValue*)num1)->d);
 
-	} else if ((num2->type()==VALUE_Real || num2->type()==VALUE_Int) && num1->type()==VALUE_Spacevector) { //v*i
+	} else if ((t2==VALUE_Real || t2==VALUE_Int) && t1==VALUE_Spacevector) { //v*i
 		*ret=new SpacevectorValue(((SpacevectorValue *) num1)->v * ((IntValue*)num2)->i);
 
-	} else if ((num2->type()==VALUE_Real || num2->type()==VALUE_Int) && num1->type()==VALUE_Spacevector) { //v*d
+	} else if ((t2==VALUE_Real || t2==VALUE_Int) && t1==VALUE_Spacevector) { //v*d
 		*ret=new SpacevectorValue(((SpacevectorValue *) num1)->v * ((DoubleValue*)num2)->d);
 
-	} else if (num1->type()==VALUE_Spacevector && num2->type()==VALUE_Spacevector) { //v*v 3-d
+	} else if (t1==VALUE_Spacevector && t2==VALUE_Spacevector) { //v*v 3-d
 		 //dot product
 		*ret=new DoubleValue(((SpacevectorValue *) num1)->v * ((SpacevectorValue*)num2)->v);
 	}
@@ -4939,6 +5288,9 @@ int LaidoutCalculator::divide(Value *num1,Value *num2, Value **ret)
 
 	if (num1==NULL) { return -1; }
 	if (num2==NULL) { return -1; }
+	int t1=num1->type(), t2=num2->type();
+	if (t1==VALUE_DoubleArray || t1==VALUE_FlatvectorArray || t2==VALUE_DoubleArray || t2==VALUE_FlatvectorArray)
+		return ArrayValueOp('/',num1,num2, ret);
 
 //	if (strcmp(num1->units,num2->units)) {
 //		 //must correct units
@@ -4947,8 +5299,8 @@ int LaidoutCalculator::divide(Value *num1,Value *num2, Value **ret)
 //	}
 
 	double divisor;
-	if (num2->type()==VALUE_Int) divisor=((IntValue*)num2)->i;
-	else if (num2->type()==VALUE_Real) divisor=((DoubleValue*)num2)->d;
+	if (t2==VALUE_Int) divisor=((IntValue*)num2)->i;
+	else if (t2==VALUE_Real) divisor=((DoubleValue*)num2)->d;
 	else return -1; //throw _("Cannot divide with that type");
 
 	if (divisor==0) {
@@ -4956,20 +5308,20 @@ int LaidoutCalculator::divide(Value *num1,Value *num2, Value **ret)
 		return 1;
 	}
 
-	if (num1->type()==VALUE_Int && num2->type()==VALUE_Int) { // i/i
+	if (t1==VALUE_Int && t2==VALUE_Int) { // i/i
 		if (((IntValue *) num1)->i % ((IntValue*)num2)->i == 0) {
 			*ret=new IntValue(((IntValue *) num1)->i / ((IntValue*)num2)->i);
 		} else {
 			*ret=new DoubleValue(((double)((IntValue *) num1)->i)/((IntValue*)num2)->i);
 		}
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Int) { // d/i
+	} else if (t1==VALUE_Real && t2==VALUE_Int) { // d/i
 		*ret=new DoubleValue(((DoubleValue *) num1)->d / (double)((IntValue*)num2)->i);
 
-	} else if (num1->type()==VALUE_Int && num2->type()==VALUE_Real) { // i/d
+	} else if (t1==VALUE_Int && t2==VALUE_Real) { // i/d
 		*ret=new DoubleValue((double)((IntValue*)num1)->i / ((DoubleValue *) num2)->d);
 
-	} else if (num1->type()==VALUE_Real && num2->type()==VALUE_Real) { // d/d
+	} else if (t1==VALUE_Real && t2==VALUE_Real) { // d/d
 		*ret=new DoubleValue(((DoubleValue *) num1)->d / ((DoubleValue*)num2)->d);
 	} 
 
@@ -50,6 +50,48 @@ class CalcSettings
 };
 
 
+//----------------------------- ScriptCache -------------------------------------
+class Entry;
+class NameLookup
+{
+ public:
+	unsigned long generation; //BlockInfo::generation this was found at, or 0 for not looked up
+	int len;
+	int scope;
+	int index; //in the scope's dict
+	Entry *entry;
+};
+
+class ScriptCache
+{
+ public:
+	char *text;
+	int textlen;  //strlen(text)
+	int exprslen; //curexprslen this was made for
+	unsigned long hash;
+	unsigned long last_used;
+	int in_use;   //nonzero while a nested evaluate() will return to this, so it must not be evicted
+	int ops_generation;
+
+	 //per character position tables, allocated as needed, -1 for not scanned yet
+	int *ws_end, *ws_lines;       //skipwscomment()
+	int *name_len;                //getnamestringlen()
+	int *op_len;                  //getopstring(), after whitespace
+	unsigned int *op_levels;      //bit i set if oplevels.e[i] has the op at this position
+	int *block_end, *block_lines; //skipBlock()
+	char *block_ch;
+	int *int_end;   long *int_value;    //intnumber()
+	int *real_end;  double *real_value; //realnumber()
+	NameLookup *names;                  //findNameEntry()
+
+	ScriptCache(const char *ntext, int nexprslen, unsigned long nhash);
+	~ScriptCache();
+	static unsigned long Hash(const char *str);
+	int *Table(int *&table);
+	void ClearOps();
+};
+
+
 //---------------------------------- OperatorLevel/OperatorFunction ------------------------------------------
 
 class OperatorFunction
@@ -117,6 +159,8 @@ class BlockInfo
 	CalculatorModule *scope_namespace;
 	Value *scope_object;
 	Laxkit::RefPtrStack<Entry> dict; //stores potentially overloaded names, and imported names
+	NameIndex nameindex; //for dict lookups
+	static unsigned long generation; //changes whenever names visible through scopes change
 
 	BlockTypes type; //one of BlockTypes
 	int start_of_condition; //while
@@ -135,7 +179,8 @@ class BlockInfo
 	virtual const char *BlockType();
 	virtual int AddValue(const char *name, Value *v);
 	virtual int AddName(CalculatorModule *mod, ObjectDef *item, Value *container_v);
-	virtual Entry *FindName(const char *name,int len);
+	virtual int FindIndex(const char *name,int len);
+	virtual Entry *FindName(const char *name,int len, int *index_ret=NULL);
 	virtual Entry *createNewEntry(ObjectDef *item, CalculatorModule *module, Value *container_v);
 	virtual int isSameEntry(ObjectDef *item, Entry *entry);
 };
@@ -153,6 +198,10 @@ class LaidoutCalculator : public Laxkit::anObject, public OpFuncEvaluator, publi
 	int curline;
 	char *curexprs;
 	int curexprslen;
+	ScriptCache *scriptcache; //scan results for curexprs
+	Laxkit::PtrStack<ScriptCache> scriptcaches;
+	unsigned long scriptcache_tick;
+	int ops_generation;
 
 	 //settings
 	CalcSettings calcsettings;
@@ -189,6 +238,9 @@ class LaidoutCalculator : public Laxkit::anObject, public OpFuncEvaluator, publi
 	void skipwscomment();
 	void skipstring();
 	void skipBlock(char ch);
+	void scanBlock(char ch);
+	ScriptCache *findScriptCache();
+	bool opAtLevel(int n, int level);
 	void skipRemainingBlock(char ch);
 	void skipExpression();
 	int nextchar(char ch);
@@ -17,6 +17,7 @@
 
 #include "values.h"
 #include "../language.h"
+#include "../profiler.h"
 
 #include <lax/strmanip.h>
 #include <lax/fileutils.h>
@@ -27,6 +28,9 @@
 #include <cstdlib>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
+#include <new>
+#include <pthread.h>
 #include <iostream>
 
 #define DBG
@@ -84,6 +88,8 @@ const char *element_TypeNames(int type)
 	if (type==VALUE_Function)    return "function";
 	if (type==VALUE_Namespace)   return "namespace";
 	if (type==VALUE_LValue)      return "lvalue";
+	if (type==VALUE_DoubleArray)     return "DoubleArray";
+	if (type==VALUE_FlatvectorArray) return "FlatvectorArray";
 
 	return "";
 }
@@ -115,6 +121,8 @@ const char *valueEnumCodeName(int format)
 	if (format==VALUE_Array)       return "VALUE_Array";
 	if (format==VALUE_Hash)        return "VALUE_Hash";
 	if (format==VALUE_LValue)      return "VALUE_LValue";
+	if (format==VALUE_DoubleArray)     return "VALUE_DoubleArray";
+	if (format==VALUE_FlatvectorArray) return "VALUE_FlatvectorArray";
 	return "";
 }
 
@@ -152,6 +160,8 @@ ValueTypes element_NameToType(const char *type)
 	if (!strcmp(type,"function"))    return VALUE_Function;
 	if (!strcmp(type,"namespace"))   return VALUE_Namespace;
 	if (!strcmp(type,"lvalue"))      return VALUE_LValue;
+	if (!strcmp(type,"DoubleArray"))     return VALUE_DoubleArray;
+	if (!strcmp(type,"FlatvectorArray")) return VALUE_FlatvectorArray;
 
 	return VALUE_Fields;
 }
@@ -1341,13 +1351,115 @@ int ObjectDef::findFieldOfThis(const char *fname,char **next) // next=NULL
 
 
 
+//---------------------------------------- NameIndex --------------------------------------
+/*! \class NameIndex
+ * \brief Open addressing hash from names to indices in some other stack.
+ *
+ * This does not own the names. The owner must Clear() it, or set valid=0 and rebuild
+ * later, whenever names are removed, renamed, or shifted to other indices. Appending
+ * to the end of the owner's stack can just be followed by Add().
+ *
+ * Used by ValueHash and BlockInfo for fast lookups, while their stacks keep their
+ * original order.
+ */
+
+NameIndex::NameIndex()
+{
+	slots=NULL;
+	size=count=0;
+	valid=0;
+}
+
+NameIndex::~NameIndex()
+{
+	delete[] slots;
+}
+
+//! FNV-1a hash of the first len characters of name. If len<0, use strlen(name).
+unsigned int NameIndex::Hash(const char *name, int len)
+{
+	unsigned int h=2166136261U;
+	if (len<0) len=strlen(name);
+	for (int c=0; c<len; c++) { h^=(unsigned char)name[c]; h*=16777619U; }
+	return h;
+}
+
+//! Remove all names, and set valid=0. Allocated space is kept.
+void NameIndex::Clear()
+{
+	for (int c=0; c<size; c++) slots[c].name=NULL;
+	count=0;
+	valid=0;
+}
+
+//! Add name for index. If name is already there, the old index is kept.
+void NameIndex::Add(const char *name, int index)
+{
+	if (!name) return;
+
+	if (4*(count+1)>3*size) {
+		 //grow and rehash
+		NameSlot *old=slots;
+		int oldsize=size;
+		size=(size ? 2*size : 16);
+		slots=new NameSlot[size];
+		for (int c=0; c<size; c++) slots[c].name=NULL;
+		count=0;
+		for (int c=0; c<oldsize; c++) {
+			if (!old[c].name) continue;
+			int i=old[c].hash&(size-1);
+			while (slots[i].name) i=(i+1)&(size-1);
+			slots[i]=old[c];
+			count++;
+		}
+		delete[] old;
+	}
+
+	unsigned int hash=Hash(name,-1);
+	int i=hash&(size-1);
+	while (slots[i].name) {
+		if (slots[i].hash==hash && !strcmp(slots[i].name,name)) return;
+		i=(i+1)&(size-1);
+	}
+	slots[i].name=name;
+	slots[i].hash=hash;
+	slots[i].index=index;
+	count++;
+}
+
+//! Return the index for the first len characters of name, or -1 if not found.
+/*! If len<0, use strlen(name).
+ */
+int NameIndex::Find(const char *name, int len)
+{
+	if (!size || !name) return -1;
+	if (len<0) len=strlen(name);
+
+	unsigned int hash=Hash(name,len);
+	int i=hash&(size-1);
+	while (slots[i].name) {
+		if (slots[i].hash==hash && !strncmp(slots[i].name,name,len) && slots[i].name[len]=='\0')
+			return slots[i].index;
+		i=(i+1)&(size-1);
+	}
+	return -1;
+}
+
+
 //---------------------------------------- ValueHash --------------------------------------
 /*! \class ValueHash
  * \brief Class to aid parsing of functions.
  *
  * Used in LaidoutCalculator.
+ *
+ * Keys stay in the order they were pushed. Once there are more than a few, lookups by
+ * name go through a NameIndex, which is rebuilt as needed after keys are removed,
+ * renamed, or moved around.
  */
 
+//! Below this many keys, findIndex() just checks each one.
+#define VALUEHASH_MIN_INDEXED 8
+
 
 ValueHash::ValueHash()
 	: keys(2)
@@ -1581,6 +1693,7 @@ int ValueHash::Evaluate(const char *func,int len, ValueHash *context, ValueHash
 			keys.remove(pos);
 			set->Push(values.e[pos],0);
 			values.remove(pos);
+			index.valid=0;
 			*value_ret=set;
 			return 0;
 		}
@@ -1607,6 +1720,7 @@ int ValueHash::Evaluate(const char *func,int len, ValueHash *context, ValueHash
 			 //push(pop(p1),p2)
 			char *key=keys.pop(pos);
 			Value *value=values.pop(pos);
+			index.valid=0;
 			push(key,value);
 			value->dec_count();
 		}
@@ -1646,6 +1760,7 @@ int ValueHash::flush()
 {
 	keys.flush();
 	values.flush();
+	index.Clear();
 	return 0;
 }
 
@@ -1720,6 +1835,8 @@ int ValueHash::push(const char *name,Value *v,int where)
 	}
 
 	keys.push(newstr(name),-1,where);
+	if (where==keys.n-1) { if (index.valid) index.Add(keys.e[where],where); }
+	else index.valid=0;
 	return values.push(v,-1,where);
 }
 
@@ -1739,6 +1856,7 @@ int ValueHash::remove(int i)
 	if (i<0 || i>=keys.n) return 1;
 	keys.remove(i);
 	values.remove(i);
+	index.valid=0;
 	return 0;
 }
 
@@ -1757,6 +1875,7 @@ void ValueHash::swap(int i1, int i2)
 	if (i1<0 || i1>keys.n || i2<0 || i2>keys.n) return;
 	keys.swap(i1,i2);
 	values.swap(i1,i2);
+	index.valid=0;
 }
 
 //! Return name of key at index i.
@@ -1778,6 +1897,7 @@ void ValueHash::renameKey(int i,const char *newname)
 {
 	if (i<0 || i>=keys.n) return;
 	makestr(keys.e[i],newname);
+	index.valid=0;
 }
 
 /*! Set value of an existing key. Return 0 for success, or nonzero for error such as key not found.
@@ -1803,25 +1923,36 @@ int ValueHash::set(int which, Value *newv)
 }
 
 //! Return the index corresponding to name, or -1 if not found.
+/*! len is how much of name to use. -1 means use all of name.
+ * The key must match those characters exactly, not just start with them.
+ */
 int ValueHash::findIndex(const char *name,int len)
 {
 	if (!name) return -1;
 	if (len<0) len = strlen(name);
-	for (int c=0; c<keys.n; c++) {
-		if (len<0 && !strcmp(name,keys.e[c])) return c;
-		if (len>0 && !strncmp(name,keys.e[c],len)) return c;
+
+	if (keys.n<VALUEHASH_MIN_INDEXED) {
+		for (int c=0; c<keys.n; c++) {
+			if (keys.e[c] && !strncmp(name,keys.e[c],len) && keys.e[c][len]=='\0') return c;
+		}
+		return -1;
 	}
-	return -1;
+
+	if (!index.valid) {
+		index.Clear();
+		for (int c=0; c<keys.n; c++) index.Add(keys.e[c],c);
+		index.valid=1;
+	}
+	return index.Find(name,len);
 }
 
 /*! Return the Value object for key==name.
  */
 Value *ValueHash::find(const char *name)
 {
-	for (int c=0; c<keys.n; c++) {
-		if (!strcmp(name,keys.e[c])) return values.e[c];
-	}
-	return NULL;
+	int i=findIndex(name);
+	if (i<0) return NULL;
+	return values.e[i];
 }
 
 /*! If which>=0 then interpret that Value and ignore name.
@@ -1972,6 +2103,231 @@ Laxkit::anObject *ValueHash::findObject(const char *name, int which, int *error_
 	return o->object;
 }
 
+//------------------------------------- PooledValue ---------------------------------------
+/*! \class PooledValue
+ * \brief Inherit from this to have small Value objects allocated from per thread slabs.
+ *
+ * Calculator arithmetic creates and destroys IntValue, DoubleValue, and friends for
+ * every intermediate result. Rather than go to the general allocator each time,
+ * objects are carved from slabs, one size class per slab, and freed objects go back to
+ * the free list of their slab. A slab is given back to the system when all its objects
+ * are freed, unless it is the last one of its size class with room in it.
+ *
+ * Each slab belongs to the thread that made it, and only that thread touches its free list.
+ * Objects freed in another thread are queued for the owning thread, which takes
+ * them back the next time it allocates that size. When a thread exits, objects still
+ * out from its slabs are returned directly by whichever thread frees them.
+ */
+
+#define VALUEPOOL_GRAIN      16    //bytes per size class
+#define VALUEPOOL_CLASSES    32    //so objects up to 512 bytes are pooled
+#define VALUEPOOL_SLAB_SIZE  16384 //must be a power of 2, slabs are aligned to it
+
+class PoolFreeNode
+{
+  public:
+	PoolFreeNode *next;
+};
+
+class PoolThread;
+
+//! Header at the start of each slab, so any object can find its slab by masking its address.
+class PoolSlab
+{
+  public:
+	PoolThread *owner;
+	PoolSlab *prev, *next; //in owner->slabs, only while there are free nodes
+	PoolFreeNode *free;
+	int sizeclass;
+	int used;
+	int listed;
+};
+
+class PoolThread
+{
+  public:
+	PoolSlab *slabs[VALUEPOOL_CLASSES]; //slabs with room
+	PoolFreeNode *volatile remote[VALUEPOOL_CLASSES]; //freed by other threads, guarded by valuepool_mutex
+	long numslabs;
+	int exited;
+};
+
+static pthread_mutex_t valuepool_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t valuepool_once=PTHREAD_ONCE_INIT;
+static pthread_key_t valuepool_key;
+static __thread PoolThread *valuepool_thread=NULL;
+
+static PoolSlab *valuepool_slab(void *p)
+{
+	return (PoolSlab*)((unsigned long)p & ~(unsigned long)(VALUEPOOL_SLAB_SIZE-1));
+}
+
+static void valuepool_link(PoolThread *t, PoolSlab *slab)
+{
+	slab->prev=NULL;
+	slab->next=t->slabs[slab->sizeclass];
+	if (slab->next) slab->next->prev=slab;
+	t->slabs[slab->sizeclass]=slab;
+	slab->listed=1;
+}
+
+static void valuepool_unlink(PoolThread *t, PoolSlab *slab)
+{
+	if (slab->prev) slab->prev->next=slab->next;
+	else t->slabs[slab->sizeclass]=slab->next;
+	if (slab->next) slab->next->prev=slab->prev;
+	slab->prev=slab->next=NULL;
+	slab->listed=0;
+}
+
+static PoolSlab *valuepool_newslab(PoolThread *t, int sizeclass)
+{
+	void *mem=NULL;
+	if (posix_memalign(&mem,VALUEPOOL_SLAB_SIZE,VALUEPOOL_SLAB_SIZE)) throw std::bad_alloc();
+
+	PoolSlab *slab=(PoolSlab*)mem;
+	slab->owner=t;
+	slab->sizeclass=sizeclass;
+	slab->used=0;
+	slab->free=NULL;
+
+	 //first chunks are taken by the header
+	int chunk=(sizeclass+1)*VALUEPOOL_GRAIN;
+	int first=(sizeof(PoolSlab)+chunk-1)/chunk;
+	for (int c=VALUEPOOL_SLAB_SIZE/chunk-1; c>=first; c--) {
+		PoolFreeNode *node=(PoolFreeNode*)((char*)mem+c*chunk);
+		node->next=slab->free;
+		slab->free=node;
+	}
+
+	t->numslabs++;
+	valuepool_link(t,slab);
+	return slab;
+}
+
+//! Put node back in slab, and release slab if it is empty and there is another with room.
+/*! Must be called from the thread that owns slab, or with valuepool_mutex held if the owner exited.
+ */
+static void valuepool_return(PoolThread *t, PoolSlab *slab, PoolFreeNode *node)
+{
+	node->next=slab->free;
+	slab->free=node;
+	slab->used--;
+	if (!slab->listed) valuepool_link(t,slab);
+
+	if (slab->used==0 && (t->exited || slab->prev || slab->next)) {
+		valuepool_unlink(t,slab);
+		free(slab);
+		t->numslabs--;
+	}
+}
+
+//! Take back what other threads freed for sizeclass. Call from t's own thread.
+static void valuepool_drain(PoolThread *t, int sizeclass)
+{
+	pthread_mutex_lock(&valuepool_mutex);
+	PoolFreeNode *node=t->remote[sizeclass];
+	t->remote[sizeclass]=NULL;
+	pthread_mutex_unlock(&valuepool_mutex);
+
+	PoolFreeNode *next;
+	for ( ; node; node=next) {
+		next=node->next;
+		valuepool_return(t,valuepool_slab(node),node);
+	}
+}
+
+//! Thread exit. Release what can be released, and leave the rest to be freed by other threads.
+static void valuepool_thread_done(void *data)
+{
+	PoolThread *t=(PoolThread*)data;
+
+	pthread_mutex_lock(&valuepool_mutex);
+	t->exited=1;
+	for (int c=0; c<VALUEPOOL_CLASSES; c++) {
+		PoolFreeNode *node=t->remote[c], *next;
+		t->remote[c]=NULL;
+		for ( ; node; node=next) {
+			next=node->next;
+			valuepool_return(t,valuepool_slab(node),node);
+		}
+
+		PoolSlab *slab=t->slabs[c], *nexts;
+		for ( ; slab; slab=nexts) {
+			nexts=slab->next;
+			if (slab->used==0) {
+				valuepool_unlink(t,slab);
+				free(slab);
+				t->numslabs--;
+			}
+		}
+	}
+	int gone=(t->numslabs==0);
+	pthread_mutex_unlock(&valuepool_mutex);
+
+	if (gone) delete t;
+	valuepool_thread=NULL;
+}
+
+static void valuepool_makekey()
+{
+	pthread_key_create(&valuepool_key, valuepool_thread_done);
+}
+
+void *PooledValue::operator new(size_t size)
+{
+	int sizeclass=(size+VALUEPOOL_GRAIN-1)/VALUEPOOL_GRAIN - 1;
+	if (sizeclass<0) sizeclass=0;
+	if (sizeclass>=VALUEPOOL_CLASSES) return ::operator new(size);
+
+	PoolThread *t=valuepool_thread;
+	if (!t) {
+		pthread_once(&valuepool_once, valuepool_makekey);
+		t=new PoolThread;
+		memset(t,0,sizeof(PoolThread));
+		pthread_setspecific(valuepool_key,t);
+		valuepool_thread=t;
+	}
+
+	if (t->remote[sizeclass]) valuepool_drain(t,sizeclass);
+
+	PoolSlab *slab=t->slabs[sizeclass];
+	if (!slab) slab=valuepool_newslab(t,sizeclass);
+
+	PoolFreeNode *node=slab->free;
+	slab->free=node->next;
+	slab->used++;
+	if (!slab->free) valuepool_unlink(t,slab); //full
+	return node;
+}
+
+void PooledValue::operator delete(void *p, size_t size)
+{
+	if (!p) return;
+	int sizeclass=(size+VALUEPOOL_GRAIN-1)/VALUEPOOL_GRAIN - 1;
+	if (sizeclass<0) sizeclass=0;
+	if (sizeclass>=VALUEPOOL_CLASSES) { ::operator delete(p); return; }
+
+	PoolFreeNode *node=(PoolFreeNode*)p;
+	PoolSlab *slab=valuepool_slab(p);
+	PoolThread *owner=slab->owner;
+	if (owner==valuepool_thread) {
+		valuepool_return(owner,slab,node);
+		return;
+	}
+
+	pthread_mutex_lock(&valuepool_mutex);
+	if (owner->exited) {
+		valuepool_return(owner,slab,node);
+		if (owner->numslabs==0) delete owner;
+	} else {
+		node->next=owner->remote[sizeclass];
+		owner->remote[sizeclass]=node;
+	}
+	pthread_mutex_unlock(&valuepool_mutex);
+}
+
+
 //------------------------------------- Value ---------------------------------------
 /*! \class Value
  * \brief Base class of internal scripting objects.
@@ -1983,6 +2339,7 @@ Value::Value()
 {
 	modified=1;
 	objectdef=NULL;
+	Profiler::ValueCreated();
 }
 
 Value::~Value()
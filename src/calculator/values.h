@@ -73,6 +73,9 @@ enum ValueTypes {
 
 	VALUE_LValue,     //!< A name value that you can assign things to.
 
+	VALUE_DoubleArray,     //!< Packed list of reals
+	VALUE_FlatvectorArray, //!< Packed list of flatvectors
+
 	VALUE_MaxBuiltIn
 };
 
@@ -272,6 +275,15 @@ class ObjectDef : public Laxkit::anObject, public LaxFiles::DumpUtility
 typedef ObjectDef StyleDef;
 
 
+//----------------------------- PooledValue ----------------------------------
+class PooledValue
+{
+  public:
+	static void *operator new(size_t size);
+	static void operator delete(void *p, size_t size);
+};
+
+
 //----------------------------- Value ----------------------------------
 
 class Value : virtual public Laxkit::anObject, virtual public LaxFiles::DumpUtility
@@ -312,11 +324,39 @@ class Value : virtual public Laxkit::anObject, virtual public LaxFiles::DumpUtil
 };
 
 
+//----------------------------- NameIndex ----------------------------------
+class NameIndex
+{
+  protected:
+	class NameSlot
+	{
+	  public:
+		const char *name; //points to the owner's copy of the name
+		unsigned int hash;
+		int index;
+	};
+	NameSlot *slots;
+	int size;  //always a power of 2, or 0
+	int count;
+
+  public:
+	int valid;
+
+	NameIndex();
+	~NameIndex();
+	static unsigned int Hash(const char *name, int len);
+	void Clear();
+	void Add(const char *name, int index);
+	int Find(const char *name, int len);
+};
+
+
 //----------------------------- ValueHash ----------------------------------
-class ValueHash : virtual public Laxkit::anObject, virtual public Value, virtual public FunctionEvaluator
+class ValueHash : virtual public Laxkit::anObject, virtual public Value, virtual public FunctionEvaluator, public PooledValue
 {
 	Laxkit::PtrStack<char> keys;
 	Laxkit::RefPtrStack<Value> values;
+	NameIndex index;
 
   public:
 	ValueHash();
@@ -385,7 +425,7 @@ class GenericValue : public Value
 };
 
 //----------------------------- SetValue ----------------------------------
-class SetValue : public Value, virtual public FunctionEvaluator
+class SetValue : public Value, virtual public FunctionEvaluator, public PooledValue
 {
   public:
 	char *restrictto;
@@ -430,7 +470,7 @@ class ArrayValue : public SetValue
 };
 
 //----------------------------- NullValue ----------------------------------
-class NullValue : public Value
+class NullValue : public Value, public PooledValue
 {
   public:
 	NullValue() {}
@@ -442,7 +482,7 @@ class NullValue : public Value
 };
 
 //----------------------------- BooleanValue ----------------------------------
-class BooleanValue : public Value
+class BooleanValue : public Value, public PooledValue
 {
   public:
 	int i;
@@ -457,7 +497,7 @@ class BooleanValue : public Value
 };
 
 //----------------------------- IntValue ----------------------------------
-class IntValue : public Value
+class IntValue : public Value, public PooledValue
 {
   public:
 	Unit units;
@@ -472,7 +512,7 @@ class IntValue : public Value
 };
 
 //----------------------------- DoubleValue ----------------------------------
-class DoubleValue : public Value, virtual public FunctionEvaluator
+class DoubleValue : public Value, virtual public FunctionEvaluator, public PooledValue
 {
   public:
 	Unit units;
@@ -490,7 +530,7 @@ class DoubleValue : public Value, virtual public FunctionEvaluator
 };
 
 //----------------------------- FlatvectorValue ----------------------------------
-class FlatvectorValue : public Value, virtual public FunctionEvaluator
+class FlatvectorValue : public Value, virtual public FunctionEvaluator, public PooledValue
 {
   public:
 	Unit units;
@@ -510,7 +550,7 @@ class FlatvectorValue : public Value, virtual public FunctionEvaluator
 };
 
 //----------------------------- SpacevectorValue ----------------------------------
-class SpacevectorValue : public Value, virtual public FunctionEvaluator
+class SpacevectorValue : public Value, virtual public FunctionEvaluator, public PooledValue
 {
   public:
 	Unit units;
@@ -530,7 +570,7 @@ class SpacevectorValue : public Value, virtual public FunctionEvaluator
 };
 
 //----------------------------- StringValue ----------------------------------
-class StringValue : public Value, virtual public FunctionEvaluator
+class StringValue : public Value, virtual public FunctionEvaluator, public PooledValue
 {
   public:
 	char *str;
@@ -637,7 +677,7 @@ class ColorValue : public Value
 };
 
 //----------------------------- ObjectValue ----------------------------------
-class ObjectValue : public Value
+class ObjectValue : public Value, public PooledValue
 {
   public:
 	Laxkit::anObject *object;
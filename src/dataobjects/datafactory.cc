@@ -26,6 +26,7 @@
 #include "lcaptiondata.h"
 #include "ltextonpath.h"
 #include "lvoronoidata.h"
+#include "instancedclones.h"
 
 #include <lax/interfaces/interfacemanager.h>
 
@@ -115,6 +116,14 @@ Laxkit::anObject *createLSomeDataRef(int p, Laxkit::anObject *refobj)
 	return new LSomeDataRef();
 }
 
+//---------------------------- InstancedClones --------------------------------
+
+//! For somedatafactory.
+Laxkit::anObject *createInstancedClones(int p, Laxkit::anObject *refobj)
+{
+	return new InstancedClones();
+}
+
 //---------------------------- LEngraverFillData --------------------------------
 
 //! For somedatafactory.
@@ -167,6 +176,7 @@ void InitializeDataFactory()
 	lobjectfactory->DefineNewObject(LAX_IMAGEPATCHDATA,  "ImagePatchData",  createLImagePatchData,  NULL, 0);
 	lobjectfactory->DefineNewObject(LAX_COLORPATCHDATA,  "ColorPatchData",  createLColorPatchData,  NULL, 0);
 	lobjectfactory->DefineNewObject(LAX_SOMEDATAREF,     "SomeDataRef",     createLSomeDataRef,     NULL, 0);
+	lobjectfactory->DefineNewObject(LO_INSTANCEDCLONES,  "InstancedClones", createInstancedClones,  NULL, 0);
 	lobjectfactory->DefineNewObject(LAX_ENGRAVERFILLDATA,"EngraverFillData",createLEngraverFillData,NULL, 0);
 	lobjectfactory->DefineNewObject(LAX_CAPTIONDATA,     "CaptionData",     createLCaptionData,     NULL, 0);
 	lobjectfactory->DefineNewObject(LAX_TEXTONPATH,      "TextOnPath",      createLTextOnPath,      NULL, 0);
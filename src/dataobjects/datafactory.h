@@ -26,6 +26,7 @@ namespace Laidout {
 
 enum LaidoutDataObjects {
 	LO_MYSTERYDATA = LaxInterfaces::LAX_DATA_MAX,
+	LO_INSTANCEDCLONES,
 
 	LO_DATA_MAX
 };
@@ -21,6 +21,7 @@
 #include "../drawdata.h"
 #include "../language.h"
 #include "../stylemanager.h"
+#include "../profiler.h"
 
 #include <lax/refptrstack.cc>
 
@@ -1003,6 +1004,9 @@ void DrawableObject::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::Du
 	int foundconfig=0;
 	if (!strcmp(whattype(),"Group")) foundconfig=-1;
 
+	 //subclasses time themselves, so only plain groups get a scope here
+	ProfileScope profile("object",foundconfig==-1 ? "Group" : NULL);
+
 	for (int c=0; c<att->attributes.n; c++) {
 		name=att->attributes.e[c]->name;
 		value=att->attributes.e[c]->value;
@@ -22,6 +22,7 @@
 #include "../printing/epsutils.h"
 #include "../configured.h"
 #include "../language.h"
+#include "../profiler.h"
 
 #include <iostream>
 using namespace std;
@@ -130,6 +131,7 @@ void EpsData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *contex
  */
 void EpsData::dump_in_atts(Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	if (!att) return;
 	char *name,*value;
 	minx=miny=0;
@@ -0,0 +1,398 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+#include "instancedclones.h"
+#include "datafactory.h"
+#include "group.h"
+#include "../stylemanager.h"
+#include "../language.h"
+#include "../profiler.h"
+
+#include <lax/interfaces/somedataref.h>
+#include <lax/transformmath.h>
+#include <lax/misc.h>
+
+
+using namespace Laxkit;
+using namespace LaxFiles;
+using namespace LaxInterfaces;
+
+
+namespace Laidout {
+
+
+//------------------------------- InstancedClones ---------------------------------------
+/*! \class InstancedClones
+ * \brief Many clones of a few source objects, held as one object.
+ *
+ * Tilings can easily make tens of thousands of clones. Rather than a SomeDataRef
+ * for each one, this keeps the source objects once, plus a packed array of
+ * 6 doubles per instance, and the index of the source each instance uses.
+ *
+ * Like SomeDataRef, an instance transform replaces the source's own matrix, so
+ * an instance draws the contents of the source as if the source had an identity
+ * matrix, then applies the instance transform.
+ *
+ * Viewport drawing and pdf and svg export draw this by instancing. Other exporters
+ * do not know about it, and skip it. Expand() creates actual SomeDataRef objects in a Group,
+ * which the clone tool's Expand command puts in place of this for those cases.
+ */
+
+InstancedClones::InstancedClones()
+{
+	numsources=0;
+	sources=NULL;
+	source_ids=NULL;
+
+	numinstances=0;
+	maxinstances=0;
+	instance_sources=NULL;
+	transforms=NULL;
+}
+
+InstancedClones::~InstancedClones()
+{
+	Clear();
+	delete[] instance_sources;
+	delete[] transforms;
+}
+
+const char *InstancedClones::Id()
+{
+	if (!nameid) {
+		if (object_idstr) makestr(nameid,object_idstr);
+		else {
+			nameid=Laxkit::make_id("Clones");
+			makestr(object_idstr,nameid);
+		}
+	}
+	return nameid;
+}
+
+//! Remove all instances, but keep the sources.
+void InstancedClones::ClearInstances()
+{
+	numinstances=0;
+	maxx=minx-1;
+	maxy=miny-1;
+}
+
+//! Remove all instances and all sources.
+void InstancedClones::Clear()
+{
+	ClearInstances();
+	for (int c=0; c<numsources; c++) {
+		if (sources[c]) sources[c]->dec_count();
+		delete[] source_ids[c];
+	}
+	delete[] sources;
+	delete[] source_ids;
+	sources=NULL;
+	source_ids=NULL;
+	numsources=0;
+}
+
+//! Return the index of object in sources, adding it if necessary.
+/*! Clones of clones are resolved to the final object, as with SomeDataRef.
+ */
+int InstancedClones::AddSource(LaxInterfaces::SomeData *object)
+{
+	if (!object) return -1;
+	if (dynamic_cast<SomeDataRef*>(object)) object=dynamic_cast<SomeDataRef*>(object)->GetFinalObject();
+	if (!object) return -1;
+
+	for (int c=0; c<numsources; c++) {
+		if (sources[c]==object) return c;
+	}
+
+	int i=AddSourceId(object->Id());
+	sources[i]=object;
+	object->inc_count();
+	return i;
+}
+
+//! Add an unlinked source, which will need SetSource() before it gets drawn. Return its index.
+int InstancedClones::AddSourceId(const char *id)
+{
+	SomeData **ns=new SomeData*[numsources+1];
+	char **nid=new char*[numsources+1];
+	if (numsources) {
+		memcpy(ns,sources,numsources*sizeof(SomeData*));
+		memcpy(nid,source_ids,numsources*sizeof(char*));
+	}
+	delete[] sources;
+	delete[] source_ids;
+	sources=ns;
+	source_ids=nid;
+
+	sources[numsources]=NULL;
+	source_ids[numsources]=newstr(id);
+	return numsources++;
+}
+
+//! Link an object to a source read in from a file, which only has an id so far.
+/*! Return 0 for success, or nonzero for bad index.
+ */
+int InstancedClones::SetSource(int index, LaxInterfaces::SomeData *object)
+{
+	if (index<0 || index>=numsources || !object) return 1;
+	if (dynamic_cast<SomeDataRef*>(object)) object=dynamic_cast<SomeDataRef*>(object)->GetFinalObject();
+	if (!object) return 1;
+
+	object->inc_count();
+	if (sources[index]) sources[index]->dec_count();
+	sources[index]=object;
+	makestr(source_ids[index],object->Id());
+	return 0;
+}
+
+//! Return the source object, or NULL if index is out of range or the source is not linked yet.
+LaxInterfaces::SomeData *InstancedClones::Source(int index)
+{
+	if (index<0 || index>=numsources) return NULL;
+	return sources[index];
+}
+
+//! Return the id of the source, which is valid even if the source has not been linked yet.
+const char *InstancedClones::SourceId(int index)
+{
+	if (index<0 || index>=numsources) return NULL;
+	return source_ids[index];
+}
+
+//! Add an instance of sources[source] with transform m. Return the index of the new instance.
+/*! Does not update the bounding box. Call FindBBox() when done adding.
+ */
+int InstancedClones::AddInstance(int source, const double *m)
+{
+	if (source<0 || source>=numsources) return -1;
+
+	if (numinstances==maxinstances) {
+		maxinstances=(maxinstances ? 2*maxinstances : 64);
+		int *ni=new int[maxinstances];
+		double *nt=new double[6*maxinstances];
+		if (numinstances) {
+			memcpy(ni,instance_sources,numinstances*sizeof(int));
+			memcpy(nt,transforms,6*numinstances*sizeof(double));
+		}
+		delete[] instance_sources;
+		delete[] transforms;
+		instance_sources=ni;
+		transforms=nt;
+	}
+
+	instance_sources[numinstances]=source;
+	memcpy(transforms+6*numinstances,m,6*sizeof(double));
+	return numinstances++;
+}
+
+void InstancedClones::FindBBox()
+{
+	maxx=minx-1;
+	maxy=miny-1;
+
+	SomeData *source;
+	for (int c=0; c<numinstances; c++) {
+		source=sources[instance_sources[c]];
+		if (!source) continue;
+		addtobounds(transforms+6*c,source);
+	}
+}
+
+//! Return whether pp is in any of the instances. pp is in parent coordinates.
+int InstancedClones::pointin(flatpoint pp,int pin)
+{
+	if (!validbounds()) return 0;
+
+	double i[6];
+	transform_invert(i,m());
+	flatpoint p=transform_point(i,pp);
+	if (p.x<minx || p.x>maxx || p.y<miny || p.y>maxy) return 0;
+
+	SomeData *source;
+	flatpoint sp;
+	for (int c=0; c<numinstances; c++) {
+		source=sources[instance_sources[c]];
+		if (!source) continue;
+
+		 //map p into the source's parent space, which is what source->pointin() expects
+		transform_invert(i,transforms+6*c);
+		sp=transform_point(i,p);
+		sp=transform_point(source->m(),sp);
+		if (source->pointin(sp,pin)) return 1;
+	}
+	return 0;
+}
+
+//! Return a new Group containing a new SomeDataRef for each instance.
+/*! The group has the same matrix as this. Calling code must dec_count() the returned group.
+ */
+Group *InstancedClones::Expand()
+{
+	Group *group=dynamic_cast<Group*>(LaxInterfaces::somedatafactory()->NewObject("Group"));
+	group->m(m());
+
+	SomeDataRef *clone;
+	SomeData *source;
+	for (int c=0; c<numinstances; c++) {
+		source=sources[instance_sources[c]];
+		if (!source) continue;
+
+		clone=dynamic_cast<SomeDataRef*>(LaxInterfaces::somedatafactory()->NewObject("SomeDataRef"));
+		clone->Set(source,1); //the 1 means don't copy matrix also
+		clone->m(transforms+6*c);
+		clone->FindBBox();
+		group->push(clone);
+		clone->dec_count();
+	}
+
+	group->FindBBox();
+	return group;
+}
+
+/*! Return Expand(). Note that the exporters that call EquivalentObject(), pdf and svg,
+ * handle InstancedClones directly, so they do not use this.
+ */
+LaxInterfaces::SomeData *InstancedClones::EquivalentObject()
+{
+	return Expand();
+}
+
+void InstancedClones::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *context)
+{
+	char spc[indent+1]; memset(spc,' ',indent); spc[indent]='\0';
+	if (what==-1) {
+		DrawableObject::dump_out(f,indent,what,context);
+		fprintf(f,"%sconfig\n",spc);
+		SomeData::dump_out(f,indent+2,what,context);
+		fprintf(f,"%s  source objectid   #id of an object to clone. There can be any number of these.\n",spc);
+		fprintf(f,"%s  instances \\      #one instance per line, the index of its source (starting at 0),\n",spc);
+		fprintf(f,"%s    0  1 0 0 1 0 0 #followed by its transform\n",spc);
+		return;
+	}
+
+	DrawableObject::dump_out(f,indent,what,context);
+	fprintf(f,"%sconfig\n",spc);
+	SomeData::dump_out(f,indent+2,what,context);
+
+	for (int c=0; c<numsources; c++) {
+		fprintf(f,"%s  source %s\n",spc,source_ids[c]);
+	}
+
+	if (numinstances) {
+		fprintf(f,"%s  instances \\\n",spc);
+		double *t;
+		for (int c=0; c<numinstances; c++) {
+			t=transforms+6*c;
+			fprintf(f,"%s    %d  %.10g %.10g %.10g %.10g %.10g %.10g\n",spc,
+					instance_sources[c], t[0],t[1],t[2],t[3],t[4],t[5]);
+		}
+	}
+}
+
+/*! Sources are only read in as ids. They get linked later in Project::ClarifyRefs().
+ */
+void InstancedClones::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
+{
+	ProfileScope profile("object",whattype());
+	DrawableObject::dump_in_atts(att,flag,context);
+
+	Attribute *config=att->find("config");
+	if (!config) return;
+
+	Clear();
+	SomeData::dump_in_atts(config,flag,context);
+
+	char *name,*value;
+	for (int c=0; c<config->attributes.n; c++) {
+		name= config->attributes.e[c]->name;
+		value=config->attributes.e[c]->value;
+
+		if (!strcmp(name,"source")) {
+			if (!isblank(value)) AddSourceId(value);
+		}
+	}
+
+	const char *instances=config->findValue("instances");
+	if (instances) {
+		const char *t=instances;
+		char *e;
+		long s;
+		double m[6];
+		while (t && *t) {
+			s=strtol(t,&e,10);
+			if (e==t) break;
+			t=e;
+
+			int i;
+			for (i=0; i<6; i++) {
+				m[i]=strtod(t,&e);
+				if (e==t) break;
+				t=e;
+			}
+			if (i<6) break;
+
+			AddInstance(s,m);
+		}
+	}
+}
+
+LaxInterfaces::SomeData *InstancedClones::duplicate(LaxInterfaces::SomeData *dup)
+{
+	if (dup && !dynamic_cast<InstancedClones*>(dup)) return NULL; //wrong type for reference object!
+	if (!dup) dup=dynamic_cast<SomeData*>(LaxInterfaces::somedatafactory()->NewObject("InstancedClones"));
+	InstancedClones *i=dynamic_cast<InstancedClones*>(dup);
+
+	i->Clear();
+	for (int c=0; c<numsources; c++) {
+		i->AddSourceId(source_ids[c]);
+		if (sources[c]) i->SetSource(c,sources[c]);
+	}
+	for (int c=0; c<numinstances; c++) i->AddInstance(instance_sources[c],transforms+6*c);
+
+	i->m(m());
+	i->setbounds(minx,maxx,miny,maxy);
+	DrawableObject::duplicate(dup);
+	return dup;
+}
+
+Value *InstancedClones::duplicate()
+{
+	return dynamic_cast<Value*>(duplicate(NULL));
+}
+
+ObjectDef *InstancedClones::makeObjectDef()
+{
+	ObjectDef *sd=stylemanager.FindDef("InstancedClones");
+	if (sd) {
+		sd->inc_count();
+		return sd;
+	}
+
+	ObjectDef *affinedef=stylemanager.FindDef("Affine");
+	sd=new ObjectDef(affinedef,
+			"InstancedClones",
+			_("Instanced Clones"),
+			_("Many linked clones of a few objects"),
+			"class",
+			NULL,NULL);
+
+	return sd;
+}
+
+
+} //namespace Laidout
+
@@ -0,0 +1,76 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef INSTANCEDCLONES_H
+#define INSTANCEDCLONES_H
+
+#include "group.h"
+
+
+namespace Laidout {
+
+
+//------------------------------- InstancedClones ---------------------------------------
+
+class InstancedClones : public DrawableObject
+{
+  protected:
+	int numsources;
+	LaxInterfaces::SomeData **sources; //may be NULL before linking after reading in
+	char **source_ids;
+
+	int numinstances, maxinstances;
+	int *instance_sources; //index into sources for each instance
+	double *transforms;    //packed, 6 per instance
+
+  public:
+	InstancedClones();
+	virtual ~InstancedClones();
+	virtual const char *whattype() { return "InstancedClones"; }
+	virtual const char *Id();
+	virtual const char *Id(const char *newid) { return DrawableObject::Id(newid); }
+	virtual void FindBBox();
+	virtual int pointin(flatpoint pp,int pin=1);
+	virtual void dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *context);
+	virtual void dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context);
+	virtual LaxInterfaces::SomeData *duplicate(LaxInterfaces::SomeData *dup);
+	virtual LaxInterfaces::SomeData *EquivalentObject();
+
+	virtual int AddSource(LaxInterfaces::SomeData *object);
+	virtual int SetSource(int index, LaxInterfaces::SomeData *object);
+	virtual int AddSourceId(const char *id);
+	virtual int NumSources() { return numsources; }
+	virtual LaxInterfaces::SomeData *Source(int index);
+	virtual const char *SourceId(int index);
+
+	virtual int AddInstance(int source, const double *m);
+	virtual int NumInstances() { return numinstances; }
+	virtual int InstanceSource(int index) { return instance_sources[index]; }
+	virtual const double *InstanceTransform(int index) { return transforms+6*index; }
+	virtual void ClearInstances();
+	virtual void Clear();
+
+	virtual Group *Expand();
+
+	 //from Value:
+	virtual Value *duplicate();
+	virtual ObjectDef *makeObjectDef();
+};
+
+
+} //namespace Laidout
+
+#endif
+
@@ -18,6 +18,7 @@
 #include "lengraverfilldata.h"
 #include "../stylemanager.h"
 #include "../language.h"
+#include "../profiler.h"
 
 #include <lax/interfaces/pathinterface.h>
 
@@ -81,6 +82,7 @@ void LEngraverFillData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpConte
  */
 void LEngraverFillData::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
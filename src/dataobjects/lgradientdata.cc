@@ -19,6 +19,7 @@
 #include "../stylemanager.h"
 #include "../language.h"
 #include "../calculator/shortcuttodef.h"
+#include "../profiler.h"
 
 
 using namespace Laxkit;
@@ -73,6 +74,7 @@ void LGradientData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *
 
 void LGradientData::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
@@ -20,6 +20,7 @@
 #include "../language.h"
 #include "../stylemanager.h"
 #include "../calculator/shortcuttodef.h"
+#include "../profiler.h"
 
 #include <iostream>
 using namespace std;
@@ -76,6 +77,7 @@ void LImagePatchData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext
 
 void LImagePatchData::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
@@ -227,6 +229,7 @@ void LColorPatchData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext
 
 void LColorPatchData::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
@@ -358,10 +361,10 @@ int LImagePatchInterface::CharInput(unsigned int ch,const char *buffer,int len,u
 	int r=recurse,m=rendermode;
 	int cc=ImagePatchInterface::CharInput(ch,buffer,len,state,k);
 	if (recurse!=r || m!=rendermode) {
-		for (int c=0; c<laidout->interfacepool.n; c++) {
-			if (!strcmp(laidout->interfacepool.e[c]->whattype(),"ImagePatchInterface")) {
-				static_cast<ImagePatchInterface *>(laidout->interfacepool.e[c])->recurse=recurse;
-				static_cast<ImagePatchInterface *>(laidout->interfacepool.e[c])->rendermode=rendermode;
+		for (int c=0; c<laidout->InterfacePool().n; c++) {
+			if (!strcmp(laidout->InterfacePool().e[c]->whattype(),"ImagePatchInterface")) {
+				static_cast<ImagePatchInterface *>(laidout->InterfacePool().e[c])->recurse=recurse;
+				static_cast<ImagePatchInterface *>(laidout->InterfacePool().e[c])->rendermode=rendermode;
 				break;
 			}
 		}
@@ -474,10 +477,10 @@ int LColorPatchInterface::CharInput(unsigned int ch,const char *buffer,int len,u
 	int r=recurse,m=rendermode;
 	int cc=ColorPatchInterface::CharInput(ch,buffer,len,state,k);
 	if (recurse!=r || m!=rendermode) {
-		for (int c=0; c<laidout->interfacepool.n; c++) {
-			if (!strcmp(laidout->interfacepool.e[c]->whattype(),"ColorPatchInterface")) {
-				static_cast<ColorPatchInterface *>(laidout->interfacepool.e[c])->recurse=recurse;
-				static_cast<ColorPatchInterface *>(laidout->interfacepool.e[c])->rendermode=rendermode;
+		for (int c=0; c<laidout->InterfacePool().n; c++) {
+			if (!strcmp(laidout->InterfacePool().e[c]->whattype(),"ColorPatchInterface")) {
+				static_cast<ColorPatchInterface *>(laidout->InterfacePool().e[c])->recurse=recurse;
+				static_cast<ColorPatchInterface *>(laidout->InterfacePool().e[c])->rendermode=rendermode;
 				break;
 			}
 		}
@@ -19,6 +19,8 @@
 #include "../stylemanager.h"
 #include "../language.h"
 #include "../calculator/shortcuttodef.h"
+#include "../calculator/arrayvalues.h"
+#include "../profiler.h"
 
 
 
@@ -73,6 +75,7 @@ void LPathsData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *con
 
 void LPathsData::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
@@ -153,6 +156,15 @@ ObjectDef *LPathsData::makeObjectDef()
 
 	sd->pushFunction("clear",_("Clear"),_("Clear all paths"), NULL, NULL);
 
+	sd->pushFunction("points",_("Points"),_("Return a FlatvectorArray of the vertices of a subpath"), NULL,
+					 "path",_("Path"),_("Index of the subpath"),"int", NULL,"0",
+					 NULL);
+
+	sd->pushFunction("appendPoints",_("Append Points"),_("Add a new subpath of straight lines through the points of a FlatvectorArray"), NULL,
+					 "points",_("Points"),_("A FlatvectorArray"),"FlatvectorArray", NULL,NULL,
+					 "closed",_("Closed"),_("Whether to close the new subpath"),"boolean", NULL,"false",
+					 NULL);
+
 	return sd;
 }
 
@@ -181,6 +193,39 @@ int LPathsData::assign(FieldExtPlace *ext,Value *v)
 int LPathsData::Evaluate(const char *func,int len, ValueHash *context, ValueHash *parameters, CalcSettings *settings,
 	                     Value **value_ret, Laxkit::ErrorLog *log)
 {
+	if (isName(func,len, "points")) {
+		int err=0;
+		int i=(parameters ? parameters->findInt("path",-1,&err) : 0);
+		if (err) i=0;
+		if (i<0 || i>=paths.n) {
+			if (log) log->AddMessage(_("Index out of range!"),ERROR_Fail);
+			return 1;
+		}
+
+		FlatvectorArrayValue *array=new FlatvectorArrayValue;
+		LaxInterfaces::Coordinate *start=paths.e[i]->path, *p=start;
+		if (p) do {
+			if (p->flags&POINT_VERTEX) array->Push(p->x(),p->y());
+			p=p->next;
+		} while (p && p!=start);
+		*value_ret=array;
+		return 0;
+
+	} else if (isName(func,len, "appendPoints")) {
+		FlatvectorArrayValue *array=dynamic_cast<FlatvectorArrayValue*>(parameters ? parameters->find("points") : NULL);
+		if (!array) return -1;
+		int err=0;
+		int closed=(parameters ? parameters->findBoolean("closed",-1,&err) : 0);
+		if (err) closed=0;
+
+		if (paths.n && paths.e[paths.n-1]->path) pushEmpty();
+		for (int c=0; c<array->n; c++) append(array->xy[2*c],array->xy[2*c+1]);
+		if (closed && array->n) close();
+		FindBBox();
+		*value_ret=NULL;
+		return 0;
+	}
+
 	//return -1;
 	AffineValue affine(m());
 	int status=affine.Evaluate(func,len,context,parameters,settings,value_ret,log);
@@ -18,6 +18,7 @@
 #include "datafactory.h"
 #include "../stylemanager.h"
 #include "../language.h"
+#include "../profiler.h"
 
 
 using namespace Laxkit;
@@ -76,6 +77,7 @@ void LTextOnPath::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *co
  */
 void LTextOnPath::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
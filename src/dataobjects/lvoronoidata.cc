@@ -18,6 +18,7 @@
 #include "../stylemanager.h"
 #include "../language.h"
 #include "../calculator/shortcuttodef.h"
+#include "../profiler.h"
 
 #include <lax/interfaces/pathinterface.h>
 
@@ -75,6 +76,7 @@ void LVoronoiData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *c
 
 void LVoronoiData::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	DrawableObject::dump_in_atts(att,flag,context);
 	int foundconfig=0;
 	for (int c=0; c<att->attributes.n; c++) {
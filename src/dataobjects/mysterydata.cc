@@ -18,6 +18,7 @@
 
 #include <lax/strmanip.h>
 #include "mysterydata.h"
+#include "../profiler.h"
 
 
 #define DBG
@@ -113,6 +114,7 @@ void MysteryData::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *co
  */
 void MysteryData::dump_in_atts(Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
+	ProfileScope profile("object",whattype());
 	if (!att) return;
 	char *nname,*value;
 	minx=miny=0;
@@ -0,0 +1,224 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include <lax/interfaces/somedata.h>
+#include <lax/transformmath.h>
+#include <sys/times.h>
+#include <cstring>
+
+#include "objecttree.h"
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+namespace Laidout {
+
+
+//------------------------------ ObjectTree ----------------------------------
+
+/*! \class ObjectTree
+ * \brief Flattened, depth first snapshot of everything in an ObjectContainer.
+ *
+ * ObjectContainer::nextObject() re-descends from the root through object_e() for every
+ * step. When a whole tree must be searched, or searched many times, it is much faster
+ * to walk it once with Rebuild(), then loop over the nodes:
+ * <pre>
+ *   for (int c=0; c<tree.n(); c++) {
+ *       ObjectTreeNode *node=tree.e(c);
+ *       ...
+ *       if (not interested in kids of node) c=tree.SkipKids(c)-1;
+ *   }
+ * </pre>
+ *
+ * Nodes are in the same order that repeated Next_Increment steps would find them in.
+ * Each node has the accumulated transform from object space to root space, its depth,
+ * its parent node, and a copy of the object's id (if it is a SomeData).
+ *
+ * Objects are NOT referenced, so a snapshot is only good while the tree is not changed.
+ * Use IsStale() with a Document or Page modtime to decide when to rebuild.
+ * Pointers can still be compared against objects that are known to exist. To check
+ * that a node is still really where the snapshot says it is, use Verify().
+ */
+
+
+ObjectTree::ObjectTree()
+{
+	root=NULL;
+	build_flags=0;
+	modtime=0;
+
+	nodes=NULL;
+	numnodes=maxnodes=0;
+	ids=NULL;
+	idslen=idsmax=0;
+}
+
+ObjectTree::~ObjectTree()
+{
+	delete[] nodes;
+	delete[] ids;
+}
+
+//! Forget everything, but keep allocated space around for the next Rebuild().
+void ObjectTree::Clear()
+{
+	root=NULL;
+	numnodes=0;
+	idslen=0;
+	modtime=0;
+}
+
+//! Flatten everything in nroot.
+/*! flags can be Next_SkipLockedKids, which will not descend into containers that
+ * have OBJ_IgnoreKids set.
+ *
+ * Returns the number of nodes.
+ */
+int ObjectTree::Rebuild(ObjectContainer *nroot, unsigned int flags)
+{
+	Clear();
+	root=nroot;
+	build_flags=flags;
+	modtime=times(NULL);
+	if (!root) return 0;
+
+	double m[6];
+	transform_identity(m);
+	AddKids(root,-1,1,m);
+	return numnodes;
+}
+
+int ObjectTree::AddNode(Laxkit::anObject *obj, int parent, int index, int depth, const double *m)
+{
+	if (numnodes==maxnodes) {
+		maxnodes=(maxnodes ? 2*maxnodes : 256);
+		ObjectTreeNode *nnodes=new ObjectTreeNode[maxnodes];
+		if (nodes) memcpy(nnodes,nodes,numnodes*sizeof(ObjectTreeNode));
+		delete[] nodes;
+		nodes=nnodes;
+	}
+
+	ObjectTreeNode *node=&nodes[numnodes];
+	node->object=obj;
+	node->parent=parent;
+	node->index=index;
+	node->depth=depth;
+	node->next=numnodes+1;
+	node->id=-1;
+	memcpy(node->m,m,6*sizeof(double));
+
+	LaxInterfaces::SomeData *data=dynamic_cast<LaxInterfaces::SomeData*>(obj);
+	const char *id=(data ? data->Id() : NULL);
+	if (id) {
+		long len=strlen(id)+1;
+		if (idslen+len>idsmax) {
+			idsmax=2*(idsmax+len);
+			char *nids=new char[idsmax];
+			if (ids) memcpy(nids,ids,idslen);
+			delete[] ids;
+			ids=nids;
+		}
+		memcpy(ids+idslen,id,len);
+		node->id=idslen;
+		idslen+=len;
+	}
+
+	return numnodes++;
+}
+
+void ObjectTree::AddKids(ObjectContainer *container, int parent, int depth, const double *m)
+{
+	if ((build_flags&Next_SkipLockedKids) && (container->object_flags()&OBJ_IgnoreKids)) return;
+
+	double mm[6];
+	int nn=container->n();
+	for (int c=0; c<nn; c++) {
+		Laxkit::anObject *obj=container->object_e(c);
+		if (!obj) continue;
+
+		const double *om=container->object_transform(c);
+		if (om) transform_mult(mm,om,m);
+		else memcpy(mm,m,6*sizeof(double));
+
+		int i=AddNode(obj,parent,c,depth,mm);
+
+		ObjectContainer *oc=dynamic_cast<ObjectContainer*>(obj);
+		if (oc) AddKids(oc,i,depth+1,mm);
+		nodes[i].next=numnodes; //nodes may have been reallocated, so don't hold a pointer
+	}
+}
+
+//! Return the id the object at node i had when the snapshot was made.
+const char *ObjectTree::Id(int i)
+{
+	if (i<0 || i>=numnodes || nodes[i].id<0) return NULL;
+	return ids+nodes[i].id;
+}
+
+//! Set place to be the position of node i relative to Root().
+/*! Returns place.n(), or -1 for bad index.
+ */
+int ObjectTree::Place(int i, FieldPlace &place)
+{
+	place.flush();
+	if (i<0 || i>=numnodes) return -1;
+
+	while (i>=0) {
+		place.push(nodes[i].index,0);
+		i=nodes[i].parent;
+	}
+	return place.n();
+}
+
+//! Return whether node i's object is still at the same place in Root().
+bool ObjectTree::Verify(int i)
+{
+	if (!root || i<0 || i>=numnodes) return false;
+	FieldPlace place;
+	Place(i,place);
+	return root->getanObject(place,0)==nodes[i].object;
+}
+
+//! Return the index of the first node at or after start that is obj, or -1.
+int ObjectTree::Find(Laxkit::anObject *obj, int start)
+{
+	if (start<0) start=0;
+	for (int c=start; c<numnodes; c++) {
+		if (nodes[c].object==obj) return c;
+	}
+	return -1;
+}
+
+//! Return the index of the first node at or after start whose id was id, or -1.
+/*! This only compares against the copies of ids made when the snapshot was built, so
+ * no objects are touched.
+ */
+int ObjectTree::FindId(const char *id, int start)
+{
+	if (!id) return -1;
+	if (start<0) start=0;
+	for (int c=start; c<numnodes; c++) {
+		if (nodes[c].id>=0 && !strcmp(ids+nodes[c].id,id)) return c;
+	}
+	return -1;
+}
+
+
+} // namespace Laidout
+
@@ -0,0 +1,86 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef OBJECTTREE_H
+#define OBJECTTREE_H
+
+
+#include <ctime>
+#include "objectcontainer.h"
+
+
+namespace Laidout {
+
+
+//------------------------------ ObjectTreeNode ----------------------------------
+
+class ObjectTreeNode
+{
+ public:
+	Laxkit::anObject *object;
+	int parent; //index of parent node, or -1 for direct kids of the root
+	int index;  //index of object in its parent container
+	int depth;  //1 for direct kids of the root
+	int next;   //index of the first node after this one that is not a descendant
+	long id;    //offset of a copy of the object's id in ObjectTree::ids, or -1
+	double m[6]; //transform from object space to root space
+};
+
+
+//------------------------------ ObjectTree ----------------------------------
+
+class ObjectTree
+{
+ protected:
+	ObjectContainer *root;
+	unsigned int build_flags;
+	clock_t modtime;
+
+	ObjectTreeNode *nodes;
+	int numnodes, maxnodes;
+	char *ids;
+	long idslen, idsmax;
+
+	int AddNode(Laxkit::anObject *obj, int parent, int index, int depth, const double *m);
+	void AddKids(ObjectContainer *container, int parent, int depth, const double *m);
+
+ public:
+	ObjectTree();
+	virtual ~ObjectTree();
+
+	virtual int Rebuild(ObjectContainer *nroot, unsigned int flags=0);
+	virtual void Clear();
+	virtual ObjectContainer *Root() { return root; }
+	virtual clock_t ModTime() { return modtime; }
+	virtual bool IsStale(clock_t since) { return root==NULL || since>=modtime; }
+
+	 //iterating
+	virtual int n() { return numnodes; }
+	virtual ObjectTreeNode *e(int i) { return (i>=0 && i<numnodes) ? &nodes[i] : NULL; }
+	virtual int SkipKids(int i) { return (i>=0 && i<numnodes) ? nodes[i].next : numnodes; }
+	virtual const char *Id(int i);
+	virtual int Place(int i, FieldPlace &place);
+	virtual bool Verify(int i);
+
+	 //searching
+	virtual int Find(Laxkit::anObject *obj, int start=0);
+	virtual int FindId(const char *id, int start=0);
+};
+
+
+} //namespace Laidout
+
+#endif
+
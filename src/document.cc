@@ -30,6 +30,8 @@
 #include "laidout.h"
 #include "headwindow.h"
 #include "utils.h"
+#include "undo.h"
+#include "profiler.h"
 #include "language.h"
 
 
@@ -411,6 +413,7 @@ Document::Document(const char *filename)
 	modtime=times(NULL);
 	curpage=-1;
 	imposition=NULL;
+	undohistory=NULL;
 	
 	ErrorLog log;
 	Load(filename,log);
@@ -431,6 +434,7 @@ Document::Document(Imposition *imp,const char *filename)//stuff=NULL
 	curpage=-1;
 	saveas=newstr(filename);
 	name=NULL;
+	undohistory=NULL;
 	
 	imposition=imp;
 	if (imposition) imposition->inc_count();
@@ -465,6 +469,11 @@ Document::Document(Imposition *imp,const char *filename)//stuff=NULL
 Document::~Document()
 {
 	DBG cerr <<" Document destructor.."<<endl;
+	if (undohistory) {
+		 //viewports might still hold the history, but its entries must not outlive us
+		undohistory->Flush();
+		undohistory->dec_count();
+	}
 	pages.flush();
 	pageranges.flush();
 	if (saveas) delete[] saveas;
@@ -475,6 +484,7 @@ Document::~Document()
 //! Remove everything from the document.
 void Document::clear()
 {
+	if (undohistory) undohistory->Flush();
 	pages.flush();
 	if (imposition) { imposition->dec_count(); imposition=NULL; }
 	if (saveas) { delete[] saveas; saveas=NULL; }
@@ -482,6 +492,13 @@ void Document::clear()
 	curpage=-1;
 }
 
+//! Return the undo history for edits to this document, creating it if necessary.
+UndoHistory *Document::GetUndoHistory()
+{
+	if (!undohistory) undohistory=new UndoHistory();
+	return undohistory;
+}
+
 ObjectDef* Document::makeObjectDef()
 {
 	cout <<"*** implement Document styledef!!!"<<endl;
@@ -521,14 +538,33 @@ int Document::NewPages(int starting,int np)
 	if (!imposition) return -1;
 
 	if (np<=0) return 0;
-	Page *p;
 
 	 //create the pages
-	if (starting<0) starting=pages.n;
+	Page **newpages=new Page*[np];
+	for (int c=0; c<np; c++) newpages[c]=new Page(NULL);
+
+	int status=InsertPages(starting, newpages, np);
+
+	for (int c=0; c<np; c++) newpages[c]->dec_count();
+	delete[] newpages;
+	return status;
+}
+
+//! Insert existing pages before page index starting, or at end if starting==-1.
+/*! The pages' counts are incremented. This is what NewPages() uses, and also how
+ * undo puts removed pages back.
+ *
+ * Returns number of pages added, or negative for error.
+ */
+int Document::InsertPages(int starting, Page **newpages, int np)
+{
+	if (!imposition) return -1;
+
+	if (np<=0) return 0;
+
+	if (starting<0 || starting>pages.n) starting=pages.n;
 	for (int c=0; c<np; c++) {
-		p=new Page(NULL);
-		pages.push(p,LISTS_DELETE_Refcount,starting);
-		p->dec_count();
+		pages.push(newpages[c],LISTS_DELETE_Refcount,starting+c);
 	}
 
 	 //adjust pageranges if necessary
@@ -548,6 +584,9 @@ int Document::NewPages(int starting,int np)
 	imposition->NumPages(pages.n);
 	SyncPages(starting,-1, true);
 
+	UndoHistory *undo=GetUndoHistory();
+	if (undo->Recording()) undo->Add(new PageUndo(this,1,starting,np));
+
 	laidout->notifyDocTreeChanged(NULL,TreePagesAdded, starting,-1);
 	return np;
 }
@@ -721,6 +760,10 @@ int Document::RemovePages(int start,int n)
 	if (pages.n<=1) return -2;
 	if (start<0 || start>=pages.n) return -1;
 	if (start+n>pages.n) n=pages.n-start;
+
+	UndoHistory *undo=GetUndoHistory();
+	if (undo->Recording()) undo->Add(new PageUndo(this,0,start,n));
+
 	for (int c=0; c<n; c++) {
 		pages.remove(start);
 	}
@@ -855,6 +898,8 @@ int Document::SaveACopy(const char *filename, int includelimbos,int includewindo
  */
 int Document::Save(int includelimbos,int includewindows,ErrorLog &log, bool add_to_recent)
 {
+	ProfileScope profile("save","Document::Save");
+
 	FILE *f=NULL;
 	if (isblank(saveas)) {
 		DBG cerr <<"**** cannot save, saveas is null."<<endl;
@@ -937,6 +982,8 @@ int Document::Load(const char *file,ErrorLog &log)
 {
 	DBG cerr <<"----Document::Load read file "<<(file?file:"**** AH! null file!")<<" into a new Document"<<endl;
 	if (!file) return 0;
+
+	ProfileScope profile("load","Document::Load");
 	
 	FILE *f=open_laidout_file_to_read(file,"Document",&log);
 	if (!f) {
@@ -960,7 +1007,10 @@ int Document::Load(const char *file,ErrorLog &log)
 
 	clear();
 	setlocale(LC_ALL,"C");
-	dump_in(f,0,0,&context,NULL);
+	{
+		ProfileScope parse("load","parse");
+		dump_in(f,0,0,&context,NULL);
+	}
 	fclose(f);
 	setlocale(LC_ALL,"");
 	
@@ -969,6 +1019,7 @@ int Document::Load(const char *file,ErrorLog &log)
 
 	if (!imposition) imposition=newImpositionByType("Singles");
 	if (pages.n==0) {
+		ProfileScope createpages("load","CreatePages");
 		pages.e=imposition->CreatePages(-1);
 		if (pages.e) { // must manually count how many element in e, put that in n
 			int c=0;
@@ -982,7 +1033,10 @@ int Document::Load(const char *file,ErrorLog &log)
 		}
 	}
 	imposition->NumPages(pages.n);
-	SyncPages(0,-1, false);
+	{
+		ProfileScope syncpages("load","SyncPages");
+		SyncPages(0,-1, false);
+	}
 
 	laidout->project->ClarifyRefs(log);
 	DBG cerr<<" *** Document::Load should probably have a load context storing refs that need to be sorted, to save time loading..."<<endl;
@@ -1016,6 +1070,9 @@ int Document::Load(const char *file,ErrorLog &log)
  */
 int Document::SyncPages(int start,int n, bool shift_within_margins)
 {
+	 //pages may have been added, removed or moved, so cached spreads are stale
+	if (imposition) imposition->Modified();
+
 	if (start>=pages.n) return 0;
 	if (n<0) n=pages.n;
 	if (start+n>pages.n) n=pages.n-start;
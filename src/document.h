@@ -29,6 +29,7 @@ namespace Laidout {
 class Spread;
 class SpreadView;
 class Imposition;
+class UndoHistory;
 
 enum  LaidoutSaveFormat {
 	Save_Normal,
@@ -98,6 +99,8 @@ class Document : public ObjectContainer, public Value
 
 	clock_t modtime;
 
+	UndoHistory *undohistory;
+
 	// ***********TEMP!!!
 	virtual int inc_count();
     virtual int dec_count();
@@ -112,6 +115,7 @@ class Document : public ObjectContainer, public Value
 	virtual const char *Name(int withsaveas);
 	virtual int Name(const char *nname);
 	virtual void clear();
+	virtual UndoHistory *GetUndoHistory();
 
 	 //style functions
 	virtual Value *duplicate();
@@ -120,6 +124,7 @@ class Document : public ObjectContainer, public Value
 	 //page and imposition management
 	virtual Page *Curpage();
 	virtual int NewPages(int starting,int n);
+	virtual int InsertPages(int starting, Page **newpages, int n);
 	virtual int RemovePages(int start,int n);
 	virtual int SyncPages(int start,int n, bool shift_within_margins);
 	virtual int ReImpose(Imposition *newimp,int scale_page_contents_to_fit);
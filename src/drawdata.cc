@@ -29,12 +29,16 @@
 #include <lax/interfaces/pathinterface.h>
 #include <lax/interfaces/colorpatchinterface.h>
 #include <lax/interfaces/imagepatchinterface.h>
+#include <lax/interfaces/imageinterface.h>
 #include <lax/transformmath.h>
+#include <lax/strmanip.h>
 
 #include <lax/interfaces/somedataref.h>
 #include <lax/interfaces/somedatafactory.h>
 #include "drawdata.h"
 #include "dataobjects/mysterydata.h"
+#include "dataobjects/instancedclones.h"
+#include "imagecache.h"
 #include "laidout.h"
 #include "language.h"
 //#include "dataobjects/datafactory.h"
@@ -105,14 +109,49 @@ void DrawDataStraight(Displayer *dp,SomeData *data,anObject *a1,anObject *a2,uns
 		return;
 	} 
 
+	 //draw each instance of the sources, skipping ones that are off screen
+	if (!strcmp(data->whattype(),"InstancedClones")) {
+		InstancedClones *clones=dynamic_cast<InstancedClones *>(data);
+		SomeData *source;
+		DoubleBBox box;
+		for (int c=0; c<clones->NumInstances(); c++) {
+			source=clones->Source(clones->InstanceSource(c));
+			if (!source || !source->validbounds()) continue;
+
+			dp->PushAndNewTransform(clones->InstanceTransform(c));
+
+			box.clear();
+			box.addtobounds(dp->realtoscreen(flatpoint(source->minx,source->miny)));
+			box.addtobounds(dp->realtoscreen(flatpoint(source->maxx,source->miny)));
+			box.addtobounds(dp->realtoscreen(flatpoint(source->maxx,source->maxy)));
+			box.addtobounds(dp->realtoscreen(flatpoint(source->minx,source->maxy)));
+			if (box.maxx>=dp->Minx && box.minx<=dp->Maxx && box.maxy>=dp->Miny && box.miny<=dp->Maxy)
+				DrawDataStraight(dp,source,a1,a2,flags);
+
+			dp->PopAxes();
+		}
+		return;
+	}
+
+	 //imported images only get a screen proxy while they are actually drawn. The image keeps
+	 //no count on it afterwards, so the cache can evict it when memory is tight
+	ImageData *proxied=NULL;
+	if (!strcmp(data->whattype(),"ImageData")) {
+		ImageData *img=dynamic_cast<ImageData *>(data);
+		if (img && !img->previewimage && !isblank(img->filename)) {
+			img->previewimage=ImageCache::GetDefault()->Proxy(img->filename, laidout->max_preview_length);
+			if (img->previewimage) proxied=img;
+		}
+	}
+
 	 // find interface in interfacepool
 	int c;
 	anInterface *interf=NULL;
 	//if (dp->GetXw()) ...
 	// else:
-	for (c=0; c<laidout->interfacepool.n; c++) {
-		if (laidout->interfacepool.e[c]->draws(data->whattype())) {
-			interf=laidout->interfacepool.e[c];
+	for (c=0; c<laidout->InterfacePool().n; c++) {
+		if (laidout->InterfacePool().e[c]->draws(data->whattype())) {
+			interf=laidout->InterfacePool().e[c];
 			break;
 		}
 	}
@@ -182,13 +221,18 @@ void DrawDataStraight(Displayer *dp,SomeData *data,anObject *a1,anObject *a2,uns
 		dp->drawline(ll,ul);
 		dp->DrawReal();
 	}
+
+	if (proxied) {
+		ImageCache::GetDefault()->Release(proxied->previewimage);
+		proxied->previewimage=NULL;
+	}
 }
 
 //! Draw data using the transform of the data....
 /*! \ingroup objects
  * Assumes dp.Updates(0) has already been called, and the transform
  * has been set appropriately. This steps through any groups, and looks
- * up an appropriate interface from laidout->interfacepool to draw the data.
+ * up an appropriate interface from laidout->InterfacePool() to draw the data.
  *
  * Note that for groups, a1 and a2 are passed along to all the group members..
  *
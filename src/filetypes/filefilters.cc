@@ -21,6 +21,7 @@
 #include "filefilters.h"
 #include "../laidout.h"
 #include "../stylemanager.h"
+#include "../profiler.h"
 
 
 #define DBG
@@ -565,6 +566,7 @@ int import_document(ImportConfig *config, Laxkit::ErrorLog &log)
 		log.AddMessage(_("Bad import configuration"),ERROR_Fail);
 		return 1;
 	}
+	ProfileScope profile("import",config->filter->VersionName());
 	return config->filter->In(config->filename,config,log);
 }
 
@@ -1332,6 +1334,7 @@ int export_document(DocumentExportConfig *config, Laxkit::ErrorLog &log)
 	}
 
 	DBG cerr << "export_document begin to \""<<config->filter->VersionName()<<"\"......."<<endl;
+	ProfileScope profile("export",config->filter->VersionName());
 
 	 //figure out what paper arrangement to print out on
 	PaperGroup *papergroup=config->papergroup;
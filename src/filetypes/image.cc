@@ -569,7 +569,7 @@ int ImageExportFilter::Out(const char *filename, Laxkit::anObject *context, Erro
 	 //spread objects
 	Spread *spread = NULL;
 	if (doc) {
-		spread = doc->imposition->Layout(out->layout, out->start);
+		spread = doc->imposition->GetSpread(out->layout, out->start);
 	}
 
 	if (spread) {
@@ -587,7 +587,7 @@ int ImageExportFilter::Out(const char *filename, Laxkit::anObject *context, Erro
 
 			if (!page) { // try to look up page in doc using pagestack->index
 				if (spread->pagestack.e[c]->index>=0 && spread->pagestack.e[c]->index<doc->pages.n) {
-					page=spread->pagestack.e[c]->page=doc->pages.e[pagei];
+					page=doc->pages.e[pagei];
 				}
 			}
 
@@ -629,6 +629,8 @@ int ImageExportFilter::Out(const char *filename, Laxkit::anObject *context, Erro
 
 			dp->PopAxes(); // remove page transform
 		} //foreach in pagestack
+
+		spread->dec_count();
 	} //if spread
 
 	//DBG dp->NewFG(.2,.2,.5);
@@ -31,7 +31,14 @@
 #include "../printing/psout.h"
 #include "pdf.h"
 #include "../impositions/singles.h"
+#include "../imagecache.h"
 #include "../utils.h"
+#include "../headwindow.h"
+#include "../dataobjects/mysterydata.h"
+#include "../dataobjects/instancedclones.h"
+#include "pdfreader.h"
+
+#include <zlib.h>
 
 #include <iostream>
 #define DBG 
@@ -53,8 +60,12 @@ namespace Laidout {
 
 /*! \class PdfImportFilter
  *
- * Use MysteryData, with nativeid == page number, and preview as the page preview, generated
- * by ghostscript.
+ * Each source page becomes a MysteryData with importer "Pdf", nativeid == page index,
+ * and the source file in attributes. The page's content is not parsed at all. On pdf
+ * export, the page's content streams and resources are copied as is into a Form XObject.
+ * See PdfReader.
+ *
+ * \todo previews of the pages, generated by ghostscript.
  */
 const char *PdfImportFilter::VersionName()
 {
@@ -82,12 +93,110 @@ const char *PdfImportFilter::FileType(const char *first100bytes)
 	return NULL;
 }
 
+//! Import pages of a pdf as MysteryData objects, one per document page, starting at in->topage.
+/*! If in->toobj is given, all the imported pages are put there instead.
+ */
 int PdfImportFilter::In(const char *file, Laxkit::anObject *context, ErrorLog &log)
 {
-	// ***
-	// find number of pages
-	// generate previews for pages via ghostscript, install with MysteryData
-	return 1;
+	ImportConfig *in=dynamic_cast<ImportConfig *>(context);
+	if (!in) return 1;
+
+	PdfReader *reader=GetPdfReader(file,&log);
+	if (!reader) return 2;
+
+	int start=(in->instart<0 ? 0 : in->instart);
+	int end  =(in->inend<0 || in->inend>=reader->NumPages() ? reader->NumPages()-1 : in->inend);
+	if (start>end) {
+		log.AddMessage(_("No pages to import."),ERROR_Fail);
+		ReleasePdfReader(file);
+		return 3;
+	}
+
+	Document *doc=in->doc;
+
+	 //create a new document if necessary, sized to the first imported page
+	if (!doc && !in->toobj) {
+		PdfSourcePage *first=reader->Page(start);
+		double width =first->Width()/72,
+			   height=first->Height()/72;
+		PaperStyle *paper=NULL;
+		int landscape=0;
+		for (int c=0; c<laidout->papersizes.n; c++) {
+			if (     fabs(width- laidout->papersizes.e[c]->width) <.01
+				  && fabs(height-laidout->papersizes.e[c]->height)<.01) {
+				paper=laidout->papersizes.e[c];
+				break;
+			}
+			if (     fabs(height-laidout->papersizes.e[c]->width) <.01
+				  && fabs(width -laidout->papersizes.e[c]->height)<.01) {
+				paper=laidout->papersizes.e[c];
+				landscape=1;
+				break;
+			}
+		}
+		if (paper) paper=dynamic_cast<PaperStyle*>(paper->duplicate());
+		else paper=new PaperStyle(_("Custom"), width,height, 0, 300, "in");
+
+		Imposition *imp=new Singles;
+		paper->landscape(landscape);
+		imp->SetPaperSize(paper);
+		paper->dec_count();
+		doc=new Document(imp,Untitled_name());
+		imp->dec_count();
+	}
+
+	int docpagenum=(in->topage<0 ? 0 : in->topage);
+	if (doc && !in->toobj && docpagenum+(end-start)>=doc->pages.n) {
+		doc->NewPages(-1,docpagenum+(end-start)+1-doc->pages.n);
+	}
+
+	char scratch[50];
+	for (int c=start; c<=end; c++) {
+		PdfSourcePage *page=reader->Page(c);
+
+		MysteryData *mdata=new MysteryData("Pdf"); //note, this is untranslated "Pdf"
+		mdata->nativeid=c;
+		sprintf(scratch,"Page %d",c+1);
+		makestr(mdata->name,scratch);
+		mdata->maxx=page->Width()/72;
+		mdata->maxy=page->Height()/72;
+
+		Attribute *att=new Attribute;
+		att->push("file",file);
+		att->push("page",c);
+		mdata->installAtts(att);
+
+		Group *group=in->toobj;
+		if (!group) {
+			group=dynamic_cast<Group *>(doc->pages.e[docpagenum+c-start]->layers.e(0)); //pick layer 0 of the page
+
+			 //fit to page, like the scribus importer
+			if (in->scaletopage!=0) {
+				PageStyle *pagestyle=doc->pages.e[docpagenum+c-start]->pagestyle;
+				double sx=pagestyle->w()/mdata->maxx,
+					   sy=pagestyle->h()/mdata->maxy;
+				if (sx>1 && sy>1 && in->scaletopage!=2) sx=sy=1;
+				if (sy<sx) sx=sy;
+				mdata->m(0,sx);
+				mdata->m(3,sx);
+				mdata->m(4,(pagestyle->w()-mdata->maxx*sx)/2);
+				mdata->m(5,(pagestyle->h()-mdata->maxy*sx)/2);
+			}
+		}
+
+		group->push(mdata);
+		mdata->dec_count();
+	}
+
+	 //if doc is new, push into the project
+	if (doc && doc!=in->doc) {
+		laidout->project->Push(doc);
+		laidout->app->addwindow(newHeadWindow(doc));
+	}
+
+	 //pages only refer to the file, which export reopens when needed
+	ReleasePdfReader(file);
+	return 0;
 }
 
 
@@ -100,8 +209,8 @@ void installPdfFilter()
 	pdfout->GetObjectDef();
 	laidout->PushExportFilter(pdfout);
 	
-	//PdfInputFilter *pdfin=new PdfInputFilter;
-	//laidout->importfilters(pdfin);
+	PdfImportFilter *pdfin=new PdfImportFilter;
+	laidout->PushImportFilter(pdfin);
 }
 
 //------------------------------------ PdfExportConfig ----------------------------------
@@ -202,6 +311,8 @@ static int o=1;//***DBG
 
 double current_dpi = 300;
 
+static int pdf_minor_version=4; //the output's pdf version, 1.x
+
 /*! \class PdfObjInfo
  * \brief Temporary class to hold info about pdf objects during export.
  */
@@ -278,6 +389,11 @@ static void pdfCaption(FILE *f, PdfObjInfo *objs, PdfObjInfo *&obj, char *&strea
 						LaxInterfaces::CaptionData *g, ErrorLog &log,int &warning, DocumentExportConfig *config);
 static void pdfTextOnPath(FILE *f, PdfObjInfo *objs, PdfObjInfo *&obj, char *&stream, int &objectcount, Attribute &resources,
 						LaxInterfaces::TextOnPath *g, ErrorLog &log,int &warning, DocumentExportConfig *config);
+static int pdfIsPdfPage(LaxInterfaces::SomeData *object);
+static void pdfPdfPage(FILE *f, PdfObjInfo *objs, PdfObjInfo *&obj, char *&stream, int &objectcount, Attribute &resources,
+						MysteryData *mdata, ErrorLog &log,int &warning, DocumentExportConfig *config);
+static void pdfInstancedClones(FILE *f, PdfObjInfo *objs, PdfObjInfo *&obj, char *&stream, int &objectcount, Attribute &resources,
+						InstancedClones *clones, ErrorLog &log,int &warning, DocumentExportConfig *config);
 
 
 //-------------------------------- pdfdumpobj
@@ -354,6 +470,12 @@ void pdfdumpobj(FILE *f,
 			pdfCaption(f,objs,obj,stream,objectcount,resources,dynamic_cast<CaptionData *>(object), log,warning,config);
 		}
 
+	} else if (!strcmp(object->whattype(),"InstancedClones")) {
+		pdfInstancedClones(f,objs,obj,stream,objectcount,resources,dynamic_cast<InstancedClones*>(object), log,warning,config);
+
+	} else if (pdfIsPdfPage(object)) {
+		pdfPdfPage(f,objs,obj,stream,objectcount,resources,dynamic_cast<MysteryData *>(object), log,warning,config);
+
 	} else if (!strcmp(object->whattype(),"TextOnPath")) {
 		if (config->textaspaths) {
 			TextOnPath *text = dynamic_cast<TextOnPath*>(object);
@@ -543,6 +665,10 @@ int PdfExportFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 	psCtmInit();
 	psFlushCtms();
 
+	 //imported pdf pages share objects only within this one file
+	PdfReader::BeginOutputPass();
+	pdf_minor_version=4;
+
 	 // a fresh PDF is:
 	 //   header: %PDF-1.4
 	 //   body: a list of indirect objects
@@ -596,8 +722,8 @@ int PdfExportFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 		if (config->evenodd==DocumentExportConfig::Even && c%2==0) continue;
         if (config->evenodd==DocumentExportConfig::Odd && c%2==1) continue;
 			
-		if (spread) { delete spread; spread=NULL; }
-		if (doc) spread=doc->imposition->Layout(layout,c);
+		if (spread) { spread->dec_count(); spread=NULL; }
+		if (doc) spread=doc->imposition->GetSpread(layout,c);
 		if (spread) desc=spread->pagesFromSpreadDesc(doc);
 		else desc = limbo->Id() ? newstr(limbo->Id()) : NULL;
 
@@ -718,7 +844,7 @@ int PdfExportFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 			pageobj->contents=obj->number;
 			//pageobj gets its own number and byte offset later
 		}
-		if (spread) { delete spread; spread=NULL; }
+		if (spread) { spread->dec_count(); spread=NULL; }
 		if (desc) delete[] desc;
 	}
 
@@ -841,7 +967,7 @@ int PdfExportFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 	fprintf(f,"%ld 0 obj\n<<\n",doccatalog);
 	 //required fields
 	fprintf(f,"  /Type /Catalog\n");
-	fprintf(f,"  /Version /1.4\n");
+	fprintf(f,"  /Version /1.%d\n",pdf_minor_version); //might be raised by imported pdf pages
 	fprintf(f,"  /Pages %d 0 R\n",pages);
 	 //the rest are optional
 	if (pagelabels>0) fprintf(f,"  /PageLabels %d 0 R\n",pagelabels);
@@ -939,6 +1065,7 @@ int PdfExportFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 	}
 	 //*** double check that this is all that needs cleanup:
 	if (objs) delete objs;
+	ReleasePdfReader(NULL); //any imported pdfs opened by pdfPdfPage()
 
 	DBG cerr <<"=================== end pdf out ========================\n";
 
@@ -1259,7 +1386,11 @@ static void pdfImage(FILE *f,
 		imagexobj=existing->number;
 
 	} else {
-		LaxImage *image=img->image;
+		 //file backed images go through the image cache, so full resolution is only
+		 //decoded here, and can be released after export
+		LaxImage *image=NULL;
+		if (img->filename) image=ImageCache::GetDefault()->Full(img->filename);
+		if (!image) { image=img->image; image->inc_count(); }
 
 		int width =image->w();
 		int height=image->h();
@@ -1358,6 +1489,7 @@ static void pdfImage(FILE *f,
 				  "endobj\n");
 
 		image->doneWithBuffer(buf);
+		ImageCache::GetDefault()->Release(image);
 	} //if !existing
 
 
@@ -1380,6 +1512,415 @@ static void pdfImage(FILE *f,
 	}
 }
 
+//--------------------------------------- pdfPdfPage() ----------------------------------------
+
+//! Return whether object is a page imported by PdfImportFilter.
+static int pdfIsPdfPage(LaxInterfaces::SomeData *object)
+{
+	MysteryData *mdata=dynamic_cast<MysteryData *>(object);
+	return mdata && mdata->importer && !strcmp(mdata->importer,"Pdf") && mdata->attributes;
+}
+
+//! Return the object number that source object num will have in the output, or -1 if it must not be copied.
+/*! New numbers are handed out in the order objects are pushed onto pending, which is the order
+ * they must be written out in, since the xref table is written in PdfObjInfo list order.
+ */
+static long pdfImportedNumber(PdfReader *reader, long num, int &objectcount, NumStack<long> &pending)
+{
+	long out=reader->OutputNumber(num);
+	if (out>0) return out;
+
+	PdfValue *v=reader->Object(num);
+	if (!v) return -1;
+
+	 //never drag in the source page tree, which might be referenced by things like /P or /Parent
+	PdfValue *type=v->find("/Type");
+	if (type && (type->IsName("/Page") || type->IsName("/Pages") || type->IsName("/Catalog"))) return -1;
+
+	out=objectcount++;
+	reader->OutputNumber(num,out);
+	pending.push(num);
+	return out;
+}
+
+//! Write out a value from an imported pdf, renumbering references.
+/*! If length>=0, then it replaces any /Length in a dict, which might be an indirect object in the source.
+ */
+static void pdfWriteImported(FILE *f, PdfValue *v, PdfReader *reader, int &objectcount, NumStack<long> &pending, long length)
+{
+	if (v->type==PDFV_Ref) {
+		long num=pdfImportedNumber(reader,v->ref,objectcount,pending);
+		if (num<0) fprintf(f,"null");
+		else fprintf(f,"%ld 0 R",num);
+
+	} else if (v->type==PDFV_Array) {
+		fprintf(f,"[");
+		for (int c=0; c<v->items.n; c++) {
+			if (c) fprintf(f," ");
+			pdfWriteImported(f,v->items.e[c],reader,objectcount,pending,-1);
+		}
+		fprintf(f,"]");
+
+	} else if (v->type==PDFV_Dict) {
+		fprintf(f,"<<");
+		for (int c=0; c<v->keys.n; c++) {
+			fprintf(f," %s ",v->keys.e[c]);
+			if (length>=0 && !strcmp(v->keys.e[c],"/Length")) fprintf(f,"%ld",length);
+			else pdfWriteImported(f,v->items.e[c],reader,objectcount,pending,-1);
+		}
+		fprintf(f," >>");
+
+	} else fputs(v->text,f);
+}
+
+//! Copy over all objects in pending, and anything they reference, as is.
+static void pdfWriteImportedObjects(FILE *f, PdfObjInfo *&obj, PdfReader *reader, int &objectcount, NumStack<long> &pending)
+{
+	const char *data;
+	long len;
+
+	 //note pending.n grows as objects get written
+	for (int c=0; c<pending.n; c++) {
+		long num=pending.e[c];
+
+		obj->next=new PdfObjInfo;
+		obj=obj->next;
+		obj->byteoffset=ftell(f);
+		obj->number=reader->OutputNumber(num);
+		fprintf(f,"%ld 0 obj\n",obj->number);
+
+		if (reader->StreamData(num,&data,&len)!=0) len=-1;
+		pdfWriteImported(f,reader->Object(num),reader,objectcount,pending,len);
+		if (len>=0) {
+			fprintf(f,"\nstream\n");
+			fwrite(data,1,len,f);
+			fprintf(f,"\nendstream");
+		}
+		fprintf(f,"\nendobj\n");
+	}
+}
+
+//! Join several content streams of one page into a single new[]'d buffer.
+/*! If any of them were compressed, the result is compressed again, and compressed is set to 1.
+ * Returns 0 for success.
+ */
+static int pdfJoinContents(PdfReader *reader, NumStack<long> &streams, char **joined_ret, long *len_ret, int *compressed)
+{
+	char *joined=NULL;
+	long len=0;
+	*compressed=0;
+
+	for (int c=0; c<streams.n; c++) {
+		const char *raw;
+		long rawlen;
+		char *buf=NULL;
+		long buflen=0;
+		PdfValue *dict=reader->Object(streams.e[c]);
+		if (!dict || reader->StreamData(streams.e[c],&raw,&rawlen)!=0) continue;
+		if (dict->find("/Filter")) *compressed=1;
+		if (PdfDecodeStream(dict,raw,rawlen, &buf,&buflen)!=0) {
+			if (joined) delete[] joined;
+			return 1;
+		}
+
+		 //streams may break anywhere between tokens, so join with whitespace
+		char *njoined=new char[len+buflen+1];
+		if (joined) memcpy(njoined,joined,len);
+		memcpy(njoined+len,buf,buflen);
+		njoined[len+buflen]='\n';
+		if (joined) delete[] joined;
+		joined=njoined;
+		len+=buflen+1;
+		delete[] buf;
+	}
+
+	if (*compressed && len) {
+		uLongf zlen=compressBound(len);
+		char *z=new char[zlen];
+		if (compress2((Bytef*)z,&zlen, (const Bytef*)joined,len, Z_DEFAULT_COMPRESSION)!=Z_OK) {
+			delete[] z;
+			*compressed=0;
+		} else {
+			delete[] joined;
+			joined=z;
+			len=zlen;
+		}
+	}
+
+	*joined_ret=joined;
+	*len_ret=len;
+	return 0;
+}
+
+//! Output a source pdf page as a Form XObject, and a reference to it in stream.
+/*! The displayed source page is mapped to the rectangle [minx,maxx]x[miny,maxy] of the current space.
+ *
+ * The source page's content stream and resources are copied verbatim, without decoding.
+ * The exception is pages whose content is split over several compressed streams. Those
+ * cannot just be concatenated, so they are inflated, joined, and compressed again.
+ *
+ * Objects shared between source pages, like fonts, are only written once per output file,
+ * and so is the Form XObject for any one source page, no matter how many times it is placed.
+ *
+ * Returns 0 for success, or nonzero if the page could not be output.
+ */
+static int pdfPlacePdfPage(FILE *f,
+						   PdfObjInfo *&obj,
+						   char *&stream,
+						   int &objectcount,
+						   Attribute &resources,
+						   PdfReader *reader,
+						   PdfSourcePage *page,
+						   double minx,double maxx,double miny,double maxy)
+{
+	if (page->Width()<=0 || page->Height()<=0) return 1;
+	if (reader->minorversion>pdf_minor_version) pdf_minor_version=reader->minorversion;
+
+
+	 //write out the Form XObject, if not done already for this file
+	if (page->outpass!=PdfReader::OutputPass() || page->outform<=0) {
+		NumStack<long> streams;
+		PdfValue *contents=reader->Resolve(page->contents);
+		if (contents && contents->type==PDFV_Array) {
+			for (int c=0; c<contents->items.n; c++) {
+				if (contents->items.e[c]->type==PDFV_Ref) streams.push(contents->items.e[c]->ref);
+			}
+		} else if (contents && page->contents->type==PDFV_Ref) streams.push(page->contents->ref);
+
+		const char *data=NULL;
+		char *joined=NULL;
+		long len=0;
+		int compressed=0;
+		PdfValue *streamdict=NULL; //has /Filter and /DecodeParms for pass through
+		if (streams.n==1) {
+			if (reader->StreamData(streams.e[0],&data,&len)==0) streamdict=reader->Object(streams.e[0]);
+			else len=0;
+
+		} else if (streams.n>1) {
+			if (pdfJoinContents(reader,streams, &joined,&len, &compressed)!=0) return 2;
+			data=joined;
+		}
+
+		NumStack<long> pending;
+		obj->next=new PdfObjInfo;
+		obj=obj->next;
+		obj->byteoffset=ftell(f);
+		obj->number=objectcount++;
+		fprintf(f,"%ld 0 obj\n",obj->number);
+		fprintf(f,"<<\n"
+				  "  /Type /XObject\n"
+				  "  /Subtype /Form\n"
+				  "  /BBox [%.10g %.10g %.10g %.10g]\n",
+				 page->mediabox[0],page->mediabox[1],page->mediabox[2],page->mediabox[3]);
+		fprintf(f,"  /Resources ");
+		if (page->resources) pdfWriteImported(f,page->resources,reader,objectcount,pending,-1);
+		else fprintf(f,"<< >>");
+		fprintf(f,"\n");
+
+		PdfValue *v;
+		if (streamdict && (v=streamdict->find("/Filter"))) {
+			fprintf(f,"  /Filter ");
+			pdfWriteImported(f,v,reader,objectcount,pending,-1);
+			fprintf(f,"\n");
+			if ((v=streamdict->find("/DecodeParms"))) {
+				fprintf(f,"  /DecodeParms ");
+				pdfWriteImported(f,v,reader,objectcount,pending,-1);
+				fprintf(f,"\n");
+			}
+		} else if (compressed) fprintf(f,"  /Filter /FlateDecode\n");
+
+		fprintf(f,"  /Length %ld\n"
+				  ">>\n"
+				  "stream\n", len);
+		if (len) fwrite(data,1,len,f);
+		fprintf(f,"\nendstream\n"
+				  "endobj\n");
+		if (joined) delete[] joined;
+
+		page->outform=obj->number;
+		page->outpass=PdfReader::OutputPass();
+
+		 //fonts, images, and whatever else the resources use
+		pdfWriteImportedObjects(f,obj,reader,objectcount,pending);
+	}
+
+
+	 //attach to content stream, mapping displayed source page to the bounds
+	double fm[6];
+	page->FormMatrix(fm);
+	double sx=(maxx>minx ? (maxx-minx)/page->Width()  : 1./72),
+		   sy=(maxy>miny ? (maxy-miny)/page->Height() : 1./72);
+	char scratch[250];
+	sprintf(scratch,"q\n"
+					"%.10f %.10f %.10f %.10f %.10f %.10f cm\n"
+					"/pdfpage%ld Do\n"
+					"Q\n",
+				fm[0]*sx, fm[1]*sy, fm[2]*sx, fm[3]*sy, fm[4]*sx+minx, fm[5]*sy+miny,
+				page->outform);
+	appendstr(stream,scratch);
+
+
+	 //Add form XObject to resources
+	Attribute *xobject=resources.find("/XObject");
+	sprintf(scratch,"/pdfpage%ld %ld 0 R\n",page->outform,page->outform);
+	if (xobject) {
+		if (!strstr(xobject->value,scratch)) appendstr(xobject->value,scratch);
+	} else {
+		resources.push("/XObject",scratch);
+	}
+	return 0;
+}
+
+//! Output a page imported by PdfImportFilter. See pdfPlacePdfPage().
+static void pdfPdfPage(FILE *f,
+					   PdfObjInfo *objs,
+					   PdfObjInfo *&obj,
+					   char *&stream,
+					   int &objectcount,
+					   Attribute &resources,
+					   MysteryData *mdata,
+					   ErrorLog &log,int &warning, DocumentExportConfig *config)
+{
+	const char *file=mdata->attributes->findValue("file");
+	PdfReader *reader=GetPdfReader(file,&log);
+	PdfSourcePage *page=(reader ? reader->Page(mdata->nativeid) : NULL);
+	int status=(page ? pdfPlacePdfPage(f,obj,stream,objectcount,resources, reader,page,
+									   mdata->minx,mdata->maxx,mdata->miny,mdata->maxy) : 1);
+	if (status!=0) {
+		setlocale(LC_ALL,"");
+		log.AddMessage(mdata->object_id,mdata->nameid,NULL,
+				status==2 ? _("Unsupported compression in imported pdf page.") : _("Could not find imported pdf page."),
+				ERROR_Warning);
+		setlocale(LC_ALL,"C");
+		warning++;
+	}
+}
+
+//--------------------------------------- pdfInstancedClones() ----------------------------------------
+
+//! Return the widest stroke in data or anything in it, in the coordinates of data's parent.
+/*! Weighted paths count their widest weight node.
+ */
+static double pdf_max_stroke_width(SomeData *data)
+{
+	double w=0, ww;
+
+	if (!strcmp(data->whattype(),"Group")) {
+		Group *g=dynamic_cast<Group *>(data);
+		for (int c=0; c<g->n(); c++) {
+			ww=pdf_max_stroke_width(g->e(c));
+			if (ww>w) w=ww;
+		}
+
+	} else if (!strcmp(data->whattype(),"PathsData")) {
+		PathsData *pdata=dynamic_cast<PathsData *>(data);
+		if (pdata->linestyle && pdata->linestyle->hasStroke()) w=pdata->linestyle->width;
+		for (int c=0; c<pdata->paths.n; c++) {
+			Path *path=pdata->paths.e[c];
+			if (!path->Weighted()) continue;
+			for (int c2=0; c2<path->pathweights.n; c2++) {
+				if (path->pathweights.e[c2]->width>w) w=path->pathweights.e[c2]->width;
+			}
+		}
+	}
+
+	 //scale by the most data's matrix stretches anything
+	double sx=norm(flatpoint(data->m(0),data->m(1))), sy=norm(flatpoint(data->m(2),data->m(3)));
+	return w*(sx>sy ? sx : sy);
+}
+
+//! Output an InstancedClones, as one Form XObject per source, drawn once per instance.
+static void pdfInstancedClones(FILE *f,
+							   PdfObjInfo *objs,
+							   PdfObjInfo *&obj,
+							   char *&stream,
+							   int &objectcount,
+							   Attribute &resources,
+							   InstancedClones *clones,
+							   ErrorLog &log,int &warning, DocumentExportConfig *config)
+{
+	int numsources=clones->NumSources();
+	if (!numsources || !clones->NumInstances()) return;
+
+	long *forms=new long[numsources];
+	for (int c=0; c<numsources; c++) forms[c]=-1;
+
+	SomeData *source;
+	double mi[6], mm[6];
+	char scratch[250];
+
+	for (int c=0; c<clones->NumInstances(); c++) {
+		int s=clones->InstanceSource(c);
+		source=clones->Source(s);
+		if (!source) continue;
+
+		 //the form contents include source->m(), but instances replace that matrix
+		transform_invert(mi,source->m());
+		transform_mult(mm,mi,clones->InstanceTransform(c));
+
+		if (forms[s]<0) {
+			 //write source contents to a new Form XObject
+			char *formstream=NULL;
+			Attribute formresources;
+			psPushCtm();
+			 //Anything in the source that gets rasterized, such as image patches, is rendered once
+			 //at the resolution this first instance needs. Every other instance of the source reuses
+			 //the same form, so instances scaled up much more than this one get a coarser raster.
+			psConcat(mm);
+			pdfdumpobj(f,objs,obj,formstream,objectcount,formresources,source,log,warning,config);
+			psPopCtm();
+
+			 //stroke widths are not in bounding boxes, so pad /BBox, which would clip otherwise.
+			 //Half the width would do for round joins, but miters stick out further
+			DoubleBBox box;
+			box.addtobounds(source->m(),source);
+			double pad=pdf_max_stroke_width(source);
+
+			obj->next=new PdfObjInfo;
+			obj=obj->next;
+			obj->byteoffset=ftell(f);
+			obj->number=objectcount++;
+			fprintf(f,"%ld 0 obj\n",obj->number);
+			fprintf(f,"<<\n"
+					  "  /Type /XObject\n"
+					  "  /Subtype /Form\n"
+					  "  /BBox [%.10g %.10g %.10g %.10g]\n",
+					 box.minx-pad, box.miny-pad, box.maxx+pad, box.maxy+pad);
+			fprintf(f,"  /Resources <<\n");
+			for (int c2=0; c2<formresources.attributes.n; c2++) {
+				fprintf(f,"    %s <<\n",formresources.attributes.e[c2]->name);
+				fprintf(f,"      %s\n",formresources.attributes.e[c2]->value);
+				fprintf(f,"    >>\n");
+			}
+			fprintf(f,"  >>\n");
+			fprintf(f,"  /Length %lu\n"
+					  ">>\n"
+					  "stream\n", formstream ? strlen(formstream) : 0);
+			if (formstream) fwrite(formstream,1,strlen(formstream),f);
+			fprintf(f,"\nendstream\n"
+					  "endobj\n");
+			delete[] formstream;
+
+			forms[s]=obj->number;
+
+			 //add form to the page's resources
+			Attribute *xobject=resources.find("/XObject");
+			sprintf(scratch,"/clone%ld %ld 0 R\n",forms[s],forms[s]);
+			if (xobject) appendstr(xobject->value,scratch);
+			else resources.push("/XObject",scratch);
+		}
+
+		sprintf(scratch,"q\n"
+						"%.10f %.10f %.10f %.10f %.10f %.10f cm\n"
+						"/clone%ld Do\n"
+						"Q\n",
+					mm[0],mm[1],mm[2],mm[3],mm[4],mm[5], forms[s]);
+		appendstr(stream,scratch);
+	}
+
+	delete[] forms;
+}
+
 //--------------------------------------- pdfImagePatch() ----------------------------------------
 
 //! Output pdf for an ImagePatchData. 
@@ -2173,5 +2714,215 @@ static int pdfaddpath(FILE *f, flatpoint *points,int n, char *&stream)
 }
 
 
+//------------------------------------ ImposePdf() ----------------------------------
+
+//! Impose the pages of infile into outfile, without making a Document.
+/*! This is for impose-only mode, and is meant for huge page counts. Paper spreads are laid out
+ * one at a time in output order with imp->PaperLayout(), and the source pages placed on each
+ * are written as Form XObjects, as in pdfPlacePdfPage(). Each sheet is written out completely
+ * and released before the next one is started, and the reader's object cache is flushed between
+ * sheets, so memory use does not grow with the number of pages. Only the xref table and the
+ * page tree's kids list do, at a few bytes per object.
+ *
+ * imp->NumPages() is set to the number of pages in infile. Source pages are scaled to fit
+ * the imposition's page cells, and centered.
+ *
+ * Return 0 for success, or nonzero for error.
+ */
+int ImposePdf(Imposition *imp, const char *infile, const char *outfile, Laxkit::ErrorLog &log)
+{
+	if (!imp || !infile || !outfile) return 1;
+
+	PdfReader *reader=GetPdfReader(infile,&log);
+	if (!reader) return 1;
+	reader->inc_count();
+	imp->NumPages(reader->NumPages());
+
+	FILE *f=open_file_for_writing(outfile,0,&log);
+	if (!f) {
+		reader->dec_count();
+		ReleasePdfReader(infile);
+		return 2;
+	}
+
+	setlocale(LC_ALL,"C");
+	PdfReader::BeginOutputPass();
+	pdf_minor_version=4;
+
+	 //object 0 is the head of free objects, and object 1 is reserved for the
+	 //Pages dict, so that page dicts can be written as soon as their sheet is done
+	PdfObjInfo *objs=new PdfObjInfo, *obj=objs;
+	objs->inuse='f';
+	objs->generation=65535;
+	PdfObjInfo *pagesobj=new PdfObjInfo;
+	pagesobj->number=1;
+	objs->next=pagesobj;
+	obj=pagesobj;
+	int objcount=2;
+
+	fprintf(f,"%%PDF-1.4\n");
+	fprintf(f,"%%\xff\xff\xff\xff\n");
+
+	NumStack<long> kids;
+	char scratch[300];
+	double m[6];
+	int warning=0;
+
+	for (int p=0; p<imp->NumPapers(); p++) {
+		Spread *spread=imp->PaperLayout(p); //not GetSpread(), which would cache every spread
+		if (!spread) continue;
+
+		 //some impositions lay out papers without a papergroup, which means just imp->paper, untransformed
+		PaperBox *box=NULL;
+		if (spread->papergroup && spread->papergroup->papers.n) {
+			box=spread->papergroup->papers.e[0]->box;
+			transform_invert(m,spread->papergroup->papers.e[0]->m());
+		} else {
+			box=imp->paper;
+			transform_identity(m);
+		}
+		if (!box || !box->paperstyle) {
+			sprintf(scratch,_("Missing paper for sheet %d."),p+1);
+			log.AddMessage(scratch,ERROR_Warning);
+			warning++;
+			spread->dec_count();
+			continue;
+		}
+
+		double pw=box->paperstyle->w(), ph=box->paperstyle->h();
+		char *stream=NULL;
+		Attribute resources;
+
+		appendstr(stream,"q\n"
+						 "72 0 0 72 0 0 cm\n"); // convert from inches
+		sprintf(scratch,"%.10f %.10f %.10f %.10f %.10f %.10f cm\n",
+				m[0], m[1], m[2], m[3], m[4], m[5]);
+		appendstr(stream,scratch);
+
+		for (int c=0; c<spread->pagestack.n(); c++) {
+			PageLocation *loc=spread->pagestack.e[c];
+			PdfSourcePage *page=reader->Page(loc->index);
+			if (!page || page->Width()<=0 || page->Height()<=0) continue;
+
+			 //fit source page to the page cell
+			SomeData *outline=loc->outline;
+			double cw=outline->maxx-outline->minx, ch=outline->maxy-outline->miny;
+			double scale=cw/(page->Width()/72);
+			if (ch/(page->Height()/72)<scale) scale=ch/(page->Height()/72);
+			double w=scale*page->Width()/72, h=scale*page->Height()/72;
+			double x=outline->minx+(cw-w)/2, y=outline->miny+(ch-h)/2;
+
+			const double *om=outline->m();
+			sprintf(scratch,"q\n"
+							"%.10f %.10f %.10f %.10f %.10f %.10f cm\n",
+					om[0], om[1], om[2], om[3], om[4], om[5]);
+			appendstr(stream,scratch);
+			if (pdfPlacePdfPage(f,obj,stream,objcount,resources, reader,page, x,x+w,y,y+h)!=0) {
+				sprintf(scratch,_("Could not impose page %d."),loc->index+1);
+				log.AddMessage(scratch,ERROR_Warning);
+				warning++;
+			}
+			appendstr(stream,"Q\n");
+		}
+		appendstr(stream,"Q\n");
+		spread->dec_count();
+
+		 //the sheet's content stream
+		obj->next=new PdfObjInfo;
+		obj=obj->next;
+		obj->number=objcount++;
+		obj->byteoffset=ftell(f);
+		fprintf(f,"%ld 0 obj\n"
+				  "<< /Length %lu >>\n"
+				  "stream\n",
+					obj->number, strlen(stream));
+		fwrite(stream,1,strlen(stream),f);
+		fprintf(f,"\nendstream\n"
+				  "endobj\n");
+		long contents=obj->number;
+		delete[] stream;
+
+		 //and its page dict
+		obj->next=new PdfObjInfo;
+		obj=obj->next;
+		obj->number=objcount++;
+		obj->byteoffset=ftell(f);
+		kids.push(obj->number);
+		fprintf(f,"%ld 0 obj\n"
+				  "<<\n  /Type /Page\n"
+				  "  /Parent 1 0 R\n"
+				  "  /MediaBox [0 0 %f %f]\n"
+				  "  /Contents %ld 0 R\n",
+				obj->number, pw*72, ph*72, contents);
+		fprintf(f,"  /Resources <<\n");
+		for (int c=0; c<resources.attributes.n; c++) {
+			fprintf(f,"    %s <<\n",resources.attributes.e[c]->name);
+			fprintf(f,"      %s\n",resources.attributes.e[c]->value);
+			fprintf(f,"    >>\n");
+		}
+		fprintf(f,"  >>\n"
+				  ">>\n"
+				  "endobj\n");
+
+		reader->ReleaseObjects();
+	}
+
+	 //the reserved Pages dict
+	pagesobj->byteoffset=ftell(f);
+	fprintf(f,"1 0 obj\n"
+			  "<<\n  /Type /Pages\n"
+			  "  /Kids [");
+	for (int c=0; c<kids.n; c++) fprintf(f,"%ld 0 R%s",kids.e[c], (c%10==9 ? "\n    " : " "));
+	fprintf(f,"]\n"
+			  "  /Count %d\n"
+			  ">>\n"
+			  "endobj\n", kids.n);
+
+	 //catalog
+	long doccatalog=objcount++;
+	obj->next=new PdfObjInfo;
+	obj=obj->next;
+	obj->number=doccatalog;
+	obj->byteoffset=ftell(f);
+	fprintf(f,"%ld 0 obj\n"
+			  "<<\n  /Type /Catalog\n"
+			  "  /Version /1.%d\n"
+			  "  /Pages 1 0 R\n"
+			  ">>\n"
+			  "endobj\n", doccatalog, pdf_minor_version);
+
+	 //xref, trailer
+	long xrefpos=ftell(f);
+	int count=0;
+	for (obj=objs; obj; obj=obj->next) count++;
+	fprintf(f,"xref\n%d %d\n",0,count);
+	for (obj=objs; obj; obj=obj->next) {
+		fprintf(f,"%010lu %05d %c \n",obj->byteoffset,obj->generation,obj->inuse);
+	}
+	fprintf(f,"trailer\n<< /Size %d\n"
+			  "    /Root %ld 0 R\n"
+			  ">>\n"
+			  "startxref\n%ld\n"
+			  "%%%%EOF\n", count, doccatalog, xrefpos);
+
+	fclose(f);
+	setlocale(LC_ALL,"");
+
+	 //iteratively, since ~PdfObjInfo() would recurse once per object
+	while (objs) {
+		obj=objs->next;
+		objs->next=NULL;
+		delete objs;
+		objs=obj;
+	}
+	reader->ReleaseObjects();
+	reader->dec_count();
+	ReleasePdfReader(infile);
+
+	DBG cerr <<"ImposePdf: "<<kids.n<<" sheets, "<<warning<<" warnings"<<endl;
+	return 0;
+}
+
+
 } // namespace Laidout
 
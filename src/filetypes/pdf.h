@@ -23,6 +23,7 @@
 namespace Laidout {
 
 void installPdfFilter();
+int ImposePdf(Imposition *imp, const char *infile, const char *outfile, Laxkit::ErrorLog &log);
 
 
 //------------------------------------ PdfExportFilter ----------------------------------
@@ -0,0 +1,1061 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+#include <lax/strmanip.h>
+#include <lax/refptrstack.cc>
+#include <lax/lists.cc>
+#include "../language.h"
+#include "pdfreader.h"
+
+#include <zlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
+
+#include <iostream>
+#define DBG
+
+using namespace std;
+using namespace Laxkit;
+
+
+namespace Laidout {
+
+
+/*! \file
+ * A minimal pdf reader, just enough to find source pages and copy their content
+ * streams and resources verbatim into other pdfs.
+ */
+
+
+//------------------------------------- PdfValue -----------------------------------
+
+/*! \class PdfValue
+ * \brief One parsed pdf object, or part of one.
+ *
+ * Atoms keep their raw source text, so strings, names, and numbers can be written
+ * back out exactly as they were read, without having to decode or re-escape anything.
+ */
+
+PdfValue::PdfValue(PdfValueType ntype)
+  : keys(LISTS_DELETE_Array)
+{
+	type=ntype;
+	text=NULL;
+	num=0;
+	ref=0;
+	gen=0;
+}
+
+PdfValue::~PdfValue()
+{
+	if (text) delete[] text;
+}
+
+//! Return the value for key in a dict, or NULL. key should include the leading '/'.
+PdfValue *PdfValue::find(const char *key)
+{
+	if (type!=PDFV_Dict) return NULL;
+	for (int c=0; c<keys.n; c++) {
+		if (!strcmp(keys.e[c],key)) return items.e[c];
+	}
+	return NULL;
+}
+
+//! Return whether this is a name equal to name. name should include the leading '/'.
+int PdfValue::IsName(const char *name)
+{
+	return type==PDFV_Name && !strcmp(text,name);
+}
+
+
+//------------------------------------- parsing helpers -----------------------------------
+
+static int pdf_isspace(char ch)
+{
+	return ch==' ' || ch=='\n' || ch=='\r' || ch=='\t' || ch=='\f' || ch=='\0';
+}
+
+static int pdf_isdelim(char ch)
+{
+	return ch=='(' || ch==')' || ch=='<' || ch=='>' || ch=='[' || ch==']'
+		|| ch=='{' || ch=='}' || ch=='/' || ch=='%';
+}
+
+//! Skip whitespace and comments.
+static const char *pdf_skip(const char *p, const char *end)
+{
+	while (p<end) {
+		if (pdf_isspace(*p)) p++;
+		else if (*p=='%') {
+			while (p<end && *p!='\n' && *p!='\r') p++;
+		} else break;
+	}
+	return p;
+}
+
+//! Return whether the keyword word starts at p, and ends at a token boundary.
+static int pdf_keyword(const char *p, const char *end, const char *word)
+{
+	int n=strlen(word);
+	if (end-p<n || strncmp(p,word,n)) return 0;
+	return p+n==end || pdf_isspace(p[n]) || pdf_isdelim(p[n]);
+}
+
+//! Parse a nonnegative integer at p, returning the position after it, or NULL.
+static const char *pdf_int(const char *p, const char *end, long *i)
+{
+	if (p>=end || !isdigit(*p)) return NULL;
+	long v=0;
+	while (p<end && isdigit(*p)) { v=v*10+(*p-'0'); p++; }
+	*i=v;
+	return p;
+}
+
+static PdfValue *pdf_parse(const char *&p, const char *end, int depth);
+
+//! Parse one value at p. On success, p is advanced past the value.
+/*! Returns NULL for keywords that are not values, such as "stream" or "endobj".
+ */
+static PdfValue *pdf_parse(const char *&p, const char *end, int depth)
+{
+	p=pdf_skip(p,end);
+	if (p>=end || depth>100) return NULL;
+	const char *start=p;
+	PdfValue *v=NULL;
+
+	if (*p=='[') {
+		p++;
+		v=new PdfValue(PDFV_Array);
+		PdfValue *item;
+		while (1) {
+			p=pdf_skip(p,end);
+			if (p>=end) break;
+			if (*p==']') { p++; break; }
+			item=pdf_parse(p,end,depth+1);
+			if (!item) { delete v; return NULL; }
+			v->items.push(item);
+		}
+
+	} else if (*p=='<' && p+1<end && p[1]=='<') {
+		p+=2;
+		v=new PdfValue(PDFV_Dict);
+		PdfValue *item;
+		while (1) {
+			p=pdf_skip(p,end);
+			if (p>=end) break;
+			if (*p=='>' && p+1<end && p[1]=='>') { p+=2; break; }
+			if (*p!='/') { delete v; return NULL; }
+			item=pdf_parse(p,end,depth+1);
+			if (!item) { delete v; return NULL; }
+			char *key=item->text; item->text=NULL;
+			delete item;
+			item=pdf_parse(p,end,depth+1);
+			if (!item) { delete[] key; delete v; return NULL; }
+			v->keys.push(key);
+			v->items.push(item);
+		}
+
+	} else if (*p=='<') {
+		while (p<end && *p!='>') p++;
+		if (p<end) p++;
+		v=new PdfValue(PDFV_String);
+
+	} else if (*p=='(') {
+		int nesting=0;
+		while (p<end) {
+			if (*p=='\\') { p+=2; continue; }
+			if (*p=='(') nesting++;
+			else if (*p==')') { nesting--; if (nesting==0) { p++; break; } }
+			p++;
+		}
+		if (p>end) p=end;
+		v=new PdfValue(PDFV_String);
+
+	} else if (*p=='/') {
+		p++;
+		while (p<end && !pdf_isspace(*p) && !pdf_isdelim(*p)) p++;
+		v=new PdfValue(PDFV_Name);
+
+	} else if (isdigit(*p) || *p=='-' || *p=='+' || *p=='.') {
+		p++;
+		while (p<end && (isdigit(*p) || *p=='.')) p++;
+		v=new PdfValue(PDFV_Number);
+		v->num=strtod(start,NULL);
+
+		 //check for "num gen R"
+		long num,gen;
+		if (isdigit(*start) && pdf_int(start,end,&num)==p) {
+			const char *pp=pdf_skip(p,end);
+			pp=pdf_int(pp,end,&gen);
+			if (pp) {
+				pp=pdf_skip(pp,end);
+				if (pdf_keyword(pp,end,"R")) {
+					v->type=PDFV_Ref;
+					v->ref=num;
+					v->gen=gen;
+					p=pp+1;
+					return v;
+				}
+			}
+		}
+
+	} else if (pdf_keyword(p,end,"true") || pdf_keyword(p,end,"false")) {
+		p+=(*p=='t' ? 4 : 5);
+		v=new PdfValue(PDFV_Bool);
+		v->num=(*start=='t');
+
+	} else if (pdf_keyword(p,end,"null")) {
+		p+=4;
+		v=new PdfValue(PDFV_Null);
+
+	} else return NULL;
+
+	v->text=newnstr(start,p-start);
+	return v;
+}
+
+
+//----------------------------------- decoding helpers ------------------------------------
+
+//! Streams that inflate to more than this are refused, rather than decompressing a bomb.
+#define PDF_MAX_DECODED_LENGTH (256*1024*1024L)
+
+//! Inflate zlib data. Returns 0 for success, with a new[]'d buffer in out_ret.
+/*! Truncated data is not an error, as long as something could be decoded, since
+ * plenty of pdfs in the wild have slightly broken streams.
+ *
+ * Returns 3 if the output would be more than PDF_MAX_DECODED_LENGTH.
+ */
+int PdfFlateDecode(const char *in, long inlen, char **out_ret, long *outlen_ret)
+{
+	z_stream z;
+	memset(&z,0,sizeof(z));
+	if (inflateInit(&z)!=Z_OK) return 1;
+
+	long max=(inlen<1024 ? 4096 : inlen*4), len=0;
+	char *out=new char[max];
+	z.next_in =(Bytef*)in;
+	z.avail_in=inlen;
+
+	int status=Z_OK;
+	while (status==Z_OK) {
+		if (len==max) {
+			if (max>=PDF_MAX_DECODED_LENGTH) {
+				inflateEnd(&z);
+				delete[] out;
+				return 3;
+			}
+			char *nout=new char[max*2];
+			memcpy(nout,out,len);
+			delete[] out;
+			out=nout;
+			max*=2;
+		}
+		z.next_out =(Bytef*)(out+len);
+		z.avail_out=max-len;
+		status=inflate(&z,Z_NO_FLUSH);
+		len=max-z.avail_out;
+	}
+	inflateEnd(&z);
+
+	if (status!=Z_STREAM_END && len==0) {
+		delete[] out;
+		return 2;
+	}
+	*out_ret=out;
+	*outlen_ret=len;
+	return 0;
+}
+
+static int paeth(int a, int b, int c)
+{
+	int p=a+b-c, pa=abs(p-a), pb=abs(p-b), pc=abs(p-c);
+	if (pa<=pb && pa<=pc) return a;
+	if (pb<=pc) return b;
+	return c;
+}
+
+//! Undo png predictors in place. Returns the new length.
+/*! colors, bpc and columns must be positive. See PdfDecodeStream().
+ */
+static long pdf_unpredict(char *buf, long len, int colors, int bpc, int columns)
+{
+	int bpp=(colors*bpc+7)/8;
+	int rowlen=(colors*bpc*columns+7)/8;
+	unsigned char *d=(unsigned char*)buf, *out=(unsigned char*)buf;
+	unsigned char *prev=NULL;
+	long outlen=0;
+
+	for (long pos=0; pos+rowlen+1<=len; pos+=rowlen+1) {
+		int filter=d[pos];
+		unsigned char *row=d+pos+1;
+		unsigned char *o=out+outlen; //note o is always before row, so in place is ok
+		for (int c=0; c<rowlen; c++) {
+			int a=(c>=bpp ? o[c-bpp] : 0);
+			int b=(prev ? prev[c] : 0);
+			int cc=(prev && c>=bpp ? prev[c-bpp] : 0);
+			int x=row[c];
+			if      (filter==1) x+=a;
+			else if (filter==2) x+=b;
+			else if (filter==3) x+=(a+b)/2;
+			else if (filter==4) x+=paeth(a,b,cc);
+			o[c]=x;
+		}
+		prev=o;
+		outlen+=rowlen;
+	}
+	return outlen;
+}
+
+//! Decode stream data according to the /Filter in dict.
+/*! Only FlateDecode, with or without png predictors, is understood, which is all
+ * that is needed to read xref streams and object streams.
+ * Returns 0 for success, with a new[]'d buffer in out_ret.
+ */
+int PdfDecodeStream(PdfValue *dict, const char *in, long inlen, char **out_ret, long *outlen_ret)
+{
+	PdfValue *filter=dict->find("/Filter");
+	PdfValue *parms =dict->find("/DecodeParms");
+	if (filter && filter->type==PDFV_Array) {
+		if (filter->items.n>1) return 1;
+		filter=(filter->items.n ? filter->items.e[0] : NULL);
+	}
+	if (parms && parms->type==PDFV_Array) parms=(parms->items.n ? parms->items.e[0] : NULL);
+
+	if (!filter) {
+		*out_ret=newnstr(in,inlen);
+		*outlen_ret=inlen;
+		return 0;
+	}
+	if (!filter->IsName("/FlateDecode") && !filter->IsName("/Fl")) return 1;
+
+	char *out=NULL;
+	long outlen=0;
+	if (PdfFlateDecode(in,inlen, &out,&outlen)!=0) return 2;
+
+	PdfValue *v;
+	int predictor=((v=(parms ? parms->find("/Predictor") : NULL)) ? v->num : 1);
+	if (predictor>=10) {
+		int colors =((v=parms->find("/Colors"))           ? v->num : 1);
+		int bpc    =((v=parms->find("/BitsPerComponent")) ? v->num : 8);
+		int columns=((v=parms->find("/Columns"))          ? v->num : 1);
+		if (colors<=0 || colors>32 || bpc<=0 || bpc>16 || columns<=0 || columns>1000000) {
+			delete[] out;
+			return 3;
+		}
+		outlen=pdf_unpredict(out,outlen, colors,bpc,columns);
+	} else if (predictor!=1) {
+		delete[] out;
+		return 3;
+	}
+
+	*out_ret=out;
+	*outlen_ret=outlen;
+	return 0;
+}
+
+
+//------------------------------------- PdfSourcePage -----------------------------------
+
+/*! \class PdfSourcePage
+ * \brief Lightweight handle on one page of a pdf opened with PdfReader.
+ *
+ * Nothing about the page content is parsed. It is just the page's box, rotation,
+ * and references to its resources and content streams, which the pdf exporter
+ * copies as is into a Form XObject.
+ */
+
+PdfSourcePage::PdfSourcePage()
+{
+	object=0;
+	mediabox[0]=mediabox[1]=0;
+	mediabox[2]=612; mediabox[3]=792;
+	rotate=0;
+	resources=NULL;
+	contents=NULL;
+	outform=0;
+	outpass=0;
+}
+
+//! Displayed width in points, after /Rotate.
+double PdfSourcePage::Width()
+{
+	if (rotate==90 || rotate==270) return fabs(mediabox[3]-mediabox[1]);
+	return fabs(mediabox[2]-mediabox[0]);
+}
+
+//! Displayed height in points, after /Rotate.
+double PdfSourcePage::Height()
+{
+	if (rotate==90 || rotate==270) return fabs(mediabox[2]-mediabox[0]);
+	return fabs(mediabox[3]-mediabox[1]);
+}
+
+//! Transform from the page's content space to displayed page space, with the lower left corner at the origin, in points.
+void PdfSourcePage::FormMatrix(double *m)
+{
+	double llx=mediabox[0], lly=mediabox[1], urx=mediabox[2], ury=mediabox[3];
+	if (rotate==90) {
+		m[0]=0;  m[1]=-1; m[2]=1;  m[3]=0;  m[4]=-lly; m[5]=urx;
+	} else if (rotate==180) {
+		m[0]=-1; m[1]=0;  m[2]=0;  m[3]=-1; m[4]=urx;  m[5]=ury;
+	} else if (rotate==270) {
+		m[0]=0;  m[1]=1;  m[2]=-1; m[3]=0;  m[4]=ury;  m[5]=-llx;
+	} else {
+		m[0]=1;  m[1]=0;  m[2]=0;  m[3]=1;  m[4]=-llx; m[5]=-lly;
+	}
+}
+
+
+//------------------------------------- PdfReader -----------------------------------
+
+/*! \class PdfReader
+ * \brief Random access to the objects of a pdf file.
+ *
+ * The file is mapped into memory, and only the cross reference sections, the page tree, and
+ * whatever objects are asked for get parsed. Both classic xref tables and (pdf 1.5) xref and
+ * object streams are understood. If the cross reference information is broken, the file is
+ * scanned for objects instead.
+ *
+ * Readers are shared. Use GetPdfReader() rather than creating new ones.
+ */
+/*! \var long *PdfReader::outnumbers
+ * \brief Object numbers that source objects have been assigned in the current output pass.
+ *
+ * This lets many placements of pages from the same file share fonts, images, and
+ * the page Form XObjects themselves. See BeginOutputPass().
+ */
+
+static unsigned long pdf_output_pass=0;
+
+PdfReader::PdfReader()
+{
+	fd=-1;
+	data=NULL;
+	datalen=0;
+	mtime=0;
+	numobjects=0;
+	offsets=NULL;
+	objstreams=NULL;
+	objects=NULL;
+	pinned=NULL;
+	streamstart=NULL;
+	streamlen=NULL;
+	outnumbers=NULL;
+	outpass=0;
+	rootobj=-1;
+	filename=NULL;
+	minorversion=4;
+}
+
+PdfReader::~PdfReader()
+{
+	Close();
+}
+
+void PdfReader::Close()
+{
+	if (data) munmap(data,datalen);
+	if (fd>=0) close(fd);
+	fd=-1;
+	data=NULL;
+	datalen=0;
+
+	if (objects) {
+		for (long c=0; c<numobjects; c++) if (objects[c]) delete objects[c];
+		delete[] objects;
+	}
+	if (offsets)     delete[] offsets;
+	if (objstreams)  delete[] objstreams;
+	if (streamstart) delete[] streamstart;
+	if (streamlen)   delete[] streamlen;
+	if (outnumbers)  delete[] outnumbers;
+	if (pinned)      delete[] pinned;
+	offsets=objstreams=streamstart=streamlen=outnumbers=NULL;
+	objects=NULL;
+	pinned=NULL;
+	numobjects=0;
+	rootobj=-1;
+	pages.flush();
+	if (filename) { delete[] filename; filename=NULL; }
+}
+
+//! Make sure the object tables can hold object numbers up to n-1.
+int PdfReader::Allocate(long n)
+{
+	if (n<=numobjects) return 0;
+	if (n>10000000) return 1;
+
+	long *noffsets=new long[n], *nobjstreams=new long[n], *nstart=new long[n], *nlen=new long[n], *nout=new long[n];
+	PdfValue **nobjects=new PdfValue*[n];
+	for (long c=0; c<n; c++) {
+		if (c<numobjects) {
+			noffsets[c]=offsets[c];
+			nobjstreams[c]=objstreams[c];
+			nobjects[c]=objects[c];
+			nstart[c]=streamstart[c];
+			nlen[c]=streamlen[c];
+			nout[c]=outnumbers[c];
+		} else {
+			noffsets[c]=nobjstreams[c]=nstart[c]=nlen[c]=-1;
+			nobjects[c]=NULL;
+			nout[c]=0;
+		}
+	}
+	if (offsets) {
+		delete[] offsets; delete[] objstreams; delete[] objects;
+		delete[] streamstart; delete[] streamlen; delete[] outnumbers;
+	}
+	offsets=noffsets;
+	objstreams=nobjstreams;
+	objects=nobjects;
+	streamstart=nstart;
+	streamlen=nlen;
+	outnumbers=nout;
+	numobjects=n;
+	return 0;
+}
+
+//! Open file, read its cross reference info and page tree. Return 0 for success.
+int PdfReader::Open(const char *file, Laxkit::ErrorLog *log)
+{
+	Close();
+
+	struct stat st;
+	fd=open(file,O_RDONLY);
+	if (fd<0 || fstat(fd,&st)!=0 || st.st_size<8) {
+		if (log) log->AddMessage(_("Could not open pdf file."),ERROR_Fail);
+		Close();
+		return 1;
+	}
+	datalen=st.st_size;
+	mtime=st.st_mtime;
+	data=(char*)mmap(NULL,datalen,PROT_READ,MAP_PRIVATE,fd,0);
+	if (data==MAP_FAILED) {
+		data=NULL;
+		if (log) log->AddMessage(_("Could not open pdf file."),ERROR_Fail);
+		Close();
+		return 1;
+	}
+	filename=newstr(file);
+	if (!strncmp(data,"%PDF-1.",7) && isdigit(data[7])) minorversion=data[7]-'0';
+
+	 //find startxref near the end
+	long xref=-1;
+	const char *end=data+datalen;
+	for (const char *p=end-9; p>=data && p>end-2048; p--) {
+		if (!strncmp(p,"startxref",9)) {
+			const char *pp=pdf_skip(p+9,end);
+			if (!pdf_int(pp,end,&xref)) xref=-1;
+			break;
+		}
+	}
+
+	int status=(xref>=0 && xref<datalen ? ReadXref(xref,0) : 1);
+	if (status==2) {
+		if (log) log->AddMessage(_("Encrypted pdfs are not supported."),ERROR_Fail);
+		Close();
+		return 2;
+	}
+	if (status!=0 || rootobj<0) {
+		if (log) log->AddMessage(_("Damaged pdf cross reference, scanning for objects."),ERROR_Warning);
+		if (Reconstruct()!=0) {
+			if (log) log->AddMessage(_("Could not read pdf file."),ERROR_Fail);
+			Close();
+			return 2;
+		}
+	}
+
+	PdfValue *root=Object(rootobj);
+	PdfValue *pagetree=(root ? Resolve(root->find("/Pages")) : NULL);
+	char *visited=new char[numobjects];
+	memset(visited,0,numobjects);
+	status=(pagetree ? ReadPageTree(pagetree, NULL,NULL,0, 0, visited) : 1);
+	delete[] visited;
+	if (status!=0 || pages.n==0) {
+		if (log) log->AddMessage(_("Could not find any pages in pdf."),ERROR_Fail);
+		Close();
+		return 3;
+	}
+
+	 //the page tree and whatever else was needed to get to it stays parsed
+	pinned=new char[numobjects];
+	for (long c=0; c<numobjects; c++) pinned[c]=(objects[c]!=NULL);
+
+	DBG cerr <<"PdfReader opened "<<file<<", "<<numobjects<<" objects, "<<pages.n<<" pages"<<endl;
+	return 0;
+}
+
+//! Return whether the file on disk has changed since it was opened.
+int PdfReader::IsStale()
+{
+	struct stat st;
+	if (!filename || stat(filename,&st)!=0) return 1;
+	return st.st_mtime!=mtime || st.st_size!=datalen;
+}
+
+//! Read a cross reference section, and any previous sections it points to.
+/*! Entries already found are not overwritten, since newer sections are read first.
+ */
+int PdfReader::ReadXref(long offset, int depth)
+{
+	if (depth>50 || offset<0 || offset>=datalen) return 1;
+	const char *p=pdf_skip(data+offset, data+datalen);
+	if (pdf_keyword(p,data+datalen,"xref")) return ReadXrefTable(p+4,depth);
+	return ReadXrefStream(p,depth);
+}
+
+int PdfReader::ReadXrefTable(const char *p, int depth)
+{
+	const char *end=data+datalen;
+	long start,n, off,gen;
+
+	while (1) {
+		p=pdf_skip(p,end);
+		if (pdf_keyword(p,end,"trailer")) break;
+		if (!(p=pdf_int(p,end,&start))) return 1;
+		p=pdf_skip(p,end);
+		if (!(p=pdf_int(p,end,&n))) return 1;
+		if (start<0 || n<0 || Allocate(start+n)!=0) return 1;
+
+		for (long c=0; c<n; c++) {
+			p=pdf_skip(p,end);
+			if (!(p=pdf_int(p,end,&off))) return 1;
+			p=pdf_skip(p,end);
+			if (!(p=pdf_int(p,end,&gen))) return 1;
+			p=pdf_skip(p,end);
+			if (p>=end) return 1;
+			if (*p=='n' && off>=0 && off<datalen && offsets[start+c]<0 && objstreams[start+c]<0 && start+c!=0) offsets[start+c]=off;
+			p++;
+		}
+	}
+
+	p+=7;
+	PdfValue *trailer=pdf_parse(p,end,0);
+	if (!trailer) return 1;
+
+	 //hybrid files keep compressed objects in an extra xref stream
+	PdfValue *v=trailer->find("/XRefStm");
+	if (v && v->type==PDFV_Number) ReadXref((long)v->num,depth+1);
+
+	int status=ReadTrailer(trailer,depth);
+	delete trailer;
+	return status;
+}
+
+int PdfReader::ReadXrefStream(const char *p, int depth)
+{
+	const char *end=data+datalen;
+	long num,gen;
+	if (!(p=pdf_int(p,end,&num))) return 1;
+	p=pdf_skip(p,end);
+	if (!(p=pdf_int(p,end,&gen))) return 1;
+	p=pdf_skip(p,end);
+	if (!pdf_keyword(p,end,"obj")) return 1;
+	p+=3;
+
+	PdfValue *dict=pdf_parse(p,end,0);
+	if (!dict || dict->type!=PDFV_Dict || !dict->find("/Type") || !dict->find("/Type")->IsName("/XRef")) {
+		if (dict) delete dict;
+		return 1;
+	}
+
+	 //xref streams must have a direct /Length
+	p=pdf_skip(p,end);
+	PdfValue *length=dict->find("/Length");
+	if (!pdf_keyword(p,end,"stream") || !length || length->type!=PDFV_Number || length->num<0) { delete dict; return 1; }
+	p+=6;
+	if (p<end && *p=='\r') p++;
+	if (p<end && *p=='\n') p++;
+	if ((long)length->num>end-p) { delete dict; return 1; }
+
+	char *buf=NULL;
+	long len=0;
+	if (PdfDecodeStream(dict, p,(long)length->num, &buf,&len)!=0) { delete dict; return 1; }
+
+	PdfValue *w=dict->find("/W");
+	PdfValue *size=dict->find("/Size");
+	if (!w || w->type!=PDFV_Array || w->items.n!=3 || !size) { delete[] buf; delete dict; return 1; }
+	 //each field is read into a long, so can be at most 8 bytes
+	int ws[3];
+	for (int c=0; c<3; c++) {
+		if (w->items.e[c]->type!=PDFV_Number || w->items.e[c]->num<0 || w->items.e[c]->num>8) { delete[] buf; delete dict; return 1; }
+		ws[c]=w->items.e[c]->num;
+	}
+	int entrylen=ws[0]+ws[1]+ws[2];
+	if (entrylen<=0 || Allocate((long)size->num)!=0) { delete[] buf; delete dict; return 1; }
+
+	 //default subsection is [0 Size]
+	PdfValue *index=dict->find("/Index");
+	NumStack<long> subsections;
+	if (index && index->type==PDFV_Array) {
+		for (int c=0; c+1<index->items.n; c+=2) {
+			if (index->items.e[c]->num<0 || index->items.e[c+1]->num<0) { delete[] buf; delete dict; return 1; }
+			subsections.push(index->items.e[c]->num);
+			subsections.push(index->items.e[c+1]->num);
+		}
+	} else {
+		subsections.push(0);
+		subsections.push(size->num);
+	}
+
+	unsigned char *d=(unsigned char*)buf;
+	long pos=0;
+	long fields[3];
+	for (int s=0; s<subsections.n; s+=2) {
+		long start=subsections.e[s];
+		if (Allocate(start+subsections.e[s+1])!=0) break;
+
+		for (long c=0; c<subsections.e[s+1] && pos+entrylen<=len; c++) {
+			for (int f=0; f<3; f++) {
+				fields[f]=0;
+				for (int b=0; b<ws[f]; b++) fields[f]=(fields[f]<<8) | d[pos++];
+			}
+			if (ws[0]==0) fields[0]=1;
+
+			long i=start+c;
+			if (i==0 || offsets[i]>=0 || objstreams[i]>=0) continue;
+			if (fields[0]==1) { if (fields[1]>=0 && fields[1]<datalen) offsets[i]=fields[1]; }
+			else if (fields[0]==2) objstreams[i]=fields[1];
+		}
+	}
+	delete[] buf;
+
+	int status=ReadTrailer(dict,depth);
+	delete dict;
+	return status;
+}
+
+//! Grab /Root if we don't have it yet, and follow /Prev.
+int PdfReader::ReadTrailer(PdfValue *trailer, int depth)
+{
+	if (trailer->find("/Encrypt")) return 2;
+
+	PdfValue *v=trailer->find("/Root");
+	if (v && v->type==PDFV_Ref && rootobj<0) rootobj=v->ref;
+
+	v=trailer->find("/Prev");
+	if (v && v->type==PDFV_Number) ReadXref((long)v->num,depth+1);
+
+	return 0;
+}
+
+//! Rebuild the object tables by scanning the whole file for "num gen obj".
+int PdfReader::Reconstruct()
+{
+	const char *end=data+datalen;
+	const char *p, *pp;
+	long num,gen;
+
+	if (offsets) {
+		for (long c=0; c<numobjects; c++) {
+			offsets[c]=objstreams[c]=-1;
+			if (objects[c]) { delete objects[c]; objects[c]=NULL; }
+		}
+	}
+	rootobj=-1;
+
+	for (p=data; p<end-3; p++) {
+		if (strncmp(p,"obj",3) || !pdf_keyword(p,end,"obj")) continue;
+
+		 //back up over "num gen "
+		pp=p-1;
+		while (pp>data && pdf_isspace(*pp)) pp--;
+		while (pp>data && isdigit(*pp)) pp--;
+		while (pp>data && pdf_isspace(*pp)) pp--;
+		while (pp>data && isdigit(*(pp-1))) pp--;
+		if (!isdigit(*pp)) continue;
+
+		const char *n=pdf_int(pp,end,&num);
+		if (!n || Allocate(num+1)!=0) continue;
+		n=pdf_int(pdf_skip(n,end),end,&gen);
+		if (!n || pdf_skip(n,end)!=p) continue;
+		offsets[num]=pp-data;
+	}
+
+	 //look for the catalog
+	for (long c=1; c<numobjects && rootobj<0; c++) {
+		if (offsets[c]<0) continue;
+		PdfValue *v=Object(c);
+		if (v && v->find("/Type") && v->find("/Type")->IsName("/Catalog")) rootobj=c;
+	}
+	return rootobj<0 ? 1 : 0;
+}
+
+//! Parse object num out of object stream objstreams[num], caching all objects in that stream.
+int PdfReader::LoadObjectStream(long num)
+{
+	long stmnum=objstreams[num];
+	if (stmnum<=0 || stmnum>=numobjects || objstreams[stmnum]>=0) return 1;
+
+	PdfValue *dict=Object(stmnum);
+	const char *raw=NULL;
+	long rawlen=0;
+	if (!dict || StreamData(stmnum,&raw,&rawlen)!=0) return 1;
+
+	char *buf=NULL;
+	long len=0;
+	if (PdfDecodeStream(dict, raw,rawlen, &buf,&len)!=0) return 1;
+
+	PdfValue *v;
+	long n    =((v=dict->find("/N"))     ? v->num : 0);
+	long first=((v=dict->find("/First")) ? v->num : 0);
+	if (first<0 || first>=len) { delete[] buf; return 1; }
+	const char *p=buf, *end=buf+len;
+	long onum,ooff;
+
+	for (long c=0; c<n; c++) {
+		p=pdf_skip(p,end);
+		if (!(p=pdf_int(p,end,&onum))) break;
+		p=pdf_skip(p,end);
+		if (!(p=pdf_int(p,end,&ooff))) break;
+		if (onum<=0 || onum>=numobjects || objects[onum] || objstreams[onum]!=stmnum) continue;
+		if (ooff<0 || first+ooff>=len) continue;
+
+		const char *op=buf+first+ooff;
+		objects[onum]=pdf_parse(op,end,0);
+	}
+
+	delete[] buf;
+	return objects[num] ? 0 : 1;
+}
+
+//! Parse the object at offset, and note where its stream data is, if any.
+PdfValue *PdfReader::ParseObject(long num, long offset)
+{
+	if (offset<0 || offset>=datalen) return NULL;
+	const char *end=data+datalen;
+	const char *p=data+offset;
+	long onum,ogen;
+
+	if (!(p=pdf_int(p,end,&onum)) || onum!=num) return NULL;
+	p=pdf_skip(p,end);
+	if (!(p=pdf_int(p,end,&ogen))) return NULL;
+	p=pdf_skip(p,end);
+	if (!pdf_keyword(p,end,"obj")) return NULL;
+	p+=3;
+
+	PdfValue *v=pdf_parse(p,end,0);
+	if (!v) return NULL;
+	objects[num]=v; //so an indirect /Length that points back here does not recurse forever
+
+	p=pdf_skip(p,end);
+	if (v->type==PDFV_Dict && pdf_keyword(p,end,"stream")) {
+		p+=6;
+		if (p<end && *p=='\r') p++;
+		if (p<end && *p=='\n') p++;
+
+		long len=-1;
+		PdfValue *length=Resolve(v->find("/Length"));
+		if (length && length->type==PDFV_Number) len=length->num;
+
+		 //sanity check the length against the endstream keyword, which is often wrong
+		const char *e=(len>=0 && len<=end-p ? pdf_skip(p+len,end) : NULL);
+		if (!e || !pdf_keyword(e,end,"endstream")) {
+			const char *s=p;
+			len=-1;
+			while (s<end-9) {
+				if (*s=='e' && !strncmp(s,"endstream",9)) { len=s-p; break; }
+				s++;
+			}
+			if (len<0) len=end-p;
+			 //the EOL before endstream is not part of the data
+			if (len>0 && p[len-1]=='\n') len--;
+			if (len>0 && p[len-1]=='\r') len--;
+		}
+		streamstart[num]=p-data;
+		streamlen[num]=len;
+	}
+
+	return v;
+}
+
+//! Return the parsed object number num, or NULL if not found.
+/*! The returned object belongs to the reader. Do not delete it.
+ */
+PdfValue *PdfReader::Object(long num)
+{
+	if (num<=0 || num>=numobjects) return NULL;
+	if (objects[num]) return objects[num];
+
+	if (offsets[num]>=0) return ParseObject(num,offsets[num]);
+	if (objstreams[num]>=0 && LoadObjectStream(num)==0) return objects[num];
+	return NULL;
+}
+
+//! If v is a reference, return what it references, else return v.
+PdfValue *PdfReader::Resolve(PdfValue *v)
+{
+	for (int c=0; v && v->type==PDFV_Ref && c<20; c++) v=Object(v->ref);
+	if (v && v->type==PDFV_Ref) return NULL;
+	return v;
+}
+
+//! Point to the raw, still encoded, bytes of stream object num. Return 0 for success.
+int PdfReader::StreamData(long num, const char **stream_ret, long *len_ret)
+{
+	if (!Object(num) || streamstart[num]<0) return 1;
+	*stream_ret=data+streamstart[num];
+	*len_ret=streamlen[num];
+	return 0;
+}
+
+//! Forget parsed objects, except those the page tree needs.
+/*! Objects are parsed again on demand. Stream data is never copied out of the mapped
+ * file to begin with, so this bounds memory use when copying many pages.
+ */
+void PdfReader::ReleaseObjects()
+{
+	if (!pinned) return;
+	for (long c=0; c<numobjects; c++) {
+		if (objects[c] && !pinned[c]) { delete objects[c]; objects[c]=NULL; }
+	}
+}
+
+//! Add all the leaves of the page tree to pages, applying inherited attributes.
+/*! visited has numobjects entries, and marks kids already read, so that a kid listed twice,
+ * or a loop back up the tree, is not read again.
+ */
+int PdfReader::ReadPageTree(PdfValue *node, PdfValue *resources, PdfValue *mediabox, int rotate, int depth, char *visited)
+{
+	if (!node || node->type!=PDFV_Dict || depth>64) return 1;
+
+	PdfValue *v;
+	if ((v=node->find("/Resources"))) resources=v;
+	if ((v=Resolve(node->find("/MediaBox"))) && v->type==PDFV_Array && v->items.n==4) mediabox=v;
+	if ((v=Resolve(node->find("/Rotate"))) && v->type==PDFV_Number) rotate=v->num;
+
+	PdfValue *kids=Resolve(node->find("/Kids"));
+	if (kids && kids->type==PDFV_Array) {
+		for (int c=0; c<kids->items.n; c++) {
+			if (kids->items.e[c]->type!=PDFV_Ref) continue;
+			long ref=kids->items.e[c]->ref;
+			if (ref<=0 || ref>=numobjects || visited[ref]) continue;
+			visited[ref]=1;
+			PdfValue *kid=Object(ref);
+			if (kid==node) continue;
+			if (kid && kid->find("/Kids")) ReadPageTree(kid, resources,mediabox,rotate, depth+1, visited);
+			else if (kid) {
+				 //leaf page. Remember its object number, which nested ReadPageTree() can't know
+				int n=pages.n;
+				ReadPageTree(kid, resources,mediabox,rotate, depth+1, visited);
+				if (pages.n==n+1) pages.e[n]->object=ref;
+			}
+		}
+		return 0;
+	}
+
+	 //is a leaf
+	PdfSourcePage *page=new PdfSourcePage;
+	page->resources=resources;
+	page->contents=node->find("/Contents");
+	if (mediabox) {
+		for (int c=0; c<4; c++) page->mediabox[c]=mediabox->items.e[c]->num;
+		if (page->mediabox[0]>page->mediabox[2]) { double t=page->mediabox[0]; page->mediabox[0]=page->mediabox[2]; page->mediabox[2]=t; }
+		if (page->mediabox[1]>page->mediabox[3]) { double t=page->mediabox[1]; page->mediabox[1]=page->mediabox[3]; page->mediabox[3]=t; }
+	}
+	rotate%=360;
+	if (rotate<0) rotate+=360;
+	page->rotate=(rotate/90)*90;
+	pages.push(page);
+	return 0;
+}
+
+//! Start a new pdf output. Object numbers from previous outputs are forgotten.
+/*! Every reader lazily resets its outnumbers when it notices the pass has changed.
+ */
+unsigned long PdfReader::BeginOutputPass()
+{
+	return ++pdf_output_pass;
+}
+
+//! Return the current output pass. See BeginOutputPass().
+unsigned long PdfReader::OutputPass()
+{
+	return pdf_output_pass;
+}
+
+//! Return the object number that source object num has in the current output pass, or 0.
+long PdfReader::OutputNumber(long num)
+{
+	if (outpass!=pdf_output_pass) {
+		for (long c=0; c<numobjects; c++) outnumbers[c]=0;
+		outpass=pdf_output_pass;
+	}
+	if (num<=0 || num>=numobjects) return 0;
+	return outnumbers[num];
+}
+
+//! Set the object number that source object num has in the current output pass.
+void PdfReader::OutputNumber(long num, long outnum)
+{
+	OutputNumber(num); //reset if necessary
+	if (num<=0 || num>=numobjects) return;
+	outnumbers[num]=outnum;
+}
+
+
+//------------------------------------- GetPdfReader() -----------------------------------
+
+static RefPtrStack<PdfReader> pdf_readers;
+
+//! Return a shared reader for file, opening it if necessary. Returns NULL on error.
+/*! The returned reader belongs to the cache. Do not dec_count() it unless you inc_count() it first.
+ * Readers are reopened when the file has changed on disk.
+ *
+ * The cache keeps the file mapped and open until ReleasePdfReader(), so whatever
+ * got the reader should call that once its import, export, or imposition is done.
+ */
+PdfReader *GetPdfReader(const char *file, Laxkit::ErrorLog *log)
+{
+	if (!file) return NULL;
+
+	for (int c=0; c<pdf_readers.n; c++) {
+		if (strcmp(pdf_readers.e[c]->filename,file)) continue;
+		if (!pdf_readers.e[c]->IsStale()) return pdf_readers.e[c];
+		pdf_readers.remove(c);
+		break;
+	}
+
+	PdfReader *reader=new PdfReader;
+	if (reader->Open(file,log)!=0) {
+		reader->dec_count();
+		return NULL;
+	}
+	pdf_readers.push(reader);
+	reader->dec_count();
+	return reader;
+}
+
+//! Drop the cached reader for file, or all cached readers if file==NULL.
+/*! Readers are unmapped and closed once nothing else has a count on them.
+ */
+void ReleasePdfReader(const char *file)
+{
+	for (int c=pdf_readers.n-1; c>=0; c--) {
+		if (!file || !strcmp(pdf_readers.e[c]->filename,file)) pdf_readers.remove(c);
+	}
+}
+
+
+} // namespace Laidout
+
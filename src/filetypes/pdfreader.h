@@ -0,0 +1,147 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef FILETYPES_PDFREADER_H
+#define FILETYPES_PDFREADER_H
+
+#include <lax/anobject.h>
+#include <lax/lists.h>
+#include <lax/errorlog.h>
+
+#include <sys/types.h>
+
+
+namespace Laidout {
+
+
+//------------------------------------- PdfValue -----------------------------------
+
+enum PdfValueType {
+	PDFV_Null,
+	PDFV_Bool,
+	PDFV_Number,
+	PDFV_Name,
+	PDFV_String,
+	PDFV_Array,
+	PDFV_Dict,
+	PDFV_Ref
+};
+
+class PdfValue
+{
+  public:
+	PdfValueType type;
+	char *text; //raw source text of atoms, so they can be written back out verbatim
+	double num;
+	long ref;
+	int gen;
+	Laxkit::PtrStack<char> keys;      //dict keys, including the leading '/'
+	Laxkit::PtrStack<PdfValue> items; //array elements, or dict values
+
+	PdfValue(PdfValueType ntype);
+	~PdfValue();
+	PdfValue *find(const char *key);
+	int IsName(const char *name);
+};
+
+
+//------------------------------------- PdfSourcePage -----------------------------------
+
+class PdfSourcePage
+{
+  public:
+	long object;        //object number of the /Page dict
+	double mediabox[4]; //llx,lly,urx,ury in points
+	int rotate;         //0, 90, 180, or 270
+	PdfValue *resources;//possibly inherited. Points into the reader's object cache
+	PdfValue *contents; //ref, or array of refs. Points into the reader's object cache
+
+	long outform;           //object number of the Form XObject in the current output pass
+	unsigned long outpass;
+
+	PdfSourcePage();
+	double Width();
+	double Height();
+	void FormMatrix(double *m);
+};
+
+
+//------------------------------------- PdfReader -----------------------------------
+
+class PdfReader : public Laxkit::anObject
+{
+  protected:
+	int fd;
+	char *data;
+	long datalen;
+	time_t mtime;
+
+	long numobjects;
+	long *offsets;    //byte offset of uncompressed objects, or -1
+	long *objstreams; //object stream containing compressed objects, or -1
+	PdfValue **objects;
+	char *pinned;     //objects that ReleaseObjects() must keep, since pages point into them
+	long *streamstart, *streamlen; //where the raw bytes of stream objects are
+	long rootobj;
+
+	long *outnumbers; //object numbers in the current output pass
+	unsigned long outpass;
+
+	int Allocate(long n);
+	int ReadXref(long offset, int depth);
+	int ReadXrefTable(const char *p, int depth);
+	int ReadXrefStream(const char *p, int depth);
+	int ReadTrailer(PdfValue *trailer, int depth);
+	int Reconstruct();
+	int LoadObjectStream(long num);
+	PdfValue *ParseObject(long num, long offset);
+	int ReadPageTree(PdfValue *node, PdfValue *resources, PdfValue *mediabox, int rotate, int depth, char *visited);
+
+  public:
+	char *filename;
+	int minorversion; //the x in %PDF-1.x
+	Laxkit::PtrStack<PdfSourcePage> pages;
+
+	PdfReader();
+	virtual ~PdfReader();
+	virtual const char *whattype() { return "PdfReader"; }
+	virtual int Open(const char *file, Laxkit::ErrorLog *log);
+	virtual void Close();
+	virtual int NumPages() { return pages.n; }
+	virtual PdfSourcePage *Page(int index) { return index>=0 && index<pages.n ? pages.e[index] : NULL; }
+	virtual int IsStale();
+
+	virtual PdfValue *Object(long num);
+	virtual PdfValue *Resolve(PdfValue *v);
+	virtual int StreamData(long num, const char **stream_ret, long *len_ret);
+	virtual void ReleaseObjects();
+
+	static unsigned long BeginOutputPass();
+	static unsigned long OutputPass();
+	virtual long OutputNumber(long num);
+	virtual void OutputNumber(long num, long outnum);
+};
+
+
+PdfReader *GetPdfReader(const char *file, Laxkit::ErrorLog *log);
+void ReleasePdfReader(const char *file);
+int PdfFlateDecode(const char *in, long inlen, char **out_ret, long *outlen_ret);
+int PdfDecodeStream(PdfValue *dict, const char *in, long inlen, char **out_ret, long *outlen_ret);
+
+
+} // namespace Laidout
+
+#endif
+
@@ -209,7 +209,7 @@ int PodofooutFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 	int papernumber=0;
 
 	for (c=start; c<=end; c++) {
-		if (doc) spread=doc->imposition->Layout(layout,c);
+		if (doc) spread=doc->imposition->GetSpread(layout,c);
 		for (p=0; p<papergroup->papers.n; p++) {
 
 			 //for plans, transforms are only 2 deep: 1 for the paper, 1 for the page
@@ -244,7 +244,7 @@ int PodofooutFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 
 			papernumber++;
 		}
-		if (spread) { delete spread; spread=NULL; }
+		if (spread) { spread->dec_count(); spread=NULL; }
 	}
 		
 	
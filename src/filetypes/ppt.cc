@@ -349,7 +349,7 @@ int PptoutFilter::Out(const char *filename, Laxkit::anObject *context, ErrorLog
 		if (config->evenodd==DocumentExportConfig::Even && c%2==0) continue;
         if (config->evenodd==DocumentExportConfig::Odd && c%2==1) continue;
 
-		if (doc) spread=doc->imposition->Layout(layout,c);
+		if (doc) spread=doc->imposition->GetSpread(layout,c);
 		for (p=0; p<papergroup->papers.n; p++) {
 			fprintf(f,"  <page>\n");
 
@@ -408,7 +408,7 @@ int PptoutFilter::Out(const char *filename, Laxkit::anObject *context, ErrorLog
 			fprintf(f,"    </frame>\n");
 			fprintf(f,"  </page>\n");
 		}
-		if (spread) { delete spread; spread=NULL; }
+		if (spread) { spread->dec_count(); spread=NULL; }
 	}
 		
 	 // write out footer
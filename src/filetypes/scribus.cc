@@ -671,7 +671,7 @@ int ScribusExportFilter::Out(const char *filename, Laxkit::anObject *context, Er
 		if (config->evenodd==DocumentExportConfig::Even && c%2==0) continue;
 		if (config->evenodd==DocumentExportConfig::Odd && c%2==1) continue;
 
-		if (doc) spread=doc->imposition->Layout(layout,c);
+		if (doc) spread=doc->imposition->GetSpread(layout,c);
 		for (p=0; p<papergroup->papers.n; p++) { //for each paper
 					
 			if (papergroup->objs.n()) {
@@ -703,7 +703,7 @@ int ScribusExportFilter::Out(const char *filename, Laxkit::anObject *context, Er
 				}
 			} //if (spread)
 		} //for each paper
-		if (spread) { delete spread; spread=NULL; }
+		if (spread) { spread->dec_count(); spread=NULL; }
 	} //for each spread
 
 	 //establish correct linking
@@ -858,7 +858,7 @@ int ScribusExportFilter::Out(const char *filename, Laxkit::anObject *context, Er
 		if (config->evenodd==DocumentExportConfig::Even && c%2==0) continue;
 		if (config->evenodd==DocumentExportConfig::Odd && c%2==1) continue;
 
-		if (doc) spread=doc->imposition->Layout(layout,c);
+		if (doc) spread=doc->imposition->GetSpread(layout,c);
 
 		for (p=0; p<papergroup->papers.n; p++) { //for each paper
 			paperrotation=config->paperrotation;
@@ -978,7 +978,7 @@ int ScribusExportFilter::Out(const char *filename, Laxkit::anObject *context, Er
 			scribuspagei++;
 		} //for each paper
 
-		if (spread) { delete spread; spread=NULL; }
+		if (spread) { spread->dec_count(); spread=NULL; }
 	} //for each spread
 		
 	
@@ -33,6 +33,7 @@
 #include "../laidout.h"
 #include "../stylemanager.h"
 #include "../dataobjects/mysterydata.h"
+#include "../dataobjects/instancedclones.h"
 #include "svg.h"
 #include "../headwindow.h"
 #include "../impositions/singles.h"
@@ -1201,6 +1202,24 @@ int svgdumpobj(FILE *f,double *mm,SomeData *obj,int &warning, int indent, ErrorL
 			fprintf(f,"%s />\n",spc);//end of clone!
 		}
 
+	} else if (!strcmp(obj->whattype(),"InstancedClones")) {
+		InstancedClones *clones=dynamic_cast<InstancedClones*>(obj);
+		fprintf(f,"%s<g id=\"%s\" transform=\"matrix(%.10g %.10g %.10g %.10g %.10g %.10g)\">\n",
+					spc, obj->Id(), obj->m(0), obj->m(1), obj->m(2), obj->m(3), obj->m(4), obj->m(5));
+
+		SomeData *source;
+		double m[6],m2[6];
+		for (int c=0; c<clones->NumInstances(); c++) {
+			source=clones->Source(clones->InstanceSource(c));
+			if (!source) continue;
+
+			transform_invert(m,source->m());
+			transform_mult(m2,m,clones->InstanceTransform(c));
+			fprintf(f,"%s  <use transform=\"matrix(%.10g %.10g %.10g %.10g %.10g %.10g)\" xlink:href=\"#%s\" />\n",
+						 spc, m2[0], m2[1], m2[2], m2[3], m2[4], m2[5], source->Id());
+		}
+		fprintf(f,"%s</g>\n",spc);
+
 
 	} else {
 		DrawableObject *dobj=dynamic_cast<DrawableObject*>(obj);
@@ -1495,7 +1514,7 @@ int SvgOutputFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 	int c2,l,pg,c3;
 	transform_set(m,1,0,0,1,0,0);
 
-	if (doc) spread=doc->imposition->Layout(layout,start);
+	if (doc) spread=doc->imposition->GetSpread(layout,start);
 	
 	 // write out header
 	double height=0,width=0;
@@ -1638,7 +1657,7 @@ int SvgOutputFilter::Out(const char *filename, Laxkit::anObject *context, ErrorL
 			}
 		}
 
-		delete spread;
+		spread->dec_count();
 	}
 
 	fprintf(f,"  </g>\n"); //from unit correction and paper
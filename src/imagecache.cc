@@ -0,0 +1,475 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include <lax/strmanip.h>
+#include <lax/laximages.h>
+
+#include "imagecache.h"
+#include "profiler.h"
+
+#include <lax/lists.cc>
+
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+using namespace Laxkit;
+
+
+namespace Laidout {
+
+
+//------------------------------------- ImageCacheBuffer ------------------------------------
+/*! \class ImageCacheBuffer
+ * \brief One decoded raster held by an ImageCache, either full resolution or a proxy level.
+ *
+ * Buffers are chained in a least recently used list in the owning ImageCache.
+ */
+
+/*! Takes possession of nimage's count.
+ */
+ImageCacheBuffer::ImageCacheBuffer(ImageCacheEntry *nentry, int nlevel, LaxImage *nimage)
+{
+	entry=nentry;
+	level=nlevel;
+	image=nimage;
+	bytes=(image ? (unsigned long)image->w()*image->h()*4 : 0);
+	prev=next=NULL;
+}
+
+ImageCacheBuffer::~ImageCacheBuffer()
+{
+	if (image) image->dec_count();
+}
+
+
+//------------------------------------- ImageCacheEntry ------------------------------------
+/*! \class ImageCacheEntry
+ * \brief Everything the ImageCache knows about one image file.
+ *
+ * levels[0] is the full resolution image, levels[n] is scaled by 1/2^n. Any of them may be
+ * NULL when not decoded or already evicted.
+ */
+
+ImageCacheEntry::ImageCacheEntry(const char *nfile)
+{
+	file=newstr(nfile);
+	width=height=-1;
+	numlevels=0;
+	for (int c=0; c<IMAGECACHE_MAX_LEVELS; c++) levels[c]=NULL;
+}
+
+/*! Buffers must have been removed by the ImageCache already.
+ */
+ImageCacheEntry::~ImageCacheEntry()
+{
+	delete[] file;
+}
+
+int ImageCacheEntry::LevelWidth(int level)
+{
+	int w=width;
+	for ( ; level>0 && w>1; level--) w=(w+1)/2;
+	return w;
+}
+
+int ImageCacheEntry::LevelHeight(int level)
+{
+	int h=height;
+	for ( ; level>0 && h>1; level--) h=(h+1)/2;
+	return h;
+}
+
+
+//------------------------------------- ImageCache ------------------------------------
+/*! \class ImageCache
+ * \brief Central store of decoded image rasters, kept within a memory budget.
+ *
+ * Documents with many images should not hold every full resolution raster in memory.
+ * Objects instead only need to know the file and its pixel dimensions. Screen drawing asks
+ * for Proxy(), which returns a downscaled mip level, and export asks for Full(), which decodes
+ * the whole image only when it is actually needed.
+ *
+ * All decoded buffers, full or proxy, are counted against Budget(). When the budget is exceeded,
+ * the least recently used buffers are released. Images handed out by Full() and Proxy() have
+ * their count incremented, and callers must Release() them when done. Buffers whose image is still
+ * held elsewhere, such as by an ImageData on screen, are not evicted, since that would not actually
+ * free any memory, and they stay counted in BytesUsed().
+ */
+
+
+static ImageCache *default_image_cache=NULL;
+
+//! Return a default cache, creating one if necessary.
+ImageCache *ImageCache::GetDefault()
+{
+	if (!default_image_cache) default_image_cache=new ImageCache();
+	return default_image_cache;
+}
+
+//! Replace the default cache. Pass NULL to just remove the old one.
+/*! Takes the old default's count, and increments the count of cache.
+ */
+void ImageCache::SetDefault(ImageCache *cache)
+{
+	if (cache==default_image_cache) return;
+	if (default_image_cache) default_image_cache->dec_count();
+	default_image_cache=cache;
+	if (cache) cache->inc_count();
+}
+
+ImageCache::ImageCache(unsigned long budget_bytes)
+{
+	budget=budget_bytes;
+	bytes_used=peak_bytes=0;
+	min_proxy_size=64;
+	lru_head=lru_tail=NULL;
+
+	hits=misses=evictions=decodes=0;
+}
+
+ImageCache::~ImageCache()
+{
+	Flush();
+}
+
+//! Set a new memory budget in bytes, and evict as necessary. Returns the new budget.
+unsigned long ImageCache::Budget(unsigned long nbudget)
+{
+	budget=nbudget;
+	Enforce(NULL);
+	return budget;
+}
+
+//! Set the size below which proxy levels are not generated. Returns the new size.
+int ImageCache::MinProxySize(int nsize)
+{
+	if (nsize>0) min_proxy_size=nsize;
+	return min_proxy_size;
+}
+
+//! Binary search for file in entries.
+/*! If not found, return NULL, and index_ret is set to where it should be inserted.
+ */
+ImageCacheEntry *ImageCache::FindEntry(const char *file, int *index_ret)
+{
+	int s=0, e=entries.n-1, m, cmp;
+	while (s<=e) {
+		m=(s+e)/2;
+		cmp=strcmp(file, entries.e[m]->file);
+		if (cmp==0) {
+			if (index_ret) *index_ret=m;
+			return entries.e[m];
+		}
+		if (cmp<0) e=m-1; else s=m+1;
+	}
+	if (index_ret) *index_ret=s;
+	return NULL;
+}
+
+//! Find or create the entry for file.
+ImageCacheEntry *ImageCache::GetEntry(const char *file)
+{
+	int i=0;
+	ImageCacheEntry *entry=FindEntry(file,&i);
+	if (entry) return entry;
+
+	entry=new ImageCacheEntry(file);
+	entries.push(entry,LISTS_DELETE_Single,i);
+	return entry;
+}
+
+//! Tell the cache about file, optionally with its pixel size as found from a cheap header read.
+/*! Nothing is decoded here. Pass width or height <=0 when unknown.
+ * Returns 0 for success, or nonzero for error.
+ */
+int ImageCache::Register(const char *file, int width, int height)
+{
+	if (isblank(file)) return 1;
+
+	ImageCacheEntry *entry=GetEntry(file);
+	if (width>0 && height>0) {
+		entry->width=width;
+		entry->height=height;
+	}
+	return 0;
+}
+
+//! Return the full size pixel dimensions of file, if known, without decoding.
+/*! Returns 0 for success, or nonzero for not known.
+ */
+int ImageCache::Dimensions(const char *file, int *width, int *height)
+{
+	if (isblank(file)) return 1;
+	ImageCacheEntry *entry=FindEntry(file,NULL);
+	if (!entry || entry->width<=0) return 1;
+	if (width)  *width =entry->width;
+	if (height) *height=entry->height;
+	return 0;
+}
+
+//! Move buffer to the front of the lru list.
+void ImageCache::Touch(ImageCacheBuffer *buffer)
+{
+	if (buffer==lru_head) return;
+	Unlink(buffer);
+
+	buffer->next=lru_head;
+	if (lru_head) lru_head->prev=buffer;
+	lru_head=buffer;
+	if (!lru_tail) lru_tail=buffer;
+}
+
+//! Remove buffer from the lru list, but do not delete it.
+void ImageCache::Unlink(ImageCacheBuffer *buffer)
+{
+	if (buffer->prev) buffer->prev->next=buffer->next;
+	if (buffer->next) buffer->next->prev=buffer->prev;
+	if (lru_head==buffer) lru_head=buffer->next;
+	if (lru_tail==buffer) lru_tail=buffer->prev;
+	buffer->prev=buffer->next=NULL;
+}
+
+//! Remove buffer from its entry and from the lru list, and delete it.
+void ImageCache::Drop(ImageCacheBuffer *buffer)
+{
+	Unlink(buffer);
+	buffer->entry->levels[buffer->level]=NULL;
+	bytes_used-=buffer->bytes;
+	delete buffer;
+}
+
+//! Evict least recently used buffers until within budget.
+/*! Never evicts keep, nor any buffer whose image is referenced outside the cache.
+ */
+void ImageCache::Enforce(ImageCacheBuffer *keep)
+{
+	ImageCacheBuffer *buffer=lru_tail, *prev;
+	while (bytes_used>budget && buffer) {
+		prev=buffer->prev;
+		if (buffer!=keep && buffer->image->the_count()<=1) {
+			DBG cerr <<"ImageCache evicting level "<<buffer->level<<" of "<<buffer->entry->file<<endl;
+			Drop(buffer);
+			evictions++;
+		}
+		buffer=prev;
+	}
+}
+
+//! Decode the full resolution image for entry, and install it at level 0.
+ImageCacheBuffer *ImageCache::Decode(ImageCacheEntry *entry)
+{
+	ProfileScope profile("image","decode");
+	LaxImage *image=load_image(entry->file);
+	if (!image) return NULL;
+	decodes++;
+
+	entry->width =image->w();
+	entry->height=image->h();
+	entry->numlevels=1;
+	while (entry->numlevels<IMAGECACHE_MAX_LEVELS) {
+		int w=entry->LevelWidth (entry->numlevels-1),
+			h=entry->LevelHeight(entry->numlevels-1);
+		if (w<=min_proxy_size && h<=min_proxy_size) break;
+		if (w<2 && h<2) break;
+		entry->numlevels++;
+	}
+
+	ImageCacheBuffer *buffer=new ImageCacheBuffer(entry,0,image);
+	entry->levels[0]=buffer;
+	bytes_used+=buffer->bytes;
+	if (bytes_used>peak_bytes) peak_bytes=bytes_used;
+	Touch(buffer);
+	return buffer;
+}
+
+//! Make the proxy for entry at level, from the nearest finer level available, decoding if necessary.
+/*! Intermediate levels are installed along the way, since they are cheap compared to decoding
+ * and will likely be wanted at other zooms.
+ */
+ImageCacheBuffer *ImageCache::MakeLevel(ImageCacheEntry *entry, int level)
+{
+	int from=level;
+	while (from>=0 && !entry->levels[from]) from--;
+
+	ImageCacheBuffer *src;
+	if (from<0) {
+		src=Decode(entry);
+		if (!src) return NULL;
+		from=0;
+	} else src=entry->levels[from];
+
+	for (int l=from+1; l<=level; l++) {
+		int sw=src->image->w(), sh=src->image->h();
+		int dw=(sw+1)/2, dh=(sh+1)/2;
+
+		LaxImage *image=create_new_image(dw,dh);
+		unsigned char *sbuf=src->image->getImageBuffer();
+		unsigned char *dbuf=image->getImageBuffer();
+
+		 //2x2 box filter, per byte so it does not matter which channel order the buffer uses
+		for (int y=0; y<dh; y++) {
+			int y1=2*y, y2=(2*y+1<sh ? 2*y+1 : 2*y);
+			const unsigned char *r1=sbuf+y1*sw*4, *r2=sbuf+y2*sw*4;
+			unsigned char *d=dbuf+y*dw*4;
+			for (int x=0; x<dw; x++) {
+				int x1=2*x*4, x2=(2*x+1<sw ? 2*x+1 : 2*x)*4;
+				for (int ch=0; ch<4; ch++) {
+					d[ch]=(r1[x1+ch]+r1[x2+ch]+r2[x1+ch]+r2[x2+ch]+2)/4;
+				}
+				d+=4;
+			}
+		}
+
+		image->doneWithBuffer(dbuf);
+		src->image->doneWithBuffer(sbuf);
+
+		ImageCacheBuffer *buffer=new ImageCacheBuffer(entry,l,image);
+		entry->levels[l]=buffer;
+		bytes_used+=buffer->bytes;
+		if (bytes_used>peak_bytes) peak_bytes=bytes_used;
+		Touch(buffer);
+		src=buffer;
+	}
+
+	return src;
+}
+
+//! Return the full resolution image for file, decoding it if necessary.
+/*! The returned image has its count incremented. Call Release() on it when done.
+ * Returns NULL if the file cannot be loaded.
+ */
+LaxImage *ImageCache::Full(const char *file)
+{
+	if (isblank(file)) return NULL;
+
+	ImageCacheEntry *entry=GetEntry(file);
+	ImageCacheBuffer *buffer=entry->levels[0];
+	if (buffer) hits++;
+	else {
+		misses++;
+		buffer=Decode(entry);
+		if (!buffer) return NULL;
+	}
+
+	Touch(buffer);
+	buffer->image->inc_count();
+	Enforce(buffer);
+	return buffer->image;
+}
+
+//! Return the smallest cached level of file whose width and height are both at least maxdim, or the whole image fits.
+/*! This is meant for screen drawing. If the proper level is not around, it is built from the
+ * nearest finer level still held, or from a fresh decode. In the latter case, the full resolution
+ * buffer becomes the least recently used of the new buffers, so it is the first to go when memory is tight.
+ *
+ * The returned image has its count incremented. Call Release() on it when done.
+ */
+LaxImage *ImageCache::Proxy(const char *file, int maxdim)
+{
+	if (isblank(file)) return NULL;
+
+	ImageCacheEntry *entry=GetEntry(file);
+	bool miss=false;
+	if (entry->numlevels==0) {
+		 //never decoded, so we do not know how many levels there can be yet
+		miss=true;
+		if (!Decode(entry)) return NULL;
+	}
+
+	int level=0;
+	if (maxdim>0) {
+		while (level+1<entry->numlevels
+				&& entry->LevelWidth (level+1)>=maxdim
+				&& entry->LevelHeight(level+1)>=maxdim)
+			level++;
+	}
+
+	ImageCacheBuffer *buffer=entry->levels[level];
+	if (!buffer) {
+		miss=true;
+		buffer=MakeLevel(entry,level);
+		if (!buffer) return NULL;
+	}
+	if (miss) misses++; else hits++;
+
+	Touch(buffer);
+	buffer->image->inc_count();
+	Enforce(buffer);
+	return buffer->image;
+}
+
+//! Counterpart to Full() and Proxy().
+void ImageCache::Release(LaxImage *image)
+{
+	if (image) image->dec_count();
+}
+
+//! Remove all buffers for file, for instance when the file on disk has changed.
+/*! Returns 0 if file was known, else 1.
+ */
+int ImageCache::Forget(const char *file)
+{
+	if (isblank(file)) return 1;
+
+	int i=-1;
+	ImageCacheEntry *entry=FindEntry(file,&i);
+	if (!entry) return 1;
+
+	for (int c=0; c<IMAGECACHE_MAX_LEVELS; c++) {
+		if (entry->levels[c]) Drop(entry->levels[c]);
+	}
+	entries.remove(i);
+	return 0;
+}
+
+//! Release all buffers and forget all entries.
+void ImageCache::Flush()
+{
+	while (lru_head) Drop(lru_head);
+	entries.flush();
+	bytes_used=0;
+}
+
+void ImageCache::ResetStats()
+{
+	hits=misses=evictions=decodes=0;
+	peak_bytes=bytes_used;
+}
+
+//! Output a summary of cache usage.
+void ImageCache::DumpStats(FILE *f, int indent)
+{
+	char spc[indent+1]; memset(spc,' ',indent); spc[indent]='\0';
+
+	unsigned long total=hits+misses;
+	fprintf(f,"%simages     %d\n",  spc,entries.n);
+	fprintf(f,"%sbudget     %lu\n", spc,budget);
+	fprintf(f,"%sused       %lu\n", spc,bytes_used);
+	fprintf(f,"%speak       %lu\n", spc,peak_bytes);
+	fprintf(f,"%shits       %lu\n", spc,hits);
+	fprintf(f,"%smisses     %lu\n", spc,misses);
+	fprintf(f,"%shitrate    %.3f\n",spc,total ? (double)hits/total : 0.);
+	fprintf(f,"%sdecodes    %lu\n", spc,decodes);
+	fprintf(f,"%sevictions  %lu\n", spc,evictions);
+}
+
+
+} // namespace Laidout
+
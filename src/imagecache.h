@@ -0,0 +1,122 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <lax/anobject.h>
+#include <lax/laximages.h>
+#include <lax/lists.h>
+
+#include <cstdio>
+
+
+namespace Laidout {
+
+
+#define IMAGECACHE_MAX_LEVELS  16
+
+
+class ImageCacheEntry;
+
+//------------------------------------- ImageCacheBuffer ------------------------------------
+class ImageCacheBuffer
+{
+  public:
+	ImageCacheEntry *entry;
+	int level; //0 is full resolution, n is 1/2^n of full
+	Laxkit::LaxImage *image;
+	unsigned long bytes;
+	ImageCacheBuffer *prev, *next; //lru chain, head is most recently used
+
+	ImageCacheBuffer(ImageCacheEntry *nentry, int nlevel, Laxkit::LaxImage *nimage);
+	~ImageCacheBuffer();
+};
+
+
+//------------------------------------- ImageCacheEntry ------------------------------------
+class ImageCacheEntry
+{
+  public:
+	char *file;
+	int width, height; //pixel size of full resolution image, -1 if not known yet
+	int numlevels;     //number of proxy levels that exist when generated, including full res
+	ImageCacheBuffer *levels[IMAGECACHE_MAX_LEVELS];
+
+	ImageCacheEntry(const char *nfile);
+	~ImageCacheEntry();
+	int LevelWidth (int level);
+	int LevelHeight(int level);
+};
+
+
+//------------------------------------- ImageCache ------------------------------------
+class ImageCache : public Laxkit::anObject
+{
+  protected:
+	Laxkit::PtrStack<ImageCacheEntry> entries; //sorted by file name
+	ImageCacheBuffer *lru_head, *lru_tail;
+
+	unsigned long budget;
+	unsigned long bytes_used;
+	unsigned long peak_bytes;
+	int min_proxy_size;
+
+	ImageCacheEntry *FindEntry(const char *file, int *index_ret);
+	ImageCacheEntry *GetEntry(const char *file);
+	ImageCacheBuffer *Decode(ImageCacheEntry *entry);
+	ImageCacheBuffer *MakeLevel(ImageCacheEntry *entry, int level);
+	void Touch(ImageCacheBuffer *buffer);
+	void Unlink(ImageCacheBuffer *buffer);
+	void Drop(ImageCacheBuffer *buffer);
+	void Enforce(ImageCacheBuffer *keep);
+
+  public:
+	 //statistics
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
+	unsigned long decodes;
+
+	static ImageCache *GetDefault();
+	static void SetDefault(ImageCache *cache);
+
+	ImageCache(unsigned long budget_bytes=256*1024*1024);
+	virtual ~ImageCache();
+	virtual const char *whattype() { return "ImageCache"; }
+
+	virtual unsigned long Budget() { return budget; }
+	virtual unsigned long Budget(unsigned long nbudget);
+	virtual unsigned long BytesUsed() { return bytes_used; }
+	virtual unsigned long PeakBytes() { return peak_bytes; }
+	virtual int MinProxySize(int nsize);
+
+	virtual int Register(const char *file, int width, int height);
+	virtual int Dimensions(const char *file, int *width, int *height);
+	virtual Laxkit::LaxImage *Full(const char *file);
+	virtual Laxkit::LaxImage *Proxy(const char *file, int maxdim);
+	virtual void Release(Laxkit::LaxImage *image);
+	virtual int Forget(const char *file);
+	virtual void Flush();
+
+	virtual void ResetStats();
+	virtual void DumpStats(FILE *f, int indent);
+};
+
+
+} // namespace Laidout
+
+#endif
+
@@ -21,10 +21,15 @@
 #include <lax/interfaces/somedatafactory.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
 
 #include "version.h"
 #include "importimage.h"
+#include "imagecache.h"
+#include "workerpool.h"
+#include "configured.h"
 #include "dataobjects/epsdata.h"
+#include "printing/epsutils.h"
 #include "utils.h"
 
 #include <lax/lists.cc>
@@ -53,6 +58,9 @@ namespace Laidout {
 /*! \var int ImportImageSettings::perpage
  * \brief -1 for as will fit, -2 for all in one page, otherwise that many per area.
  */
+/*! \var int ImportImageSettings::numthreads
+ * \brief How many threads to use for probing files and making previews. 0 means one per cpu, 1 means no extra threads.
+ */
 
 
 ImportImageSettings::ImportImageSettings()
@@ -65,6 +73,7 @@ ImportImageSettings::ImportImageSettings()
 	perpage=0;
 	destination=0;
 	destobject=NULL;
+	numthreads=0;
 }
 
 ImportImageSettings::~ImportImageSettings()
@@ -86,6 +95,7 @@ ImportImageSettings *ImportImageSettings::duplicate()
 	d->perpage     =perpage;
 	d->destination =destination;
 	d->destobject  =destobject;
+	d->numthreads  =numthreads;
 
 	for (int c=0; c<alignment.n; c++) d->alignment.push(alignment.e[c]);
 
@@ -111,6 +121,9 @@ void ImportImageSettings::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFile
 			else if (!strcmp(value,"fit")) perpage=-1;
 			else if (IntAttribute(value,&perpage)) ;
 			else perpage=-1;
+
+		} else if (!strcmp(name,"threads")) {
+			IntAttribute(value,&numthreads);
 		}
 
 	}
@@ -517,6 +530,106 @@ int dumpInImageList(ImportImageSettings *settings, Document *doc,LaxFiles::Attri
 	return curpage;
 }
 
+//------------------------------------- ImageProbeJob ------------------------------------
+
+enum ImageProbeType {
+	PROBE_Unknown=0,
+	PROBE_Png,
+	PROBE_Jpeg,
+	PROBE_Gif,
+	PROBE_Eps,
+	PROBE_ImageList,
+	PROBE_Unreadable
+};
+
+/*! \class ImageProbeJob
+ * \ingroup extras
+ * \brief Figure out cheap things about an image file on a worker thread.
+ *
+ * This reads just the file header to get the type and any EPS bounding box, asks the kernel to
+ * start reading the rest of the file in so that decoding later does not wait on the disk,
+ * and for EPS files without a preview, runs Ghostscript to make one.
+ *
+ * Nothing here touches Imlib, which is not safe across threads. The main thread only pings
+ * each file for its size, and rasters are decoded through the ImageCache when first drawn.
+ */
+class ImageProbeJob : public WorkerJob
+{
+  public:
+	const char *file;        //not owned
+	const char *previewfile; //not owned, may be NULL
+	char *epspreview;        //where an eps preview should go
+	int type;
+	int width, height; //eps bounding box size in points
+
+	ImageProbeJob() { file=previewfile=NULL; epspreview=NULL; type=PROBE_Unknown; width=height=0; }
+	virtual ~ImageProbeJob() { if (epspreview) delete[] epspreview; }
+	virtual void Run();
+	int ProbeEps(FILE *f);
+};
+
+void ImageProbeJob::Run()
+{
+	FILE *f=fopen(file,"r");
+	if (!f) { type=PROBE_Unreadable; return; }
+
+	unsigned char data[51];
+	int n=fread(data,1,50,f);
+	data[n]='\0';
+
+	if (n>=8 && !memcmp(data,"\x89PNG\r\n\x1a\n",8)) {
+		type=PROBE_Png;
+
+	} else if (n>=2 && data[0]==0xff && data[1]==0xd8) {
+		type=PROBE_Jpeg;
+
+	} else if (n>=6 && (!memcmp(data,"GIF87a",6) || !memcmp(data,"GIF89a",6))) {
+		type=PROBE_Gif;
+
+	} else if (!strncasecmp((char*)data,"#Laidout ",9)) {
+		if (strcasestr((char*)data+9,"image list")) type=PROBE_ImageList;
+
+	} else if (!strncmp((char*)data,"%!PS-Adobe-",11) && strstr((char*)data," EPSF-")) {
+		type=PROBE_Eps;
+		ProbeEps(f);
+	}
+
+	 //get the kernel started reading in the rest while we do other things
+	if (type!=PROBE_Unknown && type!=PROBE_ImageList) posix_fadvise(fileno(f),0,0,POSIX_FADV_WILLNEED);
+	fclose(f);
+
+	 //gs previews are by far the slowest part of importing eps, and are just external processes
+	if (type==PROBE_Eps) {
+		if (previewfile) epspreview=newstr(previewfile);
+		else epspreview=previewFileName(file,"%-s.png");
+	}
+	if (type==PROBE_Eps && epspreview && width>0 && height>0
+			&& strcmp("",GHOSTSCRIPT_BIN) && !file_exists(epspreview,1,NULL)) {
+		char *error=NULL;
+		WriteEpsPreviewAsPng(GHOSTSCRIPT_BIN, file, width,height, epspreview, 200,200, &error);
+		DBG if (error) cerr <<"EPS gs preview generation returned with error: "<<error<<endl;
+		if (error) delete[] error;
+	}
+}
+
+//! Find the bounding box size in points. Only looks in the header comments.
+int ImageProbeJob::ProbeEps(FILE *f)
+{
+	fseek(f,0,SEEK_SET);
+	char line[256];
+	int llx,lly,urx,ury;
+	while (fgets(line,sizeof(line),f)) {
+		if (!strncmp(line,"%%EndComments",13)) break;
+		if (!strncmp(line,"%%BoundingBox:",14) && sscanf(line+14,"%d %d %d %d",&llx,&lly,&urx,&ury)==4) {
+			width =urx-llx;
+			height=ury-lly;
+			break;
+		}
+	}
+	return 0;
+}
+
+
 //! Plop all images in directory pathtoimagedir into the document.
 /*! \ingroup extras
  * Grabs all the regular file names in pathtoimagedir and passes them to dumpInImages(...,char **,...).
@@ -557,6 +670,11 @@ int dumpInImages(ImportImageSettings *settings, Document *doc, const char *patht
  * Any broken images are not inserted into the document as broken images. They are ignored.
  * 
  * perpage==-1 means insert until page is full. perpage==-2 means put them all on startpage.
+ *
+ * File headers are probed and any EPS previews are generated on settings->numthreads worker
+ * threads (see ImageProbeJob), while images are created and placed here in file order as
+ * each probe finishes. Rasters are only pinged here. They are decoded later through the
+ * ImageCache, when first drawn or exported.
  * 
  * Returns the page index of the final page or -1 if error.
  *
@@ -592,9 +710,26 @@ int dumpInImages(ImportImageSettings *settings,
 
 	FILE *f;
 	char data[50],*p;
+
+	 //Probe headers and make eps previews on worker threads. Results are consumed below
+	 //strictly in file order, so placement is the same as doing it all serially.
+	ImageProbeJob *probes=new ImageProbeJob[nfiles];
+	WorkerPool *pool=NULL;
+	if (settings->numthreads!=1 && nfiles>1) pool=new WorkerPool(settings->numthreads);
+	for (c=0; c<nfiles; c++) {
+		if (!imagefiles[c] || !strcmp(imagefiles[c],".") || !strcmp(imagefiles[c],"..")) continue;
+		probes[c].file=imagefiles[c];
+		probes[c].previewfile=(previewfiles ? previewfiles[c] : NULL);
+		if (pool) pool->Add(&probes[c]);
+	}
+	ImageCache *cache=ImageCache::GetDefault();
 	
 	for (c=0; c<nfiles; c++) {
 		if (!imagefiles[c] || !strcmp(imagefiles[c],".") || !strcmp(imagefiles[c],"..")) continue;
+
+		if (pool) pool->Wait(&probes[c]);
+		else probes[c].Run();
+		if (probes[c].type==PROBE_Unreadable) continue;
 		
 		imaged=NULL;
 		image=pimage=NULL;
@@ -607,9 +742,14 @@ int dumpInImages(ImportImageSettings *settings,
 		if (image) {
 			DBG cerr << "dump image files: "<<imagefiles[c]<<endl;
 
+			 //image was only pinged for metrics. Screen drawing gets a cached proxy on first
+			 //draw, and the full raster is decoded through the cache only when something needs it
+			cache->Register(imagefiles[c], image->w(),image->h());
+
 			imaged=dynamic_cast<ImageData*>(LaxInterfaces::somedatafactory()->NewObject("ImageData"));
-			imaged->SetImage(image,NULL);//incs count of image
+			imaged->SetImage(image,pimage);//incs count of image and pimage
 			image->dec_count();
+			if (pimage) pimage->dec_count();
 
 		} else {
 			 // check to see if it is an image list or EPS based on first chars of file.
@@ -646,8 +786,9 @@ int dumpInImages(ImportImageSettings *settings,
 							 //the eps file, kept in postscript units (1 inch == 72 units)
 							//*******
 							char *pname;
-							if (previewfiles && previewfiles[c]) pname=newstr(previewfiles[c]);
-								else pname=previewFileName(imagefiles[c],"%-s.png");
+							if (probes[c].epspreview) pname=newstr(probes[c].epspreview); //already made by the probe
+							else if (previewfiles && previewfiles[c]) pname=newstr(previewfiles[c]);
+							else pname=previewFileName(imagefiles[c],"%-s.png");
 							imaged=new EpsData(imagefiles[c],pname,200,200,0);//*** should use laidout->maxwidth..
 							delete[] pname;
 							xywh=new double[4];
@@ -681,6 +822,9 @@ int dumpInImages(ImportImageSettings *settings,
 		if (numonpage==0) curpage++;
 	}
 
+	if (pool) delete pool;
+	delete[] probes;
+
 	if (images) {
 		c=dumpInImages(settings, doc,images,settings->startpage);
 		delete images;
@@ -56,6 +56,8 @@ class ImportImageSettings : public Laxkit::anObject, public LaxFiles::DumpUtilit
 
 	//PtrStack<ImageAlternateSpec> alternatesettings; //overrides laidout default settings
 
+	int numthreads; //for probing files, 0 is one per cpu
+
 	int startpage; //which page (or area) to start dumping images into
 	int destination;
 	Laxkit::anObject *destobject;
@@ -323,6 +323,54 @@ ImpositionInterface::ImpositionInterface(LaxInterfaces::anInterface *nowner,int
 
 
 
+//----------------------------- SpreadCache --------------------------
+/*! \class SpreadCache
+ * \brief Spreads of one layout type made for one Imposition::revision.
+ *
+ * See Imposition::GetSpread().
+ */
+
+SpreadCache::SpreadCache(int nlayout, unsigned long nrevision)
+{
+	layout=nlayout;
+	revision=nrevision;
+	n=0;
+	spreads=NULL;
+}
+
+SpreadCache::~SpreadCache()
+{
+	for (int c=0; c<n; c++) {
+		if (spreads[c]) spreads[c]->dec_count();
+	}
+	if (spreads) delete[] spreads;
+}
+
+//! Return the cached spread, or NULL. Count is not incremented.
+Spread *SpreadCache::Get(int index)
+{
+	if (index<0 || index>=n) return NULL;
+	return spreads[index];
+}
+
+//! Install spread at index, which takes over whatever count the spread had.
+void SpreadCache::Set(int index, Spread *spread)
+{
+	if (index<0) return;
+	if (index>=n) {
+		int nn=index+1;
+		if (nn<2*n) nn=2*n;
+		Spread **ns=new Spread*[nn];
+		for (int c=0; c<nn; c++) ns[c]=(c<n ? spreads[c] : NULL);
+		if (spreads) delete[] spreads;
+		spreads=ns;
+		n=nn;
+	}
+	if (spreads[index]) spreads[index]->dec_count();
+	spreads[index]=spread;
+}
+
+
 //----------------------------- Imposition --------------------------
 
 /*! \class Imposition
@@ -544,6 +592,7 @@ Imposition::Imposition(const char *nsname)
 	papergroup=NULL;
 	numpages=numpapers=0; 
 	numdocpages=0;
+	revision=1;
 	
 	DBG cerr <<"imposition base class init for object "<<object_id<<endl;
 }
@@ -666,6 +715,7 @@ int Imposition::SyncPageStyles(Document *doc,int start,int n, bool shift_within_
 int Imposition::SetPaperGroup(PaperGroup *ngroup)
 {
 	if (!ngroup) return 1;
+	Modified();
 	if (papergroup) papergroup->dec_count();
 	papergroup=ngroup;
 	if (papergroup) papergroup->inc_count();
@@ -690,6 +740,7 @@ int Imposition::SetPaperGroup(PaperGroup *ngroup)
 int Imposition::SetPaperSize(PaperStyle *npaper)
 {
 	if (!npaper) return 1;
+	Modified();
 
 	PaperStyle *newpaper=(PaperStyle *)npaper->duplicate();
 	if (paper) paper->dec_count();
@@ -744,6 +795,7 @@ int Imposition::NumSpreads(int layout)
  */
 int Imposition::NumPapers(int npapers)
 {
+	Modified();
 	numpapers=npapers;
 	numpages=GetPagesNeeded(numpapers);
 	return numpapers;
@@ -761,6 +813,7 @@ int Imposition::NumPapers(int npapers)
  */
 int Imposition::NumPages(int npages)
 {
+	Modified();
 	numdocpages=npages;
 	numpapers=GetPapersNeeded(numdocpages);
 	numpages =GetPagesNeeded(numpapers);
@@ -781,6 +834,53 @@ Spread *Imposition::Layout(int layout,int which)
 	return NULL;
 }
 
+//! Return a shared, read only spread, making it with Layout() only if it is not cached yet.
+/*! Spreads are cached per (layout, which, revision). The returned spread has its count
+ * incremented, so call dec_count() on it when done, rather than delete. Do not modify it,
+ * as other viewers and exporters may be using the same one. Use Layout() for a private spread.
+ * The one exception is filling in a NULL PageLocation::page with the document page at
+ * PageLocation::index, which is the same for every user until Document::SyncPages() calls Modified().
+ *
+ * The cache is dropped by Modified(), which subclasses must call whenever anything that
+ * affects spread layout changes.
+ */
+Spread *Imposition::GetSpread(int layout,int which)
+{
+	if (which<0) return NULL;
+
+	SpreadCache *cache=NULL;
+	for (int c=0; c<spreadcache.n; c++) {
+		if (spreadcache.e[c]->layout==layout) { cache=spreadcache.e[c]; break; }
+	}
+	if (cache && cache->revision!=revision) {
+		spreadcache.remove(spreadcache.findindex(cache));
+		cache=NULL;
+	}
+	if (!cache) {
+		cache=new SpreadCache(layout,revision);
+		spreadcache.push(cache);
+	}
+
+	Spread *spread=cache->Get(which);
+	if (!spread) {
+		spread=Layout(layout,which);
+		if (!spread) return NULL;
+		cache->Set(which,spread); //takes the initial count
+	}
+	spread->inc_count();
+	return spread;
+}
+
+//! Call whenever something that affects layout changes. This increments revision and drops cached spreads.
+/*! Spreads already handed out by GetSpread() stay valid for whoever holds them,
+ * but will no longer be handed out.
+ */
+void Imposition::Modified()
+{
+	revision++;
+	spreadcache.flush();
+}
+
 //! Return the number of different kinds of layouts the imposition can provide.
 /*! The default is to return 3: singles, pages, and papers.
  *
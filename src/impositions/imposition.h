@@ -140,10 +140,30 @@ class ImpositionWindow
 }; 
 
 
+//----------------------------- SpreadCache --------------------------
+
+class SpreadCache
+{
+  public:
+	int layout;
+	unsigned long revision; //Imposition::revision the spreads were made for
+	int n;
+	Spread **spreads; //index is spread index, NULL for not made yet
+
+	SpreadCache(int nlayout, unsigned long nrevision);
+	~SpreadCache();
+	Spread *Get(int index);
+	void Set(int index, Spread *spread);
+};
+
+
 //----------------------------- Imposition --------------------------
 
 class Imposition : public Value
 {
+  protected:
+	Laxkit::PtrStack<SpreadCache> spreadcache;
+
   public:
 	char *name;
 	char *description;
@@ -176,6 +196,9 @@ class Imposition : public Value
 	virtual LaxInterfaces::SomeData *GetPageMarginOutline(int pagenum,int local);
 	
 	virtual Spread *Layout(int layout,int which); 
+	virtual Spread *GetSpread(int layout,int which);
+	unsigned long revision;
+	virtual void Modified();
 	virtual int NumLayoutTypes();
 	virtual const char *LayoutName(int layout); 
 	//----*** ^^ this will ultimately replace these vv
@@ -21,6 +21,8 @@
 #include "../language.h"
 #include "../utils.h"
 #include "../filetypes/scribus.h"
+#include "../filetypes/pdf.h"
+#include "../filetypes/pdfreader.h"
 #include "../viewwindow.h"
 #include "../headwindow.h"
 #include "impositioneditor.h"
@@ -183,9 +185,12 @@ ImpositionEditor::ImpositionEditor(Laxkit::anXWindow *parnt,const char *nname,co
 
 	 //**** this is a hack! Should instead be parsed into an export config with extra fields for additional
 	 // 		imposing
+	imposein=NULL;
 	imposeout=NULL;
 	imposeformat=NULL;
+	imposepages=0;
 	double ww=-1, hh=-1;
+	double pagew=-1, pageh=-1; //page size of a pdf in
 
 	if (imposearg) {
 		//need to load a new document, which may be a non-laidout document.
@@ -217,13 +222,17 @@ ImpositionEditor::ImpositionEditor(Laxkit::anXWindow *parnt,const char *nname,co
 					}
 
 				} else if (isPdfFile(value,NULL)) {
-					//  pdf: if you know number of pages, create singles with that many pages and page sizes,
-					//     export temp podofo plan, call podofoimpose?
-					//     or figure out how to remap pdf pages.. should just be matter of 
-					//       adjusting root page streams with extra transforms, calling old page streams
-					//       ..and adding extra markings
-					//       updating pdf object catalog
-					//       use ghostscript to generate pdf page preview images, store at ??? (dir of file.pdf)/.file.pdf.page01.png???
+					 //pdfs are imposed straight from the file on send(), without a document. See ImposePdf().
+					ErrorLog log;
+					PdfReader *reader=GetPdfReader(value,&log);
+					if (reader) {
+						makestr(imposein,value);
+						imposepages=reader->NumPages();
+						pagew=reader->Page(0)->Width()/72;
+						pageh=reader->Page(0)->Height()/72;
+						tool->SetTotalDimensions(pagew,pageh);
+						ReleasePdfReader(value); //ImposePdf() opens it again on send()
+					} else laidout->NotifyGeneralErrors(&log);
 				}
 
 				//else if (isLaidoutDocumentFile) {
@@ -255,20 +264,26 @@ ImpositionEditor::ImpositionEditor(Laxkit::anXWindow *parnt,const char *nname,co
 			if (c<laidout->impositionpool.n) {
 				Imposition *imp=laidout->impositionpool.e[c]->Create();
 				SignatureImposition *simp=dynamic_cast<SignatureImposition*>(imp);
-				if (simp) {
-					PaperStyle *p;
-					p=(PaperStyle*)laidout->project->docs.e[0]->doc->imposition->papergroup->papers.e[0]->box->paperstyle->duplicate();
+				if (simp && (imposein || laidout->project->docs.n)) {
+					if (!imposein) {
+						PaperStyle *p=laidout->project->docs.e[0]->doc->imposition->papergroup->papers.e[0]->box->paperstyle;
+						pagew=p->w();
+						pageh=p->h();
+					}
 					//simp->SetPaper(paper);
-					simp->SetPaperFromFinalSize(p->w(),p->h());
+					simp->SetPaperFromFinalSize(pagew,pageh);
 					tool->UseThisImposition(simp);
 					simp->dec_count();
-					p->dec_count();
+				} else if (simp) {
+					simp->dec_count();
 				} else {
 					delete imp;
 				}
 			}
 		}
 
+		if (imposein) tool->GetImposition()->NumPages(imposepages);
+
 		DBG cerr <<"Impose only from "<<in<<" to "<<out<<endl;
 	}
 
@@ -279,6 +294,7 @@ ImpositionEditor::ImpositionEditor(Laxkit::anXWindow *parnt,const char *nname,co
 ImpositionEditor::~ImpositionEditor()
 { 
 	if (firstimp) firstimp->dec_count();
+	if (imposein) delete[] imposein;
 	if (imposeout) delete[] imposeout;
 	if (imposeformat) delete[] imposeformat;
 }
@@ -398,7 +414,13 @@ void ImpositionEditor::send()
 	RefCountedEventData *data=new RefCountedEventData(imp);
 	data->info1=rescale_pages;
 
-	if (imposeout) {
+	if (imposeout && imposein) {
+		 //for impose-only mode with a pdf, which streams sheets straight to imposeout
+		ErrorLog log;
+		ImposePdf(imp,imposein,imposeout,log);
+		laidout->NotifyGeneralErrors(&log);
+
+	} else if (imposeout) {
 		//for impose-only mode
 		//if imposeformat==scribus, continue...
 		Document *doc=laidout->project->docs.e[0]->doc;
@@ -33,7 +33,8 @@ class ImpositionEditor : public LaxInterfaces::ViewerWindow
 	int whichactive;
 	Imposition *firstimp;
 
-	char *imposeout, *imposeformat;
+	char *imposein, *imposeout, *imposeformat;
+	int imposepages;
 	int rescale_pages;
 	Document *doc;
  public:
@@ -289,6 +289,7 @@ int NetImposition::SetNet(const char *nettype)
 int NetImposition::SetNet(Net *newnet)
 {
 	if (!newnet) return 1;
+	Modified();
 	newnet->info=0;//clears the info tag, means it is not internal, and needs to scale to fit paper
 	nets.flush();
 	nets.push(newnet);//adds a count
@@ -834,6 +835,7 @@ int NetImposition::NumPageSpreads()
 //! Set the known number of pages to npages.
 int NetImposition::NumPages(int npages)
 {
+	Modified();
 	numpages=npages;
 	numpapers=GetPapersNeeded(npages);
 	return numpages;
@@ -1036,6 +1038,7 @@ void NetImposition::dump_out(FILE *f,int indent,int what,LaxFiles::DumpContext *
 void NetImposition::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
 	if (!att) return;
+	Modified();
 	char *name,*value;
 	Net *tempnet=NULL;
 	int foundscaling=0;
@@ -40,6 +40,9 @@ namespace Laidout {
 #define GAP .0625
 #define MWIDTH  .014
 
+//! Source of Signature::revision values, so different patterns never share one.
+static unsigned long signature_revision=0;
+
 //----------------------------- naming helper functions -----------------------------
 
 //! Return the name of the fold direction.
@@ -336,6 +339,10 @@ Signature::Signature()
 	positivex='r';  //direction of the positive x axis: 'l|r|t|b'
 	positivey='t';  //direction of the positive x axis: 'l|r|t|b', for when up might not be positivey!
 
+	indexcells=NULL;
+	indexcells_revision=0;
+	revision=0;
+
 	foldinfo=NULL;
 	reallocateFoldinfo();
 	foldinfo[0][0].finalindexfront=0;
@@ -352,6 +359,7 @@ Signature::~Signature()
 		for (int c=0; foldinfo[c]; c++) delete[] foldinfo[c];
 		delete[] foldinfo;
 	}
+	if (indexcells) delete[] indexcells;
 }
 
 const Signature &Signature::operator=(const Signature &sig)
@@ -419,6 +427,15 @@ void Signature::reallocateFoldinfo()
 		}
 	}
 	foldinfo[r]=NULL; //terminating NULL, so we don't need to remember sig->numhfolds
+	Modified();
+}
+
+//! Call whenever foldinfo changes, so cached lookups know to rebuild.
+/*! This updates revision. See CellFromIndex() and SignatureImposition::PlacementsValid().
+ */
+void Signature::Modified()
+{
+	revision=++signature_revision;
 }
 
 //! Flush all the foldinfo pages stacks, as if there have been no folds yet.
@@ -432,6 +449,7 @@ void Signature::reallocateFoldinfo()
 void Signature::resetFoldinfo(FoldedPageInfo **finfo)
 {
 	if (!finfo) finfo=foldinfo;
+	if (finfo==foldinfo) Modified();
 
 	for (int r=0; r<numhfolds+1; r++) {
 		for (int c=0; c<numvfolds+1; c++) {
@@ -484,6 +502,7 @@ int Signature::applyFold(FoldedPageInfo **finfo, int foldlevel)
 void Signature::applyFold(FoldedPageInfo **finfo, char folddir, int index, int under)
 {
 	if (!finfo) finfo=foldinfo;
+	if (finfo==foldinfo) Modified();
 
 	int newr,newc, tr,tc;
 	int fr1,fr2, fc1,fc2;
@@ -637,6 +656,7 @@ int Signature::checkFoldLevel(FoldedPageInfo **finfo, int *finalrow,int *finalco
 			page+=2;
 		}
 		hasfinal=1;
+		if (finfo==foldinfo) Modified();
 	} else hasfinal=0;
 
 	if (finalrow) *finalrow= hasfinal ? newr : -1;
@@ -738,6 +758,42 @@ int Signature::PagesPerPattern()
 	return 2*(numvfolds+1)*(numhfolds+1);
 }
 
+//! Find which cell of the unfolded pattern holds the given final page index.
+/*! finalindex is either a finalindexfront or finalindexback of foldinfo, in range [0..PagesPerPattern()).
+ * The lookup is a flat table built from foldinfo, which is only rebuilt when revision changes.
+ *
+ * Returns 1 if finalindex is on the front of the cell, 0 for the back, or -1 if not found,
+ * such as when the pattern is not totally folded.
+ */
+int Signature::CellFromIndex(int finalindex, int *row, int *col)
+{
+	int n=PagesPerPattern();
+	if (finalindex<0 || finalindex>=n) return -1;
+
+	if (!indexcells || indexcells_revision!=revision) {
+		if (indexcells) delete[] indexcells;
+		indexcells=new int[n];
+		for (int c=0; c<n; c++) indexcells[c]=-1;
+
+		int i;
+		for (int rr=0; rr<numhfolds+1; rr++) {
+		  for (int cc=0; cc<numvfolds+1; cc++) {
+			i=foldinfo[rr][cc].finalindexfront;
+			if (i>=0 && i<n) indexcells[i]=2*(rr*(numvfolds+1)+cc)+1;
+			i=foldinfo[rr][cc].finalindexback;
+			if (i>=0 && i<n) indexcells[i]=2*(rr*(numvfolds+1)+cc);
+		  }
+		}
+		indexcells_revision=revision;
+	}
+
+	int cell=indexcells[finalindex];
+	if (cell<0) return -1;
+	if (row) *row=(cell/2)/(numvfolds+1);
+	if (col) *col=(cell/2)%(numvfolds+1);
+	return cell%2;
+}
+
 /*! Return whether the page is on the front (0) or back (1). If num_sheets>1, then
  * pretend there are that many sheets stacked up for this signature.
  *
@@ -760,29 +816,16 @@ int Signature::locatePaperFromPage(int pagenumber, int *row, int *col, int num_s
 	 //
 	 //To do this, we find where it is in the pattern...
 
-	DBG int front;  //Whether sigindex is on top or bottom of unfolded pattern
-	int countdir; //Whether a pattern cell has a higher page number on top (1) or not (0).
 	int rr=-1, cc=-1;
-	for (rr=0; rr<numhfolds+1; rr++) {
-	  for (cc=0; cc<numvfolds+1; cc++) {
-		if (sigindex==foldinfo[rr][cc].finalindexfront) {
-			DBG front=1;
-			countdir=(foldinfo[rr][cc].finalindexfront>foldinfo[rr][cc].finalindexback);
-			break;
-		} else if (sigindex==foldinfo[rr][cc].finalindexback) {
-			DBG front=0;
-			countdir=(foldinfo[rr][cc].finalindexfront>foldinfo[rr][cc].finalindexback);
-			break;
-		}
-	  } //cc
-	  if (cc!=numvfolds+1) break;
-	}  //rr
+	if (CellFromIndex(sigindex, &rr,&cc)<0) {
+		DBG cerr << " *** could not find place "<<sigindex<<" in rr,cc"<<endl;
+		if (row) *row=-1;
+		if (col) *col=-1;
+		return -1;
+	}
 
-	DBG if (rr==numhfolds+1) { 
-	DBG 	cerr << " *** could not find place "<<sigindex<<" in rr,cc"<<endl;
-	DBG 	exit(0);
-	DBG }
-	DBG cerr <<"front:"<<front<<endl;
+	 //Whether a pattern cell has a higher page number on top (1) or not (0).
+	int countdir=(foldinfo[rr][cc].finalindexfront>foldinfo[rr][cc].finalindexback);
 
 	 //now rr,cc is the cell that contains sigindex.
 	 //We must figure out how it maps to pieces of paper
@@ -2469,6 +2512,11 @@ SignatureImposition::SignatureImposition(SignatureInstance *newsig)
 {
 	showwholecover=0;
 
+	placement_pages=placement_papers=0;
+	placements=NULL;
+	placement_paperstart=NULL;
+	placement_frompage=NULL;
+
 	signatures=NULL;
 	if (newsig) signatures=(SignatureInstance*)newsig->duplicate();
 	
@@ -2484,6 +2532,7 @@ SignatureImposition::SignatureImposition(SignatureInstance *newsig)
 
 SignatureImposition::~SignatureImposition()
 {
+	InvalidatePlacements();
 	if (signatures) delete signatures;
 	//if (partition) partition->dec_count();
 
@@ -2621,6 +2670,8 @@ int SignatureImposition::UseThisSignature(Signature *newsig)
 	if (signatures) paper=signatures->partition;
 	if (paper) paper->inc_count();
 
+	InvalidatePlacements();
+	Modified();
 	if (signatures) signatures->dec_count();
 	signatures=new SignatureInstance(newsig,paper);
 	if (paper) paper->dec_count();
@@ -2722,9 +2773,188 @@ int SignatureImposition::SpreadType(int spread)
 
 //--------------functions to locate spreads and pages...
 
+/*! \class SignaturePlacement
+ * \brief Where one page cell of one paper spread is, for lookup tables in SignatureImposition.
+ *
+ * page and paper are relative to one group of all stacks. Whole groups repeat for
+ * documents with more pages than PagesPerSignature(-1,0).
+ */
+
+//! Drop the page and paper lookup tables. They will be rebuilt when next needed.
+void SignatureImposition::InvalidatePlacements()
+{
+	placement_key.flush();
+	placement_pages=placement_papers=0;
+	if (placements)           { delete[] placements;           placements=NULL; }
+	if (placement_paperstart) { delete[] placement_paperstart; placement_paperstart=NULL; }
+	if (placement_frompage)   { delete[] placement_frompage;   placement_frompage=NULL; }
+}
+
+/*! Return whether the lookup tables were built from the current signatures. This checks
+ * instance order, sheets per signature, and the Signature::revision of each pattern,
+ * so folds edited directly on a pattern or sheets added to an instance are caught too.
+ * This is one check per SignatureInstance, not per page.
+ */
+int SignatureImposition::PlacementsValid()
+{
+	if (!placements) return 0;
+
+	int i=0;
+	for (SignatureInstance *s=signatures; s; s=s->next_stack) {
+		for (SignatureInstance *ins=s; ins; ins=ins->next_insert) {
+			if (i+3>placement_key.n
+				  || placement_key.e[i]  !=(unsigned long)ins
+				  || placement_key.e[i+1]!=(unsigned long)ins->sheetspersignature
+				  || placement_key.e[i+2]!=ins->pattern->revision)
+				return 0;
+			i+=3;
+		}
+	}
+	return i==placement_key.n;
+}
+
+//! Build flat lookup tables of page to paper spread, and paper spread to pages.
+/*! This covers one group of all stacks. It is the only place that walks the stacks, inserts
+ * and foldinfo to find where pages go, so PaperLayout(), PaperFromPage(), InstanceFromPage()
+ * and such are simple lookups.
+ *
+ * Return 0 for success, or nonzero for nothing to build.
+ */
+int SignatureImposition::BuildPlacements()
+{
+	InvalidatePlacements();
+	if (!signatures) return 1;
+
+	placement_pages =signatures->PagesPerSignature(-1,0);
+	placement_papers=signatures->PaperSpreadsPerSignature(-1,0);
+	if (placement_pages<=0 || placement_papers<=0) { placement_pages=placement_papers=0; return 1; }
+
+	 //count cells
+	SignatureInstance *sig;
+	int n=0;
+	placement_paperstart=new int[placement_papers+1];
+	for (int c=0; c<placement_papers; c++) {
+		placement_paperstart[c]=n;
+		sig=signatures->InstanceFromPaper(c, NULL,NULL,NULL,NULL,NULL,NULL);
+		n+=(sig->pattern->numhfolds+1)*(sig->pattern->numvfolds+1);
+	}
+	placement_paperstart[placement_papers]=n;
+
+	placements=new SignaturePlacement[n];
+	placement_frompage=new int[placement_pages];
+	for (int c=0; c<placement_pages; c++) placement_frompage[c]=-1;
+
+	int stack, insert, sigpaper, mainpageoffset, opposite_offset;
+	int rangeofpages, num_pages_in_insert, pageindex;
+	int ff,tt;
+	Signature *signature;
+	SignaturePlacement *p=placements;
+
+	for (int c=0; c<placement_papers; c++) {
+		sig=signatures->InstanceFromPaper(c, &stack,&insert, &sigpaper, &mainpageoffset, &opposite_offset, NULL);
+		signature=sig->pattern;
+		num_pages_in_insert=sig->PagesPerSignature(0,1);
+
+		 //in a signature, if there is only one sheet, each page cell can map to 2 pages,
+		 //the front and the back, whose document page indices are adjacent. When there are
+		 //more than 1 paper sheet per signature, then each cell maps to (num sheets)*2 pages.
+		rangeofpages=sig->sheetspersignature*2;
+
+		for (int rr=0; rr<signature->numhfolds+1; rr++) {
+		  for (int cc=0; cc<signature->numvfolds+1; cc++) {
+			ff=signature->foldinfo[rr][cc].finalindexback;
+			tt=signature->foldinfo[rr][cc].finalindexfront;
+			if (ff>tt) {
+				tt*=rangeofpages/2;
+				ff=tt + rangeofpages - 1;
+			} else {
+				ff*=rangeofpages/2;
+				tt=ff + rangeofpages-1;
+			}
+			if (ff>tt) pageindex=ff-sigpaper;
+			else pageindex=ff+sigpaper;
+
+			if (pageindex>=num_pages_in_insert/2) pageindex+=opposite_offset;
+			else pageindex+=mainpageoffset;
+
+			p->page    =pageindex;
+			p->paper   =c;
+			p->sigpaper=sigpaper;
+			p->stack   =stack;
+			p->insert  =insert;
+			p->row     =rr;
+			p->col     =cc;
+			p->xflip   =signature->foldinfo[rr][cc].finalxflip;
+			p->yflip   =signature->foldinfo[rr][cc].finalyflip;
+			p->instance=sig;
+
+			if (pageindex>=0 && pageindex<placement_pages && placement_frompage[pageindex]<0)
+				placement_frompage[pageindex]=p-placements;
+			p++;
+		  }
+		}
+	}
+
+	 //remember what the tables were built from
+	for (SignatureInstance *s=signatures; s; s=s->next_stack) {
+		for (SignatureInstance *ins=s; ins; ins=ins->next_insert) {
+			placement_key.push((unsigned long)ins);
+			placement_key.push((unsigned long)ins->sheetspersignature);
+			placement_key.push(ins->pattern->revision);
+		}
+	}
+
+	return 0;
+}
+
+//! Return the placement of a document page, or NULL if the page cannot be placed.
+/*! group gets how many whole groups of stacks precede the page, so the actual paper
+ * spread is placement->paper + group*(paper spreads per group).
+ */
+SignaturePlacement *SignatureImposition::PlacementFromPage(int pagenumber, int *group)
+{
+	if (pagenumber<0) return NULL;
+	if (!PlacementsValid() && BuildPlacements()!=0) return NULL;
+
+	if (group) *group=pagenumber/placement_pages;
+	int i=placement_frompage[pagenumber%placement_pages];
+	if (i<0) return NULL;
+	return placements+i;
+}
+
+//! Return the placements of all page cells on a paper spread, in row then column order.
+/*! n gets the number of cells. Pages in the placements are relative to group, as with PlacementFromPage().
+ */
+SignaturePlacement *SignatureImposition::PlacementsOnPaper(int whichpaper, int *n, int *group)
+{
+	if (n) *n=0;
+	if (whichpaper<0) return NULL;
+	if (!PlacementsValid() && BuildPlacements()!=0) return NULL;
+
+	if (group) *group=whichpaper/placement_papers;
+	whichpaper%=placement_papers;
+	if (n) *n=placement_paperstart[whichpaper+1]-placement_paperstart[whichpaper];
+	return placements+placement_paperstart[whichpaper];
+}
+
+//! Return the SignatureInstance containing the given document page.
+/*! This is a table lookup. If the page cannot be found there, then fall back to
+ * SignatureInstance::InstanceFromPage().
+ */
+SignatureInstance *SignatureImposition::InstanceFromPage(int pagenumber)
+{
+	SignaturePlacement *p=PlacementFromPage(pagenumber, NULL);
+	if (p) return p->instance;
+	return signatures->InstanceFromPage(pagenumber,NULL,NULL,NULL,NULL,NULL,NULL);
+}
+
 //! Return which paper number the given document page lays on.
 int SignatureImposition::PaperFromPage(int pagenumber)
 {
+	int group=0;
+	SignaturePlacement *p=PlacementFromPage(pagenumber, &group);
+	if (p) return p->paper + group*placement_papers;
+
 	int stack, insert, insertpage, row, col;
 	int pp=signatures->locatePaperFromPage(pagenumber, &stack, &insert, &insertpage, &row, &col, NULL);
 	return pp;
@@ -2774,6 +3004,7 @@ int SignatureImposition::GetSpreadsNeeded(int npages)
  */
 int SignatureImposition::SetPaperFromFinalSize(double w,double h)
 {
+	Modified();
 	signatures->SetPaperFromFinalSize(w,h, 1);
 	return 0;
 }
@@ -2847,6 +3078,7 @@ int SignatureImposition::NumPapers()
  */
 int SignatureImposition::NumPapers(int npapers)
 {
+	Modified();
 	int pp=signatures->PaperSpreadsPerSignature(-1,0);
 	numpapers=((npapers-1)/pp + 1) * pp;
 	return numpapers;
@@ -2876,6 +3108,8 @@ int SignatureImposition::NumPages(int npages)
 	//if (numdocpages==npages) return numpages;
 	numdocpages=npages;
 	if (!signatures) signatures=new SignatureInstance();
+	InvalidatePlacements();
+	Modified();
 
 	//all SignatureInstance objects with autoaddsheets==true get excess pages distributed
 	//between them. If there are no autoaddsheets, then whole blocks of signatures
@@ -2974,7 +3208,7 @@ Page **SignatureImposition::CreatePages(int npages)
 	int c;
 	SignatureInstance *sig;
 	for (c=0; c<numdocpages; c++) {
-		sig=signatures->InstanceFromPage(c,NULL,NULL,NULL,NULL,NULL,NULL);
+		sig=InstanceFromPage(c);
 		newpages[c]=new Page(((c%2)?sig->pagestyleodd:sig->pagestyle),c); // this incs count of pagestyle
 
 		 //add bleed information
@@ -2997,7 +3231,7 @@ void SignatureImposition::fixPageBleeds(int index, //!< Document page index
 {
 	 //fix pagestyle
 	if (!signatures) signatures=new SignatureInstance();
-	SignatureInstance *sig=signatures->InstanceFromPage(index,NULL,NULL,NULL,NULL,NULL,NULL);
+	SignatureInstance *sig=InstanceFromPage(index);
 
 	if (update_pagestyle) {
 		page->InstallPageStyle((index%2)?sig->pagestyleodd:sig->pagestyle, true);
@@ -3057,7 +3291,7 @@ PageStyle *SignatureImposition::GetPageStyle(int pagenum,int local)
 {
 	setPageStyles(0); //create if they were null
 
-	SignatureInstance *sig=signatures->InstanceFromPage(pagenum,NULL,NULL,NULL,NULL,NULL,NULL);
+	SignatureInstance *sig=InstanceFromPage(pagenum);
 		
 	PageStyle *style= (pagenum%2) ? sig->pagestyleodd : sig->pagestyle;
 	style->inc_count();
@@ -3069,7 +3303,7 @@ PageStyle *SignatureImposition::GetPageStyle(int pagenum,int local)
  */
 LaxInterfaces::SomeData *SignatureImposition::GetPageOutline(int pagenum,int local)
 {
-	SignatureInstance *sig=signatures->InstanceFromPage(pagenum,NULL,NULL,NULL,NULL,NULL,NULL);
+	SignatureInstance *sig=InstanceFromPage(pagenum);
 	return sig->GetPageOutline();
 }
 
@@ -3077,7 +3311,7 @@ LaxInterfaces::SomeData *SignatureImposition::GetPageOutline(int pagenum,int loc
  */
 LaxInterfaces::SomeData *SignatureImposition::GetPageMarginOutline(int pagenum,int local)
 {
-	SignatureInstance *sig=signatures->InstanceFromPage(pagenum,NULL,NULL,NULL,NULL,NULL,NULL);
+	SignatureInstance *sig=InstanceFromPage(pagenum);
 	return sig->GetPageMarginOutline(pagenum);
 }
 
@@ -3147,7 +3381,7 @@ Spread *SignatureImposition::PageLayout(int whichspread)
 	int page1=whichspread*2; //eventually, page1 is the one with lower left corner at origin.
 	int page2=-1;           //and numerically page2 will be > page1
 
-	SignatureInstance *sig=signatures->InstanceFromPage(page1,NULL,NULL,NULL,NULL,NULL,NULL);
+	SignatureInstance *sig=InstanceFromPage(page1);
 	double pw=sig->pattern->PageWidth(1);
 	double ph=sig->pattern->PageHeight(1);
 
@@ -3255,16 +3489,18 @@ Spread *SignatureImposition::PaperLayout(int whichpaper)
 {
 	if (whichpaper<0) whichpaper=0;
 
-	 //find containing siginstance
-	int mainpageoffset=0, opposite_offset=0;
-	int sigpaper;
-	SignatureInstance *sig=InstanceFromPaper(whichpaper, NULL,NULL, &sigpaper, &mainpageoffset, &opposite_offset, NULL);
+	 //find containing siginstance and which pages go in which cells
+	int group=0, ncells=0;
+	SignaturePlacement *cells=PlacementsOnPaper(whichpaper, &ncells, &group);
+	if (!cells) return NULL;
+	SignatureInstance *sig=cells[0].instance;
+	int sigpaper=cells[0].sigpaper;
+	int pageoffset=group*placement_pages;
 
 
 	//Create the actual Spread...
 	
 	int front=(1+whichpaper)%2; //whether to horizontally flip columns
-	int num_pages_in_insert=sig->PagesPerSignature(0,1);
 	Signature *signature=sig->pattern;
 	PaperStyle *paper=sig->partition->paper;
 
@@ -3305,14 +3541,8 @@ Spread *SignatureImposition::PaperLayout(int whichpaper)
 	double pw=ew-signature->trimleft-signature->trimright;//page width == cell - page trim
 	double ph=eh-signature->trimtop -signature->trimbottom;
 
-	 //in a signature, if there is only one sheet, each page cell can map to 2 pages,
-	 //the front and the back, whose document page indices are adjacent. When there are
-	 //more than 1 paper sheet per signature, then each cell maps to (num sheets)*2 pages.
-	int rangeofpages=sig->sheetspersignature*2;
 	int pageindex;
-	int ff,tt;
-
-	DBG cerr <<" signature pattern for paper spread "<<whichpaper<<":"<<endl;
+	int rr,cc;
 
 	 //for each tile:
 	x=(front?sig->partition->insetleft:sig->partition->insetright);
@@ -3322,13 +3552,11 @@ Spread *SignatureImposition::PaperLayout(int whichpaper)
 	  for (int ty=0; ty<sig->partition->tiley; ty++) {
 
 		 //for each cell within each tile:
-		for (int rr=0; rr<signature->numhfolds+1; rr++) {
-		  for (int cc=0; cc<signature->numvfolds+1; cc++) {
-
-			xflip=signature->foldinfo[rr][cc].finalxflip;
-			yflip=signature->foldinfo[rr][cc].finalyflip;
-
-			DBG cerr <<signature->foldinfo[rr][cc].finalindexfront<<"/"<<signature->foldinfo[rr][cc].finalindexback<<"  ";
+		for (int c=0; c<ncells; c++) {
+			rr=cells[c].row;
+			cc=cells[c].col;
+			xflip=cells[c].xflip;
+			yflip=cells[c].yflip;
 
 			xx=x+cc*ew;
 			yy=y+rr*eh; //coordinates of corner of page cell
@@ -3340,28 +3568,7 @@ Spread *SignatureImposition::PaperLayout(int whichpaper)
 			 //flip horizontally for odd numbered paper spreads (the backs of papers)
 			if (sigpaper%2==0) xx=paperwidth-xx-ew;
 
-			ff=signature->foldinfo[rr][cc].finalindexback;
-			tt=signature->foldinfo[rr][cc].finalindexfront;
-			//---------
-			if (ff>tt) {
-				tt*=rangeofpages/2;
-				ff=tt + rangeofpages - 1;
-			} else {
-				ff*=rangeofpages/2;
-				tt=ff + rangeofpages-1;
-			}
-			if (ff>tt) pageindex=ff-sigpaper;
-			else pageindex=ff+sigpaper;
-//			---------
-//			if (ff > tt) {
-//				pageindex= tt*rangeofpages/2 + rangeofpages-1 - sigpaper;
-//			} else {
-//				pageindex= tt*rangeofpages/2 + sigpaper;
-//			}
-//			----------
-			if (pageindex>=num_pages_in_insert/2) pageindex+=opposite_offset;
-			else pageindex+=mainpageoffset;
-
+			pageindex=cells[c].page+pageoffset;
 
 			pageoutline=new PathsData();//count of 1
 			pageoutline->appendRect(0,0, pw,ph); //page outline
@@ -3378,11 +3585,9 @@ Spread *SignatureImposition::PaperLayout(int whichpaper)
 			spread->pagestack.push(new PageLocation((pageindex<numdocpages?pageindex:-1),NULL,pageoutline));
 			pageoutline->dec_count();//remove extra count
 
-		  } //cc
-		}  //rr
+		} //cells
 
 		y+=patternheight+sig->partition->tilegapy;
-		DBG cerr <<endl;
 	  } //tx
 	  x+=patternwidth+sig->partition->tilegapx;
 	} //ty
@@ -3744,6 +3949,7 @@ int SignatureImposition::RemoveStack(int stack, int insert)
 		if (s->next_insert) s->next_insert->prev_insert=s->prev_insert;
 		s->next_insert=s->prev_insert=NULL;
 	}
+	InvalidatePlacements();
 	s->dec_count();
 
 	if (si) {
@@ -3811,6 +4017,8 @@ void SignatureImposition::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFile
 	char *name,*value;
 	int nump=-1;
 
+	InvalidatePlacements();
+	Modified();
 	if (signatures) { delete signatures; signatures=NULL; }
 
 	for (int c=0; c<att->attributes.n; c++) {
@@ -91,12 +91,17 @@ class Signature : public Value
 
 	 //for easy storing of final arrangement:
 	FoldedPageInfo **foldinfo;
+	unsigned long revision; //changes whenever foldinfo changes
+	int *indexcells; //final index -> r*(numvfolds+1)+c, rebuilt when indexcells_revision!=revision
+	unsigned long indexcells_revision;
 	virtual void reallocateFoldinfo();
 	virtual void resetFoldinfo(FoldedPageInfo **finfo);
 	virtual int  applyFold(FoldedPageInfo **finfo, int foldlevel);
 	virtual void applyFold(FoldedPageInfo **finfo, char folddir, int index, int under);
 	virtual int checkFoldLevel(FoldedPageInfo **finfo, int *finalrow,int *finalcol);
 	virtual int HasFinal();
+	virtual void Modified();
+	virtual int CellFromIndex(int finalindex, int *row, int *col);
 
 	Signature();
 	virtual ~Signature();
@@ -235,11 +240,38 @@ class SignatureInstance : public Value
 };
 
 
+//------------------------------------ SignaturePlacement -----------------------------------------
+class SignaturePlacement
+{
+  public:
+	int page;     //page index within one group of stacks
+	int paper;    //paper spread index within one group of stacks
+	int sigpaper; //paper spread index within instance
+	int stack, insert;
+	int row, col; //cell in pattern, as seen on the paper spread
+	int xflip, yflip;
+	SignatureInstance *instance;
+};
+
+
 //------------------------------------ SignatureImposition -----------------------------------------
 class SignatureImposition : public Imposition
 {
   protected:
 	SignatureInstance *signatures;
+
+	 //lookup tables for one group of stacks, rebuilt when placement_key no longer matches signatures
+	Laxkit::NumStack<unsigned long> placement_key;
+	int placement_pages, placement_papers;
+	SignaturePlacement *placements; //all cells of all paper spreads, in paper, then row, then col order
+	int *placement_paperstart;      //placement_papers+1 indices into placements
+	int *placement_frompage;        //placement_pages indices into placements, -1 for none
+	virtual int PlacementsValid();
+	virtual int BuildPlacements();
+	virtual void InvalidatePlacements();
+	virtual SignaturePlacement *PlacementFromPage(int pagenumber, int *group);
+	virtual SignaturePlacement *PlacementsOnPaper(int whichpaper, int *n, int *group);
+	virtual SignatureInstance *InstanceFromPage(int pagenumber);
 	
 	virtual void setPageStyles(int force_new);
 	virtual void fixPageBleeds(int index,Page *page, bool update_pagestyle);
@@ -198,6 +198,7 @@ int Singles::SetPaperSize(PaperStyle *npaper)
 int Singles::SetDefaultMargins(double l,double r,double t,double b)
 {
 	if (!pagestyle) return 1;
+	Modified();
 	pagestyle->ml = marginleft  = l;
 	pagestyle->mr = marginright = r;
 	pagestyle->mt = margintop   = t;
@@ -218,6 +219,7 @@ int Singles::SetDefaultMargins(double l,double r,double t,double b)
 void Singles::dump_in_atts(LaxFiles::Attribute *att,int flag,LaxFiles::DumpContext *context)
 {
 	if (!att) return;
+	Modified();
 	char *name,*value;
 
 	for (int c=0; c<att->attributes.n; c++) {
@@ -19,6 +19,7 @@
 #include "aligninterface.h"
 #include "../viewwindow.h"
 #include "../drawdata.h"
+#include "../undo.h"
 
 //#include "viewwindow.h"
 #include <lax/strmanip.h>
@@ -2676,8 +2677,15 @@ int AlignInterface::ApplyAlignment(int updateorig)
 
 
 	 //optionally set new transforms to be the base to work from
-	if (updateorig)	for (int c=0; c<selection->n(); c++) {
-		controls.e[c]->original_transform->m(selection->e(c)->obj->m());
+	if (updateorig) {
+		LaidoutViewport *lvp=dynamic_cast<LaidoutViewport*>(viewport);
+		UndoHistory *undo=(lvp ? lvp->GetUndoHistory() : UndoHistory::GetDefault());
+		undo->BeginGroup();
+		for (int c=0; c<selection->n(); c++) {
+			undo->Add(new TransformUndo(selection->e(c)->obj, controls.e[c]->original_transform->m(), NULL));
+			controls.e[c]->original_transform->m(selection->e(c)->obj->m());
+		}
+		undo->EndGroup();
 	}
 
 	RemapBounds(); //find new bounding box of objects in transformed state
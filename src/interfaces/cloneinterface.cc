@@ -139,6 +139,23 @@ int TilingOp::isRecursive(int which)
 
 
 
+//------------------------------------- TilingLattice ------------------------------------
+
+/*! \class TilingLattice
+ * Cache of which p1 cells of a Tiling are within a boundary, so that repeated
+ * Tiling::Render() calls do not need to test every cell against the boundary again.
+ * See Tiling::LatticeCells().
+ */
+
+TilingLattice::TilingLattice()
+{
+	valid=false;
+	key_boundary=NULL;
+	for (int c=0; c<18; c++) key[c]=0;
+	for (int c=0; c<4; c++) key_range[c]=0;
+}
+
+
 //------------------------------------- Tiling ------------------------------------
 
 /*! \class Tiling
@@ -538,29 +555,39 @@ void Tiling::dump_in_atts(LaxFiles::Attribute *att, int flag, LaxFiles::DumpCont
 //}
 
 
-//! Create tiled clones, EITHER trace the lines, OR clone sourceobjects.
-/*! Install new objects as kids of parent_space. If NULL, create and return a new Group (else return parent_space).
+/*! Find which p1 cells are approximately within boundary, and put them in lattice->cells as x,y pairs.
+ * If lattice was already computed for the same boundary, base_offsetm, p1 range, and repeat basis,
+ * then nothing is recomputed. Return the number of cells.
  *
- * If source_objects is NULL, or has no objects, then create path outline objects from the transformed base cells instead.
- * If source_objects is not NULL and has objects, then render clones of the contents, and do NOT render base cell outlines.
- *
- * Install in parent_space. If parent_space==NULL, then return a new Group.
- *
- * If base_lines!=NULL, assume it is structured 1 group per tiling->basecells, and each of those groups contains
- * however many tiling->basecells->transforms there are.
+ * If boundary==NULL, then all the cells in the p1 range are used.
+ * Only the boundary's matrix is checked for changes, not its path. Call lattice->Clear() if the path changes.
  */
-Group *Tiling::Render(Group *parent_space,
-					   Group *source_objects, //!< If non-null, clone these. Each->property["tilingSource"] is the source base index
-					   Affine *base_offsetm,  //!< Additional offset to place basecells from source_objects
-					   Group *base_lines, //!< Optional base cells. If null, then create copies of tiling's default.
+int Tiling::LatticeCells(TilingLattice *lattice,
+					   Affine *base_offsetm,
 					   int p1_minx, int p1_maxx, int p1_miny, int p1_maxy,
-					   LaxInterfaces::PathsData *boundary, //!< only render cells approximately within this
-					   Affine *final_orient   //!< final transform to apply to clones
-					 )
+					   LaxInterfaces::PathsData *boundary)
 {
-	bool trace_cells = (source_objects==NULL || (source_objects!=NULL && source_objects->n()==0));
-
-	if (!parent_space) parent_space = new Group;
+	double key[18];
+	Affine repeat;
+	repeat.setBasis(repeatOrigin(),repeatXDir(),repeatYDir());
+	transform_copy(key, boundary ? boundary->m() : repeat.m());
+	transform_copy(key+6, base_offsetm ? base_offsetm->m() : repeat.m());
+	transform_copy(key+12, repeat.m());
+
+	if (lattice->valid
+			&& lattice->key_boundary==boundary
+			&& lattice->key_range[0]==p1_minx && lattice->key_range[1]==p1_maxx
+			&& lattice->key_range[2]==p1_miny && lattice->key_range[3]==p1_maxy
+			&& !memcmp(lattice->key,key,18*sizeof(double)))
+		return lattice->cells.n/2;
+
+	lattice->Clear();
+	memcpy(lattice->key,key,18*sizeof(double));
+	lattice->key_boundary=boundary;
+	lattice->key_range[0]=p1_minx;
+	lattice->key_range[1]=p1_maxx;
+	lattice->key_range[2]=p1_miny;
+	lattice->key_range[3]=p1_maxy;
 
 
 	 //figure out the maximum bounds of the render area that covers boundary
@@ -568,7 +595,6 @@ Group *Tiling::Render(Group *parent_space,
 	if (p1_maxy<p1_miny)  p1_maxy = p1_miny;
 	if (!isXRepeatable()) p1_maxx = p1_minx;
 	if (!isYRepeatable()) p1_maxy = p1_miny;
-	Affine p1;
 
 	NumStack<flatpoint> points;
 	if (boundary) {
@@ -601,6 +627,64 @@ Group *Tiling::Render(Group *parent_space,
 	if (!isXRepeatable()) { p1_minx=p1_maxx=(p1_minx+p1_maxx)/2; }
 	if (!isYRepeatable()) { p1_miny=p1_maxy=(p1_miny+p1_maxy)/2; }
 
+	flatpoint pp;
+	for (int x=p1_minx; x<=p1_maxx; x++) {
+	  for (int y=p1_miny; y<=p1_maxy; y++) {
+		pp.x = x+.5;
+		pp.y = y+.5;
+		if ((p1_minx!=p1_maxx || p1_miny!=p1_maxy) && !point_is_in(pp, points.e, points.n)) continue;
+
+		lattice->cells.push(x);
+		lattice->cells.push(y);
+	  }
+	}
+
+	lattice->valid=true;
+	return lattice->cells.n/2;
+}
+
+//! Create tiled clones, EITHER trace the lines, OR clone sourceobjects.
+/*! Install new objects as kids of parent_space. If NULL, create and return a new Group (else return parent_space).
+ *
+ * If source_objects is NULL, or has no objects, then create path outline objects from the transformed base cells instead.
+ * If source_objects is not NULL and has objects, then render clones of the contents, and do NOT render base cell outlines.
+ *
+ * Install in parent_space. If parent_space==NULL, then return a new Group.
+ *
+ * If base_lines!=NULL, assume it is structured 1 group per tiling->basecells, and each of those groups contains
+ * however many tiling->basecells->transforms there are.
+ *
+ * If instances!=NULL, then clones of source objects are added to it as instances, rather than as
+ * a separate SomeDataRef per clone in parent_space. Its old instances are removed first. Cell outlines are
+ * still rendered into parent_space. It is up to the caller to put instances somewhere.
+ *
+ * If lattice!=NULL, it is used to cache which cells are within boundary between calls. See LatticeCells().
+ *
+ * If view!=NULL, then skip cells that are clearly outside of it, for quick previews. view is
+ * in parent_space coordinates.
+ */
+Group *Tiling::Render(Group *parent_space,
+					   Group *source_objects, //!< If non-null, clone these. Each->property["tilingSource"] is the source base index
+					   Affine *base_offsetm,  //!< Additional offset to place basecells from source_objects
+					   Group *base_lines, //!< Optional base cells. If null, then create copies of tiling's default.
+					   int p1_minx, int p1_maxx, int p1_miny, int p1_maxy,
+					   LaxInterfaces::PathsData *boundary, //!< only render cells approximately within this
+					   Affine *final_orient,  //!< final transform to apply to clones
+					   InstancedClones *instances, //!< If non-null, add source clones to this instead of parent_space
+					   TilingLattice *lattice, //!< Optional cache of which cells are in boundary
+					   DoubleBBox *view       //!< Optional bounds to render within
+					 )
+{
+	bool trace_cells = (source_objects==NULL || (source_objects!=NULL && source_objects->n()==0));
+
+	if (!parent_space) parent_space = new Group;
+	if (instances) instances->ClearInstances();
+
+	 //find which p1 cells to render, reusing lattice if possible
+	TilingLattice templattice;
+	if (!lattice) lattice = &templattice;
+	LatticeCells(lattice, base_offsetm, p1_minx,p1_maxx, p1_miny,p1_maxy, boundary);
+
 	
 	 //cache transform of source objects to base objects, if any
 	Affine *sourcem =NULL;  //matrices of source objects
@@ -671,12 +755,26 @@ Group *Tiling::Render(Group *parent_space,
 		basecellmi.Invert();
 	}
 	
+	Affine p1;
 	flatpoint pp;
-	for (int x=p1_minx; x<=p1_maxx; x++) {
-	  for (int y=p1_miny; y<=p1_maxy; y++) {
-		pp.x = x+.5;
-		pp.y = y+.5;
-		if ((p1_minx!=p1_maxx || p1_miny!=p1_maxy) && !point_is_in(pp, points.e, points.n)) continue;
+	int x,y;
+	for (int cell=0; cell<lattice->cells.n; cell+=2) {
+		x = lattice->cells.e[cell];
+		y = lattice->cells.e[cell+1];
+
+		if (view) {
+			 //skip cells that are well outside the view, padding by a cell on each side
+			DoubleBBox cellbox;
+			for (int cx=-1; cx<=2; cx+=3) {
+			  for (int cy=-1; cy<=2; cy+=3) {
+				pp = repeatOrigin() + (x+cx)*repeatXDir() + (y+cy)*repeatYDir();
+				if (final_orient) pp = final_orient->transformPoint(pp);
+				cellbox.addtobounds(pp);
+			  }
+			}
+			if (cellbox.maxx<view->minx || cellbox.minx>view->maxx
+					|| cellbox.maxy<view->miny || cellbox.miny>view->maxy) continue;
+		}
 
 		for (int c=0; c<basecells.n; c++) {
 		  for (int c2=0; c2<basecells.e[c]->transforms.n; c2++) {
@@ -710,7 +808,7 @@ Group *Tiling::Render(Group *parent_space,
 				obj = dynamic_cast<DrawableObject*>(source_objects->e(s));
 				if (!obj || obj->properties.findInt("tilingSource") != c) continue;
 
-				InsertClone(parent_space, obj, &sourcem[s], &basecellmi, clonet, final_orient);
+				InsertClone(parent_space, obj, &sourcem[s], &basecellmi, clonet, final_orient, instances);
 			  }
 			}
 
@@ -732,7 +830,7 @@ Group *Tiling::Render(Group *parent_space,
 					obj = dynamic_cast<DrawableObject*>(source_objects->e(s));
 					if (!obj || obj->properties.findInt("tilingSource") != c) continue;
 
-					InsertClone(parent_space, obj, &sourcem[s], &basecellmi, clonet, final_orient);
+					InsertClone(parent_space, obj, &sourcem[s], &basecellmi, clonet, final_orient, instances);
 				  }
 				}
 
@@ -740,13 +838,13 @@ Group *Tiling::Render(Group *parent_space,
 
 		  } //basecells dests
 		} //basecells
-	  } //y
-	} //x
+	} //cells
 
 	 //clean up
 	if (trace) trace->dec_count();
 	delete[] sourcem;
 	delete[] sourcemi;
+	if (instances) instances->FindBBox();
 
 	return parent_space;
 }
@@ -754,15 +852,28 @@ Group *Tiling::Render(Group *parent_space,
 /*! Used during Render(), this simplifies insertion of clones to destination group.
  *
  * The clone will have transform: sourcem * basecellmi * clonet * final_orient
+ *
+ * If instances!=NULL, then add an instance with that transform to it instead, and parent_space is ignored.
  */
 void Tiling::InsertClone(Group *parent_space,  //!< clone into here
 						 SomeData *object,     //!< the object to clone
 						 Affine *sourcem,      //!< use this transform in place of identity
 						 Affine *basecellmi,   //!< mapping to get source onto proper place for current base cell
 						 Affine &clonet,       //!< current clone transform
-						 Affine *final_orient  //!< final transform to apply to clone
+						 Affine *final_orient, //!< final transform to apply to clone
+						 InstancedClones *instances //!< optional instanced object to add to instead
 						 )
 {
+	if (instances) {
+		Affine a;
+		if (sourcem) a.m(sourcem->m());
+		if (basecellmi) a.Multiply(*basecellmi);
+		a.Multiply(clonet);
+		if (final_orient) a.Multiply(*final_orient);
+		instances->AddInstance(instances->AddSource(object), a.m());
+		return;
+	}
+
 	SomeDataRef *clone = dynamic_cast<SomeDataRef*>(LaxInterfaces::somedatafactory()->NewObject("SomeDataRef"));
 	
 	if (dynamic_cast<SomeDataRef*>(object)) object=dynamic_cast<SomeDataRef*>(object)->GetFinalObject();
@@ -2464,6 +2575,8 @@ enum CloneInterfaceElements {
 	CLONEIA_Toggle_Orientations,
 	CLONEIA_Select,
 	CLONEIA_ColorFillOrStroke,
+	CLONEIA_Toggle_Instances,
+	CLONEIA_Expand_Instances,
 	
 	 //interface modes
 	CMODE_Normal,
@@ -2504,6 +2617,7 @@ CloneInterface::CloneInterface(anInterface *nowner,int nid,Laxkit::Displayer *nd
 	preview_orient = false;
 	snap_to_base = true;
 	color_to_stroke = true;
+	instance_clones = true;
 	show_p1 = false; 
 
 	 //structure is:
@@ -2516,6 +2630,8 @@ CloneInterface::CloneInterface(anInterface *nowner,int nid,Laxkit::Displayer *nd
 	 //      for base 2
 	previewoc = NULL;
 	preview = NULL; 
+	clones = NULL;
+	render_timer = 0;
 	base_cells = NULL;
 	source_proxies = NULL;
 
@@ -2572,7 +2688,9 @@ CloneInterface::~CloneInterface()
 	if (base_cells) base_cells->dec_count();
 	if (source_proxies) source_proxies->dec_count();
 	if (lines) lines->dec_count();
+	if (clones) clones->dec_count();
 	if (previewoc) delete previewoc;
+	if (render_timer) app->removetimer(this,render_timer);
 }
 
 const char *CloneInterface::Name()
@@ -2601,7 +2719,10 @@ void CloneInterface::Clear(LaxInterfaces::SomeData *d)
 	if (preview)        { preview->dec_count();        preview = NULL;        }
 	if (base_cells)     { base_cells->dec_count();     base_cells = NULL;     }
 	if (source_proxies) { source_proxies->dec_count(); source_proxies = NULL; }
+	if (clones)         { clones->dec_count();         clones = NULL;         }
 	if (lines) lines->flush();
+	if (render_timer)   { app->removetimer(this,render_timer); render_timer = 0; }
+	lattice.Clear();
 
 	active = false;
 }
@@ -2698,6 +2819,7 @@ int CloneInterface::SetTiling(Tiling *newtiling)
 
 	Tiling *oldtiling = tiling;
 	tiling = newtiling;
+	lattice.Clear();
 
 	extra_input_fields.flush();
 	for (int c=0; c<tiling->basecells.n; c++) {
@@ -2898,6 +3020,8 @@ Laxkit::ShortcutHandler *CloneInterface::GetShortcuts()
 	sc->Add(CLONEIA_Edit,            'e',ControlMask,0,"Edit",              _("Edit"),NULL,0);
 	sc->Add(CLONEIA_Select,             's',0,0,       "Select",            _("Select tile mode"),NULL,0);
 	sc->Add(CLONEIA_ColorFillOrStroke,  'x',0,0,       "FillOrStroke",      _("Toggle sending color to fill or stroke"),NULL,0);
+	sc->Add(CLONEIA_Toggle_Instances,   'i',0,0,       "ToggleInstances",   _("Toggle instanced clones, or separate clone objects"),NULL,0);
+	sc->Add(CLONEIA_Expand_Instances,   'I',ShiftMask,0,"ExpandInstances",  _("Expand instanced clones into separate clone objects"),NULL,0);
 
 	//sc->AddShortcut(LAX_Del,0,0, PAPERI_Delete);
 
@@ -2964,6 +3088,15 @@ int CloneInterface::PerformAction(int action)
 		needtodraw=1;
 		return 0;
 
+	} else if (action==CLONEIA_Toggle_Instances) {
+		ToggleInstances();
+		needtodraw=1;
+		return 0;
+
+	} else if (action==CLONEIA_Expand_Instances) {
+		ExpandInstances();
+		return 0;
+
 	} else if (action==CLONEIA_Toggle_Orientations) {
 		ToggleOrientations();
 		needtodraw=1;
@@ -3157,6 +3290,13 @@ int CloneInterface::Event(const Laxkit::EventData *e,const char *mes)
 				}
 			}
 		}
+
+		if (rectinterface.somedata == base_cells || rectinterface.somedata == boundary) {
+			 //every clone moves, so only redo what is in view until the mouse is released
+			if (active) Render(true);
+		} else {
+			UpdateSourceBounds();
+		}
 		return 0;
 
 	} else if (!strncmp(mes,"setrecurse",10)) {
@@ -3909,7 +4049,11 @@ int CloneInterface::LBDown(int x,int y,unsigned int state,int count,const Laxkit
 			} else if (status == 2) { //child existed already
 			}
 
-			if (active) Render();
+			if (active) {
+				 //instanced clones draw the source groups live, so they only need new bounds
+				if (clones && NumProxies()>1) UpdateSourceBounds();
+				else Render();
+			}
 
 			needtodraw=1;
 			return 0;
@@ -3928,20 +4072,36 @@ int CloneInterface::LBDown(int x,int y,unsigned int state,int count,const Laxkit
 
 /*! Render lines and/or objects into preview.
  * If active, then also check to ensure that preview is properly installed in viewport.
+ *
+ * If in_view_only, then skip cells that are outside the viewport, for quick updates while
+ * dragging. A full Render() is done from Idle() once the mouse button is released.
  */
-int CloneInterface::Render()
+int CloneInterface::Render(bool in_view_only)
 {
 	if (!tiling) return 1;
 
 	preview->flush(); //remove old clones
 	preview->push(base_cells);
+	if (clones) { clones->dec_count(); clones = NULL; }
+
+	DoubleBBox viewbox, *view = NULL;
+	if (in_view_only) {
+		 //preview has the same space as this interface, so use the current view bounds
+		viewbox.addtobounds(dp->screentoreal(dp->Minx,dp->Miny));
+		viewbox.addtobounds(dp->screentoreal(dp->Maxx,dp->Miny));
+		viewbox.addtobounds(dp->screentoreal(dp->Maxx,dp->Maxy));
+		viewbox.addtobounds(dp->screentoreal(dp->Minx,dp->Maxy));
+		view = &viewbox;
+
+		if (!render_timer) render_timer = app->addtimer(this, 100, 100, -1);
+	}
 
 
 	 //render lines for preview only
 	Group *ret=NULL;
 	if (trace_cells || preview_lines) {
 		lines->flush();
-		ret = tiling->Render(lines, NULL, base_cells, NULL, 0,3, 0,3, boundary, base_cells);
+		ret = tiling->Render(lines, NULL, base_cells, NULL, 0,3, 0,3, boundary, base_cells, NULL, &lattice, view);
 		if (!ret) {
 			PostMessage(_("Could not clone!"));
 			return 0;
@@ -3968,7 +4128,18 @@ int CloneInterface::Render()
 			layer->dec_count();
 		}
 
-		ret = tiling->Render(layer, srcs, base_cells, NULL, 0,3, 0,3, boundary, base_cells);
+		if (instance_clones) {
+			 //one object holding all the clones, instead of an object per clone
+			clones = new InstancedClones;
+			char *str = make_id("clones");
+			clones->Id(str);
+			delete[] str;
+			ret = tiling->Render(layer, srcs, base_cells, NULL, 0,3, 0,3, boundary, base_cells, clones, &lattice, view);
+			layer->push(clones);
+
+		} else {
+			ret = tiling->Render(layer, srcs, base_cells, NULL, 0,3, 0,3, boundary, base_cells, NULL, &lattice, view);
+		}
 		if (srcs != source_proxies) srcs->dec_count();
 
 		if (!ret) {
@@ -3990,7 +4161,7 @@ int CloneInterface::Render()
 			preview->push(layer);
 			layer->dec_count();
 		}
-		ret = tiling->Render(layer, NULL, base_cells, base_cells, 0,3, 0,3, boundary, base_cells);
+		ret = tiling->Render(layer, NULL, base_cells, base_cells, 0,3, 0,3, boundary, base_cells, NULL, &lattice, view);
 		layer->FindBBox();
 		if (preview != layer) preview->FindBBox();
 	}
@@ -4021,6 +4192,90 @@ int CloneInterface::Render()
 	return 0;
 }
 
+/*! Finish a Render(true) once the mouse button is up.
+ */
+int CloneInterface::Idle(int tid)
+{
+	if (tid != render_timer) return 1;
+
+	int mx,my;
+	unsigned int state = 0;
+	mouseposition(0, curwindow, &mx,&my, &state, NULL, NULL);
+	if (state & Button1Mask) return 0; //still dragging
+
+	app->removetimer(this,render_timer);
+	render_timer = 0;
+	if (active) Render();
+	return 0;
+}
+
+/*! Clones draw their sources live, so when a source object is moved around,
+ * only the bounds of the base cell source groups, and of instanced clones of them need updating,
+ * not a whole new Render().
+ */
+void CloneInterface::UpdateSourceBounds()
+{
+	if (source_proxies) {
+		for (int c=0; c<source_proxies->n(); c++) source_proxies->e(c)->FindBBox();
+	}
+	if (clones) {
+		clones->FindBBox();
+		DrawableObject *layer = dynamic_cast<DrawableObject*>(clones->GetParent());
+		if (layer) layer->FindBBox();
+	}
+	needtodraw=1;
+}
+
+/*! Toggle between rendering source clones as a single InstancedClones object,
+ * or as a separate SomeDataRef for each clone.
+ */
+int CloneInterface::ToggleInstances()
+{
+	instance_clones = !instance_clones;
+	if (active) Render();
+	needtodraw=1;
+
+	PostMessage(instance_clones ? _("Instanced clones") : _("Separate clone objects"));
+	return instance_clones;
+}
+
+/*! Replace the instanced clones in preview with a group holding a separate clone object
+ * per instance, and render separate clones from now on. Exporters other than pdf and svg
+ * do not know about InstancedClones, so this is what to do before exporting to those.
+ *
+ * Returns 0 for expanded, or nonzero for nothing to expand.
+ */
+int CloneInterface::ExpandInstances()
+{
+	if (!clones) {
+		PostMessage(_("No instanced clones to expand"));
+		return 1;
+	}
+
+	DrawableObject *layer = dynamic_cast<DrawableObject*>(clones->GetParent());
+	int i = (layer ? layer->findindex(clones) : -1);
+	if (i < 0) return 1;
+
+	Group *group = clones->Expand();
+	char *str = make_id("clones");
+	group->Id(str);
+	delete[] str;
+
+	layer->remove(i);
+	layer->push(group);
+	group->dec_count();
+	layer->FindBBox();
+	if (preview != layer) preview->FindBBox();
+
+	clones->dec_count();
+	clones = NULL;
+	instance_clones = false;
+	needtodraw=1;
+
+	PostMessage(_("Expanded to separate clone objects"));
+	return 0;
+}
+
 int CloneInterface::ToggleOrientations()
 {
 	preview_orient = !preview_orient;
@@ -16,6 +16,7 @@
 
 #include "../calculator/values.h"
 #include "../dataobjects/group.h"
+#include "../dataobjects/instancedclones.h"
 #include "../language.h"
 #include "../viewwindow.h"
 
@@ -102,13 +103,32 @@ class TilingOp
 };
 
 
+//------------------------------------- TilingLattice ------------------------------------
+
+class TilingLattice
+{
+  public:
+	double key[18]; //boundary matrix, base offset, and repeat basis that cells were found for
+	int key_range[4];
+	LaxInterfaces::PathsData *key_boundary;
+	bool valid;
+
+	Laxkit::NumStack<int> cells; //x,y pairs of p1 cells that are within the boundary
+
+	TilingLattice();
+	virtual ~TilingLattice() {}
+	virtual void Clear() { valid=false; cells.flush(); }
+};
+
+
 //------------------------------------- Tiling ------------------------------------
 
 class Tiling : public Laxkit::anObject, public LaxFiles::DumpUtility //, public MetaInfo
 {
   protected:
 	void InsertClone(Group *parent_space, LaxInterfaces::SomeData *object, 
-			Laxkit::Affine *sourcem, Laxkit::Affine *basecellmi, Laxkit::Affine &clonet, Laxkit::Affine *final_orient);
+			Laxkit::Affine *sourcem, Laxkit::Affine *basecellmi, Laxkit::Affine &clonet, Laxkit::Affine *final_orient,
+			InstancedClones *instances=NULL);
 
   public:
 	char *name;
@@ -157,13 +177,20 @@ class Tiling : public Laxkit::anObject, public LaxFiles::DumpUtility //, public
 	virtual TilingOp *AddBase(LaxInterfaces::PathsData *outline, int absorb_count, int lock_base,
 								bool shearable=false, bool flexible_base=false);
 
+	virtual int LatticeCells(TilingLattice *lattice,
+					   Laxkit::Affine *base_offsetm,
+					   int p1_minx, int p1_maxx, int p1_miny, int p1_maxy,
+					   LaxInterfaces::PathsData *boundary);
 	virtual Group *Render(Group *parent_space,
 					   Group *source_objects,
 					   Laxkit::Affine *base_offsetm,
 					   Group *base_lines, //!< Optional base cells. If null, then create copies of tiling's default.
 					   int p1_minx, int p1_maxx, int p1_miny, int p1_maxy,
 					   LaxInterfaces::PathsData *boundary,
-					   Laxkit::Affine *final_orient);
+					   Laxkit::Affine *final_orient,
+					   InstancedClones *instances=NULL,
+					   TilingLattice *lattice=NULL,
+					   Laxkit::DoubleBBox *view=NULL);
 //	virtual void RenderRecursive(TilingDest *dest, int iterations, Laxkit::Affine current_space,
 //					   Group *parent_space,
 //					   LaxInterfaces::ObjectContext *base_object_to_update, //!< If non-null, update relevant clones connected to base object
@@ -198,6 +225,7 @@ class CloneInterface : public LaxInterfaces::anInterface
 	bool preview_orient;
 	bool snap_to_base;
 	bool color_to_stroke;
+	bool instance_clones;
 	bool show_p1;
 
 	bool trace_cells;
@@ -205,6 +233,9 @@ class CloneInterface : public LaxInterfaces::anInterface
 	VObjContext *previewoc;
 	Group *preview;
 	Group *lines;
+	InstancedClones *clones; //points to the instanced clones in preview, if any
+	TilingLattice lattice;
+	int render_timer;
 
 	LaxInterfaces::PathsData *boundary;
 
@@ -242,7 +273,10 @@ class CloneInterface : public LaxInterfaces::anInterface
 	virtual int ToggleOrientations();
 	virtual int ToggleActivated();
 	virtual int TogglePreview();
-	virtual int Render();
+	virtual int ToggleInstances();
+	virtual int ExpandInstances();
+	virtual int Render(bool in_view_only=false);
+	virtual void UpdateSourceBounds();
 	virtual void DrawSelected();
 	virtual Laxkit::ScreenColor *BaseCellColor(int which);
 	virtual TilingDest *GetDest(const char *str);
@@ -275,6 +309,7 @@ class CloneInterface : public LaxInterfaces::anInterface
 	virtual void Clear(LaxInterfaces::SomeData *d);
 	virtual int InterfaceOn();
 	virtual int InterfaceOff(); 
+	virtual int Idle(int tid=0);
 	virtual Laxkit::MenuInfo *ContextMenu(int x,int y,int deviceid, Laxkit::MenuInfo *menu);
 	virtual int Event(const Laxkit::EventData *e,const char *mes);
 
@@ -25,6 +25,7 @@
 
 #include "nodeinterface.h"
 #include "../utils.h"
+#include "../laidout.h"
 
 #include <lax/laxutils.h>
 #include <lax/bezutils.h>
@@ -367,6 +368,8 @@ NodeBase::NodeBase()
 	fullwidth = 0;
 	deletable = true; //usually at least one node will not be deletable
 	modtime   = 0;
+	update_pass = 0;
+	update_pending = 0;
 
 	type = NULL;
 	def = NULL;
@@ -422,7 +425,7 @@ LaxInterfaces::anInterface *NodeBase::PropInterface(LaxInterfaces::anInterface *
 int NodeBase::GetStatus()
 { 
 	 //find newest mod time of inputs
-	std::time_t t=0;
+	unsigned long t=0;
 	for (int c=0; c<properties.n; c++) {
 		if (!properties.e[c]->IsOutput() && properties.e[c]->modtime > t) t = properties.e[c]->modtime;
 	}
@@ -436,31 +439,26 @@ int NodeBase::GetStatus()
 	return 0;
 }
 
+/*! Return a new revision number for modtime fields. This only ever increases, so unlike
+ * time(NULL), changes within the same second are still ordered.
+ */
+unsigned long NodeBase::NewModtime()
+{
+	static unsigned long revision = 0;
+	return __sync_add_and_fetch(&revision, 1); //nodes may be updating in several threads
+}
+
 /*! Call whenever any of the inputs change, update outputs.
- * Default placeolder is to trigger update in connected outputs.
+ * Default placeolder is to trigger update in connected outputs, via NodeGroup::PropagateUpdate().
  * Subclasses should redefine to actually update the outputs based on the inputs
- * or any other internal state, as well as the overall preview (if any).
+ * or any other internal state, as well as the overall preview (if any), then call this.
  *
  * Returns GetStatus().
  */
 int NodeBase::Update()
 {
-	NodeProperty *prop;
-
-	for (int c=0; c<properties.n; c++) {
-		prop = properties.e[c];
-
-		if (prop->IsInput()) continue;
-		if (prop->connections.n==0) continue;
-
-		for (int c2=0; c2<prop->connections.n; c2++) {
-			if (prop->connections.e[c2]->to) {
-				prop->connections.e[c2]->to->Update();
-			}
-		}
-	}
-
-	modtime = time(NULL);
+	modtime = NewModtime();
+	NodeGroup::PropagateUpdate(this);
 	return GetStatus();
 }
 
@@ -469,6 +467,36 @@ int NodeBase::UpdatePreview()
 	return 1;
 }
 
+/*! \fn int NodeBase::Process(NodeProgressFunc progress, void *data)
+ * Do any slow, full quality work that Update() puts off, such as rendering and saving
+ * a full size image, while Update() only makes what is needed for previews.
+ * If progress is not NULL, call it now and then with how much is done, from 0 to 1.
+ * If it returns nonzero, stop.
+ *
+ * Return 1 for something processed, 0 for nothing to do, or -1 for error or canceled.
+ * Default is to do nothing.
+ */
+
+/*! \fn int NodeBase::ProcessPending()
+ * Return nonzero if an Update() put off work that Process() should do, such as when
+ * a save node has changed, but its file is not written yet. Default is 0.
+ */
+
+/*! Set preview_area, the part of total_preview that is on screen, as fractions 0..1 of its width and height.
+ * NodeInterface calls this as it draws the preview.
+ *
+ * Return 1 if some of that area has not been rendered, and UpdatePreview() should be called.
+ * Default is to return 0, as total_preview is assumed to be complete.
+ */
+int NodeBase::PreviewArea(double minx,double maxx,double miny,double maxy)
+{
+	preview_area.minx = minx;
+	preview_area.maxx = maxx;
+	preview_area.miny = miny;
+	preview_area.maxy = maxy;
+	return 0;
+}
+
 /*! Update the bounds to be just enough to encase everything.
  */
 int NodeBase::Wrap()
@@ -856,11 +884,169 @@ Laxkit::ObjectFactory *NodeGroup::NodeFactory(bool create)
 		nodekeeper.SetObject(node_factory, true);
 
 		SetupDefaultNodeTypes(node_factory);
+
+		 //headless runs put off loading node plugins until now
+		if (laidout) laidout->InitializePlugins();
 	}
 
 	return node_factory;
 }
 
+/*! Nonzero while PropagateUpdate() is updating downstream nodes.
+ */
+int NodeGroup::propagating = 0;
+
+/*! Incremented for each PropagateUpdate() pass. Nodes in the current pass have NodeBase::update_pass equal to this.
+ */
+unsigned long NodeGroup::update_pass = 0;
+
+//! Nodes that changed while a PropagateUpdate() pass was running, to be redone.
+static Laxkit::NumStack<NodeBase*> node_restarts;
+
+/*! Decrement the pending count of every node in the current pass that node feeds into,
+ * and push any that become ready onto ready.
+ *
+ * In a pass, NodeBase::update_pending is how many dirty nodes feeding into a node are not updated yet,
+ * or -1 once the node itself is updated.
+ */
+static void node_update_release(NodeBase *node, unsigned long pass, Laxkit::NumStack<NodeBase*> &ready)
+{
+	for (int c=0; c<node->properties.n; c++) {
+		NodeProperty *prop = node->properties.e[c];
+		if (prop->IsInput()) continue;
+
+		for (int c2=0; c2<prop->connections.n; c2++) {
+			NodeBase *to = prop->connections.e[c2]->to;
+			if (!to || to->update_pass != pass || to->update_pending <= 0) continue;
+			to->update_pending--;
+			if (to->update_pending == 0) ready.push(to);
+		}
+	}
+}
+
+/*! Update everything downstream of changed, each node exactly once, with every node
+ * updated only after all the affected nodes feeding into it.
+ *
+ * Simply having each Update() call Update() on everything connected to its outputs
+ * updates a node once per path to it, which explodes on graphs with lots of diamonds.
+ * Instead, this marks every node reachable from changed as dirty, sorts them topologically,
+ * then calls Update() on each in order. While that is happening, the NodeBase::Update()
+ * of the nodes being updated do not propagate further, since their downstream nodes are already scheduled.
+ *
+ * If an Update() changes some node that has already been updated in the pass, or is not part
+ * of it at all, the rest of the pass is stale. It is canceled, and a new pass is run from
+ * the nodes that changed plus the nodes the canceled pass had not gotten to yet.
+ *
+ * Nodes that are part of a cycle are never ready, so they are skipped instead of recursing forever.
+ *
+ * Everything happens on the calling thread. Most nodes are cheap, and the expensive ones
+ * (gegl nodes) share one gegl graph, so there is nothing to gain from threads here.
+ *
+ * Returns the number of nodes updated.
+ */
+int NodeGroup::PropagateUpdate(NodeBase *changed)
+{
+	if (!changed) return 0;
+
+	if (propagating) {
+		 //nodes in the current pass still waiting for their update are taken care of, others mean a restart
+		if (changed->update_pass == update_pass && changed->update_pending >= 0) return 0;
+		changed->inc_count();
+		node_restarts.push(changed);
+		return 0;
+	}
+
+	 //sources have changed themselves, stale nodes still need their own Update()
+	Laxkit::NumStack<NodeBase*> sources, stale;
+	changed->inc_count();
+	sources.push(changed);
+
+	int n = 0;
+	for (int round = 0; (sources.n || stale.n) && round < 100; round++) {
+		unsigned long pass = ++update_pass;
+
+		 //find all the dirty nodes, reachable from sources, plus the stale ones
+		Laxkit::NumStack<NodeBase*> dirty, tocheck;
+		for (int c=0; c<sources.n; c++) tocheck.push(sources.e[c]);
+		for (int c=0; c<stale.n; c++) {
+			if (stale.e[c]->update_pass == pass) continue;
+			stale.e[c]->update_pass = pass;
+			stale.e[c]->update_pending = 0;
+			dirty.push(stale.e[c]);
+			tocheck.push(stale.e[c]);
+		}
+		while (tocheck.n) {
+			NodeBase *node = tocheck.pop();
+			for (int c=0; c<node->properties.n; c++) {
+				NodeProperty *prop = node->properties.e[c];
+				if (prop->IsInput()) continue;
+
+				for (int c2=0; c2<prop->connections.n; c2++) {
+					NodeBase *to = prop->connections.e[c2]->to;
+					if (!to || to->update_pass == pass) continue;
+					to->update_pass = pass;
+					to->update_pending = 0;
+					dirty.push(to);
+					tocheck.push(to);
+				}
+			}
+		}
+
+		 //count how many dirty nodes feed into each dirty node
+		for (int c=0; c<dirty.n; c++) {
+			NodeBase *node = dirty.e[c];
+			for (int c2=0; c2<node->properties.n; c2++) {
+				NodeProperty *prop = node->properties.e[c2];
+				if (prop->IsInput()) continue;
+
+				for (int c3=0; c3<prop->connections.n; c3++) {
+					NodeBase *to = prop->connections.e[c3]->to;
+					if (to && to->update_pass == pass) to->update_pending++;
+				}
+			}
+		}
+
+		Laxkit::NumStack<NodeBase*> ready;
+		for (int c=0; c<dirty.n; c++) {
+			if (dirty.e[c]->update_pending == 0) ready.push(dirty.e[c]);
+		}
+
+		propagating++;
+		int canceled = 0;
+		while (ready.n) {
+			NodeBase *node = ready.pop(0);
+			node->Update();
+			node->update_pending = -1;
+			n++;
+			if (node_restarts.n) { canceled = 1; break; }
+			node_update_release(node, pass, ready);
+		}
+		propagating--;
+
+		for (int c=0; c<sources.n; c++) sources.e[c]->dec_count();
+		sources.flush();
+		stale.flush();
+
+		if (canceled) {
+			 //start over from what changed, and whatever this pass did not get to
+			while (node_restarts.n) sources.push(node_restarts.pop(0));
+			for (int c=0; c<dirty.n; c++) {
+				if (dirty.e[c]->update_pending >= 0) stale.push(dirty.e[c]);
+			}
+		}
+
+		DBG if (!canceled) {
+		DBG 	int missed = 0;
+		DBG 	for (int c=0; c<dirty.n; c++) if (dirty.e[c]->update_pending >= 0) missed++;
+		DBG 	if (missed) cerr << " *** warning! "<<missed<<" nodes in a cycle not updated!"<<endl;
+		DBG }
+	}
+
+	for (int c=0; c<sources.n; c++) sources.e[c]->dec_count();
+
+	return n;
+}
+
 /*! Install newnodefactory. If it is null, then remove the default. Else inc count on it (and install as default).
  */
 void NodeGroup::SetNodeFactory(Laxkit::ObjectFactory *newnodefactory)
@@ -978,6 +1164,35 @@ int NodeGroup::Connect(NodeProperty *from, NodeProperty *to, NodeConnection *use
 	return 0;
 }
 
+/*! Process() every node in the group with ProcessPending(), such as save nodes whose files
+ * are out of date. Stops at the first one canceled through progress.
+ *
+ * Return the number processed, or -1 if any failed or were canceled.
+ */
+int NodeGroup::Process(NodeProgressFunc progress, void *data)
+{
+	int n = 0, errors = 0;
+	for (int c=0; c<nodes.n; c++) {
+		if (!nodes.e[c]->ProcessPending()) continue;
+
+		int status = nodes.e[c]->Process(progress, data);
+		if (status > 0) n++;
+		else if (status < 0) { errors++; break; }
+	}
+	return errors ? -1 : n;
+}
+
+/*! Return the number of nodes in the group that have ProcessPending().
+ */
+int NodeGroup::ProcessPending()
+{
+	int n = 0;
+	for (int c=0; c<nodes.n; c++) {
+		if (nodes.e[c]->ProcessPending()) n++;
+	}
+	return n;
+}
+
 /*! Use when connecting forward to node via connection. Traverse forwards through connection,
  * and node should not be found. Return 0 if not found, or 1 for found.
  */
@@ -1618,7 +1833,7 @@ int MathNode::Update()
 
 	if (!properties.e[3]->data) properties.e[3]->data=new DoubleValue(result);
 	else dynamic_cast<DoubleValue*>(properties.e[3]->data)->d = result;
-	properties.e[3]->modtime = time(NULL);
+	properties.e[3]->modtime = NewModtime();
 
 	return NodeBase::Update();
 }
@@ -1853,6 +2068,7 @@ Laxkit::MenuInfo *NodeInterface::ContextMenu(int x,int y,int deviceid, Laxkit::M
 		menu->AddItem(_("Show previews"), NODES_Show_Previews);
 		menu->AddItem(_("Hide previews"), NODES_Hide_Previews);
 	}
+	menu->AddItem(selected.n ? _("Process selected") : _("Process all"), NODES_Process_Nodes);
 
 	return menu;
 }
@@ -1865,6 +2081,8 @@ int NodeInterface::Event(const Laxkit::EventData *data, const char *mes)
 
         if (i==NODES_Add_Node) {
 			PerformAction(NODES_Add_Node);
+		} else if (i==NODES_Show_Previews || i==NODES_Hide_Previews || i==NODES_Process_Nodes) {
+			PerformAction(i);
 		}
 
 		return 0;
@@ -2193,7 +2411,25 @@ int NodeInterface::Refresh()
 				//double ph = (node->width-th)*node->total_preview->h()/node->total_preview->w();
 				double ph = node->total_preview->h();
 				double pw = node->total_preview->w();
-				dp->imageout(node->total_preview, node->x+node->width/2-pw/2, node->y+th*1.15, pw, ph);
+				double px = node->x+node->width/2-pw/2;
+				double py = node->y+th*1.15;
+
+				 //tell the node which part of the preview is on screen, so it need only render that
+				flatpoint p1 = dp->realtoscreen(px,py), p2 = dp->realtoscreen(px+pw,py+ph);
+				double sx1 = p1.x, sx2 = p2.x, sy1 = p1.y, sy2 = p2.y;
+				if (sx1 > sx2) { sx1 = p2.x; sx2 = p1.x; }
+				if (sy1 > sy2) { sy1 = p2.y; sy2 = p1.y; }
+				if (sx2>sx1 && sy2>sy1) {
+					double vx1 = ((sx1 < 0 ? 0 : sx1) - sx1) / (sx2-sx1);
+					double vx2 = ((sx2 > curwindow->win_w ? curwindow->win_w : sx2) - sx1) / (sx2-sx1);
+					double vy1 = ((sy1 < 0 ? 0 : sy1) - sy1) / (sy2-sy1);
+					double vy2 = ((sy2 > curwindow->win_h ? curwindow->win_h : sy2) - sy1) / (sy2-sy1);
+					if (p1.x > p2.x) { double t = 1-vx1; vx1 = 1-vx2; vx2 = t; }
+					if (p1.y > p2.y) { double t = 1-vy1; vy1 = 1-vy2; vy2 = t; }
+					if (node->PreviewArea(vx1,vx2,vy1,vy2)) node->UpdatePreview();
+				}
+
+				dp->imageout(node->total_preview, px, py, pw, ph);
 				y += ph;
 			}
 		//}
@@ -3166,12 +3402,22 @@ Laxkit::ShortcutHandler *NodeInterface::GetShortcuts()
 
     sc->Add(NODES_Save_Nodes,      's',0,  0, "SaveNodes"      , _("Save Nodes"     ),NULL,0);
     sc->Add(NODES_Load_Nodes,      'l',0,  0, "LoadNodes"      , _("Load Nodes"     ),NULL,0);
+    sc->Add(NODES_Process_Nodes,   'p',0,  0, "ProcessNodes"   , _("Process Nodes"  ),NULL,0);
 
     manager->AddArea(whattype(),sc);
     return sc;
 
 }
 
+/*! Progress for NodeBase::Process() called from NodeInterface. Nothing is drawn while processing,
+ * so this only reports to the terminal in debug builds.
+ */
+static int node_process_progress(NodeBase *node, double fraction, void *data)
+{
+	DBG cerr << (node->Label() ? node->Label() : node->Type()) << ": " << int(fraction*100) << "%" << endl;
+	return 0;
+}
+
 int NodeInterface::PerformAction(int action)
 {
 	if (action==NODES_Group_Nodes) {
@@ -3265,12 +3511,37 @@ int NodeInterface::PerformAction(int action)
 		needtodraw=1;
 		return 0;
 
+	} else if (action==NODES_Process_Nodes) {
+		 //do the full quality work that updates put off, for selected nodes, or all pending if none selected
+		if (!nodes) return 0;
+
+		Laxkit::RefPtrStack<NodeBase> *nn = (selected.n ? &selected : &nodes->nodes);
+
+		int n = 0, errors = 0;
+		for (int c=0; c<nn->n; c++) {
+			if (!selected.n && !nn->e[c]->ProcessPending()) continue;
+
+			int status = nn->e[c]->Process(node_process_progress, NULL);
+			if (status > 0) n++;
+			else if (status < 0) errors++;
+		}
+
+		char scratch[200];
+		if (errors) sprintf(scratch, _("Processed %d nodes, %d failed."), n, errors);
+		else sprintf(scratch, _("Processed %d nodes."), n);
+		PostMessage(scratch);
+		needtodraw=1;
+		return 0;
+
 	} else if (action==NODES_Save_Nodes) {
 		DBG cerr <<"save nodes..."<<endl;
 		if (!nodes) return 0;
 
 		const char *file = "nodes-TEMP.nodes";
 
+		 //write out anything updates have put off, so saved outputs match the saved graph
+		if (nodes->ProcessPending()) nodes->Process(node_process_progress, NULL);
+
 		DumpContext context(NULL,1, object_id);
 		ErrorLog log;
 		context.log = &log;
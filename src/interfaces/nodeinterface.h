@@ -55,6 +55,9 @@ namespace Laidout {
 class NodeBase;
 class NodeProperty;
 
+//return nonzero to cancel
+typedef int (*NodeProgressFunc)(NodeBase *node, double fraction, void *data);
+
 
 //---------------------------- NodeConnection ------------------------------------
 class NodeConnection
@@ -97,7 +100,7 @@ class NodeProperty
 	char *name;
 	char *label;
 	char *tooltip;
-	std::time_t modtime;
+	unsigned long modtime; //revision of last change, see NodeBase::NewModtime()
 
 	NodeBase *owner;
 	Value *data;
@@ -195,12 +198,19 @@ class NodeBase : public Laxkit::anObject, public Laxkit::DoubleRectangle
 	bool deletable;
 
 	Laxkit::LaxImage *total_preview;
+	Laxkit::DoubleBBox preview_area; //part of total_preview last drawn on screen, as fractions of its size
 
 	Laxkit::PtrStack<NodeProperty> properties; //includes inputs and outputs
-	std::time_t modtime; //time of last update
+	unsigned long modtime; //revision of last update, see NewModtime()
+
+	 //bookkeeping for NodeGroup::PropagateUpdate()
+	unsigned long update_pass;
+	int update_pending;
 
 	NodeColors *colors;
 
+	static unsigned long NewModtime();
+
 	NodeBase();
 	virtual ~NodeBase();
 	virtual const char *whattype() { return "Nodes"; }
@@ -214,6 +224,9 @@ class NodeBase : public Laxkit::anObject, public Laxkit::DoubleRectangle
 
 	virtual int Update();
 	virtual int UpdatePreview();
+	virtual int Process(NodeProgressFunc progress=NULL, void *data=NULL) { return 0; }
+	virtual int ProcessPending() { return 0; } //nonzero if Update() put off work for Process()
+	virtual int PreviewArea(double minx,double maxx,double miny,double maxy);
 	virtual int GetStatus();
 	virtual int UsesPreview() { return total_preview!=NULL && show_preview; }
 	virtual int Wrap();
@@ -242,6 +255,8 @@ class NodeBase : public Laxkit::anObject, public Laxkit::DoubleRectangle
 class NodeGroup : public NodeBase, public LaxFiles::DumpUtility
 {
 	static Laxkit::SingletonKeeper nodekeeper;
+	static int propagating;
+	static unsigned long update_pass;
 
   protected:
 	virtual int CheckForward(NodeBase *node, NodeConnection *connection);
@@ -250,6 +265,7 @@ class NodeGroup : public NodeBase, public LaxFiles::DumpUtility
   public:
 	static Laxkit::ObjectFactory *NodeFactory(bool create=true);
 	static void SetNodeFactory(Laxkit::ObjectFactory *newnodefactory);
+	static int PropagateUpdate(NodeBase *changed);
 
 	Laxkit::ScreenColor background;
 
@@ -269,6 +285,8 @@ class NodeGroup : public NodeBase, public LaxFiles::DumpUtility
 	virtual int DeleteNodes(Laxkit::RefPtrStack<NodeBase> &selected);
 	virtual NodeGroup *Encapsulate(Laxkit::RefPtrStack<NodeBase> &selected);
 	virtual int Connect(NodeProperty *from, NodeProperty *to, NodeConnection *usethis);
+	virtual int Process(NodeProgressFunc progress=NULL, void *data=NULL);
+	virtual int ProcessPending();
 
 	virtual void       dump_out(FILE *f, int indent, int what, LaxFiles::DumpContext *context);
     virtual LaxFiles::Attribute *dump_out_atts(LaxFiles::Attribute *att, int what, LaxFiles::DumpContext *context);
@@ -336,6 +354,7 @@ enum NodeInterfaceActions {
 	NODES_Load_Nodes,
 	NODES_Show_Previews,
 	NODES_Hide_Previews,
+	NODES_Process_Nodes,
 
 	NODES_MAX
 };
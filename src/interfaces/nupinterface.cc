@@ -17,6 +17,9 @@
 
 #include "../language.h"
 #include "nupinterface.h"
+#include "../undo.h"
+#include "../viewwindow.h"
+#include "../workerpool.h"
 //#include "viewwindow.h"
 #include <lax/strmanip.h>
 #include <lax/laxutils.h>
@@ -249,6 +252,8 @@ NUpInterface::NUpInterface(int nid,Displayer *ndp)
 	temparrowdir=-1;
 	active=0;
 	needtoresetlayout=1;
+	unclump_threads=0;
+	unclump_pool=NULL;
 
 	nupinfo=new NUpInfo;
 	nupinfo->uioffset=flatpoint(50,50);
@@ -273,6 +278,8 @@ NUpInterface::NUpInterface(anInterface *nowner,int nid,Displayer *ndp)
 	temparrowdir=-1;
 	active=0;
 	needtoresetlayout=1;
+	unclump_threads=0;
+	unclump_pool=NULL;
 
 	nupinfo=new NUpInfo;
 	nupinfo->uioffset=flatpoint(50,50);
@@ -285,6 +292,7 @@ NUpInterface::~NUpInterface()
 	DBG cerr <<"NUpInterface destructor.."<<endl;
 
 	if (nupinfo) nupinfo->dec_count();
+	delete unclump_pool;
 
 	//if (doc) doc->dec_count();
 }
@@ -1452,15 +1460,22 @@ int NUpInterface::Apply(int updateorig)
 
 	} else if (nupinfo->flowtype==NUP_Unclump) {
 		 // spread out evenly
-		//ApplyUnclump();
+		ApplyUnclump();
 	
 	} else if (nupinfo->flowtype==NUP_Unoverlap) {
 		// *** move just enough to unobscure
 	}
 
 
-	if (updateorig)	for (int c=0; c<selection->n(); c++) {
-		objcontrols.e[c]->original_transform->m(selection->e(c)->obj->m());
+	if (updateorig) {
+		LaidoutViewport *lvp=dynamic_cast<LaidoutViewport*>(viewport);
+		UndoHistory *undo=(lvp ? lvp->GetUndoHistory() : UndoHistory::GetDefault());
+		undo->BeginGroup();
+		for (int c=0; c<selection->n(); c++) {
+			undo->Add(new TransformUndo(selection->e(c)->obj, objcontrols.e[c]->original_transform->m(), NULL));
+			objcontrols.e[c]->original_transform->m(selection->e(c)->obj->m());
+		}
+		undo->EndGroup();
 	}
 
 	//RemapBounds();
@@ -1591,77 +1606,310 @@ void NUpInterface::ApplySizedGrid()
  */
 double rect_radius(flatpoint cc,double w,double h,flatpoint v)
 {
-	// ****
-	return 0;
+	double len=norm(v);
+	if (len==0 || w<=0 || h<=0) return 0;
+
+	double x=fabs(v.x)/len, y=fabs(v.y)/len;
+	if (x*h > y*w) return w/2/x; //hits a vertical side first
+	return h/2/y;
+}
+
+
+//---------------------------- UnclumpSystem -------------------------------
+
+#define UNCLUMP_GRID_MIN    64   //fewer objects than this just compare every pair
+#define UNCLUMP_THREAD_MIN  1000 //fewer objects than this are not worth extra threads
+
+/*! \class UnclumpSystem
+ * \brief Centers and sizes of objects being unclumped, and a grid to find near neighbors quickly.
+ *
+ * Objects only push on each other when their centers are closer than 2*(mindist + their
+ * rect_radius() along the line between them). With grid cells at least that big, only objects
+ * in the same cell or the 8 around it can affect each other. Neighbors are summed in index
+ * order, so the grid gives the same forces as comparing every pair.
+ */
+class UnclumpSystem
+{
+  public:
+	int n;
+	flatpoint *centers, *dims, *forces;
+	double mindist, damp, ff;
+	double reach; //smallest allowed cell size
+	flatpoint pts[4], datac; //target area, and its center
+
+	double cellsize;
+	flatpoint gridorigin;
+	int nx, ny, maxcells;
+	int *cell_start;  //nx*ny+1 indices into cell_items, or NULL for no grid
+	int *cell_items;  //object indices, ascending within each cell
+	int *object_cell;
+
+	UnclumpSystem(int nn);
+	~UnclumpSystem();
+	void BuildGrid();
+	flatpoint Force(int c, Laxkit::NumStack<int> &neighbors);
+	flatpoint PairForce(int c, int c2);
+};
+
+UnclumpSystem::UnclumpSystem(int nn)
+{
+	n=nn;
+	centers=new flatpoint[n];
+	dims   =new flatpoint[n];
+	forces =new flatpoint[n];
+	mindist=damp=ff=reach=0;
+
+	cellsize=0;
+	nx=ny=maxcells=0;
+	cell_start=NULL;
+	cell_items=NULL;
+	object_cell=NULL;
+}
+
+UnclumpSystem::~UnclumpSystem()
+{
+	delete[] centers;
+	delete[] dims;
+	delete[] forces;
+	delete[] cell_start;
+	delete[] cell_items;
+	delete[] object_cell;
+}
+
+//! Sort current centers into grid cells.
+void UnclumpSystem::BuildGrid()
+{
+	double minx,maxx,miny,maxy;
+	minx=maxx=centers[0].x;
+	miny=maxy=centers[0].y;
+	for (int c=1; c<n; c++) {
+		if      (centers[c].x<minx) minx=centers[c].x;
+		else if (centers[c].x>maxx) maxx=centers[c].x;
+		if      (centers[c].y<miny) miny=centers[c].y;
+		else if (centers[c].y>maxy) maxy=centers[c].y;
+	}
+
+	 //cells can be bigger than reach, so don't let far flung objects make a huge sparse grid
+	cellsize=(reach>0 ? reach : 1);
+	while (((maxx-minx)/cellsize+1) * ((maxy-miny)/cellsize+1) > 4.*n) cellsize*=2;
+	nx=(int)((maxx-minx)/cellsize)+1;
+	ny=(int)((maxy-miny)/cellsize)+1;
+	gridorigin=flatpoint(minx,miny);
+
+	if (nx*ny+1>maxcells) {
+		delete[] cell_start;
+		maxcells=nx*ny+1;
+		cell_start=new int[maxcells];
+	}
+	if (!cell_items) {
+		cell_items =new int[n];
+		object_cell=new int[n];
+	}
+
+	 //counting sort, so each cell lists its objects in ascending order
+	memset(cell_start,0,(nx*ny+1)*sizeof(int));
+	int x,y;
+	for (int c=0; c<n; c++) {
+		x=(int)((centers[c].x-minx)/cellsize);
+		y=(int)((centers[c].y-miny)/cellsize);
+		if (x>=nx) x=nx-1;
+		if (y>=ny) y=ny-1;
+		object_cell[c]=y*nx+x;
+		cell_start[object_cell[c]+1]++;
+	}
+	for (int c=0; c<nx*ny; c++) cell_start[c+1]+=cell_start[c];
+
+	 //filling moves each cell start to the next cell's start, so shift back after
+	for (int c=0; c<n; c++) cell_items[cell_start[object_cell[c]]++]=c;
+	memmove(cell_start+1,cell_start,nx*ny*sizeof(int));
+	cell_start[0]=0;
+}
+
+//! Return the push on object c from object c2.
+flatpoint UnclumpSystem::PairForce(int c, int c2)
+{
+	flatpoint dist=centers[c2]-centers[c];
+	double dd=norm(dist);
+
+	if (dd==0) {
+		 //exactly on top of each other, so push apart in a direction that depends only on the pair
+		double a=((c<c2 ? (double)c*n+c2 : (double)c2*n+c)) * 2.39996323; //golden angle
+		dd=mindist*.01; //mindist is always positive, see ApplyUnclump()
+		dist=flatpoint(cos(a),sin(a))*dd;
+		if (c>c2) dist=flatpoint(-dist.x,-dist.y);
+	}
+
+	flatpoint force(0,0);
+	double distbtwn=rect_radius(centers[c],dims[c].x,dims[c].y,dist) + rect_radius(centers[c2],dims[c2].x,dims[c2].y,dist);
+	if (dd<2*(mindist + distbtwn)) force-=ff * dist/(dd*dd);
+	if (dd<(mindist + distbtwn)) force-=3*(ff * dist/(dd*dd));
+	return force;
+}
+
+//! Return the total force on object c. neighbors is scratch space.
+/*! This only reads centers, dims, and the grid, so it is safe to call from several threads at once.
+ */
+flatpoint UnclumpSystem::Force(int c, Laxkit::NumStack<int> &neighbors)
+{
+	flatpoint force(0,0);
+	flatpoint cc1=centers[c];
+
+	 //go toward target area
+	if (!point_is_in(cc1, pts,4)) {
+		flatpoint v=cc1-datac;
+		double d=norm(v);
+		if (d>0) force-=v/d*damp;
+	}
+
+	if (!cell_start) {
+		for (int c2=0; c2<n; c2++) {
+			if (c==c2) continue;
+			force+=PairForce(c,c2);
+		}
+		return force;
+	}
+
+	 //gather the 3x3 cells around c, in ascending index order like the all pairs loop
+	neighbors.flush();
+	int cx=object_cell[c]%nx, cy=object_cell[c]/nx;
+	int cell, c2, i;
+	for (int y=cy-1; y<=cy+1; y++) {
+		if (y<0 || y>=ny) continue;
+		for (int x=cx-1; x<=cx+1; x++) {
+			if (x<0 || x>=nx) continue;
+			cell=y*nx+x;
+			for (int cc=cell_start[cell]; cc<cell_start[cell+1]; cc++) {
+				c2=cell_items[cc];
+				if (c2==c) continue;
+				neighbors.push(c2);
+				for (i=neighbors.n-1; i>0 && neighbors.e[i-1]>c2; i--) neighbors.e[i]=neighbors.e[i-1];
+				neighbors.e[i]=c2;
+			}
+		}
+	}
+
+	for (i=0; i<neighbors.n; i++) force+=PairForce(c,neighbors.e[i]);
+	return force;
 }
 
+
+//---------------------------- UnclumpJob -------------------------------
+
+/*! \class UnclumpJob
+ * \brief Find forces for a range of objects in an UnclumpSystem.
+ *
+ * Only forces[start..end-1] are written, so jobs over different ranges can run at once.
+ */
+class UnclumpJob : public WorkerJob
+{
+  public:
+	UnclumpSystem *system;
+	int start, end;
+	Laxkit::NumStack<int> neighbors;
+
+	UnclumpJob() { system=NULL; start=end=0; }
+	virtual void Run();
+};
+
+void UnclumpJob::Run()
+{
+	for (int c=start; c<end; c++) system->forces[c]=system->Force(c,neighbors);
+}
+
+
+/*! Push objects apart from each other, and toward the target area.
+ *
+ * Each iteration finds forces for all objects from where they were at the end of the
+ * previous iteration, then moves them all at once, so results do not depend on how the work
+ * is split among threads. With more than UNCLUMP_GRID_MIN objects, neighbors are found with a
+ * grid rather than checking every pair. Stops early when nothing moves much any more.
+ */
 void NUpInterface::ApplyUnclump()
 {
+	int n=selection->n();
+	if (!n) return;
 	int maxiterations=100;
 
-	flatpoint p1,p2, dist, force;
-	double dd;
-
-	double damp=10;
-	double ff=25;
 	double wholew=data->maxx-data->minx;
 	double wholeh=data->maxy-data->miny;
-	double mindist=sqrt(wholew*wholeh/selection->n());
-	flatpoint pts[4];
-	pts[0]=transform_point(data->m(),data->minx,data->miny);
-	pts[1]=transform_point(data->m(),data->maxx,data->miny);
-	pts[2]=transform_point(data->m(),data->maxx,data->maxy);
-	pts[3]=transform_point(data->m(),data->minx,data->maxy);
-	flatpoint datac=(pts[0]+pts[2])/2;
-
-	flatpoint cc, cc1,cc2;
-	flatpoint d,v;
-	double w,h, w2,h2;
-	flatpoint dims[selection->n()];
-	flatpoint centers[selection->n()];
-	double distbtwn;
 
-	for (int c=0; c<selection->n(); c++) {
-		WidthHeight(selection->e(c), flatpoint(1,0),flatpoint(0,1), &dims[c].x,&dims[c].y, &cc);
+	UnclumpSystem system(n);
+	system.damp=10;
+	system.ff=25;
+	system.mindist=sqrt(wholew*wholeh/n);
+	system.pts[0]=transform_point(data->m(),data->minx,data->miny);
+	system.pts[1]=transform_point(data->m(),data->maxx,data->miny);
+	system.pts[2]=transform_point(data->m(),data->maxx,data->maxy);
+	system.pts[3]=transform_point(data->m(),data->minx,data->maxy);
+	system.datac=(system.pts[0]+system.pts[2])/2;
+
+	flatpoint cc;
+	double r, maxradius=0;
+	for (int c=0; c<n; c++) {
+		WidthHeight(selection->e(c), flatpoint(1,0),flatpoint(0,1), &system.dims[c].x,&system.dims[c].y, &cc);
 		objcontrols.e[c]->original_center=cc;
-		centers[c]=cc;
+		system.centers[c]=cc;
+		r=norm(system.dims[c])/2;
+		if (r>maxradius) maxradius=r;
+	}
+	 //a target area with no width or height gives no spacing, so space by object size instead.
+	 //Coincident objects are pushed apart by a fraction of mindist, so it must never be 0
+	if (!(system.mindist>0)) system.mindist=(maxradius>0 ? maxradius : 1);
+	system.reach=2*(system.mindist + 2*maxradius); //rect_radius() is never more than half the diagonal
+
+	bool usegrid=(n>=UNCLUMP_GRID_MIN);
+	WorkerPool *pool=NULL;
+	int numjobs=1;
+	if (n>=UNCLUMP_THREAD_MIN && unclump_threads!=1) {
+		if (!unclump_pool) unclump_pool=new WorkerPool(unclump_threads);
+		pool=unclump_pool;
+		if (pool->NumThreads()>1) numjobs=pool->NumThreads();
+	}
+	UnclumpJob *jobs=new UnclumpJob[numjobs];
+	for (int c=0; c<numjobs; c++) {
+		jobs[c].system=&system;
+		jobs[c].start=(int)((long)c*n/numjobs);
+		jobs[c].end  =(int)((long)(c+1)*n/numjobs);
 	}
-	
-	for (int iterations=0; iterations<maxiterations; iterations++) {
-		for (int c=0; c<selection->n(); c++) {
-			d=flatpoint(0,0);
-
-			cc1=centers[c];
-			w=dims[c].x;
-			h=dims[c].y;
-			d.x=d.y=0;
 
-			force=flatpoint(0,0);
-			p1=cc1-flatpoint(w/2,h/2);
-			p2=cc1+flatpoint(w/2,h/2);
+	double move, maxmove;
+	double tolerance=system.mindist*1e-3;
+	for (int iterations=0; iterations<maxiterations; iterations++) {
+		if (usegrid) system.BuildGrid();
 
-			 //go toward screen
-			if (!point_is_in(cc1, pts,4)) {
-				v=cc1-datac;
-				force+=v/norm(v)*damp;
+		for (int c=0; c<numjobs; c++) {
+			if (pool) pool->Add(&jobs[c]);
+			else jobs[c].Run();
+		}
+		if (pool) pool->WaitAll();
+
+		maxmove=0;
+		for (int c=0; c<n; c++) {
+			 //limit huge pushes from near coincident objects
+			move=norm(system.forces[c]);
+			if (move>system.mindist) {
+				system.forces[c]=system.forces[c]*(system.mindist/move);
+				move=system.mindist;
 			}
+			system.centers[c]+=system.forces[c];
+			if (move>maxmove) maxmove=move;
+		}
+		if (maxmove<tolerance) break;
+	}
 
-			for (int c2=0; c2<selection->n(); c2++) {
-				if (c==c2) continue;
+	delete[] jobs;
 
-				WidthHeight(selection->e(c2), flatpoint(1,0),flatpoint(0,1), &w2,&h2, &cc2);
-				dist=cc2-cc1;
-				dd=norm(dist);
-				distbtwn=rect_radius(cc1,w,h,dist)+rect_radius(cc2,w2,h2,dist);
-				if (dd<2*(mindist + distbtwn)) force-=ff * dist/(dd*dd);
-				if (dd<(mindist + distbtwn)) force-=3*(ff * dist/(dd*dd));
-			}
-
-			//forces.e[c]=force;
+	double mm[6];
+	transform_identity(mm);
+	flatpoint d;
+	for (int c=0; c<n; c++) {
+		d=system.centers[c]-objcontrols.e[c]->original_center;
+		mm[4]=d.x;
+		mm[5]=d.y;
+		TransformSelection(mm,c,c);
 
-			cc1+=force;
-			centers[c]=cc1;
-		}
+		objcontrols.e[c]->flags=objcontrols.e[c]->flags&~CONTROL_Skip;
+		objcontrols.e[c]->new_center=system.centers[c];
 	}
 }
 
@@ -26,6 +26,9 @@
 namespace Laidout {
 
 
+class WorkerPool;
+
+
 
 enum NUpControlType {
 	NUP_None=0,
@@ -128,6 +131,8 @@ class NUpInterface : public LaxInterfaces::ObjectInterface
 	int firsttime;
 	int overoverlay;
 	int active;
+	int unclump_threads; //0 for one per cpu, 1 for no extra threads
+	WorkerPool *unclump_pool; //made on the first big unclump, kept until the tool goes away
 
 	virtual int scanNup(int x,int y);
 	virtual int hscan(int x,int y);
@@ -0,0 +1,539 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include <lax/strmanip.h>
+#include <lax/attributes.h>
+#include <lax/fileutils.h>
+#include <lax/lists.cc>
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+
+#include "jobserver.h"
+#include "laidout.h"
+#include "language.h"
+#include "profiler.h"
+#include "calculator/calculator.h"
+
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+using namespace Laxkit;
+using namespace LaxFiles;
+
+
+namespace Laidout {
+
+
+static volatile sig_atomic_t jobserver_stop=0;
+
+ //worker exit codes. Anything else means the worker died without responding
+#define JOBEXIT_Ok      0  //job succeeded, and response was sent
+#define JOBEXIT_Failed  75 //job failed, and response was sent
+
+static void jobserver_signal(int sig)
+{
+	jobserver_stop=1;
+}
+
+
+//------------------------------------- JobServerClient ------------------------------------
+/*! \class JobServerClient
+ * \brief One connection to a JobServer, or stdin/stdout.
+ */
+
+JobServerClient::JobServerClient(int nfd, int noutfd)
+{
+	fd=nfd;
+	outfd=noutfd;
+	buffer=NULL;
+	len=max=0;
+	pending=0;
+	eof=0;
+}
+
+JobServerClient::~JobServerClient()
+{
+	if (outfd>=0 && outfd!=fd) close(outfd);
+	if (fd>0) close(fd); //don't close stdin
+	delete[] buffer;
+}
+
+
+//------------------------------------- JobServerJob ------------------------------------
+/*! \class JobServerJob
+ * \brief One line of work for a JobServer.
+ */
+
+JobServerJob::JobServerJob(const char *nid, JobServerJobType ntype, const char *narg, JobServerClient *nclient)
+{
+	id=newstr(nid);
+	type=ntype;
+	arg=newstr(narg);
+	client=nclient;
+	pid=0;
+	queued=started=Profiler::Now();
+}
+
+JobServerJob::~JobServerJob()
+{
+	delete[] id;
+	delete[] arg;
+}
+
+
+//------------------------------------- JobServer ------------------------------------
+/*! \class JobServer
+ * \brief Keep an initialized Laidout around to run export and script jobs as they come in.
+ *
+ * Started with --serve. Every job would otherwise pay for a whole LaidoutApp::init():
+ * plugins, filters, impositions, paper sizes, laidoutrc, and the calculator modules.
+ * The server does that once, then forks a worker for each job, so each job starts
+ * with everything already warm, jobs cannot interfere with each other, and a crashing
+ * job does not take the server down. At most maxjobs workers run at once. The rest wait in line.
+ *
+ * Jobs are read from stdin if where is "-" or NULL, or else from connections to
+ * a Unix domain socket at the path where. Each job is one line:
+ * <pre>
+ *   jobid export /some/file.laidout filter=Pdf tofile=/some/file.pdf
+ *   jobid command reimpose(...); export(...)
+ *   jobid script /some/script
+ *   jobid quit
+ * </pre>
+ * "export" takes the same settings as --export. "command" and "script" are like --command and
+ * --script, so reimposing or anything else the calculator can do works there. "quit" stops taking
+ * new jobs, and the server exits once the current ones are done. The server also stops on
+ * SIGINT or SIGTERM, or in stdin mode, at the end of input.
+ *
+ * Each job gets one line of json back, on stdout or its connection, in whatever order jobs finish:
+ * <pre>
+ *   { "id": "jobid", "status": "ok", "queue_ms": 0.012, "load_ms": 35.1, "run_ms": 220.4,
+ *     "total_ms": 255.6, "result": null, "messages": [ { "severity": "warning", "text": "..." } ] }
+ * </pre>
+ * status is one of "ok", "warning", or "error". A worker that exits or crashes before it responds
+ * gets an "error" response from the server.
+ *
+ * The socket is made accessible only to the user running the server, since jobs can run any command.
+ * In stdin mode, anything else written to stdout goes to stderr instead, so it cannot garble the responses.
+ */
+
+JobServer::JobServer(const char *where, int nmaxjobs)
+{
+	socketpath=(where && strcmp(where,"-") ? newstr(where) : NULL);
+	listenfd=-1;
+	maxjobs=(nmaxjobs>0 ? nmaxjobs : 1);
+	quitting=0;
+}
+
+JobServer::~JobServer()
+{
+	if (listenfd>=0) {
+		close(listenfd);
+		if (socketpath) unlink(socketpath);
+	}
+	delete[] socketpath;
+}
+
+//! Open the socket, or set up stdin as the only client. Returns 0 for success.
+int JobServer::Listen()
+{
+	if (!socketpath) {
+		int out=dup(1);
+		dup2(2,1);
+		clients.push(new JobServerClient(0,out));
+		return 0;
+	}
+
+	struct sockaddr_un addr;
+	if (strlen(socketpath)>=sizeof(addr.sun_path)) {
+		cerr <<_("Socket path too long: ")<<socketpath<<endl;
+		return 1;
+	}
+
+	listenfd=socket(AF_UNIX,SOCK_STREAM,0);
+	if (listenfd<0) {
+		cerr <<_("Could not create socket: ")<<strerror(errno)<<endl;
+		return 1;
+	}
+
+	memset(&addr,0,sizeof(addr));
+	addr.sun_family=AF_UNIX;
+	strcpy(addr.sun_path,socketpath);
+	unlink(socketpath);
+
+	 //commands can do anything we can, so nobody else gets to connect
+	mode_t oldmask=umask(077);
+	int status=bind(listenfd,(struct sockaddr*)&addr,sizeof(addr));
+	umask(oldmask);
+	if (status==0) status=chmod(socketpath,0600);
+
+	if (status<0 || listen(listenfd,16)<0) {
+		cerr <<_("Could not listen on ")<<socketpath<<": "<<strerror(errno)<<endl;
+		close(listenfd);
+		listenfd=-1;
+		return 1;
+	}
+
+	return 0;
+}
+
+//! Serve jobs until told to quit. Returns 0 for normal exit, or nonzero for could not start.
+int JobServer::Run()
+{
+	if (Listen()!=0) return 1;
+
+	signal(SIGPIPE,SIG_IGN);
+	signal(SIGINT,jobserver_signal);
+	signal(SIGTERM,jobserver_signal);
+
+	while (1) {
+		if (jobserver_stop) quitting=1;
+
+		ReapJobs();
+		StartJobs();
+		CloseFinishedClients();
+
+		if (!queue.n && !running.n && (quitting || (!socketpath && !clients.n))) break;
+
+		 //wait for more input, checking on running workers now and then
+		struct pollfd fds[clients.n+1];
+		JobServerClient *polled[clients.n+1];
+		int nfds=0;
+		if (listenfd>=0 && !quitting) {
+			fds[nfds].fd=listenfd;
+			fds[nfds].events=POLLIN;
+			polled[nfds]=NULL;
+			nfds++;
+		}
+		for (int c=0; c<clients.n; c++) {
+			if (clients.e[c]->eof || quitting) continue;
+			fds[nfds].fd=clients.e[c]->fd;
+			fds[nfds].events=POLLIN;
+			polled[nfds]=clients.e[c];
+			nfds++;
+		}
+
+		if (poll(fds,nfds, running.n ? 10 : 250)<=0) continue;
+
+		for (int c=0; c<nfds; c++) {
+			if (!fds[c].revents) continue;
+
+			if (!polled[c]) {
+				int fd=accept(listenfd,NULL,NULL);
+				if (fd>=0) clients.push(new JobServerClient(fd,fd));
+			} else ReadClient(polled[c]);
+		}
+	}
+
+	return 0;
+}
+
+//! Read what is available from client, and queue up any complete lines.
+/*! Returns the number of jobs found.
+ */
+int JobServer::ReadClient(JobServerClient *client)
+{
+	if (client->max-client->len<1024) {
+		client->max=2*client->max+4096;
+		char *nbuffer=new char[client->max];
+		if (client->buffer) memcpy(nbuffer,client->buffer,client->len);
+		delete[] client->buffer;
+		client->buffer=nbuffer;
+	}
+
+	int n=read(client->fd, client->buffer+client->len, client->max-client->len-1);
+	if (n<0 && (errno==EINTR || errno==EAGAIN)) return 0;
+	if (n<=0) {
+		client->eof=1;
+		 //last line might not have a newline
+		if (client->len) client->buffer[client->len++]='\n';
+	} else client->len+=n;
+
+	int numjobs=0;
+	char *start=client->buffer, *end;
+	while ((end=(char*)memchr(start,'\n',client->len-(start-client->buffer)))!=NULL) {
+		*end='\0';
+		if (ParseJob(client,start)) numjobs++;
+		start=end+1;
+	}
+	client->len-=start-client->buffer;
+	if (client->len) memmove(client->buffer,start,client->len);
+
+	return numjobs;
+}
+
+//! Turn line into a job on queue. Returns 1 for job queued, else 0.
+int JobServer::ParseJob(JobServerClient *client, char *line)
+{
+	 //chop trailing whitespace
+	int l=strlen(line);
+	while (l && isspace(line[l-1])) line[--l]='\0';
+	while (isspace(*line)) line++;
+	if (!*line || *line=='#') return 0;
+
+	 //jobid
+	char *id=line;
+	while (*line && !isspace(*line)) line++;
+	if (*line) *line++='\0';
+	while (isspace(*line)) line++;
+
+	 //job type
+	char *type=line;
+	while (*line && !isspace(*line)) line++;
+	if (*line) *line++='\0';
+	while (isspace(*line)) line++;
+
+	JobServerJobType jobtype=JOB_None;
+	if      (!strcmp(type,"export"))  jobtype=JOB_Export;
+	else if (!strcmp(type,"command")) jobtype=JOB_Command;
+	else if (!strcmp(type,"script"))  jobtype=JOB_Script;
+	else if (!strcmp(type,"quit"))    jobtype=JOB_Quit;
+
+	JobServerJob *job=new JobServerJob(id,jobtype,line,client);
+
+	if (jobtype==JOB_None || jobtype==JOB_Quit || !*line) {
+		ErrorLog log;
+		if (jobtype==JOB_Quit) quitting=1;
+		else if (jobtype==JOB_None) log.AddMessage(_("Unknown job type"),ERROR_Fail);
+		else log.AddMessage(_("Missing job argument"),ERROR_Fail);
+		Respond(job, jobtype==JOB_Quit ? "ok" : "error", 0,0, NULL, &log);
+		delete job;
+		return 0;
+	}
+
+	client->pending++;
+	queue.push(job);
+	return 1;
+}
+
+//! Fork workers for queued jobs, up to maxjobs at once. Returns the number started.
+int JobServer::StartJobs()
+{
+	int n=0;
+	while (queue.n && running.n<maxjobs) {
+		JobServerJob *job=queue.pop(0);
+		job->started=Profiler::Now();
+
+		fflush(stdout);
+		fflush(stderr);
+		pid_t pid=fork();
+
+		if (pid==0) {
+			 //worker
+			signal(SIGINT,SIG_DFL);
+			signal(SIGTERM,SIG_DFL);
+			if (listenfd>=0) close(listenfd);
+			int failed=RunJob(job);
+			fflush(stdout);
+			fflush(stderr);
+			_exit(failed ? JOBEXIT_Failed : JOBEXIT_Ok); //skip atexit and destructors, those belong to the server
+		}
+
+		if (pid<0) {
+			ErrorLog log;
+			log.AddMessage(_("Could not start worker process"),ERROR_Fail);
+			Respond(job,"error",0,0,NULL,&log);
+			job->client->pending--;
+			delete job;
+			break;
+		}
+
+		job->pid=pid;
+		running.push(job);
+		n++;
+	}
+	return n;
+}
+
+//! Collect finished workers. Workers that died without responding get an error response.
+/*! Workers exit with JOBEXIT_Ok or JOBEXIT_Failed after responding. Any other exit status,
+ * or a signal, means the job ended early, and the client would otherwise wait forever.
+ *
+ * Returns the number of jobs finished.
+ */
+int JobServer::ReapJobs()
+{
+	int n=0, status;
+	pid_t pid;
+	while ((pid=waitpid(-1,&status,WNOHANG))>0) {
+		for (int c=0; c<running.n; c++) {
+			JobServerJob *job=running.e[c];
+			if (job->pid!=pid) continue;
+
+			char scratch[100];
+			scratch[0]='\0';
+			if (WIFSIGNALED(status)) {
+				sprintf(scratch,_("Worker killed by signal %d"),WTERMSIG(status));
+			} else if (WIFEXITED(status) && WEXITSTATUS(status)!=JOBEXIT_Ok && WEXITSTATUS(status)!=JOBEXIT_Failed) {
+				sprintf(scratch,_("Worker exited with status %d before responding"),WEXITSTATUS(status));
+			}
+			if (scratch[0]) {
+				ErrorLog log;
+				log.AddMessage(scratch,ERROR_Fail);
+				Respond(job,"error",0,(Profiler::Now()-job->started)/1000,NULL,&log);
+			}
+
+			job->client->pending--;
+			running.remove(c);
+			n++;
+			break;
+		}
+	}
+	return n;
+}
+
+//! Remove clients that have hung up and have nothing left in progress.
+void JobServer::CloseFinishedClients()
+{
+	for (int c=clients.n-1; c>=0; c--) {
+		if (clients.e[c]->eof && !clients.e[c]->pending) clients.remove(c);
+	}
+}
+
+//! In a worker, do the actual job and respond. Returns 0 for job succeeded, else nonzero.
+int JobServer::RunJob(JobServerJob *job)
+{
+	ErrorLog log;
+	double load=0, run=0;
+	double t=Profiler::Now();
+	char *result=NULL;
+	int err=0;
+
+	if (job->type==JOB_Export) {
+		 //arg is: file settings...
+		char *end=NULL;
+		char *file=QuotedAttribute(job->arg,&end);
+		const char *settings=(end ? end : "");
+
+		Document *doc=NULL;
+		if (file && laidout->Load(file,log)>=0) doc=laidout->curdoc;
+		load=(Profiler::Now()-t)/1000;
+
+		if (!doc) {
+			if (!log.Total()) log.AddMessage(_("Could not load document"),ERROR_Fail);
+			err=1;
+		} else {
+			t=Profiler::Now();
+			err=laidout->ExportDocument(doc,settings,log);
+			run=(Profiler::Now()-t)/1000;
+		}
+		delete[] file;
+
+	} else {
+		 //command or script
+		char *text=(job->type==JOB_Script ? read_in_whole_file(job->arg,NULL) : newstr(job->arg));
+		if (!text) {
+			log.AddMessage(_("Could not read script"),ERROR_Fail);
+			err=1;
+		} else {
+			Value *v=NULL;
+			err=laidout->Calculator()->evaluate(text,-1,&v,&log);
+			if (v) {
+				int len=0;
+				v->getValueStr(&result,&len,1);
+				v->dec_count();
+			}
+			run=(Profiler::Now()-t)/1000;
+		}
+		delete[] text;
+	}
+
+	int fails=0, warnings=0;
+	for (int c=0; c<log.Total(); c++) {
+		if (log.Message(c)->severity==ERROR_Fail) fails++;
+		else if (log.Message(c)->severity==ERROR_Warning) warnings++;
+	}
+	const char *status="ok";
+	if (err>0 || fails) status="error";
+	else if (err<0 || warnings) status="warning";
+
+	Respond(job,status,load,run,result,&log);
+	delete[] result;
+	return err>0 || fails;
+}
+
+//! Append str to json as a quoted json string, or null if str is NULL.
+static void json_append_string(char *&json, const char *str)
+{
+	if (!str) { appendstr(json,"null"); return; }
+
+	int len=strlen(str);
+	char *s=new char[6*len+3], *p=s;
+	*p++='"';
+	for ( ; *str; str++) {
+		if (*str=='"' || *str=='\\') { *p++='\\'; *p++=*str; }
+		else if (*str=='\n') { *p++='\\'; *p++='n'; }
+		else if ((unsigned char)*str<0x20) p+=sprintf(p,"\\u%04x",(unsigned char)*str);
+		else *p++=*str;
+	}
+	*p++='"';
+	*p='\0';
+	appendstr(json,s);
+	delete[] s;
+}
+
+//! Write one line of json about job to its client. Times are in milliseconds.
+void JobServer::Respond(JobServerJob *job, const char *status, double load, double run, const char *result, ErrorLog *log)
+{
+	char scratch[200];
+	char *json=newstr("{ \"id\": ");
+	json_append_string(json,job->id);
+	appendstr(json,", \"status\": ");
+	json_append_string(json,status);
+
+	sprintf(scratch,", \"queue_ms\": %.3f, \"load_ms\": %.3f, \"run_ms\": %.3f, \"total_ms\": %.3f, \"result\": ",
+			(job->started-job->queued)/1000, load, run, (Profiler::Now()-job->queued)/1000);
+	appendstr(json,scratch);
+	json_append_string(json,result);
+
+	appendstr(json,", \"messages\": [");
+	for (int c=0; log && c<log->Total(); c++) {
+		ErrorLogNode *e=log->Message(c);
+		appendstr(json, c ? ", { \"severity\": " : " { \"severity\": ");
+		json_append_string(json, e->severity==ERROR_Fail ? "error" : (e->severity==ERROR_Warning ? "warning" : "info"));
+		appendstr(json,", \"text\": ");
+		json_append_string(json,e->description);
+		appendstr(json," }");
+	}
+	appendstr(json," ] }\n");
+
+	 //one write, so lines from concurrent workers do not get mixed up
+	int len=strlen(json), pos=0, n;
+	while (pos<len) {
+		n=write(job->client->outfd, json+pos, len-pos);
+		if (n<0 && errno==EINTR) continue;
+		if (n<=0) break;
+		pos+=n;
+	}
+	delete[] json;
+}
+
+
+} // namespace Laidout
+
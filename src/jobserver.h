@@ -0,0 +1,101 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include <lax/lists.h>
+#include <lax/errorlog.h>
+
+#include <sys/types.h>
+
+
+namespace Laidout {
+
+
+enum JobServerJobType {
+	JOB_None,
+	JOB_Export,
+	JOB_Command,
+	JOB_Script,
+	JOB_Quit
+};
+
+
+//------------------------------------- JobServerClient ------------------------------------
+class JobServerClient
+{
+  public:
+	int fd;     //where jobs are read from
+	int outfd;  //where responses are written to
+	char *buffer;
+	int len, max;
+	int pending; //number of jobs queued or running for this client
+	int eof;
+
+	JobServerClient(int nfd, int noutfd);
+	~JobServerClient();
+};
+
+
+//------------------------------------- JobServerJob ------------------------------------
+class JobServerJob
+{
+  public:
+	char *id;
+	JobServerJobType type;
+	char *arg;
+	JobServerClient *client;
+	pid_t pid;
+	double queued, started; //microseconds, from Profiler::Now()
+
+	JobServerJob(const char *nid, JobServerJobType ntype, const char *narg, JobServerClient *nclient);
+	~JobServerJob();
+};
+
+
+//------------------------------------- JobServer ------------------------------------
+class JobServer
+{
+  protected:
+	char *socketpath;
+	int listenfd;
+	int maxjobs;
+	int quitting;
+
+	Laxkit::PtrStack<JobServerClient> clients;
+	Laxkit::PtrStack<JobServerJob> queue;
+	Laxkit::PtrStack<JobServerJob> running;
+
+	int Listen();
+	int ReadClient(JobServerClient *client);
+	int ParseJob(JobServerClient *client, char *line);
+	int StartJobs();
+	int ReapJobs();
+	void CloseFinishedClients();
+	int RunJob(JobServerJob *job);
+	void Respond(JobServerJob *job, const char *status, double load, double run, const char *result, Laxkit::ErrorLog *log);
+
+  public:
+	JobServer(const char *where, int nmaxjobs);
+	virtual ~JobServer();
+	virtual int Run();
+};
+
+
+} // namespace Laidout
+
+#endif
+
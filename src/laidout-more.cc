@@ -285,9 +285,8 @@ int LaidoutApp::dump_out_file_format(const char *file, int nooverwrite)
  */
 void LaidoutApp::InitializeShortcuts()
 {
-	static int initialized=0;
-	if (initialized) return;
-	initialized=1;
+	if (shortcuts_initialized) return;
+	shortcuts_initialized=1;
 
 	ShortcutManager *manager=GetDefaultShortcutManager();
 	char buffer[200];
@@ -310,9 +309,31 @@ void LaidoutApp::InitializeShortcuts()
 
 
 	 //for each interface
-	for (int c=0; c<interfacepool.n; c++) {
-		interfacepool.e[c]->GetShortcuts(); //this will install in shortcutmanager if it is not already there
+	RefPtrStack<LaxInterfaces::anInterface> &tools=InterfacePool();
+	for (int c=0; c<tools.n; c++) {
+		tools.e[c]->GetShortcuts(); //this will install in shortcutmanager if it is not already there
 	}
+
+	if (pending_shortcuts) {
+		manager->Load(pending_shortcuts);
+		delete[] pending_shortcuts;
+		pending_shortcuts=NULL;
+	}
+}
+
+//! Load a shortcuts file over the defaults.
+/*! Loading needs every area's shortcuts defined first, which means building every window
+ * type and tool. Runs without windows never use shortcuts, so there the file is only
+ * remembered, and loaded if something calls InitializeShortcuts() later, such as --list-shortcuts.
+ */
+void LaidoutApp::LoadShortcuts(const char *file)
+{
+	if (donotusex && !shortcuts_initialized) {
+		makestr(pending_shortcuts,file);
+		return;
+	}
+	InitializeShortcuts();
+	GetDefaultShortcutManager()->Load(file);
 }
 
 //! Dump the list of known bound shortcuts to f with indentation.
@@ -50,6 +50,10 @@
 #include "printing/epsutils.h"
 #include "filetypes/filters.h"
 #include "utils.h"
+#include "imagecache.h"
+#include "undo.h"
+#include "profiler.h"
+#include "jobserver.h"
 #include "api/functions.h"
 #include "newdoc.h"
 
@@ -60,6 +64,7 @@
 
 
 #include <sys/stat.h>
+#include <unistd.h>
 #include <cstdio>
 
 #ifdef LAX_USES_CAIRO
@@ -80,7 +85,7 @@ using namespace std;
 namespace Laidout {
 
 
-ObjectDef stylemanager(NULL,"Laidout",_("Laidout"),_("Global Laidout namespace"),"namespace",NULL,NULL);
+LaidoutNamespace stylemanager;
 
 
 
@@ -237,6 +242,9 @@ LaidoutApp::LaidoutApp()
 	preview_file_bases(2)
 {	
 	autosave_timerid=0;
+	plugins_initialized=0;
+	shortcuts_initialized=0;
+	pending_shortcuts=NULL;
 	
 	icons=IconManager::GetDefault();
 
@@ -298,11 +306,16 @@ LaidoutApp::~LaidoutApp()
 	dumpOutResources();
 
 	if (defaultpaper)       defaultpaper->dec_count();
+	UndoHistory::SetDefault(NULL); //holds references to documents and objects
+
 	if (curdoc)             curdoc->dec_count();
 	if (project)            delete project;
 	if (config_dir)         delete[] config_dir;
 	if (ghostscript_binary) delete[] ghostscript_binary;
+	if (pending_shortcuts)  delete[] pending_shortcuts;
 	if (calculator)		    calculator->dec_count();
+
+	ImageCache::SetDefault(NULL);
 }
 
 
@@ -505,7 +518,13 @@ Value *LaidoutApp::duplicate()
  */
 int LaidoutApp::init(int argc,char **argv)
 {
-	anXApp::init(argc,argv); //setupdefaultcolors() is called here
+	 //each phase is timed when profiling, see Profiler
+	ProfileScope startupscope("startup","init");
+
+	{
+		ProfileScope scope("startup","anXApp::init");
+		anXApp::init(argc,argv); //setupdefaultcolors() is called here
+	}
 	
 	 //------------ make adjustments to some standard dirs 
 	 //             when running before installing
@@ -535,43 +554,56 @@ int LaidoutApp::init(int argc,char **argv)
 //		delete[] iconpath;
 //	} else {
 		DBG cerr <<"Added installed icon dir "<<ICON_DIRECTORY<<" to icon path"<<endl;
-		if (icon_dir) icons->AddPath(icon_dir);
-		icons->AddPath(ICON_DIRECTORY);
+		if (!donotusex) {
+			if (icon_dir) icons->AddPath(icon_dir);
+			icons->AddPath(ICON_DIRECTORY);
+		}
 		if (!icon_dir) makestr(icon_dir,ICON_DIRECTORY);
 //	}
 	delete[] curexecpath; curexecpath=NULL;
 
 
 	 //------load plugins
-	InitializePlugins();
+	 //Without the gui, these wait until something asks for NodeGroup::NodeFactory().
+	 //With it, load now so any errors get shown at startup.
+	if (!donotusex) InitializePlugins();
 
 
 	 //------setup initial pools
+	 //interfacepool is built on first call to InterfacePool(), and calculator on first Calculator().
 	 
 	DBG cerr <<"---file filters init"<<endl;
-	installFilters();
+	{
+		ProfileScope scope("startup","filters");
+		installFilters();
+	}
 	
 	DBG cerr <<"---imposition pool init"<<endl;
-	GetBuiltinImpositionPool(&impositionpool);
+	{
+		ProfileScope scope("startup","impositions");
+		GetBuiltinImpositionPool(&impositionpool);
+	}
 	DBG cerr <<"---imposition pool init done"<<endl;
 	
 	DBG cerr <<"---papersizes pool init"<<endl;
-	GetBuiltinPaperSizes(&papersizes);
+	{
+		ProfileScope scope("startup","papersizes");
+		GetBuiltinPaperSizes(&papersizes);
+	}
 	
-	DBG cerr <<"---interfaces pool init"<<endl;
+	DBG cerr <<"---pathops init"<<endl;
 	PushBuiltinPathops(); // this must be called before getinterfaces because of pathops...
-	GetBuiltinInterfaces(&interfacepool);
 
 
 	 //read in laidoutrc
-	if (!readinLaidoutDefaults()) {
-		createlaidoutrc();
+	{
+		ProfileScope scope("startup","laidoutrc");
+		if (!readinLaidoutDefaults()) {
+			createlaidoutrc();
+		}
 	}
 
-	 //establish user accesible api
-	DBG cerr<<"---install functions"<<endl;
-	InitFunctions();
-	InitObjectDefinitions();
+	 //user accessible api is added to stylemanager on first lookup, see LaidoutNamespace
 	
 	 //read in resources
 	char configfile[strlen(config_dir)+20];
@@ -602,20 +634,21 @@ int LaidoutApp::init(int argc,char **argv)
 	}
 	
 	 //define default icon
-	char *str=newstr(icon_dir);
-	//appendstr(str,"/Laidout-shaded-icon-48x48.png");
-	appendstr(str,"/laidout-48x48.png");
-	DefaultIcon(str);
-	delete[] str;
-
+	if (!donotusex) {
+		char *str=newstr(icon_dir);
+		//appendstr(str,"/Laidout-shaded-icon-48x48.png");
+		appendstr(str,"/laidout-48x48.png");
+		DefaultIcon(str);
+		delete[] str;
+	}
 
-	 //initialize the main calculator
-	DBG cerr<<"---init main calculator"<<endl;
-	if (!calculator) calculator=new LaidoutCalculator();
 
 	 // Note parseargs has to come after initing all the pools and whatever else
 	DBG cerr <<"---init: parse args"<<endl;
-	parseargs(argc,argv);
+	{
+		ProfileScope scope("startup","parseargs");
+		parseargs(argc,argv);
+	}
 	
 	 // Define default project if necessary, and Pop something up if there hasn't been anything yet
 	if (!project) project=new Project();
@@ -643,7 +676,11 @@ int LaidoutApp::init(int argc,char **argv)
 		//***
 
 	} else if (runmode==RUNMODE_Shell) {
-		calculator->RunShell();
+		Calculator()->RunShell();
+		return 0;
+
+	} else if (runmode==RUNMODE_Server) {
+		RunJobServer();
 		return 0;
 	}
 
@@ -682,6 +719,31 @@ int LaidoutApp::IsProject()
 	return !isblank(project->filename);
 }
 
+//! Return the main calculator, creating it on first use.
+LaidoutCalculator *LaidoutApp::Calculator()
+{
+	if (!calculator) {
+		DBG cerr<<"---init main calculator"<<endl;
+		ProfileScope scope("startup","calculator");
+		stylemanager.Initialize(); //the calculator imports all of it
+		calculator=new LaidoutCalculator();
+	}
+	return calculator;
+}
+
+//! Return the pool of tools, building it on first use.
+/*! Only windows and rendering need these, so command line runs that never draw never pay for them.
+ */
+Laxkit::RefPtrStack<LaxInterfaces::anInterface> &LaidoutApp::InterfacePool()
+{
+	if (!interfacepool.n) {
+		DBG cerr <<"---interfaces pool init"<<endl;
+		ProfileScope scope("startup","interfaces");
+		GetBuiltinInterfaces(&interfacepool);
+	}
+	return interfacepool;
+}
+
 //! Called from init(), creates a user's laidoutrc if readinLaidoutDefaults failed.
 /*! Return 0 for created ok, else non-zero error.
  *
@@ -844,6 +906,13 @@ int LaidoutApp::createlaidoutrc()
 					  "\n# The maximum width or height for preview images\n"
 					  "#maxPreviewLength 200\n"
 					  "\n"
+					  "\n# Megabytes of memory to use for decoded images and their screen proxies.\n"
+					  "# Least recently used images are released when this is exceeded.\n"
+					  "#imageCacheMegabytes 256\n"
+					  "\n"
+					  "\n# Megabytes of memory to use for undo in each document. The oldest undos are discarded when this is exceeded.\n"
+					  "#undoMegabytes 32\n"
+					  "\n"
 					  "\n");
 			fclose(f);
 			setlocale(LC_ALL,"");
@@ -908,9 +977,7 @@ int LaidoutApp::readinLaidoutDefaults()
 			
 		} else if (!strcmp(name,"shortcuts")) {
 			foundkeys=1;
-			InitializeShortcuts();
-			ShortcutManager *m=GetDefaultShortcutManager();
-			m->Load(value);
+			LoadShortcuts(value);
 
 		} else if (!strcmp(name,"default_template")) {
 			if (file_exists(value,1,NULL)==S_IFREG) makestr(prefs.default_template,value);
@@ -1001,6 +1068,16 @@ int LaidoutApp::readinLaidoutDefaults()
 		} else if (!strcmp(name,"maxPreviewLength")) {
 			IntAttribute(value,&max_preview_length);
 
+		} else if (!strcmp(name,"imageCacheMegabytes")) {
+			 //memory budget for decoded images and their proxies
+			int mb=0;
+			if (IntAttribute(value,&mb) && mb>0) ImageCache::GetDefault()->Budget((unsigned long)mb*1024*1024);
+
+		} else if (!strcmp(name,"undoMegabytes")) {
+			 //memory budget for each undo history, oldest undos are discarded first
+			int mb=0;
+			if (IntAttribute(value,&mb) && mb>0) UndoHistory::default_budget=(long)mb*1024*1024;
+
 		}
 	}
 	
@@ -1014,9 +1091,7 @@ int LaidoutApp::readinLaidoutDefaults()
 		if (readable_file(keys)) {
 			DBG cerr <<" ----- reading in default shortcuts file ------"<<endl;
 
-			InitializeShortcuts();
-			ShortcutManager *m=GetDefaultShortcutManager();
-			m->Load(keys);
+			LoadShortcuts(keys);
 		}
 		delete[] keys;
 	}
@@ -1036,10 +1111,14 @@ int LaidoutApp::RemovePlugin(const char *name)
 	return 1;
 }
 
-/*! Returns the number of plugins added.
+/*! Returns the number of plugins added. Only the first call does anything.
  */
 int LaidoutApp::InitializePlugins()
 {
+	if (plugins_initialized) return 0;
+	plugins_initialized=1;
+
+	ProfileScope scope("startup","plugins");
 	int n=0;
 
 	DBG cerr <<"Initializing plugins..."<<endl;
@@ -1137,6 +1216,10 @@ void InitOptions()
 	options.Add("theme",              'T', 1, "Set theme. Currently, one of Light, Dark, or Gray",0,NULL);
 	options.Add("helphtml",           'H', 0, "Output an html fragment of key shortcuts.",   0, NULL);
 	options.Add("helpman",             0 , 0, "Output a man page fragment of options.",      0, NULL);
+	options.Add("serve",              'J', 1, "Serve export and script jobs from stdin (-) or a Unix socket, without the gui",0,"(-|/some/socket)");
+	options.Add("jobs",               'j', 1, "Number of jobs --serve may run at once. Default is the number of processors",0,"4");
+	options.Add("profile",             0 , 1, "Write startup, load, save, import, export, and script function timings to this file on exit, or - for stdout",0,"/some/file");
+	options.Add("profile-format",      0 , 1, "Format for --profile. Default is json. chrome is a trace file, report a sorted table, flamegraph folded stacks",0,"(json|chrome|report|flamegraph)");
 	options.Add("version",            'v', 0, "Print out version info, then exit.",          0, NULL);
 	options.Add("help",               'h', 0, "Show this summary and exit.",                 0, NULL);
 
@@ -1198,15 +1281,20 @@ void LaidoutApp::parseargs(int argc,char **argv)
 					fread(instr,1,size,f);
 					instr[size]='\0';
 					runmode=RUNMODE_Commands;
-					char *str=calculator->In(instr);
+					char *str=Calculator()->In(instr);
 					if (str) cout <<str<<endl;
 					if (runmode!=RUNMODE_Shell) runmode=RUNMODE_Quit;
 				} break;
 
+			case 'J': { // --serve, started from init() once everything is loaded
+					donotusex=1;
+					runmode=RUNMODE_Server;
+				} break;
+
 			case 'c': { // --command
 					donotusex=1;
 					runmode=RUNMODE_Commands;
-					char *str=calculator->In(o->arg());
+					char *str=Calculator()->In(o->arg());
 					if (str) cout <<str<<endl;
 					if (runmode!=RUNMODE_Shell) runmode=RUNMODE_Quit;
 				} break;
@@ -1319,16 +1407,10 @@ void LaidoutApp::parseargs(int argc,char **argv)
 
 	 //export doc if found, then exit
 	if (exprt) {
-		//*** this should probably be moved to its own function so command line pane can call it
 		//*** is this obsoleted by --command?
 
 		DBG cout << "export: "<<exprt<<endl;
 
-		 //parse the config string into a config
-		Attribute att;
-		NameValueToAttribute(&att,exprt,'=',0);
-		DBG att.dump_out(stdout,2);
-
 		 //figure out where to export from
 		const char *filename=NULL;
 		o=options.remaining();
@@ -1354,23 +1436,8 @@ void LaidoutApp::parseargs(int argc,char **argv)
 			dumperrorlog(_("Warnings encountered while loading document:"),error);
 		}
 
-		const char *format=att.findValue("filter");
-		DBG cout << "Exporting with \""<<(format ? format : "unknown filter") <<"\""<<endl;
-		ExportFilter *filter = FindExportFilter(format,false);
-		if (!filter) {
-			cout <<_("Filter not found!")<<endl;
-			exit(1);
-		}
-
-		DocumentExportConfig *config=filter->CreateConfig(NULL);
-		//config->dump_in_atts(&att,0,NULL);
-		 
-		config->doc=doc;
-		config->doc->inc_count();
-		config->filter=filter;
-		config->dump_in_atts(&att,0,NULL);//second time with doc!
-
-		int err=export_document(config,error);
+		error.Clear();
+		int err=ExportDocument(doc,exprt,error);
 		if (err>0) {
 			dumperrorlog(_("Export failed."),error);
 			exit(1);
@@ -1410,6 +1477,52 @@ void LaidoutApp::parseargs(int argc,char **argv)
 	DBG cerr <<"---------end options"<<endl;
 }
 
+//! Run a JobServer with the --serve and --jobs options. Documents named on the command line stay loaded for jobs to use.
+/*! Returns 0 after the server quits normally, else nonzero.
+ */
+int LaidoutApp::RunJobServer()
+{
+	LaxOption *o=options.find("serve",0);
+	LaxOption *j=options.find("jobs",0);
+	int maxjobs=(j && j->parsed_present ? strtol(j->arg(),NULL,10) : 0);
+	if (maxjobs<=0) maxjobs=sysconf(_SC_NPROCESSORS_ONLN);
+
+	Calculator(); //so workers don't each have to make one
+
+	JobServer server(o && o->parsed_present ? o->arg() : "-", maxjobs);
+	return server.Run();
+}
+
+//! Export doc with settings like "filter=Pdf tofile=out.pdf start=3", as for --export.
+/*! Returns the export_document() status: 0 for success, less than 0 for success with
+ * warnings, or greater than 0 for failure.
+ */
+int LaidoutApp::ExportDocument(Document *doc, const char *settings, ErrorLog &log)
+{
+	 //parse the config string into a config
+	Attribute att;
+	NameValueToAttribute(&att,settings,'=',0);
+	DBG att.dump_out(stdout,2);
+
+	const char *format=att.findValue("filter");
+	DBG cout << "Exporting with \""<<(format ? format : "unknown filter") <<"\""<<endl;
+	ExportFilter *filter = FindExportFilter(format,false);
+	if (!filter) {
+		log.AddMessage(_("Filter not found!"),ERROR_Fail);
+		return 1;
+	}
+
+	DocumentExportConfig *config=filter->CreateConfig(NULL);
+	config->doc=doc;
+	if (doc) doc->inc_count();
+	config->filter=filter;
+	config->dump_in_atts(&att,0,NULL);//second time with doc!
+
+	int err=export_document(config,log);
+	config->dec_count();
+	return err;
+}
+
 //! Return whether win is in topwindows.
 /*! This is used by HeadWindow to verify that a previously marked window
  * is still around. Note that this sort of query is not threadsafe,
@@ -1990,12 +2103,28 @@ int main(int argc,char **argv)
 		theme = o->arg();
 	}
 
+	 //start profiling before anything is loaded
+	o=options.find("profile",0);
+	if (o && o->parsed_present) {
+		LaxOption *o2=options.find("profile-format",0);
+		Profiler::SetDefault(new Profiler(o->arg(), Profiler::FormatFromString(o2 && o2->parsed_present ? o2->arg() : NULL)));
+	} else Profiler::StartFromEnvironment();
+
 
 	 //redefine Laxkit's default preview maker
 	generate_preview_image=laidout_preview_maker;
 
 	laidout=new LaidoutApp();
-	if (theme) laidout->Theme(theme);
+
+	 //runs that never open a window can skip icons, themes, tools, and such
+	const char *headless[]={ "export-formats", "list-export-options", "export", "file-format",
+							 "command", "script", "shell", "serve", NULL };
+	for (int c=0; headless[c]; c++) {
+		o=options.find(headless[c],0);
+		if (o && o->parsed_present) { laidout->donotusex=1; break; }
+	}
+
+	if (theme && !laidout->donotusex) laidout->Theme(theme);
 	if (backend) laidout->Backend(backend);
 	o=options.find("experimental",0);
 	if (o && o->parsed_present) laidout->experimental=1;
@@ -2034,6 +2163,8 @@ int main(int argc,char **argv)
 	Laxkit::SetUnitManager(NULL);
 	DBG cerr <<"---------  close laidout app..."<<endl;
 	laidout->dec_count();
+	DBG cerr <<"---------  write profile..."<<endl;
+	Profiler::SetDefault(NULL);
 	
 	DBG cerr <<"---------  close stylemanager"<<endl;
 	DBG cerr <<"  stylemanager.getNumFields()="<<(stylemanager.getNumFields())<<endl;
@@ -80,7 +80,8 @@ enum RunModeType {
 		RUNMODE_Commands,
 		RUNMODE_Shell,
 		RUNMODE_Quit,
-		RUNMODE_Impose_Only
+		RUNMODE_Impose_Only,
+		RUNMODE_Server
 	};
 
 class LaidoutApp : public Laxkit::anXApp, public Value, public Laxkit::EventReceiver
@@ -91,6 +92,10 @@ class LaidoutApp : public Laxkit::anXApp, public Value, public Laxkit::EventRece
 	void dumpOutResources();
 
 	int autosave_timerid;
+	int plugins_initialized;
+	int shortcuts_initialized;
+	char *pending_shortcuts; //keys file to load once shortcuts are actually initialized
+	void LoadShortcuts(const char *file);
 	virtual int  Idle(int tid=0);
 	virtual int Autosave();
 
@@ -102,7 +107,8 @@ class LaidoutApp : public Laxkit::anXApp, public Value, public Laxkit::EventRece
 	Document *curdoc;
 	Laxkit::anXWindow *lastview;
 
-	LaidoutCalculator *calculator;
+	LaidoutCalculator *calculator; //use Calculator(), this is made on demand
+	LaidoutCalculator *Calculator();
 
 	 //global prefs
 	int experimental;
@@ -124,7 +130,8 @@ class LaidoutApp : public Laxkit::anXApp, public Value, public Laxkit::EventRece
 
 //	Laxkit::PtrStack<Style> stylestack:
 //	Laxkit::PtrStack<FontThing> fontstack;
-	Laxkit::RefPtrStack<LaxInterfaces::anInterface> interfacepool;
+	Laxkit::RefPtrStack<LaxInterfaces::anInterface> interfacepool; //use InterfacePool(), this is made on demand
+	Laxkit::RefPtrStack<LaxInterfaces::anInterface> &InterfacePool();
 	Laxkit::PtrStack<ImpositionResource> impositionpool;
 	Laxkit::PtrStack<ExportFilter> exportfilters;
 	Laxkit::PtrStack<ImportFilter>  importfilters;
@@ -144,6 +151,7 @@ class LaidoutApp : public Laxkit::anXApp, public Value, public Laxkit::EventRece
 	virtual int init(int argc,char **argv);
 	virtual void setupdefaultcolors();
 	void parseargs(int argc,char **argv);
+	int RunJobServer();
 	int readinLaidoutDefaults();
 	int createlaidoutrc();
 	int isTopWindow(Laxkit::anXWindow *win);
@@ -167,6 +175,7 @@ class LaidoutApp : public Laxkit::anXApp, public Value, public Laxkit::EventRece
 	int NewDocument(Imposition *imposition, const char *filename);
 	int NewDocument(const char *spec);
 	int NewProject(Project *proj, Laxkit::ErrorLog &log);
+	int ExportDocument(Document *doc, const char *settings, Laxkit::ErrorLog &log);
 	void PushExportFilter(ExportFilter *filter);
 	ExportFilter *FindExportFilter(const char *name, bool exact_only);
 	void PushImportFilter(ImportFilter *filter);
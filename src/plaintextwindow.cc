@@ -307,7 +307,7 @@ int PlainTextWindow::Event(const Laxkit::EventData *data,const char *mes)
 			input=edit->GetCText();
 		}
 		if (!input) return 0;
-		char *output=laidout->calculator->In(input);
+		char *output=laidout->Calculator()->In(input);
 		DBG if (!output) cerr  << "script in: "<<input<<endl<< "script out: (none)" <<endl;
 		if (output) {
 			DBG cerr << "script in: "<<input<<endl<< "script out" << output<<endl;
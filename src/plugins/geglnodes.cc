@@ -20,6 +20,8 @@
 #include "../interfaces/nodeinterface.h"
 #include "geglnodes.h"
 
+#include <cstring>
+#include <cmath>
 
 #include <iostream>
 #define DBG
@@ -343,6 +345,7 @@ GeglLaidoutNode::GeglLaidoutNode(const char *oper)
 {
 	gegl      = NULL;
 	operation = NULL;
+	process_pending = false;
 	op        = NULL; //don't delete this! it lives within op_menu
 	SetOperation(oper);
 
@@ -457,10 +460,9 @@ int GeglLaidoutNode::Update()
 //	if (errors == 0) {
 		 //should do this ONLY if the node is a sync
 		if (IsSaveNode()) {
+			process_pending = true;
 			if (AutoProcess()) {
-				DBG cerr <<"..........Attempting to process "<<operation<<endl;
-				gegl_node_process(gegl);
-				XMLOut(gegl, operation);
+				Process(NULL, NULL);
 			} else {
 				DBG cerr <<"....deferring gegl node process"<<endl;
 			}
@@ -470,13 +472,46 @@ int GeglLaidoutNode::Update()
 //		DBG cerr << " *** warning! "<<errors<<" encountered in GeglLaidoutNode::Update()!"<<endl;
 //	}
 
+	preview_done.clear(); //old preview is stale
 	UpdatePreview();
 
 	return NodeBase::Update();
 }
 
+/*! For save nodes, process the whole graph at full size, which writes out the file.
+ * This is done in chunks, so progress can report on it, and can cancel.
+ *
+ * Return 1 for processed, 0 for not a save node, or -1 for canceled.
+ */
+int GeglLaidoutNode::Process(NodeProgressFunc progress, void *data)
+{
+	if (!IsSaveNode()) return 0;
+
+	DBG cerr <<"..........Attempting to process "<<operation<<endl;
+
+	GeglProcessor *processor = gegl_node_new_processor(gegl, NULL);
+	double done = 0;
+	int canceled = 0;
+	while (gegl_processor_work(processor, &done)) {
+		if (progress && progress(this, done, data)) { canceled = 1; break; }
+	}
+	g_object_unref(processor);
+
+	if (canceled) return -1;
+
+	if (progress) progress(this, 1.0, data);
+	XMLOut(gegl, operation);
+	process_pending = false;
+	return 1;
+}
+
 /*! Checks for true on last property if it's named "AutoProcess" and contains a BooleanValue.
  * If no such property, assume yes.
+ *
+ * This is the "Auto Save" setting of save nodes. When on, every Update() processes the full size
+ * image and writes it out. When off, Update() only marks process_pending, so property tweaks
+ * cost only what the previews need, and the file is written on an explicit Process(), such as
+ * NodeInterface's "Process" action, or when the node graph is saved.
  */
 int GeglLaidoutNode::AutoProcess()
 {
@@ -500,11 +535,25 @@ int GeglLaidoutNode::GetRect(Laxkit::DoubleBBox &box)
 	return box.nonzerobounds();
 }
 
-/*! Return 0 for nothing done, or 1 for preview updated.
+/*! Record the on screen part of the preview. Return 1 if any of it is not rendered yet.
+ */
+int GeglLaidoutNode::PreviewArea(double minx,double maxx,double miny,double maxy)
+{
+	NodeBase::PreviewArea(minx,maxx, miny,maxy);
+	if (!preview_done.validbounds()) return 1;
+	return minx < preview_done.minx || maxx > preview_done.maxx
+		|| miny < preview_done.miny || maxy > preview_done.maxy;
+}
+
+/*! Render the part of the preview that is on screen, according to preview_area, or all of it
+ * if preview_area is not set yet.
+ *
+ * Return 0 for nothing done, or 1 for preview updated.
  */
 int GeglLaidoutNode::UpdatePreview()
 {
 	if (!IsSaveNode()) return 0; //only use processable nodes for now
+	if (!show_preview) return 0; //nothing visible, so nothing to render
 
 
 	//connect an output proxy to whatever's at the input pad
@@ -552,34 +601,58 @@ int GeglLaidoutNode::UpdatePreview()
 
 	if (!total_preview) { 
 		total_preview = create_new_image(ibufw, ibufh);
+		preview_done.clear();
 	}
 
 	unsigned char *buffer = total_preview->getImageBuffer(); //bgra
+	if (needtowrap) memset(buffer, 0, ibufw*ibufh*4); //parts off screen stay blank until shown
+
+	 //clip to the part of the preview that is on screen
+	int x1 = 0, x2 = ibufw, y1 = 0, y2 = ibufh;
+	if (preview_area.validbounds()) {
+		x1 = floor(preview_area.minx * ibufw);  x2 = ceil(preview_area.maxx * ibufw);
+		y1 = floor(preview_area.miny * ibufh);  y2 = ceil(preview_area.maxy * ibufh);
+		if (x1 < 0) x1 = 0;
+		if (y1 < 0) y1 = 0;
+		if (x2 > ibufw) x2 = ibufw;
+		if (y2 > ibufh) y2 = ibufh;
+	}
 
-
-	GeglRectangle  orect;
-	orect.x = orect.y = 0;
-	orect.width  = ibufw;
-	orect.height = ibufh;
-
-	gegl_node_blit (proxy,
-					ibufw/(double)rect.width,
-					&orect,
-					babl_format("R'G'B'A u8"),
-					buffer,
-					GEGL_AUTO_ROWSTRIDE,
-					GEGL_BLIT_DEFAULT);
-
-	//need to flip r and b
-	int i=0;
-	unsigned char t;
-	for (int y=0; y<ibufh; y++) {
-		for (int x=0; x<ibufw; x++) {
-			t = buffer[i+2];
-			buffer[i+2] = buffer[i];
-			buffer[i] = t;
-			i += 4;
+	if (x2 > x1 && y2 > y1) {
+		 //render only that rect of the bounds, already scaled down. With mipmap rendering on (see Initialize()),
+		 //gegl reads reduced levels instead of whole full size buffers for this.
+		double pscale = ibufw/(double)rect.width;
+		GeglRectangle  orect;
+		orect.x = rect.x * pscale + x1;
+		orect.y = rect.y * pscale + y1;
+		orect.width  = x2 - x1;
+		orect.height = y2 - y1;
+
+		gegl_node_blit (proxy,
+						pscale,
+						&orect,
+						babl_format("R'G'B'A u8"),
+						buffer + (y1*ibufw + x1)*4,
+						ibufw*4,
+						GEGL_BLIT_DEFAULT);
+
+		//need to flip r and b
+		unsigned char t;
+		for (int y=y1; y<y2; y++) {
+			unsigned char *p = buffer + (y*ibufw + x1)*4;
+			for (int x=x1; x<x2; x++) {
+				t = p[2];
+				p[2] = p[0];
+				p[0] = t;
+				p += 4;
+			}
 		}
+
+		 //what is rendered, as fractions, for PreviewArea() to compare against
+		preview_done.minx = x1/(double)ibufw;
+		preview_done.maxx = x2/(double)ibufw;
+		preview_done.miny = y1/(double)ibufh;
+		preview_done.maxy = y2/(double)ibufh;
 	}
 
 	total_preview->doneWithBuffer(buffer);
@@ -956,6 +1029,9 @@ int GeglNodesPlugin::Initialize()
 	 //initialize gegl
 	gegl_init (NULL,NULL); //(&argc, &argv);
 
+	 //scaled down previews render from mipmap levels, instead of full resolution
+	g_object_set(gegl_config(), "mipmap-rendering", TRUE, NULL);
+
 
 	ObjectFactory *node_factory = Laidout::NodeGroup::NodeFactory(true);
 
@@ -40,6 +40,8 @@ class GeglLaidoutNode : public Laidout::NodeBase
 
 	char *operation;
 	GeglNode *gegl;
+	bool process_pending; //a save node was updated, but not yet processed
+	Laxkit::DoubleBBox preview_done; //part of total_preview rendered since the last Update(), as fractions
 
 	GeglLaidoutNode(const char *oper);
 	virtual ~GeglLaidoutNode();
@@ -48,6 +50,9 @@ class GeglLaidoutNode : public Laidout::NodeBase
 	virtual int UpdateProperties();
 	virtual int Update();
 	virtual int UpdatePreview();
+	virtual int Process(NodeProgressFunc progress=NULL, void *data=NULL);
+	virtual int ProcessPending() { return process_pending; }
+	virtual int PreviewArea(double minx,double maxx,double miny,double maxy);
 	virtual int Disconnected(NodeConnection *connection, int to_side);
 	virtual int Connected(NodeConnection *connection);
 	virtual int SetPropertyFromAtt(const char *propname, LaxFiles::Attribute *att);
@@ -32,6 +32,11 @@ using namespace Laxkit;
 using namespace LaxInterfaces;
 
 #include <fstream>
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <iostream>
 using namespace std;
@@ -1682,6 +1687,46 @@ int Net::clearPotentials(int original)
 	return changed;
 }
 
+//! Find the rotation plus translation that takes pt1 to p1, and pt2 to p2.
+/*! Used to join one net face to another along an edge. Puts the result in m.
+ */
+static void edgeJoinTransform(flatpoint p1,flatpoint p2, flatpoint pt1,flatpoint pt2, double *m)
+{
+	 // pt1*tm --> T --> p1*fm
+	 // pt2*tm --> T --> p2*fm
+	 //
+	 //   [ a b 0 ]
+	 // T=[ c d 0 ] --> [a,b,c,d,e,f]
+	 //   [ e f 1 ]
+	
+	 //transform
+	double a,b,c,d,e,f; //c=-b, a=d
+	double q1x,q1y,q2x,q2y, p1x,p1y,p2x,p2y, dd;
+	q1x=p1.x;
+	q1y=p1.y;
+	q2x=p2.x;
+	q2y=p2.y;
+	p1x=pt1.x;
+	p1y=pt1.y;
+	p2x=pt2.x;
+	p2y=pt2.y;
+	
+	dd=(p1x*p1x-p1x*p2x-p1y*p2y+p2x*p2x+p1y*p1y-p1y*p2y-p1x*p2x+p2y*p2y);
+	a=(q1x*(p1x-p2x)+q1y*(p1y-p2y)+q2x*(p2x-p1x)+q2y*(p2y-p1y))/dd;
+	b=(q1x*(p2y-p1y)+q1y*(p1x-p2x)+q2x*(p1y-p2y)+q2y*(p2x-p1x))/dd;
+	c=-b;
+	d=a;
+	e=(q1x*(p2x*p2x-p1y*p2y-p1x*p2x+p2y*p2y)+q1y*(p1x*p2y-p1y*p2x)+q2x*(p1x*p1x-p1x*p2x+p1y*p1y-p1y*p2y)+q2y*(p1y*p2x-p1x*p2y))/dd;
+	f=(q1x*(p1y*p2x-p1x*p2y)+q1y*(p2x*p2x-p1x*p2x-p1y*p2y+p2y*p2y)+q2x*(p1x*p2y-p1y*p2x)+q2y*(p1x*p1x-p1y*p2y+p1y*p1y-p1x*p2x))/dd;
+
+	m[0]=a;
+	m[1]=b;
+	m[2]=c;
+	m[3]=d;
+	m[4]=e;
+	m[5]=f;
+}
+
 //! Connect net face f1 to net face f2 along edge ee of f1.
 /*! If ee<0 then autodetect the edge.
  *
@@ -1732,40 +1777,8 @@ int	Net::connectFaces(int f1,int f2,int ee)
 	pt1=transform_point(  to->matrix,pt1);
 	pt2=transform_point(  to->matrix,pt2);
 	
-	 // pt1*tm --> T --> p1*fm
-	 // pt2*tm --> T --> p2*fm
-	 //
-	 //   [ a b 0 ]
-	 // T=[ c d 0 ] --> [a,b,c,d,e,f]
-	 //   [ e f 1 ]
-	
-	 //transform
-	double a,b,c,d,e,f; //c=-b, a=d
-	double q1x,q1y,q2x,q2y, p1x,p1y,p2x,p2y, dd;
-	q1x=p1.x;
-	q1y=p1.y;
-	q2x=p2.x;
-	q2y=p2.y;
-	p1x=pt1.x;
-	p1y=pt1.y;
-	p2x=pt2.x;
-	p2y=pt2.y;
-	
-	dd=(p1x*p1x-p1x*p2x-p1y*p2y+p2x*p2x+p1y*p1y-p1y*p2y-p1x*p2x+p2y*p2y);
-	a=(q1x*(p1x-p2x)+q1y*(p1y-p2y)+q2x*(p2x-p1x)+q2y*(p2y-p1y))/dd;
-	b=(q1x*(p2y-p1y)+q1y*(p1x-p2x)+q2x*(p1y-p2y)+q2y*(p2x-p1x))/dd;
-	c=-b;
-	d=a;
-	e=(q1x*(p2x*p2x-p1y*p2y-p1x*p2x+p2y*p2y)+q1y*(p1x*p2y-p1y*p2x)+q2x*(p1x*p1x-p1x*p2x+p1y*p1y-p1y*p2y)+q2y*(p1y*p2x-p1x*p2y))/dd;
-	f=(q1x*(p1y*p2x-p1x*p2y)+q1y*(p2x*p2x-p1x*p2x-p1y*p2y+p2y*p2y)+q2x*(p1x*p2y-p1y*p2x)+q2y*(p1x*p1x-p1y*p2y+p1y*p1y-p1x*p2x))/dd;
-
 	double m[6];
-	m[0]=a;
-	m[1]=b;
-	m[2]=c;
-	m[3]=d;
-	m[4]=e;
-	m[5]=f;
+	edgeJoinTransform(p1,p2, pt1,pt2, m);
 
 	double mm[6];
 	transform_mult(mm,to->matrix,m);
@@ -1953,25 +1966,725 @@ int Net::Unwrap(int netfacei,int atedge)
 	return 0;
 }
 
-//! For any edges with potential faces, unwrap there, until all is unwrapped.
-int Net::TotalUnwrap()
+//----------------Net automatic unfolding
+
+/*! \class UnfoldFace
+ * \brief Internal read only copy of an AbstractNet face, for use by Net::AutoUnwrap().
+ *
+ * AbstractNet::GetFace() need not be safe to call from several threads at once,
+ * so all the faces are copied out once before any unfolding threads start.
+ */
+class UnfoldFace
+{
+  public:
+	int n;
+	flatpoint *p;    //vertices in face coordinates
+	int *tooriginal; //face across each edge, or -1
+	int *toedge;     //edge of that face that this edge connects to
+	double m[6];     //matrix the face has before being joined to anything
+
+	UnfoldFace() { n=0; p=NULL; tooriginal=toedge=NULL; transform_identity(m); }
+	~UnfoldFace() { delete[] p; delete[] tooriginal; delete[] toedge; }
+};
+
+/*! \class UnfoldPlan
+ * \brief Internal class holding one candidate unfolding from Net::AutoUnwrap().
+ *
+ * Each placed face is joined to its parent face along one edge, or is the root of
+ * an island of faces. Islands are packed next to each other once all faces are placed.
+ */
+class UnfoldPlan
+{
+  public:
+	int nfaces;
+	double *matrices;   //6 per face, face coordinates to net coordinates
+	flatpoint **pts;    //net space outline of each face, points into ptbuffer
+	flatpoint *ptbuffer;
+	double *bounds;     //minx,maxx,miny,maxy of each placed face
+	int *parent;        //face joined to, or -1 for island roots and fixed faces
+	int *parentedge;    //edge of parent joined along
+	int *childedge;     //edge of this face joined along
+	int *island;        //-1 for not placed yet
+	int *order;         //faces in the order they were placed
+	int numplaced;
+	int numislands;
+	double area;        //area of the bounding box of all islands
+	int candidate;
+
+	UnfoldPlan(int n, UnfoldFace *faces);
+	~UnfoldPlan();
+};
+
+UnfoldPlan::UnfoldPlan(int n, UnfoldFace *faces)
+{
+	nfaces=n;
+	int totalpoints=0;
+	for (int c=0; c<n; c++) totalpoints+=faces[c].n;
+
+	matrices  =new double[6*n];
+	pts       =new flatpoint*[n];
+	ptbuffer  =new flatpoint[totalpoints];
+	bounds    =new double[4*n];
+	parent    =new int[n];
+	parentedge=new int[n];
+	childedge =new int[n];
+	island    =new int[n];
+	order     =new int[n];
+	totalpoints=0;
+	for (int c=0; c<n; c++) {
+		pts[c]=ptbuffer+totalpoints;
+		totalpoints+=faces[c].n;
+	}
+	numplaced=numislands=0;
+	area=0;
+	candidate=-1;
+}
+
+UnfoldPlan::~UnfoldPlan()
+{
+	delete[] matrices;
+	delete[] pts;
+	delete[] ptbuffer;
+	delete[] bounds;
+	delete[] parent;
+	delete[] parentedge;
+	delete[] childedge;
+	delete[] island;
+	delete[] order;
+}
+
+/*! \class UnfoldGrid
+ * \brief Internal uniform grid of face bounding boxes in net space, used to find overlap candidates.
+ *
+ * Grid cells are hashed into a fixed number of buckets. Each bucket is a linked list
+ * of entries. Clear() just bumps a generation count, so starting a new island is cheap.
+ */
+class UnfoldGrid
 {
-	if (!faces.n) Unwrap(-1,0);
-	if (!faces.n) return 1;
-	do {
+  public:
+	double cell;
+	int nbuckets;
+	int *heads;
+	unsigned int *stamps; //bucket heads are only valid when stamps[bucket]==generation
+	unsigned int generation;
+	int numentries, maxentries;
+	int *entryface, *entrynext;
+
+	UnfoldGrid(int nfaces, double ncell);
+	~UnfoldGrid();
+	void Clear() { generation++; numentries=0; }
+	int Bucket(long x,long y);
+	int Head(int bucket) { return stamps[bucket]==generation ? heads[bucket] : -1; }
+	void Add(int face, const double *b);
+};
+
+UnfoldGrid::UnfoldGrid(int nfaces, double ncell)
+{
+	cell=ncell;
+	nbuckets=16;
+	while (nbuckets<2*nfaces) nbuckets<<=1;
+	heads =new int[nbuckets];
+	stamps=new unsigned int[nbuckets];
+	memset(stamps,0,nbuckets*sizeof(unsigned int));
+	generation=1;
+
+	numentries=0;
+	maxentries=2*nfaces+16;
+	entryface=new int[maxentries];
+	entrynext=new int[maxentries];
+}
+
+UnfoldGrid::~UnfoldGrid()
+{
+	delete[] heads;
+	delete[] stamps;
+	delete[] entryface;
+	delete[] entrynext;
+}
+
+int UnfoldGrid::Bucket(long x,long y)
+{
+	unsigned long h=(unsigned long)x*73856093ul ^ (unsigned long)y*19349663ul;
+	return (h^(h>>17))&(nbuckets-1);
+}
+
+//! Add face to every cell its bounds b (minx,maxx,miny,maxy) touch.
+void UnfoldGrid::Add(int face, const double *b)
+{
+	long x1=(long)floor(b[0]/cell), x2=(long)floor(b[1]/cell);
+	long y1=(long)floor(b[2]/cell), y2=(long)floor(b[3]/cell);
+	int bucket;
+
+	for (long x=x1; x<=x2; x++) {
+		for (long y=y1; y<=y2; y++) {
+			if (numentries==maxentries) {
+				maxentries*=2;
+				int *nf=new int[maxentries], *nn=new int[maxentries];
+				memcpy(nf,entryface,numentries*sizeof(int));
+				memcpy(nn,entrynext,numentries*sizeof(int));
+				delete[] entryface; entryface=nf;
+				delete[] entrynext; entrynext=nn;
+			}
+			bucket=Bucket(x,y);
+			entryface[numentries]=face;
+			entrynext[numentries]=Head(bucket);
+			heads[bucket]=numentries;
+			stamps[bucket]=generation;
+			numentries++;
+		}
+	}
+}
+
+//! Return whether segment a1-a2 crosses b1-b2 properly. Touching within tol does not count.
+static int segmentsCross(flatpoint a1,flatpoint a2, flatpoint b1,flatpoint b2, double tol)
+{
+	flatpoint a=a2-a1, b=b2-b1;
+	double la=sqrt(a.x*a.x+a.y*a.y), lb=sqrt(b.x*b.x+b.y*b.y);
+	if (la<tol || lb<tol) return 0;
+
+	double o1=a.x*(b1.y-a1.y)-a.y*(b1.x-a1.x),
+		   o2=a.x*(b2.y-a1.y)-a.y*(b2.x-a1.x);
+	if (!((o1>tol*la && o2<-tol*la) || (o1<-tol*la && o2>tol*la))) return 0;
+
+	double o3=b.x*(a1.y-b1.y)-b.y*(a1.x-b1.x),
+		   o4=b.x*(a2.y-b1.y)-b.y*(a2.x-b1.x);
+	return (o3>tol*lb && o4<-tol*lb) || (o3<-tol*lb && o4>tol*lb);
+}
+
+//! Return whether polygons a and b overlap by more than tol.
+/*! Faces joined along an edge, or touching at a vertex, do not count as overlapping.
+ * Containment is checked with the average of the vertices, which assumes the faces are convex.
+ */
+static int polygonsOverlap(flatpoint *a,int na, flatpoint *b,int nb, double tol)
+{
+	if (na<3 || nb<3) return 0;
+
+	for (int c=0; c<na; c++) {
+		for (int c2=0; c2<nb; c2++) {
+			if (segmentsCross(a[c],a[(c+1)%na], b[c2],b[(c2+1)%nb], tol)) return 1;
+		}
+	}
+
+	flatpoint ca, cb;
+	for (int c=0; c<na; c++) { ca.x+=a[c].x; ca.y+=a[c].y; }
+	for (int c=0; c<nb; c++) { cb.x+=b[c].x; cb.y+=b[c].y; }
+	ca.x/=na; ca.y/=na;
+	cb.x/=nb; cb.y/=nb;
+	return point_is_in(ca,b,nb) || point_is_in(cb,a,na);
+}
+
+/*! \class Unfolder
+ * \brief Internal class that makes candidate unfoldings for Net::AutoUnwrap().
+ *
+ * Everything in here is read only once unfolding starts, so one Unfolder is shared
+ * by all the threads. Each thread has its own UnfoldPlan, UnfoldGrid and queue.
+ */
+class Unfolder
+{
+  public:
+	int nfaces;
+	UnfoldFace *faces;
+	int totaledges;
+	double cell; //about the size of an average face
+	double tol;  //distances smaller than this are considered 0
+
+	int numfixed;    //faces already in the net that are not to be moved
+	int *fixed;      //original index of fixed faces
+	double *fixedm;  //6 per fixed face
+
+	int numseeds;
+	int numcandidates;
+
+	Unfolder();
+	~Unfolder();
+	int Setup(AbstractNet *basenet);
+	void Run(int candidate, UnfoldPlan *plan, UnfoldGrid *grid, int *queue, int *seen, int *query);
+	void Place(UnfoldPlan *plan, UnfoldGrid *grid, int face, const double *m, int island);
+	void Pack(UnfoldPlan *plan);
+};
+
+Unfolder::Unfolder()
+{
+	nfaces=0;
+	faces=NULL;
+	totaledges=0;
+	cell=1;
+	tol=1e-10;
+	numfixed=0;
+	fixed=NULL;
+	fixedm=NULL;
+	numseeds=numcandidates=1;
+}
+
+Unfolder::~Unfolder()
+{
+	delete[] faces;
+	delete[] fixed;
+	delete[] fixedm;
+}
+
+//! Copy out all the faces of basenet. Return the number of faces.
+int Unfolder::Setup(AbstractNet *basenet)
+{
+	nfaces=basenet->NumFaces();
+	if (nfaces<=0) return 0;
+	faces=new UnfoldFace[nfaces];
+
+	NetFace *face;
+	double size=0, x1,x2,y1,y2;
+	for (int c=0; c<nfaces; c++) {
+		face=basenet->GetFace(c,1);
+		if (!face) continue;
+
+		UnfoldFace *f=faces+c;
+		f->n=face->edges.n;
+		f->p=new flatpoint[f->n];
+		f->tooriginal=new int[f->n];
+		f->toedge=new int[f->n];
+		if (face->matrix) transform_copy(f->m,face->matrix);
+
+		for (int c2=0; c2<f->n; c2++) {
+			if (face->edges.e[c2]->points) f->p[c2]=face->edges.e[c2]->points->fp;
+			f->tooriginal[c2]=face->edges.e[c2]->tooriginal;
+			f->toedge[c2]    =face->edges.e[c2]->tofaceedge;
+			if (f->tooriginal[c2]>=nfaces) f->tooriginal[c2]=-1;
+		}
+		delete face;
+
+		totaledges+=f->n;
+		if (f->n) {
+			x1=x2=f->p[0].x;
+			y1=y2=f->p[0].y;
+			for (int c2=1; c2<f->n; c2++) {
+				if (f->p[c2].x<x1) x1=f->p[c2].x; else if (f->p[c2].x>x2) x2=f->p[c2].x;
+				if (f->p[c2].y<y1) y1=f->p[c2].y; else if (f->p[c2].y>y2) y2=f->p[c2].y;
+			}
+			size+=(x2-x1>y2-y1 ? x2-x1 : y2-y1);
+		}
+	}
+
+	if (size>0) cell=size/nfaces;
+	tol=cell*1e-7;
+	return nfaces;
+}
+
+//! Put face in plan with matrix m, and add it to grid.
+void Unfolder::Place(UnfoldPlan *plan, UnfoldGrid *grid, int face, const double *m, int island)
+{
+	UnfoldFace *f=faces+face;
+	double *b=plan->bounds+4*face;
+	flatpoint *p=plan->pts[face];
+
+	transform_copy(plan->matrices+6*face,m);
+	for (int c=0; c<f->n; c++) {
+		p[c]=transform_point(m,f->p[c]);
+		if (c==0 || p[c].x<b[0]) b[0]=p[c].x;
+		if (c==0 || p[c].x>b[1]) b[1]=p[c].x;
+		if (c==0 || p[c].y<b[2]) b[2]=p[c].y;
+		if (c==0 || p[c].y>b[3]) b[3]=p[c].y;
+	}
+	if (f->n==0) b[0]=b[1]=b[2]=b[3]=0;
+
+	plan->island[face]=island;
+	plan->order[plan->numplaced++]=face;
+	grid->Add(face,b);
+}
+
+//! Make candidate unfolding number candidate.
+/*! Candidates alternate between breadth first and depth first growth from
+ * one of numseeds seed faces spread through the face list.
+ *
+ * A face that would overlap an already placed face in its island is not dropped from that edge,
+ * but can still be joined through any of its other edges later on.
+ * Only when no placed face can take any remaining face is a new island started.
+ *
+ * queue must have room for 2*totaledges ints, and seen for nfaces.
+ */
+void Unfolder::Run(int candidate, UnfoldPlan *plan, UnfoldGrid *grid, int *queue, int *seen, int *query)
+{
+	int depthfirst=candidate%2;
+	int seed=(int)((long)(candidate/2)*nfaces/numseeds);
+	int head=0, tail=0; //queue holds (face,edge) pairs
+	int nextroot=0;
+	int f, e, to, toedge;
+	double m[6], mm[6];
+	flatpoint p1,p2, pt1,pt2;
+
+	plan->candidate=candidate;
+	plan->numplaced=plan->numislands=0;
+	for (int c=0; c<nfaces; c++) { plan->island[c]=-1; plan->parent[c]=-1; }
+	grid->Clear();
+
+	 //fixed faces are all in island 0
+	for (int c=0; c<numfixed; c++) {
+		Place(plan,grid, fixed[c],fixedm+6*c, 0);
+		plan->numislands=1;
+	}
+	for (int c=0; c<plan->numplaced; c++) {
+		f=plan->order[c];
+		for (int c2=0; c2<faces[f].n; c2++) { queue[tail++]=f; queue[tail++]=c2; }
+	}
+
+	while (1) {
+		if (head==tail) {
+			 //start a new island
+			if (plan->numplaced==nfaces) break;
+			head=tail=0;
+			if (plan->numislands==0) f=seed;
+			else {
+				while (plan->island[nextroot]>=0) nextroot++;
+				f=nextroot;
+			}
+			if (plan->numislands) grid->Clear();
+			Place(plan,grid, f,faces[f].m, plan->numislands);
+			plan->numislands++;
+			for (int c2=0; c2<faces[f].n; c2++) { queue[tail++]=f; queue[tail++]=c2; }
+			continue;
+		}
+
+		if (depthfirst) { tail-=2; f=queue[tail]; e=queue[tail+1]; }
+		else { f=queue[head]; e=queue[head+1]; head+=2; }
+
+		to=faces[f].tooriginal[e];
+		toedge=faces[f].toedge[e];
+		if (to<0 || plan->island[to]>=0 || toedge<0 || toedge>=faces[to].n) continue;
+
+		 //join to along edge, same as Net::connectFaces()
+		p1 =plan->pts[f][e];
+		p2 =plan->pts[f][(e+1)%faces[f].n];
+		pt2=transform_point(faces[to].m, faces[to].p[toedge]);
+		pt1=transform_point(faces[to].m, faces[to].p[(toedge+1)%faces[to].n]);
+		edgeJoinTransform(p1,p2, pt1,pt2, m);
+		transform_mult(mm,faces[to].m,m);
+
+		 //check against anything already placed nearby
+		flatpoint *p=plan->pts[to];
+		double b[4]={0,0,0,0};
+		for (int c=0; c<faces[to].n; c++) {
+			p[c]=transform_point(mm,faces[to].p[c]);
+			if (c==0 || p[c].x<b[0]) b[0]=p[c].x;
+			if (c==0 || p[c].x>b[1]) b[1]=p[c].x;
+			if (c==0 || p[c].y<b[2]) b[2]=p[c].y;
+			if (c==0 || p[c].y>b[3]) b[3]=p[c].y;
+		}
+
+		int overlap=0;
+		(*query)++;
+		long x1=(long)floor(b[0]/cell), x2=(long)floor(b[1]/cell);
+		long y1=(long)floor(b[2]/cell), y2=(long)floor(b[3]/cell);
+		for (long x=x1; x<=x2 && !overlap; x++) {
+			for (long y=y1; y<=y2 && !overlap; y++) {
+				for (int i=grid->Head(grid->Bucket(x,y)); i>=0; i=grid->entrynext[i]) {
+					int other=grid->entryface[i];
+					if (seen[other]==*query) continue;
+					seen[other]=*query;
+
+					double *ob=plan->bounds+4*other;
+					if (ob[0]>=b[1]-tol || ob[1]<=b[0]+tol || ob[2]>=b[3]-tol || ob[3]<=b[2]+tol) continue;
+					if (polygonsOverlap(p,faces[to].n, plan->pts[other],faces[other].n, tol)) {
+						overlap=1;
+						break;
+					}
+				}
+			}
+		}
+		if (overlap) continue;
+
+		Place(plan,grid, to,mm, plan->island[f]);
+		plan->parent[to]=f;
+		plan->parentedge[to]=e;
+		plan->childedge[to]=toedge;
+		for (int c2=0; c2<faces[to].n; c2++) {
+			if (c2==toedge) continue;
+			queue[tail++]=to;
+			queue[tail++]=c2;
+		}
+	}
+
+	Pack(plan);
+}
+
+class UnfoldIsland
+{
+  public:
+	int island;
+	double b[4];
+};
+
+static int cmpUnfoldIsland(const void *a, const void *b)
+{
+	double ha=((const UnfoldIsland*)a)->b[3]-((const UnfoldIsland*)a)->b[2],
+		   hb=((const UnfoldIsland*)b)->b[3]-((const UnfoldIsland*)b)->b[2];
+	if (ha>hb) return -1;
+	if (ha<hb) return 1;
+	return ((const UnfoldIsland*)a)->island - ((const UnfoldIsland*)b)->island;
+}
+
+//! Lay islands out in rows, tallest first, and find the total area.
+/*! Island 0 stays put when there are fixed faces. Other islands go to its right.
+ */
+void Unfolder::Pack(UnfoldPlan *plan)
+{
+	int n=plan->numislands;
+	UnfoldIsland *islands=new UnfoldIsland[n];
+	for (int c=0; c<n; c++) islands[c].island=-1;
+
+	double *b, *ib;
+	int isl;
+	for (int c=0; c<plan->numplaced; c++) {
+		isl=plan->island[plan->order[c]];
+		b=plan->bounds+4*plan->order[c];
+		ib=islands[isl].b;
+		if (islands[isl].island<0) { islands[isl].island=isl; memcpy(ib,b,4*sizeof(double)); continue; }
+		if (b[0]<ib[0]) ib[0]=b[0];
+		if (b[1]>ib[1]) ib[1]=b[1];
+		if (b[2]<ib[2]) ib[2]=b[2];
+		if (b[3]>ib[3]) ib[3]=b[3];
+	}
+
+	double gap=cell/10;
+	double x0=0, y0=0, width=0, areas=0;
+	int first=0;
+	if (numfixed) {
+		x0=islands[0].b[1]+gap;
+		y0=islands[0].b[2];
+		first=1;
+	}
+	for (int c=first; c<n; c++) {
+		ib=islands[c].b;
+		areas+=(ib[1]-ib[0]+gap)*(ib[3]-ib[2]+gap);
+		if (ib[1]-ib[0]>width) width=ib[1]-ib[0];
+	}
+	if (width<sqrt(areas)) width=sqrt(areas);
+	qsort(islands+first,n-first,sizeof(UnfoldIsland),cmpUnfoldIsland);
+
+	 //find offset of each island
+	double *dx=new double[2*n];
+	double x=x0, y=y0, rowh=0;
+	for (int c=0; c<n; c++) dx[2*c]=dx[2*c+1]=0;
+	for (int c=first; c<n; c++) {
+		ib=islands[c].b;
+		if (x>x0 && x+ib[1]-ib[0]>x0+width) {
+			x=x0;
+			y+=rowh+gap;
+			rowh=0;
+		}
+		dx[2*islands[c].island  ]=x-ib[0];
+		dx[2*islands[c].island+1]=y-ib[2];
+		x+=ib[1]-ib[0]+gap;
+		if (ib[3]-ib[2]>rowh) rowh=ib[3]-ib[2];
+	}
+
+	 //move faces, and find total bounds
+	double all[4];
+	int f;
+	for (int c=0; c<plan->numplaced; c++) {
+		f=plan->order[c];
+		isl=plan->island[f];
+		b=plan->bounds+4*f;
+		plan->matrices[6*f+4]+=dx[2*isl];
+		plan->matrices[6*f+5]+=dx[2*isl+1];
+		for (int c2=0; c2<faces[f].n; c2++) {
+			plan->pts[f][c2].x+=dx[2*isl];
+			plan->pts[f][c2].y+=dx[2*isl+1];
+		}
+		b[0]+=dx[2*isl]; b[1]+=dx[2*isl];
+		b[2]+=dx[2*isl+1]; b[3]+=dx[2*isl+1];
+		if (c==0) memcpy(all,b,4*sizeof(double));
+		else {
+			if (b[0]<all[0]) all[0]=b[0];
+			if (b[1]>all[1]) all[1]=b[1];
+			if (b[2]<all[2]) all[2]=b[2];
+			if (b[3]>all[3]) all[3]=b[3];
+		}
+	}
+	plan->area=(plan->numplaced ? (all[1]-all[0])*(all[3]-all[2]) : 0);
+
+	delete[] dx;
+	delete[] islands;
+}
+
+//! Return whether plan a is better than plan b: fewer islands, then less area.
+static int betterUnfolding(UnfoldPlan *a, UnfoldPlan *b)
+{
+	if (!b) return 1;
+	if (a->numislands!=b->numislands) return a->numislands<b->numislands;
+	if (a->area!=b->area) return a->area<b->area;
+	return a->candidate<b->candidate;
+}
+
+/*! \class UnfoldThread
+ * \brief Internal per thread data for Net::AutoUnwrap().
+ *
+ * Thread number i of n tries candidates i, i+n, i+2n, ..., and keeps the best one.
+ */
+class UnfoldThread
+{
+  public:
+	Unfolder *unfolder;
+	int first, stride;
+	UnfoldPlan *best;
+	UnfoldThread() { unfolder=NULL; first=0; stride=1; best=NULL; }
+	~UnfoldThread() { delete best; }
+};
+
+static void *unfoldThreadMain(void *data)
+{
+	UnfoldThread *thread=(UnfoldThread*)data;
+	Unfolder *u=thread->unfolder;
+
+	UnfoldGrid grid(u->nfaces,u->cell);
+	int *queue=new int[2*u->totaledges+2];
+	int *seen =new int[u->nfaces];
+	int query=0;
+	for (int c=0; c<u->nfaces; c++) seen[c]=0;
+
+	UnfoldPlan *plan=NULL, *t;
+	for (int c=thread->first; c<u->numcandidates; c+=thread->stride) {
+		if (!plan) plan=new UnfoldPlan(u->nfaces,u->faces);
+		u->Run(c,plan,&grid,queue,seen,&query);
+		if (betterUnfolding(plan,thread->best)) {
+			t=thread->best;
+			thread->best=plan;
+			plan=t;
+		}
+	}
+
+	delete plan;
+	delete[] queue;
+	delete[] seen;
+	return NULL;
+}
+
+//! Unwrap all of basenet, so that no faces overlap.
+/*! If the net has at most one actual face, the whole net is redone from scratch.
+ * numcandidates unfoldings are made, growing breadth first and depth first from
+ * numcandidates/2 different seed faces. The one with the fewest islands is used,
+ * and of those, the one with the least bounding box area. If numcandidates<=0,
+ * then use 2 per thread, but at least 8.
+ *
+ * If there are more actual faces, those are kept where they are, and the rest
+ * of the faces are unfolded from them. Potential faces are discarded.
+ *
+ * Candidates are spread over numthreads threads. If numthreads<=0, then use one per processor.
+ *
+ * Return 0 for success, or nonzero for error, and nothing changed.
+ */
+int Net::AutoUnwrap(int numcandidates, int numthreads)
+{
+	if (!basenet) return 1;
+
+	Unfolder unfolder;
+	if (unfolder.Setup(basenet)==0) return 2;
+	int nfaces=unfolder.nfaces;
+
+	 //remove potential faces, and find the faces that stay put
+	if (numActual()<=1) faces.flush();
+	else {
+		int *newindex=new int[faces.n];
+		int n=0;
+		for (int c=0; c<faces.n; c++) {
+			newindex[c]=(faces.e[c]->tag==FACE_Actual && faces.e[c]->original>=0 && faces.e[c]->original<nfaces) ? n++ : -1;
+		}
+		for (int c=faces.n-1; c>=0; c--) if (newindex[c]<0) faces.remove(c);
 		for (int c=0; c<faces.n; c++) {
-			if (faces.e[c]->tag!=FACE_Actual) continue;
 			for (int c2=0; c2<faces.e[c]->edges.n; c2++) {
-				if (faces.e[c]->edges.e[c2]->tag==FACE_Potential) Unwrap(c,c2);
+				NetFaceEdge *e=faces.e[c]->edges.e[c2];
+				if (e->toface>=0) e->toface=newindex[e->toface];
 			}
+		}
+		delete[] newindex;
+
+		unfolder.numfixed=faces.n;
+		unfolder.fixed =new int[faces.n];
+		unfolder.fixedm=new double[6*faces.n];
+		for (int c=0; c<faces.n; c++) {
+			unfolder.fixed[c]=faces.e[c]->original;
+			if (faces.e[c]->matrix) transform_copy(unfolder.fixedm+6*c,faces.e[c]->matrix);
+			else transform_identity(unfolder.fixedm+6*c);
+		}
+		numcandidates=1;
+	}
+
+	if (numthreads<=0) {
+		long n=sysconf(_SC_NPROCESSORS_ONLN);
+		numthreads=(n>0 ? (int)n : 1);
+	}
+	if (numcandidates<=0) numcandidates=(2*numthreads<8 ? 8 : 2*numthreads);
+	if (numcandidates>2*nfaces) numcandidates=2*nfaces;
+	if (numthreads>numcandidates) numthreads=numcandidates;
+	unfolder.numcandidates=numcandidates;
+	unfolder.numseeds=(numcandidates+1)/2;
+
+	 //make candidates
+	UnfoldThread *threads=new UnfoldThread[numthreads];
+	pthread_t *ids=new pthread_t[numthreads];
+	char *started=new char[numthreads];
+	for (int c=0; c<numthreads; c++) {
+		threads[c].unfolder=&unfolder;
+		threads[c].first=c;
+		threads[c].stride=numthreads;
+		started[c]=(c>0 && pthread_create(&ids[c],NULL,unfoldThreadMain,threads+c)==0);
+	}
+	for (int c=0; c<numthreads; c++) if (!started[c]) unfoldThreadMain(threads+c);
+	for (int c=0; c<numthreads; c++) if (started[c]) pthread_join(ids[c],NULL);
+
+	UnfoldPlan *plan=NULL;
+	for (int c=0; c<numthreads; c++) {
+		if (threads[c].best && betterUnfolding(threads[c].best,plan)) plan=threads[c].best;
+	}
+	DBG if (plan) cerr <<"Net::AutoUnwrap picked candidate "<<plan->candidate<<" of "<<numcandidates
+	DBG			<<", islands: "<<plan->numislands<<", area: "<<plan->area<<endl;
+
+	 //add the new faces
+	int *netindex=new int[nfaces];
+	for (int c=0; c<nfaces; c++) netindex[c]=-1;
+	for (int c=0; c<faces.n; c++) netindex[faces.e[c]->original]=c;
+	for (int c=0; c<plan->numplaced; c++) {
+		int f=plan->order[c];
+		if (netindex[f]>=0) continue;
+
+		NetFace *face=basenet->GetFace(f,1);
+		face->tag=FACE_Actual;
+		if (!face->matrix) face->matrix=new double[6];
+		transform_copy(face->matrix,plan->matrices+6*f);
+		netindex[f]=faces.n;
+		faces.push(face,1);
+	}
 
+	 //link up edges along the joins, everything else is taken
+	for (int c=0; c<faces.n; c++) {
+		int f=faces.e[c]->original;
+		for (int c2=0; c2<faces.e[c]->edges.n; c2++) {
+			NetFaceEdge *e=faces.e[c]->edges.e[c2];
+			int to=e->tooriginal;
+			if (to<0 || to>=nfaces) continue;
+			if ((plan->parent[f]==to && plan->childedge[f]==c2) || (plan->parent[to]==f && plan->parentedge[to]==c2)) {
+				e->toface=netindex[to];
+				e->tag=FACE_Actual;
+			} else if (!(e->toface>=0 && e->tag==FACE_Actual)) {
+				e->toface=-1;
+				e->tag=FACE_Taken;
+			}
 		}
-		break;
-	} while (1);
+	}
+
+	delete[] netindex;
+	delete[] threads;
+	delete[] ids;
+	delete[] started;
+
+	if (!(_config&1)) rebuildLines();
 	FindBBox();
 	return 0;
 }
 
+//! Unwrap all of basenet with AutoUnwrap(), using the default number of candidates and threads.
+int Net::TotalUnwrap()
+{
+	return AutoUnwrap(0,0);
+}
+
 //! Convert a potential net face with index netfacei to an actual one.
 /*! Return 0 for success, or nonzero for error and nothing changed.
  *
@@ -181,6 +181,7 @@ class Net : public LaxInterfaces::SomeData
 	virtual int Anchor(int basenetfacei);
 	virtual int Unwrap(int netfacei,int atedge);
 	virtual int TotalUnwrap();
+	virtual int AutoUnwrap(int numcandidates, int numthreads);
 	virtual int PickUp(int netfacei,int cutatedge);
 	virtual int Drop(int netfacei);
 	virtual int addPotentialsToFace(int facenum);
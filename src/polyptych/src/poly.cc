@@ -18,6 +18,7 @@
 #include <iostream>
 #include <cstring>
 #include <cctype>
+#include <cmath>
 
 #include <lax/attributes.h>
 #include <lax/strmanip.h>
@@ -420,6 +421,74 @@ Settype &Settype::operator=(const Settype &nset)
 	return *this;
 }
 
+//------------------------------ EdgeHash -------------------------------------
+
+/*! \class EdgeHash
+ * \brief Internal open addressing map from undirected vertex pairs to an int.
+ *
+ * Used by Polyhedron::makeedges() and Polyhedron::connectFaces() so that finding
+ * the other side of an edge does not need a search through every other edge.
+ */
+class EdgeHash
+{
+  public:
+	int size; //always a power of 2
+	int *key1, *key2, *value;
+
+	EdgeHash(int n);
+	~EdgeHash();
+	int Slot(int p1,int p2);
+	int Get(int p1,int p2);
+	void Set(int p1,int p2, int v);
+};
+
+//! Make room for about n distinct edges.
+EdgeHash::EdgeHash(int n)
+{
+	size=16;
+	while (size<2*n) size<<=1;
+	key1 =new int[size];
+	key2 =new int[size];
+	value=new int[size];
+	for (int c=0; c<size; c++) key1[c]=-1;
+}
+
+EdgeHash::~EdgeHash()
+{
+	delete[] key1;
+	delete[] key2;
+	delete[] value;
+}
+
+//! Return the slot holding edge (p1,p2), or the empty slot where it should go.
+int EdgeHash::Slot(int p1,int p2)
+{
+	if (p1>p2) { int t=p1; p1=p2; p2=t; }
+
+	unsigned int h=(unsigned int)p1*2654435761u ^ (unsigned int)p2*40503u;
+	h^=h>>15;
+	int i=h&(size-1);
+	while (key1[i]!=-1 && (key1[i]!=p1 || key2[i]!=p2)) i=(i+1)&(size-1);
+	return i;
+}
+
+//! Return the value for edge (p1,p2), or -1 if not there.
+int EdgeHash::Get(int p1,int p2)
+{
+	int i=Slot(p1,p2);
+	return key1[i]==-1 ? -1 : value[i];
+}
+
+//! Set the value for edge (p1,p2). Direction of the edge does not matter.
+void EdgeHash::Set(int p1,int p2, int v)
+{
+	int i=Slot(p1,p2);
+	key1[i]= p1<p2 ? p1 : p2;
+	key2[i]= p1<p2 ? p2 : p1;
+	value[i]=v;
+}
+
+
 //------------------------------ Polyhedron -------------------------------------
 
 /*! \class Polyhedron
@@ -583,36 +652,45 @@ int Polyhedron::validate()
 void Polyhedron::connectFaces()
 {
 	 //first clear all face links
+	int emax=0;
 	for (int c=0; c<faces.n; c++) {
 		if (!faces.e[c]->f) faces.e[c]->f=new int[faces.e[c]->pn];
 		for (int c2=0; c2<faces.e[c]->pn; c2++) {
 			faces.e[c]->f[c2]=-1;
 		}
+		emax+=faces.e[c]->pn;
 	}
-
-	 //now find connections
-	int c,c2,c3,c4;
+	if (emax==0) return;
+
+	 //now find connections. Each unmatched face edge waits in the hash
+	 //until the next face edge with the same endpoints comes along.
+	EdgeHash hash(emax);
+	int *hface =new int[emax];
+	int *hindex=new int[emax];
+	int n=0, h;
 	int a1,a2;
-	for (c=0; c<faces.n; c++) {
-	  for (c2=0; c2<faces.e[c]->pn; c2++) {
-	  	if (faces.e[c]->f[c2]!=-1) continue;
-
-	  	a1=faces.e[c]->p[c2];
-	  	a2=faces.e[c]->p[(c2+1)%faces.e[c]->pn];
-
-	  	for (c3=0; c3<faces.n; c3++) {
-  		  for (c4=0; c4<faces.e[c]->pn; c4++) {
-  		  	if ((faces.e[c3]->p[c4]==a1 && faces.e[c3]->p[(c4+1)%faces.e[c]->pn]==a2)
-				 || (faces.e[c3]->p[c4]==a2 && faces.e[c3]->p[(c4+1)%faces.e[c]->pn]==a1)) {
-  		  		faces.e[c]->f[c2]=c3;
-				faces.e[c3]->f[c4]=c;
-				c3=faces.n;
-				break;
-  		  	}
-  		  }
-	  	}
+	for (int c=0; c<faces.n; c++) {
+	  for (int c2=0; c2<faces.e[c]->pn; c2++) {
+		a1=faces.e[c]->p[c2];
+		a2=faces.e[c]->p[(c2+1)%faces.e[c]->pn];
+		if (a1==a2) continue;
+
+		h=hash.Get(a1,a2);
+		if (h>=0 && hface[h]!=c) {
+			faces.e[c]->f[c2]=hface[h];
+			faces.e[hface[h]]->f[hindex[h]]=c;
+			hash.Set(a1,a2,-1);
+		} else {
+			hface[n]=c;
+			hindex[n]=c2;
+			hash.Set(a1,a2,n);
+			n++;
+		}
 	  }
 	}
+
+	delete[] hface;
+	delete[] hindex;
 }
 
 //! Add a face to a set.
@@ -692,15 +770,15 @@ int Polyhedron::makeedges()
 	DBG cerr <<"makeedges emax:"<<emax;
 	
 	 //for each edge of each face, see if it matches any edge in any other face.
+	 //hash maps vertex pairs to index in edges
+	EdgeHash hash(emax);
 	for (c=0; c<faces.n; c++) {              //for each face in polyhedron
 		for (c2=0; c2<faces.e[c]->pn; c2++) { //for each edge in face
 			p1=faces.e[c]->p[c2];  //point 1 of a face's edge
 			p2=faces.e[c]->p[(c2+1)%faces.e[c]->pn]; //point 2 of a face's edge
-			for (c3=0; c3<edges.n; c3++) { //check current edge against known edges
-				if ((edges.e[c3]->p1==p1 && edges.e[c3]->p2==p2) ||
-					(edges.e[c3]->p1==p2 && edges.e[c3]->p2==p1)) break;
-			}
-			if (c3==edges.n) { // edge not found in this->edges
+			c3=hash.Get(p1,p2); //check current edge against known edges
+			if (c3<0) { // edge not found in this->edges
+				hash.Set(p1,p2,edges.n);
 				edges.push(new Edge(p1,p2,c,-1));
 				faces.e[c]->f[c2]=-1; //-1 because we are not sure what face it connects to yet
 			} else {
@@ -743,6 +821,9 @@ int Polyhedron::makeedges()
  * This will update all face references to the points.
  * You might want to run makeedges() again afterwards, as currently edges is flushed.
  *
+ * Vertices are matched through a uniform grid spatial hash, so this is near linear
+ * in the number of vertices. Each vertex collapses to the lowest index vertex near it.
+ *
  * \todo should update edges too, right now just flushes edges
  * \todo **** must collapse edges when points are too near!! such as for gore tips...
  */
@@ -751,36 +832,88 @@ void Polyhedron::collapseVertices(double zero, int vstart, int vend)
 	 //remove existing edges
 	edges.flush();
 
-	zero*=zero;
-	double d;
-	spacevector v;
+	if (vertices.n==0) return;
 	if (vstart<0) vstart=0;
 	else if (vstart>=vertices.n) vstart=vertices.n-1;
 	if (vend<0 || vend>=vertices.n) vend=vertices.n-1;
 
-	 //collapse vertices
+	 //Points are binned into a uniform grid with cells at least zero wide, so only points
+	 //in the 27 cells around a point need to be checked. Cells are hashed into buckets,
+	 //each bucket a linked list through next[].
+	double cell=zero;
+	double extent=0;
 	for (int c=vstart; c<=vend; c++) {
-		for (int c2=c+1; c2<=vend; c2++) {
-			v=vertices.e[c2]-vertices.e[c];
-			d=v*v;
-			if (d<zero || (d>0 && vertices.e[c2]==vertices.e[c])) {
-				 //found one to collapse
-				for (int c3=0; c3<faces.n; c3++) {
-					for (int c4=0; c4<faces.e[c3]->pn; c4++) {
-						if (faces.e[c3]->p[c4]==c2) {
-							faces.e[c3]->p[c4]=c;
-						} else if (faces.e[c3]->p[c4]>c2) {
-							faces.e[c3]->p[c4]--;
-						}
-					}
+		if (fabs(vertices.e[c].x)>extent) extent=fabs(vertices.e[c].x);
+		if (fabs(vertices.e[c].y)>extent) extent=fabs(vertices.e[c].y);
+		if (fabs(vertices.e[c].z)>extent) extent=fabs(vertices.e[c].z);
+	}
+	if (cell<extent*1e-9) cell=extent*1e-9; //keeps cell coordinates inside a long
+	if (cell<=0) cell=1;
+	zero*=zero;
+
+	int n=vend-vstart+1;
+	int nbuckets=16;
+	while (nbuckets<2*n) nbuckets<<=1;
+	int *buckets=new int[nbuckets];
+	int *next   =new int[n];
+	long *cellx =new long[3*n];
+	int *remap  =new int[vertices.n]; //old index -> old index of survivor, then -> new index
+	for (int c=0; c<nbuckets; c++) buckets[c]=-1;
+	for (int c=0; c<vertices.n; c++) remap[c]=c;
+
+	long cx,cy,cz;
+	unsigned long h;
+	int i, found;
+	double d;
+	spacevector v;
+	for (int c=vstart; c<=vend; c++) {
+		i=c-vstart;
+		cellx[3*i  ]=cx=(long)floor(vertices.e[c].x/cell);
+		cellx[3*i+1]=cy=(long)floor(vertices.e[c].y/cell);
+		cellx[3*i+2]=cz=(long)floor(vertices.e[c].z/cell);
+
+		 //find the lowest index survivor close enough to c
+		found=-1;
+		for (long x=cx-1; x<=cx+1; x++)
+		  for (long y=cy-1; y<=cy+1; y++)
+			for (long z=cz-1; z<=cz+1; z++) {
+				h=(unsigned long)x*73856093ul ^ (unsigned long)y*19349663ul ^ (unsigned long)z*83492791ul;
+				for (int c2=buckets[h&(nbuckets-1)]; c2>=0; c2=next[c2]) {
+					if (cellx[3*c2]!=x || cellx[3*c2+1]!=y || cellx[3*c2+2]!=z) continue;
+					if (found>=0 && c2+vstart>found) continue;
+					v=vertices.e[c2+vstart]-vertices.e[c];
+					d=v*v;
+					if (d<zero || vertices.e[c2+vstart]==vertices.e[c]) found=c2+vstart;
 				}
-				vertices.pop(c2);
-				vend--;
-				c2--;
 			}
+
+		if (found>=0) { remap[c]=found; continue; }
+
+		 //c survives, so add to grid
+		h=(unsigned long)cx*73856093ul ^ (unsigned long)cy*19349663ul ^ (unsigned long)cz*83492791ul;
+		next[i]=buckets[h&(nbuckets-1)];
+		buckets[h&(nbuckets-1)]=i;
+	}
+
+	 //compact the vertex list, and point faces at the new indices
+	int nn=0;
+	for (int c=0; c<vertices.n; c++) {
+		if (remap[c]!=c) { remap[c]=remap[remap[c]]; continue; } //survivors always come first
+		vertices.e[nn]=vertices.e[c];
+		remap[c]=nn++;
+	}
+	vertices.n=nn;
+	for (int c3=0; c3<faces.n; c3++) {
+		for (int c4=0; c4<faces.e[c3]->pn; c4++) {
+			faces.e[c3]->p[c4]=remap[faces.e[c3]->p[c4]];
 		}
 	}
 
+	delete[] buckets;
+	delete[] next;
+	delete[] cellx;
+	delete[] remap;
+
 	 //check faces for null edges and remove.
 	 //If a null face results, then remove
 	int compto;
@@ -42,6 +42,10 @@
 #include <lax/lists.cc>
 
 #include <fstream>
+#include <cmath>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
 
 #include <iostream>
 #define DBG 
@@ -69,6 +73,9 @@ int AA=3; //***should be able to autocompute suitable value?
 double pixPerUnit;
 int generate_images=1;
 Basis *extra_basis=NULL;
+int render_threads=0;  //0 means one per processor
+int legacy_render=0;   //use GraphicsMagick pixel access, as in older versions
+int benchmark=0;       //render with both renderers, report timing, and write nothing
 
 
 
@@ -247,6 +254,350 @@ int Net2::SaveSvgWithImages(const char *filename, const char *filebase, flatpoin
 }
 
 
+//------------------------------------ Face rendering -----------------------------------
+
+//! Return seconds since some arbitrary time, for timing benchmarks.
+static double timeNow()
+{
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return tv.tv_sec+tv.tv_usec/1000000.;
+}
+
+/*! \class FaceRender
+ * \brief Where one face image goes, and what part of the sphere it shows.
+ *
+ * A point (u,v) in [0..1] of the face image corresponds to b.p+u*b.x+v*b.y in space.
+ * pgon holds the face outline in image pixels.
+ */
+class FaceRender
+{
+  public:
+	Basis b;
+	int width, height;
+	Pgon *pgon;
+	unsigned char *pixels; //RGBA, width*height*4
+
+	FaceRender() { width=height=0; pgon=NULL; pixels=NULL; }
+	~FaceRender() { delete[] pixels; }
+};
+
+/*! \class SphereRenderer
+ * \brief Renders faces from an equirectangular image held in memory, on several threads.
+ *
+ * The sphere image is copied out of GraphicsMagick once as 8 bit RGB. Work is split
+ * into bands of rows of face images, which threads pull off a shared counter.
+ */
+class SphereRenderer
+{
+  public:
+	unsigned char *sphere; //RGB
+	int spherewidth, sphereheight;
+
+	FaceRender *faces;
+	int *jobface, *jobrow, numjobs, nextjob;
+	pthread_mutex_t mutex;
+
+	SphereRenderer(Image &spheremap);
+	~SphereRenderer();
+	void Render(FaceRender *nfaces, int first, int n, int numthreads);
+	void RenderRows(FaceRender *face, int y1, int y2);
+	static void *ThreadMain(void *data);
+};
+
+#define ROWS_PER_JOB 8
+
+SphereRenderer::SphereRenderer(Image &spheremap)
+{
+	spherewidth =spheremap.columns();
+	sphereheight=spheremap.rows();
+	sphere=new unsigned char[spherewidth*sphereheight*3];
+	spheremap.write(0,0,spherewidth,sphereheight,"RGB",CharPixel,sphere);
+
+	faces=NULL;
+	jobface=jobrow=NULL;
+	numjobs=nextjob=0;
+	pthread_mutex_init(&mutex,NULL);
+}
+
+SphereRenderer::~SphereRenderer()
+{
+	delete[] sphere;
+	pthread_mutex_destroy(&mutex);
+}
+
+void *SphereRenderer::ThreadMain(void *data)
+{
+	SphereRenderer *r=(SphereRenderer*)data;
+	int job;
+	while (1) {
+		pthread_mutex_lock(&r->mutex);
+		job=r->nextjob++;
+		pthread_mutex_unlock(&r->mutex);
+		if (job>=r->numjobs) break;
+
+		FaceRender *face=r->faces+r->jobface[job];
+		int y2=r->jobrow[job]+ROWS_PER_JOB;
+		if (y2>face->height) y2=face->height;
+		r->RenderRows(face, r->jobrow[job], y2);
+	}
+	return NULL;
+}
+
+//! Render n faces starting at nfaces[first], allocating FaceRender::pixels as needed.
+void SphereRenderer::Render(FaceRender *nfaces, int first, int n, int numthreads)
+{
+	faces=nfaces;
+	numjobs=nextjob=0;
+	for (int c=first; c<first+n; c++) {
+		if (!faces[c].pixels) faces[c].pixels=new unsigned char[faces[c].width*faces[c].height*4];
+		numjobs+=(faces[c].height+ROWS_PER_JOB-1)/ROWS_PER_JOB;
+	}
+	jobface=new int[numjobs];
+	jobrow =new int[numjobs];
+	numjobs=0;
+	for (int c=first; c<first+n; c++) {
+		for (int y=0; y<faces[c].height; y+=ROWS_PER_JOB) {
+			jobface[numjobs]=c;
+			jobrow [numjobs]=y;
+			numjobs++;
+		}
+	}
+
+	if (numthreads>numjobs) numthreads=numjobs;
+	pthread_t *threads=new pthread_t[numthreads];
+	int started=0;
+	for (int c=1; c<numthreads; c++) {
+		if (pthread_create(&threads[started],NULL,ThreadMain,this)==0) started++;
+	}
+	ThreadMain(this);
+	for (int c=0; c<started; c++) pthread_join(threads[c],NULL);
+
+	delete[] threads;
+	delete[] jobface;
+	delete[] jobrow;
+	jobface=jobrow=NULL;
+}
+
+//! Render rows [y1,y2) of face.
+/*! Only pixels within 1 pixel of the face outline are drawn, the same area that the old
+ * polygon mask with stroke width 2 covered. The outline is assumed convex.
+ *
+ * Supersamples are spaced evenly along each row, so each one is the previous point
+ * plus a constant step, and the sphere is sampled bilinearly.
+ */
+void SphereRenderer::RenderRows(FaceRender *face, int y1, int y2)
+{
+	Pgon *pgon=face->pgon;
+	int w=face->width, h=face->height;
+	double aai=1./AA;
+	spacepoint rowp, p, dx=face->b.x/(w*AA);
+	double band1,band2, minx,maxx, t, r, fx,fy, tx,ty;
+	int x1,x2, sx0,sx1,sy0,sy1;
+	double rq,gq,bq;
+	unsigned char *s00,*s01,*s10,*s11, *out;
+	flatpoint a,b;
+
+	for (int y=y1; y<y2; y++) {
+		out=face->pixels+y*w*4;
+		memset(out,0,w*4);
+
+		 //find x extent of the face within a pixel of this row's center
+		band1=y+.5-1;
+		band2=y+.5+1;
+		minx=1e300; maxx=-1e300;
+		for (int c=0; c<pgon->pn; c++) {
+			a=pgon->p[c];
+			b=pgon->p[(c+1)%pgon->pn];
+			if (a.y>=band1 && a.y<=band2) {
+				if (a.x<minx) minx=a.x;
+				if (a.x>maxx) maxx=a.x;
+			}
+			if (a.y==b.y) continue;
+			for (int e=0; e<2; e++) {
+				t=((e==0 ? band1 : band2)-a.y)/(b.y-a.y);
+				if (t<0 || t>1) continue;
+				t=a.x+t*(b.x-a.x);
+				if (t<minx) minx=t;
+				if (t>maxx) maxx=t;
+			}
+		}
+		if (minx>maxx) continue;
+		x1=(int)ceil(minx-1-.5);
+		x2=(int)floor(maxx+1-.5);
+		if (x1<0) x1=0;
+		if (x2>w-1) x2=w-1;
+
+		for (int x=x1; x<=x2; x++) {
+			rq=gq=bq=0;
+			for (int ya=0; ya<AA; ya++) {
+				rowp=face->b.p + ((y+aai*(ya+.5))/h)*face->b.y;
+				p=rowp + (x*AA+.5)*dx;
+
+				for (int xa=0; xa<AA; xa++, p+=dx) {
+					 //transform (x,y,z) -> (sx,sy)
+					r=sqrt(p.x*p.x+p.y*p.y);
+					fx=(atan2(p.y,p.x)/M_PI+1)/2*spherewidth-.5; //theta
+					fy=(atan2(p.z,r)/M_PI+.5)*sphereheight-.5;   //gamma
+
+					sx0=(int)floor(fx);
+					tx=fx-sx0;
+					sx1=sx0+1;
+					sx0=((sx0%spherewidth)+spherewidth)%spherewidth; //wraps around in theta
+					sx1=((sx1%spherewidth)+spherewidth)%spherewidth;
+
+					sy0=(int)floor(fy);
+					ty=fy-sy0;
+					sy1=sy0+1;
+					if (sy0<0) sy0=0; else if (sy0>=sphereheight) sy0=sphereheight-1;
+					if (sy1<0) sy1=0; else if (sy1>=sphereheight) sy1=sphereheight-1;
+
+					s00=sphere+(sy0*spherewidth+sx0)*3;
+					s01=sphere+(sy0*spherewidth+sx1)*3;
+					s10=sphere+(sy1*spherewidth+sx0)*3;
+					s11=sphere+(sy1*spherewidth+sx1)*3;
+					rq+=(1-ty)*((1-tx)*s00[0]+tx*s01[0]) + ty*((1-tx)*s10[0]+tx*s11[0]);
+					gq+=(1-ty)*((1-tx)*s00[1]+tx*s01[1]) + ty*((1-tx)*s10[1]+tx*s11[1]);
+					bq+=(1-ty)*((1-tx)*s00[2]+tx*s01[2]) + ty*((1-tx)*s10[2]+tx*s11[2]);
+				}
+			}
+			out[x*4  ]=(unsigned char)(rq/(AA*AA)+.5);
+			out[x*4+1]=(unsigned char)(gq/(AA*AA)+.5);
+			out[x*4+2]=(unsigned char)(bq/(AA*AA)+.5);
+			out[x*4+3]=255;
+		}
+	}
+}
+
+//! Render one face through GraphicsMagick pixel access. This is how spheretopoly used to render.
+/*! Kept around for --legacy-render and --benchmark.
+ */
+void RenderFaceMagick(Image &spheremap, FaceRender *face, Image &faceimage)
+{
+	int spherewidth=spheremap.columns(),
+		sphereheight=spheremap.rows();
+	int pixelwidth=face->width, pixelheight=face->height;
+	Pgon *pgon=face->pgon;
+	Basis &b=face->b;
+
+	ColorRGB color,color2;
+	int sx,sy;
+	double rq,gq,bq;
+	double aai=1./AA;
+	double xx[AA],yy[AA],r;
+	spacepoint p;
+	char scratch[100];
+
+	faceimage.magick("TIFF");
+	sprintf(scratch,"%dx%d",pixelwidth,pixelheight);
+	faceimage.size(scratch);
+	faceimage.read("xc:transparent");
+
+	 //construct and draw the polygon mask
+	std::list<Magick::Coordinate> pgonpoints;
+	for (int c2=0; c2<pgon->pn; c2++) {
+		pgonpoints.push_back(Magick::Coordinate(pgon->p[c2].x,pgon->p[c2].y));
+	}
+	color.alpha(0);
+	color.red(1.0);
+	color.blue(1.0);
+	color.green(1.0);
+	faceimage.fillColor(color);
+	faceimage.strokeColor(color);
+	faceimage.strokeWidth(2);
+	faceimage.draw(DrawablePolygon(pgonpoints));
+
+	 // for each pixel in face image, find corresponding point on sphere
+	for (int x=0; x<pixelwidth; x++) {
+	  for (int c2=0; c2<AA; c2++) xx[c2]=((double)x+aai*(c2+.5))/pixelwidth;
+
+	  for (int y=0; y<pixelheight; y++) {
+		for (int c2=0; c2<AA; c2++) yy[c2]=((double)y+aai*(c2+.5))/pixelheight;
+
+		 //only work on pixels that are in the polygon
+		color2=faceimage.pixelColor(x,y);
+		if (color2.alpha()==1.) continue;
+
+		rq=gq=bq=0;
+		for (int xa=0; xa<AA; xa++) {
+		  for (int ya=0; ya<AA; ya++) {
+			p=b.p+xx[xa]*b.x+yy[ya]*b.y;
+
+			 //transform (x,y,z) -> (sx,sy)
+			r=sqrt(p.x*p.x+p.y*p.y);
+			sx=(int)((atan2(p.y,p.x)/M_PI+1)/2*spherewidth); //theta
+			sy=(int)((atan(p.z/r)/M_PI+.5)*sphereheight);   //gamma
+			if (sx<0) sx=0;
+			else if (sx>=spherewidth) sx=spherewidth-1;
+			if (sy<0) sy=0;
+			else if (sy>=sphereheight) sy=sphereheight-1;
+
+			color=spheremap.pixelColor(sx,sy);
+			rq+=color.red();
+			gq+=color.green();
+			bq+=color.blue();
+		  }
+		}
+		rq/=AA*AA;
+		gq/=AA*AA;
+		bq/=AA*AA;
+		if (rq>1) rq=1;
+		if (gq>1) gq=1;
+		if (bq>1) bq=1;
+		color.red(rq);
+		color.green(gq);
+		color.blue(bq);
+		color.alpha(0);
+		faceimage.pixelColor(x,y,color);
+	  }
+	}
+}
+
+//! Render all faces with both renderers, and print timing and how different the results are.
+int BenchmarkRenderers(Image &spheremap, FaceRender *faces, int n, int numthreads)
+{
+	cout <<"Benchmarking "<<n<<" faces, oversampling "<<AA<<"x"<<AA<<", "<<numthreads<<" threads"<<endl;
+
+	double start=timeNow();
+	Image faceimage;
+	faceimage.depth(8);
+	faceimage.matte(true);
+	unsigned char **old=new unsigned char*[n];
+	for (int c=0; c<n; c++) {
+		RenderFaceMagick(spheremap,faces+c,faceimage);
+		old[c]=new unsigned char[faces[c].width*faces[c].height*4];
+		faceimage.write(0,0,faces[c].width,faces[c].height,"RGBA",CharPixel,old[c]);
+	}
+	double oldtime=timeNow()-start;
+
+	start=timeNow();
+	SphereRenderer renderer(spheremap);
+	renderer.Render(faces,0,n,numthreads);
+	double newtime=timeNow()-start;
+
+	 //compare
+	long pixels=0, maskdiff=0;
+	double diff=0;
+	for (int c=0; c<n; c++) {
+		for (int i=0; i<faces[c].width*faces[c].height; i++) {
+			unsigned char *o=old[c]+i*4, *p=faces[c].pixels+i*4;
+			if ((o[3]>127) != (p[3]>127)) { maskdiff++; continue; }
+			if (p[3]<=127) continue;
+			pixels++;
+			diff+=fabs((double)o[0]-p[0]) + fabs((double)o[1]-p[1]) + fabs((double)o[2]-p[2]);
+		}
+		delete[] old[c];
+	}
+	delete[] old;
+
+	cout <<"  GraphicsMagick pixel access: "<<oldtime<<" s"<<endl
+		 <<"  raw buffers:                 "<<newtime<<" s  ("<<(newtime>0 ? oldtime/newtime : 0)<<"x)"<<endl
+		 <<"  mean channel difference:     "<<(pixels ? diff/pixels/3 : 0)<<" of 255"<<endl
+		 <<"  pixels in only one mask:     "<<maskdiff<<endl;
+	return 0;
+}
+
+
 //------------------------------------ SphereToPoly() -----------------------------------
 
 //! Create several small images, 1 per face of a polyhedron from a sphere map.
@@ -266,9 +617,6 @@ int SphereToPoly(Image spheremap,
 {
 	if (!poly || (output!=OUT_NONE && !net)) return 1;
 
-	int spherewidth=spheremap.columns(),
-		sphereheight=spheremap.rows();
-
 	//figure out an orientation for the face in 3d.
 	//
 	// for each face of the polyhedron, create an image around the 
@@ -276,36 +624,23 @@ int SphereToPoly(Image spheremap,
 	// find the corresponding theta,gamma, and read off pixel from spheremap.
 	// possibly oversample.
 
-
-	ColorRGB color,color2;
-	Image faceimage;
-	faceimage.depth(8);
-	faceimage.magick("TIFF");
-	faceimage.matte(true);
-
 	double pixperunit=-1; // net units
-	int c, sx,sy, facei;
+	int c, facei;
 	DoubleBBox bbox;
 	double width, height;
 	int pixelwidth, pixelheight;
 
 	Basis b;
-	//unsigned int rq,gq,bq; //quantums are ints
-	double rq,gq,bq;        //rgb are doubles
-
 	double scale;
-	double aai=1./AA;
-	double xx[AA],yy[AA],r;
 
 	PtrStack<Pgon> pgons;
 	Pgon *pgon;
-	spacepoint p;
 	flatpoint netp,netx;
 	flatpoint imagedims[poly->faces.n],imageoffset[poly->faces.n];
-	char filename[300],scratch[500];
+	char filename[300];
+	FaceRender *renders=new FaceRender[poly->faces.n];
 	
 	for (c=0; c<poly->faces.n; c++) { //for each face...
-	//for (c=0; c<1; c++) { //for each face...
 		
 		 //find transform and bounding box for face in polyhedron
 		 // b is basis of face:
@@ -339,111 +674,78 @@ int SphereToPoly(Image spheremap,
 		imageoffset[c]=pgon->p[0]-flatpoint(bbox.minx,bbox.miny);
 		//cout <<"imagedims["<<c<<"]= "<<imagedims[c].x<<" x "<<imagedims[c].y<<endl;
 
-		if (generate_images) {
-			faceimage.magick("TIFF");
-			sprintf(scratch,"%dx%d",pixelwidth,pixelheight);
-			faceimage.size(scratch);
-			faceimage.read("xc:transparent");
-			//faceimage.read("xc:#ff000000");
-		}
-
 		 //scale points so that they are in face image space
 		for (int c2=0; c2<poly->faces.e[c]->pn; c2++) {
 			pgon->p[c2]=(pgon->p[c2]-flatpoint(bbox.minx,bbox.miny))/width*pixelwidth;
 		}
 		pgons.push(pgon,1); //add to list of pgons
 
-
-		 //construct and draw the polygon mask
-		if (generate_images) {
-			std::list<Magick::Coordinate> pgonpoints;
-			for (int c2=0; c2<pgon->pn; c2++) {
-				pgonpoints.push_back(Magick::Coordinate(pgon->p[c2].x,pgon->p[c2].y));
-			}
-			color.alpha(0);
-			color.red(1.0);
-			color.blue(1.0);
-			color.green(1.0);
-			faceimage.fillColor(color);
-			faceimage.strokeColor(color);
-			faceimage.strokeWidth(2);
-			faceimage.draw(DrawablePolygon(pgonpoints));
-		}
-
-		
 		 // transform b.p to be at lower left of image
 		 // and b.x and b.y to span the bounding box of the face image
 		b.p+= bbox.minx*b.x + bbox.miny*b.y;
 		b.x*=width;
 		b.y*=height;
-		
-		
-		 // for each pixel in face image, find corresponding point on sphere
-		if (generate_images) for (int x=0; x<pixelwidth; x++) {
-		  for (int c2=0; c2<AA; c2++) xx[c2]=((double)x+aai*(c2+.5))/pixelwidth;
 
-		  for (int y=0; y<pixelheight; y++) {
-			for (int c2=0; c2<AA; c2++) yy[c2]=((double)y+aai*(c2+.5))/pixelheight;
-
-			 //only work on pixels that are in the polygon
-			color2=faceimage.pixelColor(x,y);
-			if (color2.alpha()==1.) continue;
+		 //the sphere's basis is applied to the face's basis once here, rather than to every sample
+		if (extra_basis) {
+			b.p-=extra_basis->p;
+			b.p=spacepoint(b.p*extra_basis->x, b.p*extra_basis->y, b.p*extra_basis->z);
+			b.x=spacepoint(b.x*extra_basis->x, b.x*extra_basis->y, b.x*extra_basis->z);
+			b.y=spacepoint(b.y*extra_basis->x, b.y*extra_basis->y, b.y*extra_basis->z);
+		}
 
-			rq=gq=bq=0;
-			for (int xa=0; xa<AA; xa++) {
-			  for (int ya=0; ya<AA; ya++) {
-				p=b.p+xx[xa]*b.x+yy[ya]*b.y;
-				
-				if (extra_basis) {
-					p-=extra_basis->p;
-					p=spacepoint(p*extra_basis->x,p*extra_basis->y,p*extra_basis->z);
-				}
+		renders[c].b=b;
+		renders[c].width=pixelwidth;
+		renders[c].height=pixelheight;
+		renders[c].pgon=pgon;
+	}
 
-				 //transform (x,y,z) -> (sx,sy)
-				r=sqrt(p.x*p.x+p.y*p.y);
-				sx=(int)((atan2(p.y,p.x)/M_PI+1)/2*spherewidth); //theta
-				sy=(int)((atan(p.z/r)/M_PI+.5)*sphereheight);   //gamma
-				if (sx<0) sx=0;
-				else if (sx>=spherewidth) sx=spherewidth-1;
-				if (sy<0) sy=0;
-				else if (sy>=sphereheight) sy=sphereheight-1;
-
-				color=spheremap.pixelColor(sx,sy);
-				rq+=color.red();
-				gq+=color.green();
-				bq+=color.blue();
-			  }
-			}
-			rq/=AA*AA;
-			gq/=AA*AA;
-			bq/=AA*AA;
-			if (rq>1) rq=1;
-			if (gq>1) gq=1;
-			if (bq>1) bq=1;
-			color.red(rq);
-			color.green(gq);
-			color.blue(bq);
-
-			//if (color2.alpha()!=1.) { //this is checked for above...
-				color.alpha(0);
-				faceimage.pixelColor(x,y,color);
-			//}
-		  }
-		  //DBG cout <<"\\\n";
-		}
+	int numthreads=render_threads;
+	if (numthreads<=0) {
+		long n=sysconf(_SC_NPROCESSORS_ONLN);
+		numthreads=(n>0 ? (int)n : 1);
+	}
 
+	if (generate_images && benchmark) {
+		BenchmarkRenderers(spheremap,renders,poly->faces.n,numthreads);
+		delete[] renders;
+		return 0;
+	}
 
-		 //save the image somewhere..
-		if (generate_images) {
+	if (generate_images && legacy_render) {
+		Image faceimage;
+		faceimage.depth(8);
+		faceimage.matte(true);
+		for (c=0; c<poly->faces.n; c++) {
+			RenderFaceMagick(spheremap,renders+c,faceimage);
 			sprintf(filename,"%s%03d.png",filebase,c);
 			cout <<"writing "<<filename<<"..."<<endl;
 			faceimage.write(filename);
 		}
 
-		if (output==OUT_IMAGE) {
-			//***composite to master image
+	} else if (generate_images) {
+		 //render a few faces at a time, so that not every face image is in memory at once
+		SphereRenderer renderer(spheremap);
+		for (c=0; c<poly->faces.n; c+=numthreads) {
+			int n=(c+numthreads<=poly->faces.n ? numthreads : poly->faces.n-c);
+			renderer.Render(renders,c,n,numthreads);
+
+			for (int c2=c; c2<c+n; c2++) {
+				Image faceimage(renders[c2].width,renders[c2].height,"RGBA",CharPixel,renders[c2].pixels);
+				faceimage.depth(8);
+				sprintf(filename,"%s%03d.png",filebase,c2);
+				cout <<"writing "<<filename<<"..."<<endl;
+				faceimage.write(filename);
+				delete[] renders[c2].pixels;
+				renders[c2].pixels=NULL;
+			}
 		}
 	}
+	delete[] renders;
+
+	if (output==OUT_IMAGE) {
+		//***composite to master image
+	}
 
 	 //lay out into net!!
 	if (output==OUT_NONE) return 0;
@@ -579,6 +881,9 @@ void InitOptions()
 	options.Add("point-at-pix", 'P',       1, "Just like --point-at-ang, but use pixels of the sphere photo, not degrees. "
 											 "The 4th number if any should be in degrees.", 0, "1,2,3,4" );
 	options.Add("range",        'r',       1, "When generating faces, which to generate. Default is all faces.", 0, "1-4,10" );
+	options.Add("threads",      't',       1, "How many threads to render faces with. Default is one per processor.", 0, "4" );
+	options.Add("legacy-render",'G',       0, "Render faces through GraphicsMagick pixel access, as older versions did. Much slower.", 0, "" );
+	options.Add("benchmark",    'B',       0, "Render faces with both the current and the legacy renderer, print timings, and write nothing.", 0, "" );
 	options.Add("rotate-x",     'X',       1, "Rotate the sphere image around the X axis by this many degrees", 0, "15" );
 	options.Add("rotate-y",     'Y',       1, "Rotate the sphere image around the Y axis by this many degrees", 0, "15" );
 	options.Add("rotate-z",     'Z',       1, "Rotate the sphere image around the Z axis by this many degrees", 0, "15" );
@@ -709,6 +1014,15 @@ int main(int argc,char **argv)
 				AA=strtol(o->arg(),NULL,10);
 				if (AA<0) AA=2;
 			    break;
+			case 't':
+				render_threads=strtol(o->arg(),NULL,10);
+				break;
+			case 'G':
+				legacy_render=1;
+				break;
+			case 'B':
+				benchmark=1;
+				break;
 			case 'X': { //rotate around X
 				if (!extra_basis) extra_basis=new Basis;
 				double angle=strtod(o->arg(),NULL);
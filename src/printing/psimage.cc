@@ -17,6 +17,7 @@
 #include <lax/laximages.h>
 #include "psimage.h"
 #include "psfilters.h"
+#include "../imagecache.h"
 
 #include <iostream>
 using namespace std;
@@ -61,14 +62,25 @@ int psImage(FILE *f,LaxInterfaces::ImageData *img)
 	
 	if (!img || !img->image) return 1;
 
-	unsigned char *buf=img->image->getImageBuffer(); // ARGB
-	if (!buf) return 2;
+	 //file backed images go through the image cache, so full resolution is only decoded for output
+	ImageCache *cache=ImageCache::GetDefault();
+	LaxImage *image=NULL;
+	if (img->filename) image=cache->Full(img->filename);
+	if (!image) { image=img->image; image->inc_count(); }
 
-	int width,height;
-	width =img->image->w();
-	height=img->image->h();
+	unsigned char *buf=image->getImageBuffer(); // ARGB
+	if (!buf) { cache->Release(image); return 2; }
 
-	if (has_alpha(buf, width*height)) { return psImage_masked_interleave1(f, buf,width,height); }
+	int width,height;
+	width =image->w();
+	height=image->h();
+
+	if (has_alpha(buf, width*height)) {
+		int status=psImage_masked_interleave1(f, buf,width,height);
+		image->doneWithBuffer(buf);
+		cache->Release(image);
+		return status;
+	}
 	//if (has_alpha(buf, width*height)) { psImage_103(f,img); return; }
 	
 
@@ -115,7 +127,8 @@ int psImage(FILE *f,LaxInterfaces::ImageData *img)
 	Ascii85_out(f,rgbbuf,len,1,75);
 
 	delete[] rgbbuf;
-	img->image->doneWithBuffer(buf);
+	image->doneWithBuffer(buf);
+	cache->Release(image);
 
 	return 0;
 }
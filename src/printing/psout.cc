@@ -483,7 +483,7 @@ int psout(const char *filename, Laxkit::anObject *context, ErrorLog &log)
 	int p,plandscape;
 	for (c=start; c<=end; c++) {
 		 //get spread if any
-		if (doc) spread=doc->imposition->Layout(layout,c);
+		if (doc) spread=doc->imposition->GetSpread(layout,c);
 		else spread=NULL;
 		 
 		 //get paper description
@@ -603,7 +603,7 @@ int psout(const char *filename, Laxkit::anObject *context, ErrorLog &log)
 					  "\n");		
 			DBG cerr<<"Done printing paper "<<p<<"."<<endl;
 		}
-		if (spread) { delete spread; spread=NULL; }
+		if (spread) { spread->dec_count(); spread=NULL; }
 		delete[] desc; desc=NULL;
 	}
 
@@ -686,7 +686,7 @@ int epsout(const char *filename, Laxkit::anObject *context, ErrorLog &log)
 
 	 // Find bbox
 	 //*** note bbox is not used!!
-	if (doc) spread=doc->imposition->Layout(layout,start);
+	if (doc) spread=doc->imposition->GetSpread(layout,start);
 	bbox.clear();
 	bbox.addtobounds(spread->path);
 	
@@ -818,7 +818,7 @@ int epsout(const char *filename, Laxkit::anObject *context, ErrorLog &log)
 			psPopCtm();
 		}
 
-		delete spread;
+		spread->dec_count();
 	}
 	fprintf(f,"grestore\n");//remove papergroup->paper transform
 	psPopCtm();
@@ -0,0 +1,548 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include <lax/strmanip.h>
+#include <lax/lists.cc>
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+#include "profiler.h"
+#include "configured.h"
+
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+//------------------------------------- allocation counting ------------------------------------
+//
+// When configured with --profile-allocations, the global allocators are replaced so that each
+// profiled scope can report how many allocations happened within it. Otherwise allocation
+// counts are always 0, and allocation is left alone.
+
+static volatile int profile_counting=0;
+static volatile long profile_allocations=0;
+
+#ifdef LAIDOUT_PROFILE_ALLOCATIONS
+
+#if __cplusplus >= 201103L
+#define PROFILE_NEW_THROWS
+#define PROFILE_NOTHROW noexcept
+#else
+#define PROFILE_NEW_THROWS throw(std::bad_alloc)
+#define PROFILE_NOTHROW throw()
+#endif
+
+void *operator new(size_t size) PROFILE_NEW_THROWS
+{
+	if (profile_counting) __sync_fetch_and_add(&profile_allocations,1);
+	void *p=malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) PROFILE_NEW_THROWS
+{
+	if (profile_counting) __sync_fetch_and_add(&profile_allocations,1);
+	void *p=malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) PROFILE_NOTHROW
+{
+	free(p);
+}
+
+void operator delete[](void *p) PROFILE_NOTHROW
+{
+	free(p);
+}
+
+#endif //LAIDOUT_PROFILE_ALLOCATIONS
+
+
+namespace Laidout {
+
+
+//------------------------------------- ProfilePhase ------------------------------------
+/*! \class ProfilePhase
+ * \brief Running totals for all the scopes of one category and name.
+ */
+
+ProfilePhase::ProfilePhase(const char *ncategory, const char *nname)
+{
+	category=newstr(ncategory);
+	name=newstr(nname);
+	count=0;
+	total=self=0;
+	allocs=self_allocs=0;
+	values=self_values=0;
+	next_hashed=NULL;
+}
+
+ProfilePhase::~ProfilePhase()
+{
+	delete[] category;
+	delete[] name;
+}
+
+
+//------------------------------------- ProfileScope ------------------------------------
+/*! \class ProfileScope
+ * \brief Put one on the stack to time the rest of the enclosing block.
+ *
+ * If there is no active Profiler, nname is NULL, or this is not the thread the Profiler
+ * was started from, nothing is recorded. category and name must stay valid until the scope closes, and
+ * are copied when recorded.
+ *
+ * For per object type timing, use category "object" and whattype() for name.
+ * Script functions and methods use category "script".
+ */
+
+ProfileScope::ProfileScope(const char *ncategory, const char *nname)
+{
+	Profiler *profiler=Profiler::active;
+	if (!profiler || !nname || !pthread_equal(profiler->owner,pthread_self())) {
+		category=NULL;
+		return;
+	}
+
+	category=ncategory ? ncategory : "misc";
+	name=nname;
+	child_time=0;
+	child_allocs=0;
+	child_values=0;
+	parent=profiler->current;
+	stack=NULL;
+	profiler->current=this;
+	start_allocs=profile_allocations;
+	start_values=Profiler::values_created;
+	start=Profiler::Now();
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (!category) return;
+
+	double end=Profiler::Now();
+	long end_allocs=profile_allocations;
+	long end_values=Profiler::values_created;
+	Profiler *profiler=Profiler::active;
+	if (!profiler || profiler->current!=this) return; //profiler was replaced while we were open
+
+	profiler->current=parent;
+	profiler->Record(this,end,end_allocs,end_values);
+}
+
+
+//------------------------------------- Profiler ------------------------------------
+/*! \class Profiler
+ * \brief Collect timing and allocation counts for startup, load, save, import and export phases.
+ *
+ * This is off unless LAIDOUT_PROFILE is set in the environment, or --profile is
+ * given on the command line. The results are written to file when the profiler
+ * is removed with SetDefault(NULL), which also happens on exit().
+ *
+ * PROFILE_Summary writes json with total and self (not counting nested scopes) time
+ * and allocations for each phase, and separately for each object type. PROFILE_ChromeTrace
+ * writes every scope as a complete event, suitable for chrome://tracing or Perfetto.
+ * PROFILE_Report writes a plain text table of the same totals as PROFILE_Summary, sorted by
+ * self time. PROFILE_Flamegraph writes self time in microseconds for each distinct stack of
+ * scopes, in the folded format used by flamegraph.pl, inferno, and speedscope.
+ *
+ * Raw allocations are only counted when configured with --profile-allocations.
+ * Besides raw allocations, each scope counts how many script Value objects were created
+ * within it, which Value's constructor reports with ValueCreated().
+ *
+ * A filename of "-" writes to stdout instead of a file.
+ */
+
+Profiler *Profiler::active=NULL;
+volatile long Profiler::values_created=0;
+
+static void profiler_atexit()
+{
+	Profiler::SetDefault(NULL);
+}
+
+//! Replace the active profiler. The old one writes its file, then is deleted.
+void Profiler::SetDefault(Profiler *profiler)
+{
+	if (profiler==active) return;
+
+	static int registered=0;
+	if (profiler && !registered) {
+		atexit(profiler_atexit);
+		registered=1;
+	}
+
+	Profiler *old=active;
+	active=NULL;
+	profile_counting=0;
+	if (old) {
+		old->Write();
+		delete old;
+	}
+
+	active=profiler;
+	if (active) {
+		active->owner=pthread_self();
+		profile_counting=1;
+	}
+}
+
+//! Install a profiler if LAIDOUT_PROFILE is set.
+/*! LAIDOUT_PROFILE is the file to write. LAIDOUT_PROFILE_FORMAT is anything FormatFromString() knows.
+ *
+ * Returns 1 if a profiler was started, else 0.
+ */
+int Profiler::StartFromEnvironment()
+{
+	const char *file=getenv("LAIDOUT_PROFILE");
+	if (!file || !*file) return 0;
+
+	SetDefault(new Profiler(file,FormatFromString(getenv("LAIDOUT_PROFILE_FORMAT"))));
+	return 1;
+}
+
+//! Return a monotonic time in microseconds.
+double Profiler::Now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec*1e6 + t.tv_nsec/1e3;
+}
+
+//! Number of allocations made so far while a profiler was active.
+/*! Always 0 unless configured with --profile-allocations.
+ */
+long Profiler::Allocations()
+{
+	return profile_allocations;
+}
+
+//! Map "json", "chrome", "report", or "flamegraph" (also "folded") to a ProfileFormat.
+/*! Anything else, including NULL, is PROFILE_Summary.
+ */
+ProfileFormat Profiler::FormatFromString(const char *str)
+{
+	if (!str) return PROFILE_Summary;
+	if (!strcasecmp(str,"chrome")) return PROFILE_ChromeTrace;
+	if (!strcasecmp(str,"report")) return PROFILE_Report;
+	if (!strcasecmp(str,"flamegraph") || !strcasecmp(str,"folded")) return PROFILE_Flamegraph;
+	return PROFILE_Summary;
+}
+
+Profiler::Profiler(const char *file, ProfileFormat nformat)
+{
+	filename=newstr(file);
+	format=nformat;
+	owner=pthread_self();
+	origin=Now();
+	current=NULL;
+
+	events=NULL;
+	numevents=maxevents=0;
+
+	phase_table_size=256;
+	phase_table=new ProfilePhase*[phase_table_size];
+	memset(phase_table,0,phase_table_size*sizeof(ProfilePhase*));
+
+	stack_table_size=256;
+	stack_table=new ProfileStack*[stack_table_size];
+	memset(stack_table,0,stack_table_size*sizeof(ProfileStack*));
+}
+
+Profiler::~Profiler()
+{
+	delete[] filename;
+	delete[] events;
+	delete[] phase_table;
+	delete[] stack_table;
+}
+
+static unsigned long profile_hash(const char *category, const char *name)
+{
+	unsigned long h=5381;
+	for ( ; *category; category++) h=h*33+(unsigned char)*category;
+	h=h*33+':';
+	for ( ; *name; name++) h=h*33+(unsigned char)*name;
+	return h;
+}
+
+//! Return the phase for category and name, creating it if necessary.
+/*! This is on every scope exit, so phases are kept in a hash table too. It is doubled
+ * whenever there get to be more phases than slots.
+ */
+ProfilePhase *Profiler::FindPhase(const char *category, const char *name)
+{
+	unsigned long hash=profile_hash(category,name);
+	ProfilePhase *phase=phase_table[hash%phase_table_size];
+	for ( ; phase; phase=phase->next_hashed) {
+		if (!strcmp(phase->name,name) && !strcmp(phase->category,category)) return phase;
+	}
+
+	phase=new ProfilePhase(category,name);
+	phases.push(phase);
+
+	if (phases.n>phase_table_size) {
+		delete[] phase_table;
+		phase_table_size*=2;
+		phase_table=new ProfilePhase*[phase_table_size];
+		memset(phase_table,0,phase_table_size*sizeof(ProfilePhase*));
+		for (int c=0; c<phases.n-1; c++) {
+			ProfilePhase *p=phases.e[c];
+			unsigned long i=profile_hash(p->category,p->name)%phase_table_size;
+			p->next_hashed=phase_table[i];
+			phase_table[i]=p;
+		}
+	}
+
+	unsigned long i=hash%phase_table_size;
+	phase->next_hashed=phase_table[i];
+	phase_table[i]=phase;
+	return phase;
+}
+
+void Profiler::Record(ProfileScope *scope, double end, long end_allocs, long end_values)
+{
+	int oldcounting=profile_counting;
+	profile_counting=0; //don't count our own bookkeeping
+
+	double duration=end-scope->start;
+	long allocs=end_allocs-scope->start_allocs;
+	long values=end_values-scope->start_values;
+
+	ProfilePhase *phase=FindPhase(scope->category,scope->name);
+	phase->count++;
+	phase->total+=duration;
+	phase->self+=duration-scope->child_time;
+	phase->allocs+=allocs;
+	phase->self_allocs+=allocs-scope->child_allocs;
+	phase->values+=values;
+	phase->self_values+=values-scope->child_values;
+
+	if (scope->parent) {
+		scope->parent->child_time+=duration;
+		scope->parent->child_allocs+=allocs;
+		scope->parent->child_values+=values;
+	}
+
+	if (format==PROFILE_Flamegraph) {
+		ProfileStack *stack=StackFor(scope,phase);
+		stack->count++;
+		stack->self+=duration-scope->child_time;
+	}
+
+	if (format==PROFILE_ChromeTrace) {
+		if (numevents==maxevents) {
+			maxevents=(maxevents ? 2*maxevents : 1024);
+			ProfileEvent *nevents=new ProfileEvent[maxevents];
+			if (events) memcpy(nevents,events,numevents*sizeof(ProfileEvent));
+			delete[] events;
+			events=nevents;
+		}
+		ProfileEvent *event=&events[numevents++];
+		event->category=phase->category;
+		event->name=phase->name;
+		event->start=scope->start-origin;
+		event->duration=duration;
+		event->allocs=allocs;
+	}
+
+	profile_counting=oldcounting;
+}
+
+static unsigned long stack_hash(ProfileStack *parent, ProfilePhase *phase)
+{
+	return ((unsigned long)parent>>4)*31 + ((unsigned long)phase>>4);
+}
+
+//! Return the node for the stack of scopes ending in scope, creating it if necessary.
+/*! A stack is identified by its parent stack and the phase of its innermost scope, so no
+ * folded string is built until writing. The result is remembered in the scope, so each open
+ * scope is resolved at most once, however many children it has. phase may be NULL if not known yet.
+ */
+ProfileStack *Profiler::StackFor(ProfileScope *scope, ProfilePhase *phase)
+{
+	if (scope->stack) return scope->stack;
+
+	if (!phase) phase=FindPhase(scope->category,scope->name);
+	ProfileStack *parent=(scope->parent ? StackFor(scope->parent,NULL) : NULL);
+
+	unsigned long hash=stack_hash(parent,phase);
+	ProfileStack *stack=stack_table[hash%stack_table_size];
+	while (stack && (stack->parent!=parent || stack->phase!=phase)) stack=stack->next_hashed;
+
+	if (!stack) {
+		stack=new ProfileStack;
+		stack->parent=parent;
+		stack->phase=phase;
+		stack->count=0;
+		stack->self=0;
+		stacks.push(stack);
+
+		if (stacks.n>stack_table_size) {
+			delete[] stack_table;
+			stack_table_size*=2;
+			stack_table=new ProfileStack*[stack_table_size];
+			memset(stack_table,0,stack_table_size*sizeof(ProfileStack*));
+			for (int c=0; c<stacks.n-1; c++) {
+				ProfileStack *s=stacks.e[c];
+				unsigned long i=stack_hash(s->parent,s->phase)%stack_table_size;
+				s->next_hashed=stack_table[i];
+				stack_table[i]=s;
+			}
+		}
+
+		unsigned long i=hash%stack_table_size;
+		stack->next_hashed=stack_table[i];
+		stack_table[i]=stack;
+	}
+
+	scope->stack=stack;
+	return stack;
+}
+
+//! Write str as a quoted json string.
+static void json_string(FILE *f, const char *str)
+{
+	fputc('"',f);
+	for ( ; *str; str++) {
+		if (*str=='"' || *str=='\\') fprintf(f,"\\%c",*str);
+		else if ((unsigned char)*str<0x20) fprintf(f,"\\u%04x",(unsigned char)*str);
+		else fputc(*str,f);
+	}
+	fputc('"',f);
+}
+
+void Profiler::WriteSummary(FILE *f)
+{
+	fprintf(f,"{\n");
+	for (int type=0; type<2; type++) {
+		 //type 0 is the load/save phases, type 1 the per object type breakdown
+		fprintf(f,"  \"%s\": [",type==0 ? "phases" : "types");
+		int n=0;
+		for (int c=0; c<phases.n; c++) {
+			ProfilePhase *phase=phases.e[c];
+			if ((strcmp(phase->category,"object")==0) != (type==1)) continue;
+
+			fprintf(f,"%s\n    { \"category\": ",n ? "," : "");
+			json_string(f,phase->category);
+			fprintf(f,", \"name\": ");
+			json_string(f,phase->name);
+			fprintf(f,", \"count\": %ld, \"total_ms\": %.3f, \"self_ms\": %.3f, \"allocs\": %ld, \"self_allocs\": %ld,"
+					  " \"values\": %ld, \"self_values\": %ld }",
+					phase->count, phase->total/1000, phase->self/1000, phase->allocs, phase->self_allocs,
+					phase->values, phase->self_values);
+			n++;
+		}
+		fprintf(f,"\n  ]%s\n",type==0 ? "," : "");
+	}
+	fprintf(f,"}\n");
+}
+
+void Profiler::WriteChromeTrace(FILE *f)
+{
+	fprintf(f,"{ \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [");
+	for (long c=0; c<numevents; c++) {
+		ProfileEvent *event=&events[c];
+		fprintf(f,"%s\n    { \"name\": ",c ? "," : "");
+		json_string(f,event->name);
+		fprintf(f,", \"cat\": ");
+		json_string(f,event->category);
+		fprintf(f,", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1, \"args\": { \"allocs\": %ld } }",
+				event->start, event->duration, event->allocs);
+	}
+	fprintf(f,"\n  ]\n}\n");
+}
+
+static int compare_self_time(const void *a, const void *b)
+{
+	double sa=(*(ProfilePhase**)a)->self, sb=(*(ProfilePhase**)b)->self;
+	return sa<sb ? 1 : (sa>sb ? -1 : 0);
+}
+
+void Profiler::WriteReport(FILE *f)
+{
+	if (!phases.n) return;
+
+	ProfilePhase **sorted=new ProfilePhase*[phases.n];
+	memcpy(sorted,phases.e,phases.n*sizeof(ProfilePhase*));
+	qsort(sorted,phases.n,sizeof(ProfilePhase*),compare_self_time);
+
+	fprintf(f,"%12s %12s %10s %10s %10s %10s  %s\n","self ms","total ms","count","allocs","values","self vals","name");
+	for (int c=0; c<phases.n; c++) {
+		ProfilePhase *phase=sorted[c];
+		fprintf(f,"%12.3f %12.3f %10ld %10ld %10ld %10ld  %s:%s\n",
+				phase->self/1000, phase->total/1000, phase->count, phase->allocs, phase->values, phase->self_values,
+				phase->category, phase->name);
+	}
+
+	delete[] sorted;
+}
+
+//! Write the frames of stack outermost first, separated by ';'.
+static void write_folded(FILE *f, ProfileStack *stack)
+{
+	if (stack->parent) {
+		write_folded(f,stack->parent);
+		fputc(';',f);
+	}
+	 //frames are separated by ';', so keep that and spaces out of names
+	for (const char *p=stack->phase->name; *p; p++) fputc(*p==';' || *p==' ' ? '_' : *p, f);
+}
+
+void Profiler::WriteFlamegraph(FILE *f)
+{
+	for (int c=0; c<stacks.n; c++) {
+		write_folded(f,stacks.e[c]);
+		fprintf(f," %.0f\n", stacks.e[c]->self);
+	}
+}
+
+//! Write out what has been collected so far. Returns 0 for success, nonzero for error.
+int Profiler::Write()
+{
+	int usestdout=!strcmp(filename,"-");
+	FILE *f=(usestdout ? stdout : fopen(filename,"w"));
+	if (!f) {
+		cerr <<"Could not open profile file "<<filename<<" for writing!"<<endl;
+		return 1;
+	}
+
+	int oldcounting=profile_counting;
+	profile_counting=0;
+	if (format==PROFILE_ChromeTrace) WriteChromeTrace(f);
+	else if (format==PROFILE_Report) WriteReport(f);
+	else if (format==PROFILE_Flamegraph) WriteFlamegraph(f);
+	else WriteSummary(f);
+	profile_counting=oldcounting;
+
+	if (usestdout) fflush(f);
+	else fclose(f);
+	return 0;
+}
+
+
+} // namespace Laidout
+
@@ -0,0 +1,151 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <lax/lists.h>
+
+#include <cstdio>
+#include <pthread.h>
+
+
+namespace Laidout {
+
+
+enum ProfileFormat {
+	PROFILE_Summary,
+	PROFILE_ChromeTrace,
+	PROFILE_Report,
+	PROFILE_Flamegraph
+};
+
+
+//------------------------------------- ProfilePhase ------------------------------------
+class ProfilePhase
+{
+  public:
+	char *category;
+	char *name;
+	long count;
+	double total;  //microseconds, including nested scopes
+	double self;   //microseconds, not including nested scopes
+	long allocs;
+	long self_allocs;
+	long values;   //script Value objects created
+	long self_values;
+	ProfilePhase *next_hashed; //chain in Profiler::phase_table
+
+	ProfilePhase(const char *ncategory, const char *nname);
+	~ProfilePhase();
+};
+
+
+//------------------------------------- ProfileStack ------------------------------------
+class ProfileStack
+{
+  public:
+	ProfileStack *parent; //NULL for outermost scopes
+	ProfilePhase *phase;
+	long count;
+	double self; //microseconds
+	ProfileStack *next_hashed; //chain in Profiler::stack_table
+};
+
+
+//------------------------------------- ProfileEvent ------------------------------------
+class ProfileEvent
+{
+  public:
+	const char *category; //points to the strings in a ProfilePhase
+	const char *name;
+	double start, duration; //microseconds
+	long allocs;
+};
+
+
+//------------------------------------- ProfileScope ------------------------------------
+class ProfileScope
+{
+	friend class Profiler;
+  protected:
+	const char *category;
+	const char *name;
+	double start;
+	long start_allocs;
+	long start_values;
+	double child_time;
+	long child_allocs;
+	long child_values;
+	ProfileScope *parent;
+	ProfileStack *stack; //for PROFILE_Flamegraph, NULL until needed
+
+  public:
+	ProfileScope(const char *ncategory, const char *nname);
+	~ProfileScope();
+};
+
+
+//------------------------------------- Profiler ------------------------------------
+class Profiler
+{
+	friend class ProfileScope;
+  protected:
+	static Profiler *active;
+	static volatile long values_created;
+
+	char *filename;
+	ProfileFormat format;
+	pthread_t owner;
+	double origin;
+	ProfileScope *current;
+
+	Laxkit::PtrStack<ProfilePhase> phases;
+	ProfilePhase **phase_table; //hashed category:name, for FindPhase()
+	int phase_table_size;
+	Laxkit::PtrStack<ProfileStack> stacks; //for PROFILE_Flamegraph
+	ProfileStack **stack_table; //hashed parent and phase, for StackFor()
+	int stack_table_size;
+	ProfileEvent *events;
+	long numevents, maxevents;
+
+	ProfilePhase *FindPhase(const char *category, const char *name);
+	void Record(ProfileScope *scope, double end, long end_allocs, long end_values);
+	ProfileStack *StackFor(ProfileScope *scope, ProfilePhase *phase);
+	void WriteSummary(FILE *f);
+	void WriteChromeTrace(FILE *f);
+	void WriteReport(FILE *f);
+	void WriteFlamegraph(FILE *f);
+
+  public:
+	static Profiler *GetDefault() { return active; }
+	static void SetDefault(Profiler *profiler);
+	static int StartFromEnvironment();
+	static double Now();
+	static long Allocations();
+	static ProfileFormat FormatFromString(const char *str);
+	static void ValueCreated() { if (active) __sync_fetch_and_add(&values_created,1); }
+
+	Profiler(const char *file, ProfileFormat nformat);
+	~Profiler();
+
+	int Write();
+};
+
+
+} // namespace Laidout
+
+#endif
+
@@ -24,6 +24,8 @@
 #include "headwindow.h"
 #include "laidout.h"
 #include "language.h"
+#include "profiler.h"
+#include "dataobjects/instancedclones.h"
 
 #include <lax/lists.cc>
 
@@ -126,6 +128,7 @@ int Project::Push(Document *doc)
 {
 	if (!doc) return 1;
 	docs.push(new ProjDocument(doc,NULL,NULL));
+	objecttree.Clear();
 	return 0;
 }
 
@@ -156,6 +159,8 @@ Document *Project::Find(const char *name, int howmatch)
  */
 int Project::Pop(Document *doc)
 {
+	objecttree.Clear();
+
 	if (!doc) {
 		if (docs.n) {
 			docs.remove();
@@ -353,6 +358,8 @@ int Project::clear()
  */
 int Project::Load(const char *file,ErrorLog &log)
 {
+	ProfileScope profile("load","Project::Load");
+
 	FILE *f=open_laidout_file_to_read(file,"Project",&log);
 	if (!f) return 1;
 	
@@ -362,7 +369,10 @@ int Project::Load(const char *file,ErrorLog &log)
 
 	char *dir=lax_dirname(filename,0);
 	DumpContext context(dir,1, object_id);
-	dump_in(f,0,0,&context,NULL);
+	{
+		ProfileScope parse("load","parse");
+		dump_in(f,0,0,&context,NULL);
+	}
 	if (!name) makestr(name,filename);
 
 	fclose(f);
@@ -376,6 +386,8 @@ int Project::Load(const char *file,ErrorLog &log)
  */
 int Project::Save(ErrorLog &log)
 {
+	ProfileScope profile("save","Project::Save");
+
 	if (isblank(filename)) {
 		log.AddMessage(_("Cannot save to blank file name."),ERROR_Fail);
 		DBG cerr <<"**** cannot save, filename is null."<<endl;
@@ -474,19 +486,23 @@ int Project::ClarifyAnchors(ErrorLog &log)
  */
 int Project::ClarifyRefs(ErrorLog &log)
 {
-	//need to search in docs->pages, limbos, and papergroup->objs
-	FieldPlace first; first.push(0);
-	FieldPlace place; place=first;
-	anObject *obj=NULL;
+	ProfileScope profile("load","ClarifyRefs");
+
+	 //need to search in docs->pages, limbos, and papergroup->objs.
+	 //Resolving refs does not change the tree, so one snapshot serves for all the lookups
+	ObjectTree *tree=&objecttree;
+	tree->Rebuild(this);
+
+	anObject *obj;
 	SomeDataRef *ref;
 	SomeData *o;
-	int c;
 	int numrefs=0;
 
-	while (1) {
-		DBG cerr <<"refs: "<<(obj?obj->whattype():"(no obj)")<<endl;
+	for (int i=0; i<tree->n(); i++) {
+		obj=tree->e(i)->object;
+		DBG cerr <<"refs: "<<obj->whattype()<<endl;
 
-		if (obj && !strcmp(obj->whattype(),"EngraverFillData")) {
+		if (!strcmp(obj->whattype(),"EngraverFillData")) {
 			EngraverFillData *edata=dynamic_cast<EngraverFillData*>(obj);
 			for (int c=0; c<edata->groups.n; c++) {
 				if (edata->groups.e[c]->trace
@@ -501,7 +517,7 @@ int Project::ClarifyRefs(ErrorLog &log)
 						log.AddMessage(_("Missing clone id!"),ERROR_Warning);
 
 					} else {
-						o=FindObject(ref->thedata_id);
+						o=FindObjectInTree(tree,ref->thedata_id);
 						if (o) {
 							ref->Set(o,1);
 							numrefs++;
@@ -511,10 +527,8 @@ int Project::ClarifyRefs(ErrorLog &log)
 					}
 				}
 			}
-			obj=NULL;
-		}
 
-		if (obj && !strcmp(obj->whattype(),"SomeDataRef")) {
+		} else if (!strcmp(obj->whattype(),"SomeDataRef")) {
 			ref=dynamic_cast<SomeDataRef*>(obj);
 
 			if (ref->thedata) {
@@ -524,7 +538,7 @@ int Project::ClarifyRefs(ErrorLog &log)
 				log.AddMessage(_("Missing clone id!"),ERROR_Warning);
 
 			} else {
-				o=FindObject(ref->thedata_id);
+				o=FindObjectInTree(tree,ref->thedata_id);
 				if (o) {
 					ref->Set(o,1);
 					numrefs++;
@@ -532,12 +546,23 @@ int Project::ClarifyRefs(ErrorLog &log)
 					log.AddMessage(_("Missing clone object!"),ERROR_Warning);
 				}
 			}
-		}
 
-		obj=NULL;
-		c=nextObject(place,0,Next_Increment, &obj);
-		if (c==Next_Error) break;
-		if (first==place) break;
+		} else if (!strcmp(obj->whattype(),"InstancedClones")) {
+			InstancedClones *clones=dynamic_cast<InstancedClones*>(obj);
+
+			for (int c=0; c<clones->NumSources(); c++) {
+				if (clones->Source(c)) continue; //already linked
+
+				o=FindObjectInTree(tree,clones->SourceId(c));
+				if (o) {
+					clones->SetSource(c,o);
+					numrefs++;
+				} else {
+					log.AddMessage(_("Missing clone object!"),ERROR_Warning);
+				}
+			}
+			clones->FindBBox();
+		}
 	}
 
 	ClarifyAnchors(log);
@@ -545,36 +570,57 @@ int Project::ClarifyRefs(ErrorLog &log)
 	return numrefs;
 }
 
+//! Return a flattened snapshot of all objects in the project, rebuilding it if necessary.
+/*! The snapshot is rebuilt if any document or page has been modified since it was
+ * made, or documents were added or removed. Not every edit updates those modtimes, so
+ * anything found in the snapshot should be checked with ObjectTree::Verify() before use.
+ */
+ObjectTree *Project::Tree()
+{
+	bool stale=(objecttree.Root()!=this);
+
+	Document *doc;
+	for (int c=0; !stale && c<docs.n; c++) {
+		doc=docs.e[c]->doc;
+		if (!doc) continue;
+		if (objecttree.IsStale(doc->modtime)) stale=true;
+		for (int p=0; !stale && p<doc->pages.n; p++) {
+			if (objecttree.IsStale(doc->pages.e[p]->modtime)) stale=true;
+		}
+	}
+
+	if (stale) objecttree.Rebuild(this);
+	return &objecttree;
+}
+
+//! Return a verified object in tree whose id is id, or NULL.
+LaxInterfaces::SomeData *Project::FindObjectInTree(ObjectTree *tree, const char *id)
+{
+	int i=-1;
+	SomeData *o;
+	while ((i=tree->FindId(id,i+1))>=0) {
+		if (!tree->Verify(i)) return NULL;
+		o=dynamic_cast<SomeData*>(tree->e(i)->object);
+		if (o && o->Id() && !strcmp(o->Id(),id)) return o;
+	}
+	return NULL;
+}
+
 /*! This is to aid in mapping unresolved references. For arbitrary
  * object location, use the other find.
  */
 LaxInterfaces::SomeData *Project::FindObject(const char *id)
 {
 	//need to search in docs->pages, limbos, and papergroup->objs
-	FieldPlace first; first.push(0);
-	FieldPlace place(first);
-	anObject *obj=NULL;
-	SomeData *o;
-	int c;
-
-	while (1) {
-		if (obj && dynamic_cast<SomeData*>(obj)) {
-			o=dynamic_cast<SomeData*>(obj);
-
-			if (!o || !o->Id()) {
-				//skip if no id to match!
-			} else if (!strcmp(o->Id(),id)) {
-				return o;
-			}
-		}
+	if (!id) return NULL;
 
-		obj=NULL;
-		c=nextObject(place,0,Next_Increment, &obj);
-		if (c==Next_Error) break;
-		if (first==place) break;
-	}
+	ObjectTree *tree=Tree();
+	SomeData *o=FindObjectInTree(tree,id);
+	if (o) return o;
 
-	return NULL;
+	 //snapshot might be out of date, so try once more from scratch
+	tree->Rebuild(this);
+	return FindObjectInTree(tree,id);
 }
 
 /*! Find an object, and put its path in found.
@@ -590,27 +636,19 @@ LaxInterfaces::SomeData *Project::FindObject(const char *id)
 int Project::FindObject(LaxInterfaces::SomeData *data, FieldPlace &found)
 {
 	found.flush();
+	if (!data) return 0;
 
 	//need to search in docs->pages, limbos, and papergroup->objs
-	FieldPlace first; first.push(0);
-	FieldPlace place(first);
-	anObject *obj=NULL;
-	SomeData *o;
-	int c;
-
-	while (1) {
-		if (obj && dynamic_cast<SomeData*>(obj)) {
-			o=dynamic_cast<SomeData*>(obj);
-			if (o==data) {
-				found=place;
-				return place.n();
-			}
+	ObjectTree *tree=Tree();
+	for (int pass=0; pass<2; pass++) {
+		int i=tree->Find(data);
+		if (i>=0 && tree->Verify(i)) {
+			tree->Place(i,found);
+			return found.n();
 		}
 
-		obj=NULL;
-		c=nextObject(place,0,Next_Increment, &obj);
-		if (c==Next_Error) break;
-		if (first==place) break;
+		 //snapshot might be out of date, so try once more from scratch
+		if (pass==0) tree->Rebuild(this);
 	}
 
 	return 0;
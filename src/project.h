@@ -20,6 +20,7 @@
 #include "document.h"
 #include "papersizes.h"
 #include "plaintext.h"
+#include "dataobjects/objecttree.h"
 
 
 namespace Laidout {
@@ -40,6 +41,9 @@ class ProjDocument
 //------------------------- Project ------------------------------------
 class Project : public LaxFiles::DumpUtility, public ObjectContainer
 {
+  protected:
+	ObjectTree objecttree;
+
   public:
 	char *name,*filename,*dir;
 	double defaultdpi;
@@ -74,6 +78,8 @@ class Project : public LaxFiles::DumpUtility, public ObjectContainer
 	virtual int ClarifyAnchors(Laxkit::ErrorLog &log);
 	virtual LaxInterfaces::SomeData *FindObject(const char *id);
 	virtual int FindObject(LaxInterfaces::SomeData *data, FieldPlace &found);
+	virtual ObjectTree *Tree();
+	virtual LaxInterfaces::SomeData *FindObjectInTree(ObjectTree *tree, const char *id);
 
 	 //from ObjectContainer:
 	virtual int n();
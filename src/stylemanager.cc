@@ -16,6 +16,10 @@
 
 
 #include "stylemanager.h"
+#include "api/functions.h"
+#include "language.h"
+#include "laidout.h"
+#include "profiler.h"
 
 #include <iostream>
 using namespace std;
@@ -30,6 +34,47 @@ namespace Laidout {
 //StyleManager no longer used, use CalculatorModule instead
 
 
+//------------------------------ LaidoutNamespace -------------------------------
+
+/*! \class LaidoutNamespace
+ * The global namespace, stylemanager, which holds the ObjectDefs of everything scriptable.
+ *
+ * The builtin functions and definitions from InitFunctions() and InitObjectDefinitions()
+ * are only added on first lookup, or when the calculator is made, so runs that never
+ * look anything up, such as exporting from the command line with no scripting, skip them.
+ */
+
+LaidoutNamespace::LaidoutNamespace()
+  : ObjectDef(NULL,"Laidout",_("Laidout"),_("Global Laidout namespace"),"namespace",NULL,NULL)
+{
+	initialized=0;
+}
+
+//! Add the builtin functions and definitions, if not done already.
+/*! Returns 0 for added now, -1 for already added, or 1 for too early,
+ * since the "laidout" variable needs the application to exist.
+ */
+int LaidoutNamespace::Initialize()
+{
+	if (initialized) return -1;
+	if (!laidout) return 1;
+	initialized=1; //before adding, since making the defs looks up other defs
+
+	DBG cerr<<"---install functions"<<endl;
+	ProfileScope scope("startup","functions");
+	InitFunctions();
+	InitObjectDefinitions();
+	return 0;
+}
+
+//! Make sure the builtins are there, then look up as usual.
+ObjectDef *LaidoutNamespace::FindDef(const char *objectdef, int len, int which)
+{
+	if (!initialized) Initialize();
+	return ObjectDef::FindDef(objectdef,len,which);
+}
+
+
 
 } //namespace Laidout
 
@@ -22,9 +22,22 @@
 namespace Laidout {
 
 
+//------------------------------ LaidoutNamespace -------------------------------
+
+class LaidoutNamespace : public ObjectDef
+{
+  protected:
+	int initialized;
+
+  public:
+	LaidoutNamespace();
+	virtual ObjectDef *FindDef(const char *objectdef, int len=-1, int which=0);
+	virtual int Initialize();
+};
+
 
 #ifndef LAIDOUT_CC
-extern ObjectDef stylemanager;
+extern LaidoutNamespace stylemanager;
 #endif
 
 
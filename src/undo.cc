@@ -0,0 +1,488 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include <lax/strmanip.h>
+#include <lax/attributes.h>
+#include <lax/dump.h>
+#include <lax/transformmath.h>
+
+#include "undo.h"
+#include "document.h"
+#include "language.h"
+
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+using namespace Laxkit;
+using namespace LaxFiles;
+using namespace LaxInterfaces;
+
+
+namespace Laidout {
+
+
+//------------------------------------- UndoEntry ------------------------------------
+/*! \class UndoEntry
+ * \brief Base class for one undoable change held in an UndoHistory.
+ *
+ * Subclasses should store only what is needed to go between the before and after
+ * states, not whole copies of objects, so that the cost of undo is proportional to the edit.
+ */
+
+UndoEntry::UndoEntry()
+{
+	group=0;
+	time=times(NULL);
+	prev=next=NULL;
+}
+
+UndoEntry::~UndoEntry()
+{
+}
+
+
+//------------------------------------- TransformUndo ------------------------------------
+/*! \class TransformUndo
+ * \brief Undo for a change of an object's transform, which is just two matrices.
+ */
+
+/*! If new_transform==NULL, then use obj->m().
+ */
+TransformUndo::TransformUndo(SomeData *obj, const double *old_transform, const double *new_transform)
+{
+	object=obj;
+	if (object) object->inc_count();
+	transform_copy(oldm,old_transform);
+	transform_copy(newm,new_transform ? new_transform : obj->m());
+}
+
+TransformUndo::~TransformUndo()
+{
+	if (object) object->dec_count();
+}
+
+const char *TransformUndo::Description()
+{
+	return _("Transform");
+}
+
+long TransformUndo::Size()
+{
+	return sizeof(TransformUndo);
+}
+
+int TransformUndo::Undo()
+{
+	object->m(oldm);
+	return 0;
+}
+
+int TransformUndo::Redo()
+{
+	object->m(newm);
+	return 0;
+}
+
+
+//------------------------------------- ObjectDeltaUndo ------------------------------------
+/*! \class ObjectDeltaUndo
+ * \brief Undo for arbitrary changes to an object, stored as a delta of its serialized form.
+ *
+ * This is for things like path and mesh edits, where the object may be huge but an edit
+ * usually touches only a small part of it. Before editing, call Serialize() on the object.
+ * After the edit, construct one of these with that text. Only the bytes between the longest
+ * common prefix and suffix of the before and after states are kept.
+ *
+ * Undoing and redoing serializes the current object, splices in the other middle, and
+ * reads the result back in with dump_in_atts(). If the object has been changed by
+ * something outside the history in the meantime, the splice will not line up, and
+ * Undo() or Redo() fails rather than corrupting the object.
+ */
+
+//! Return a new char[] of obj dumped out, with its length in len_ret.
+char *ObjectDeltaUndo::Serialize(SomeData *obj, long *len_ret)
+{
+	char *buffer=NULL;
+	size_t len=0;
+	FILE *f=open_memstream(&buffer,&len);
+	if (!f) { *len_ret=0; return NULL; }
+
+	DumpContext context(NULL,1,0);
+	obj->dump_out(f,0,0,&context);
+	fclose(f);
+
+	char *str=new char[len+1];
+	memcpy(str,buffer,len);
+	str[len]='\0';
+	free(buffer);
+
+	*len_ret=len;
+	return str;
+}
+
+/*! before is the result of a Serialize() on obj before the edit.
+ */
+ObjectDeltaUndo::ObjectDeltaUndo(SomeData *obj, const char *before, long beforelen, const char *ndesc)
+{
+	object=obj;
+	if (object) object->inc_count();
+	description=newstr(ndesc ? ndesc : _("Edit object"));
+
+	long afterlen=0;
+	char *after=Serialize(obj,&afterlen);
+
+	long maxcommon=(beforelen<afterlen ? beforelen : afterlen);
+	prefix=0;
+	while (prefix<maxcommon && before[prefix]==after[prefix]) prefix++;
+	suffix=0;
+	while (suffix<maxcommon-prefix && before[beforelen-1-suffix]==after[afterlen-1-suffix]) suffix++;
+
+	oldlen=beforelen-prefix-suffix;
+	newlen=afterlen -prefix-suffix;
+	oldmiddle=new char[oldlen+1];
+	newmiddle=new char[newlen+1];
+	memcpy(oldmiddle,before+prefix,oldlen); oldmiddle[oldlen]='\0';
+	memcpy(newmiddle,after +prefix,newlen); newmiddle[newlen]='\0';
+
+	delete[] after;
+}
+
+ObjectDeltaUndo::~ObjectDeltaUndo()
+{
+	if (object) object->dec_count();
+	delete[] description;
+	delete[] oldmiddle;
+	delete[] newmiddle;
+}
+
+long ObjectDeltaUndo::Size()
+{
+	return sizeof(ObjectDeltaUndo)+oldlen+newlen+2+strlen(description)+1;
+}
+
+/*! Object should currently have from in the middle. Replace with to.
+ * Returns 0 for success, or 1 for object is not in the expected state.
+ */
+int ObjectDeltaUndo::Apply(const char *from, long fromlen, const char *to, long tolen)
+{
+	long curlen=0;
+	char *cur=Serialize(object,&curlen);
+	if (!cur) return 1;
+	if (curlen!=prefix+fromlen+suffix || memcmp(cur+prefix,from,fromlen)) {
+		DBG cerr <<" *** ObjectDeltaUndo: object "<<object->object_id<<" changed outside of undo history!"<<endl;
+		delete[] cur;
+		return 1;
+	}
+
+	long len=prefix+tolen+suffix;
+	char *text=new char[len+1];
+	memcpy(text,cur,prefix);
+	memcpy(text+prefix,to,tolen);
+	memcpy(text+prefix+tolen,cur+curlen-suffix,suffix);
+	text[len]='\0';
+	delete[] cur;
+
+	FILE *f=fmemopen(text,len,"r");
+	if (!f) { delete[] text; return 1; }
+	Attribute att;
+	att.dump_in(f,0,NULL);
+	fclose(f);
+	delete[] text;
+
+	DumpContext context(NULL,1,0);
+	object->dump_in_atts(&att,0,&context);
+	object->FindBBox();
+	return 0;
+}
+
+int ObjectDeltaUndo::Undo()
+{
+	return Apply(newmiddle,newlen, oldmiddle,oldlen);
+}
+
+int ObjectDeltaUndo::Redo()
+{
+	return Apply(oldmiddle,oldlen, newmiddle,newlen);
+}
+
+
+//------------------------------------- PageUndo ------------------------------------
+/*! \class PageUndo
+ * \brief Undo for adding or removing pages in a Document.
+ *
+ * This holds references to the pages themselves, so removed pages are kept around
+ * exactly as they were, without copying any of their contents.
+ * Construct after pages are added, or before pages are removed, so that the pages
+ * are at [nstart,nstart+nn) in ndoc.
+ *
+ * This should only go in ndoc's own history, see Document::GetUndoHistory(), so ndoc is not
+ * inc_count()'d. Otherwise the document would keep itself alive.
+ */
+
+PageUndo::PageUndo(Document *ndoc, int nadded, int nstart, int nn)
+{
+	doc=ndoc;
+	added=nadded;
+	start=nstart;
+	n=nn;
+	pages=new Page*[n];
+	for (int c=0; c<n; c++) {
+		pages[c]=doc->pages.e[start+c];
+		pages[c]->inc_count();
+	}
+}
+
+PageUndo::~PageUndo()
+{
+	for (int c=0; c<n; c++) pages[c]->dec_count();
+	delete[] pages;
+}
+
+const char *PageUndo::Description()
+{
+	return added ? _("Add pages") : _("Remove pages");
+}
+
+long PageUndo::Size()
+{
+	return sizeof(PageUndo)+n*sizeof(Page*);
+}
+
+int PageUndo::Undo()
+{
+	if (added) return doc->RemovePages(start,n)==n ? 0 : 1;
+	return doc->InsertPages(start,pages,n)==n ? 0 : 1;
+}
+
+int PageUndo::Redo()
+{
+	if (added) return doc->InsertPages(start,pages,n)==n ? 0 : 1;
+	return doc->RemovePages(start,n)==n ? 0 : 1;
+}
+
+
+//------------------------------------- UndoHistory ------------------------------------
+/*! \class UndoHistory
+ * \brief Linear undo and redo of document edits, kept within a memory budget.
+ *
+ * Each entry reports its own Size(). When adding an entry puts the history over Budget(),
+ * the oldest groups of entries are discarded. The most recent group is always kept, even
+ * if by itself it is larger than the budget.
+ *
+ * While undoing or redoing, Replaying() is true and Add() refuses new entries, so code that
+ * records its own changes, such as Document::NewPages(), does not need to know whether
+ * it is being called from here.
+ *
+ * Each Document has its own history, see Document::GetUndoHistory(), so that closing a document
+ * frees everything its undos refer to. GetDefault() is for edits outside of any document.
+ */
+
+
+static UndoHistory *default_undo_history=NULL;
+
+//! Budget in bytes for new histories that are not given one. Set from laidoutrc's undoMegabytes.
+long UndoHistory::default_budget=32*1024*1024;
+
+//! Return the history for edits not in any document, creating one if necessary.
+UndoHistory *UndoHistory::GetDefault()
+{
+	if (!default_undo_history) default_undo_history=new UndoHistory();
+	return default_undo_history;
+}
+
+//! Replace the default history. Pass NULL to just remove the old one.
+void UndoHistory::SetDefault(UndoHistory *history)
+{
+	if (history==default_undo_history) return;
+	if (default_undo_history) default_undo_history->dec_count();
+	default_undo_history=history;
+	if (history) history->inc_count();
+}
+
+/*! If budget_bytes<0, use default_budget.
+ */
+UndoHistory::UndoHistory(long budget_bytes)
+{
+	first=last=current=NULL;
+	budget=(budget_bytes<0 ? default_budget : budget_bytes);
+	bytes_used=0;
+	num_entries=0;
+	group_counter=0;
+	open_group=0;
+	group_depth=0;
+	replaying=0;
+}
+
+UndoHistory::~UndoHistory()
+{
+	Flush();
+}
+
+//! Set a new budget in bytes, discarding old entries as necessary.
+long UndoHistory::Budget(long nbudget)
+{
+	budget=nbudget;
+	Enforce();
+	return budget;
+}
+
+//! Remove and delete all entries after entry, or all entries if entry==NULL.
+void UndoHistory::DeleteAfter(UndoEntry *entry)
+{
+	UndoEntry *e=(entry ? entry->next : first), *next;
+	if (entry) entry->next=NULL; else first=NULL;
+	last=entry;
+
+	while (e) {
+		next=e->next;
+		bytes_used-=e->Size();
+		num_entries--;
+		delete e;
+		e=next;
+	}
+}
+
+//! Discard oldest groups until within budget. Only entries that are currently done are discarded.
+void UndoHistory::Enforce()
+{
+	while (bytes_used>budget && first && current && first->group!=last->group) {
+		unsigned long g=first->group;
+		while (first && first->group==g) {
+			UndoEntry *e=first;
+			first=e->next;
+			if (first) first->prev=NULL; else last=NULL;
+			if (current==e) current=NULL;
+			bytes_used-=e->Size();
+			num_entries--;
+			DBG cerr <<"UndoHistory discarding "<<e->Description()<<", "<<e->Size()<<" bytes"<<endl;
+			delete e;
+		}
+		if (!current) break; //everything remaining is redo
+	}
+}
+
+//! Start a group of entries to be undone together. Groups can nest, only the outermost matters.
+unsigned long UndoHistory::BeginGroup()
+{
+	if (group_depth==0) open_group=++group_counter;
+	group_depth++;
+	return open_group;
+}
+
+void UndoHistory::EndGroup()
+{
+	if (group_depth>0) group_depth--;
+}
+
+//! Take possession of entry, and make it the most recent thing to undo.
+/*! Anything that was undone is no longer redoable.
+ * If we are in the middle of an undo or redo, entry is deleted, and 1 is returned.
+ * Otherwise returns 0.
+ */
+int UndoHistory::Add(UndoEntry *entry)
+{
+	if (!entry) return 1;
+	if (replaying) { delete entry; return 1; }
+
+	DeleteAfter(current);
+
+	entry->group=(group_depth>0 ? open_group : ++group_counter);
+	entry->prev=last;
+	entry->next=NULL;
+	if (last) last->next=entry; else first=entry;
+	last=current=entry;
+
+	bytes_used+=entry->Size();
+	num_entries++;
+	Enforce();
+	return 0;
+}
+
+//! Return whether an entry for obj has been added since Marker() returned since_marker.
+/*! Entries that have been undone do not count.
+ */
+bool UndoHistory::Recorded(LaxInterfaces::SomeData *obj, unsigned long since_marker)
+{
+	for (UndoEntry *e=current; e && e->group>since_marker; e=e->prev) {
+		if (e->Object()==obj) return true;
+	}
+	return false;
+}
+
+//! Undo the most recent group. Returns 0 for success, or nonzero for nothing to undo or error.
+int UndoHistory::Undo()
+{
+	if (!current) return 1;
+
+	int status=0;
+	unsigned long g=current->group;
+	replaying++;
+	while (current && current->group==g) {
+		if (current->Undo()!=0) status=2;
+		current=current->prev;
+	}
+	replaying--;
+	return status;
+}
+
+//! Redo the next group. Returns 0 for success, or nonzero for nothing to redo or error.
+int UndoHistory::Redo()
+{
+	UndoEntry *e=(current ? current->next : first);
+	if (!e) return 1;
+
+	int status=0;
+	unsigned long g=e->group;
+	replaying++;
+	while (e && e->group==g) {
+		if (e->Redo()!=0) status=2;
+		current=e;
+		e=e->next;
+	}
+	replaying--;
+	return status;
+}
+
+//! Remove all entries.
+void UndoHistory::Flush()
+{
+	DeleteAfter(NULL);
+	current=NULL;
+	bytes_used=0;
+	num_entries=0;
+}
+
+//! Output memory use of the history, and of each entry, oldest first.
+void UndoHistory::DumpStats(FILE *f, int indent)
+{
+	char spc[indent+1]; memset(spc,' ',indent); spc[indent]='\0';
+
+	fprintf(f,"%sbudget   %ld\n",spc,budget);
+	fprintf(f,"%sused     %ld\n",spc,bytes_used);
+	fprintf(f,"%sentries  %d\n", spc,num_entries);
+	for (UndoEntry *e=first; e; e=e->next) {
+		fprintf(f,"%s  %c group %-5lu %8ld bytes  %s\n", spc,
+				e==current ? '>' : ' ', e->group, e->Size(), e->Description());
+	}
+}
+
+
+} // namespace Laidout
+
@@ -0,0 +1,168 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef UNDO_H
+#define UNDO_H
+
+#include <lax/anobject.h>
+#include <lax/interfaces/somedata.h>
+
+#include <cstdio>
+#include <sys/times.h>
+
+
+namespace Laidout {
+
+
+class Document;
+class Page;
+
+
+//------------------------------------- UndoEntry ------------------------------------
+class UndoEntry
+{
+  public:
+	unsigned long group; //entries with the same group are undone and redone together
+	clock_t time; //wall clock time when made, from times()
+	UndoEntry *prev, *next;
+
+	UndoEntry();
+	virtual ~UndoEntry();
+	virtual LaxInterfaces::SomeData *Object() { return NULL; } //the object this changes, if any
+	virtual const char *Description() = 0;
+	virtual long Size() = 0; //bytes held by this entry, not counting shared objects
+	virtual int Undo() = 0;
+	virtual int Redo() = 0;
+};
+
+
+//------------------------------------- TransformUndo ------------------------------------
+class TransformUndo : public UndoEntry
+{
+  public:
+	LaxInterfaces::SomeData *object;
+	double oldm[6], newm[6];
+
+	TransformUndo(LaxInterfaces::SomeData *obj, const double *old_transform, const double *new_transform);
+	virtual ~TransformUndo();
+	virtual LaxInterfaces::SomeData *Object() { return object; }
+	virtual const char *Description();
+	virtual long Size();
+	virtual int Undo();
+	virtual int Redo();
+};
+
+
+//------------------------------------- ObjectDeltaUndo ------------------------------------
+class ObjectDeltaUndo : public UndoEntry
+{
+  protected:
+	int Apply(const char *from, long fromlen, const char *to, long tolen);
+
+  public:
+	LaxInterfaces::SomeData *object;
+	char *description;
+	long prefix;       //length of unchanged start of the serialized object
+	long suffix;       //length of unchanged end of the serialized object
+	char *oldmiddle;   //what was in between before the edit
+	long oldlen;
+	char *newmiddle;   //what is in between after the edit
+	long newlen;
+
+	static char *Serialize(LaxInterfaces::SomeData *obj, long *len_ret);
+
+	ObjectDeltaUndo(LaxInterfaces::SomeData *obj, const char *before, long beforelen, const char *ndesc);
+	virtual ~ObjectDeltaUndo();
+	virtual LaxInterfaces::SomeData *Object() { return object; }
+	virtual const char *Description() { return description; }
+	virtual long Size();
+	virtual int Undo();
+	virtual int Redo();
+	virtual bool IsEmpty() { return oldlen==0 && newlen==0; }
+};
+
+
+//------------------------------------- PageUndo ------------------------------------
+class PageUndo : public UndoEntry
+{
+  public:
+	Document *doc; //not counted, since the history this is in belongs to doc
+	int added; //1 for the pages were added, 0 for removed
+	int start;
+	int n;
+	Page **pages; //references to the actual pages, not copies
+
+	PageUndo(Document *ndoc, int nadded, int nstart, int nn);
+	virtual ~PageUndo();
+	virtual const char *Description();
+	virtual long Size();
+	virtual int Undo();
+	virtual int Redo();
+};
+
+
+//------------------------------------- UndoHistory ------------------------------------
+class UndoHistory : public Laxkit::anObject
+{
+  protected:
+	UndoEntry *first, *last; //oldest and newest entries
+	UndoEntry *current;      //most recent entry that has been done, NULL if all are undone
+	long budget;
+	long bytes_used;
+	int num_entries;
+	unsigned long group_counter;
+	unsigned long open_group;
+	int group_depth;
+	int replaying;
+
+	void DeleteAfter(UndoEntry *entry);
+	void Enforce();
+
+  public:
+	static long default_budget;
+	static UndoHistory *GetDefault();
+	static void SetDefault(UndoHistory *history);
+
+	UndoHistory(long budget_bytes=-1);
+	virtual ~UndoHistory();
+	virtual const char *whattype() { return "UndoHistory"; }
+
+	virtual long Budget() { return budget; }
+	virtual long Budget(long nbudget);
+	virtual long BytesUsed() { return bytes_used; }
+	virtual int NumEntries() { return num_entries; }
+
+	virtual int Add(UndoEntry *entry);
+	virtual unsigned long BeginGroup();
+	virtual void EndGroup();
+	virtual bool Replaying() { return replaying>0; }
+	virtual bool Recording() { return replaying==0; }
+	virtual unsigned long Marker() { return group_counter; }
+	virtual bool Recorded(LaxInterfaces::SomeData *obj, unsigned long since_marker);
+
+	virtual int Undo();
+	virtual int Redo();
+	virtual bool CanUndo() { return current!=NULL; }
+	virtual bool CanRedo() { return current ? current->next!=NULL : first!=NULL; }
+	virtual void Flush();
+
+	virtual void DumpStats(FILE *f, int indent);
+};
+
+
+} // namespace Laidout
+
+#endif
+
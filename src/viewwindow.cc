@@ -54,6 +54,7 @@
 #include "laidout.h"
 #include "newdoc.h"
 #include "importimage.h"
+#include "undo.h"
 #include "drawdata.h"
 #include "helpwindow.h"
 #include "configured.h"
@@ -484,6 +485,13 @@ LaidoutViewport::LaidoutViewport(Document *newdoc)
 	current_edit_area=-1; //which aspect of a drawable object we are working on.. -1 means curobj is not DrawableObject
 	edit_area_icon=NULL;
 
+	undo_obj=NULL;
+	undo_history=NULL;
+	undo_marker=0;
+	undo_before=NULL;
+	undo_beforelen=0;
+	undo_inedit=0;
+
 	
 	viewmode=-1;
 	SetViewMode(PAGELAYOUT,-1);
@@ -509,7 +517,9 @@ LaidoutViewport::~LaidoutViewport()
 {
 	DBG cerr <<"in LaidoutViewport destructor, obj "<<object_id<<endl;
 
-	if (spread) delete spread;
+	CommitObjectUndo();
+
+	if (spread) spread->dec_count();
 	if (papergroup) papergroup->dec_count();
 
 	if (limbo) limbo->dec_count();
@@ -539,6 +549,7 @@ int LaidoutViewport::UseThisDoc(Document *ndoc)
 {
 	if (doc==ndoc) return 0;
 
+	CommitObjectUndo();
 	curpage=NULL;
 
 	if (doc) doc->dec_count();
@@ -674,7 +685,7 @@ int LaidoutViewport::Event(const Laxkit::EventData *data,const char *mes)
 			}
 			curobj.set(NULL, 1, 0); //setting to Limbo
 			clearCurobj();
-			delete spread;
+			spread->dec_count();
 			spread=NULL;
 			if (papergroup && !isDefaultPapergroup(1)) { papergroup->dec_count(); papergroup=NULL; }
 			//spreadi=-1;
@@ -1171,7 +1182,7 @@ void LaidoutViewport::setupthings(int tospread, int topage)//tospread=-1
 	}
 
 	if (spread) { 
-		delete spread;
+		spread->dec_count();
 		spread=NULL; 
 		spreadi=-1;
 	} 
@@ -1179,7 +1190,7 @@ void LaidoutViewport::setupthings(int tospread, int topage)//tospread=-1
 	DBG cerr <<"LaidoutViewport::setupthings:  viewmode="<<viewmode<<"  tospread="<<tospread<<endl;
 	 // retrieve the proper spread according to viewmode
 	if (!spread && tospread>=0 && doc && doc->imposition) {
-		spread=doc->imposition->Layout(viewmode,tospread);
+		spread=doc->imposition->GetSpread(viewmode,tospread);
 		spreadi=tospread;
 		if (!papergroup && spread->papergroup) {
 			papergroup=spread->papergroup;
@@ -1923,6 +1934,12 @@ void LaidoutViewport::setCurobj(VObjContext *voc)
 	if (voc) {
 		curobj=*voc;//incs voc->obj count, decs old curobj.obj
 	}
+	if (curobj.obj!=undo_obj) {
+		 //a different object may be selected in the middle of a press, as in click-and-drag,
+		 //so snapshot it now, before the tool gets to change it
+		CommitObjectUndo();
+		if (undo_inedit) SnapshotObjectUndo();
+	}
 
 	FieldPlace place; 
 	place=curobj.context;
@@ -1952,6 +1969,57 @@ void LaidoutViewport::setCurobj(VObjContext *voc)
 	}
 }
 
+//! Return the history that edits in this viewport go to, which is the document's if there is one.
+UndoHistory *LaidoutViewport::GetUndoHistory()
+{
+	return doc ? doc->GetUndoHistory() : UndoHistory::GetDefault();
+}
+
+//! Add an undo entry for any changes to the object that was current, since SnapshotObjectUndo().
+/*! Only the changed part of the object's serialized form is stored. See ObjectDeltaUndo.
+ *
+ * If something else, such as NUpInterface or AlignInterface, has recorded its own undo for the
+ * object in the meantime, then nothing is added, since that would be the same edit twice.
+ */
+void LaidoutViewport::CommitObjectUndo()
+{
+	if (!undo_obj) return;
+
+	if (undo_history->Recording() && !undo_history->Recorded(undo_obj,undo_marker)) {
+		ObjectDeltaUndo *entry=new ObjectDeltaUndo(undo_obj, undo_before,undo_beforelen, NULL);
+		if (entry->IsEmpty()) delete entry;
+		else undo_history->Add(entry);
+	}
+
+	undo_obj->dec_count();
+	undo_obj=NULL;
+	undo_history->dec_count();
+	undo_history=NULL;
+	delete[] undo_before;
+	undo_before=NULL;
+	undo_beforelen=0;
+}
+
+//! Remember the current state of curobj.obj if not done already, so that changes to it can be undone.
+/*! This is called on input that might change curobj, rather than whenever curobj changes, so that
+ * just selecting objects does not serialize each one. The matching CommitObjectUndo() happens when
+ * that input is done (LBUp, or after a key is handled), so each edit gets its own undo entry, in
+ * the same order as any other undo entries made during it.
+ */
+void LaidoutViewport::SnapshotObjectUndo()
+{
+	if (undo_obj && undo_obj==curobj.obj) return;
+	CommitObjectUndo();
+	if (!curobj.obj) return;
+
+	undo_obj=curobj.obj;
+	undo_obj->inc_count();
+	undo_history=GetUndoHistory();
+	undo_history->inc_count();
+	undo_marker=undo_history->Marker();
+	undo_before=ObjectDeltaUndo::Serialize(undo_obj,&undo_beforelen);
+}
+
 /*! Strip down curobj so that it points to only a context, not an object. Calls dec_count() on the old object if any.
  * Note that selection is not modified.
  */
@@ -1983,6 +2051,8 @@ int LaidoutViewport::LBDown(int x,int y,unsigned int state,int count,const Laxki
 		MouseMove(x,y,state,mouse);
 		return 0;
 	}
+	undo_inedit=1; //until LBUp
+	SnapshotObjectUndo();
 	return ViewportWindow::LBDown(x,y,state,count,mouse);
 }
 
@@ -1995,7 +2065,10 @@ int LaidoutViewport::LBUp(int x,int y,unsigned int state,const Laxkit::LaxMouse
 		const_cast<LaxMouse*>(mouse)->setMouseShape(this,0);
 		return 0;
 	}
-	return ViewportWindow::LBUp(x,y,state,mouse);
+	int status=ViewportWindow::LBUp(x,y,state,mouse);
+	undo_inedit=0;
+	CommitObjectUndo();
+	return status;
 }
 
 //! *** for debugging, show which page mouse is over..
@@ -2842,8 +2915,16 @@ Laxkit::ShortcutHandler *LaidoutViewport::GetShortcuts()
 int LaidoutViewport::PerformAction(int action)
 {
 	if (action==VIEWPORT_Undo || action==VIEWPORT_Redo) {
-		ViewportWindow::PerformAction(action);
+		 //make sure any pending edit to curobj is undoable first
+		CommitObjectUndo();
+
+		UndoHistory *undo=GetUndoHistory();
+		int status=(action==VIEWPORT_Undo ? undo->Undo() : undo->Redo());
+		if (status==1) ViewportWindow::PerformAction(action); //nothing in our history, let Laxkit try
+		else if (status!=0) postmessage(action==VIEWPORT_Undo ? _("Could not undo!") : _("Could not redo!"));
+
 		laidout->notifyDocTreeChanged(NULL,TreeObjectRepositioned,0,0);
+		needtodraw=1;
 		return 0;
 
 	} else if (action==LOV_DeselectAll) {
@@ -3063,8 +3144,16 @@ int LaidoutViewport::CharInput(unsigned int ch,const char *buffer,int len,unsign
 		return 0;
 	}
 
+	 //keys might edit curobj
+	int inedit=undo_inedit;
+	undo_inedit=1;
+	SnapshotObjectUndo();
+
 	 // ask interfaces, and default viewport stuff, which queries all action based activity.
-	if (ViewportWindow::CharInput(ch,buffer,len,state,d)==0) return 0;
+	int status=ViewportWindow::CharInput(ch,buffer,len,state,d);
+	undo_inedit=inedit;
+	if (!inedit) CommitObjectUndo(); //else a drag is still going, and LBUp commits
+	if (status==0) return 0;
 
 	DBG // ******** vvvvvvvv  for debugging objecttreewindow:
 	if (laidout->experimental && ch=='O' && (state&LAX_STATE_MASK)==(ShiftMask|ControlMask)) {
@@ -3670,17 +3759,17 @@ void ViewWindow::dump_in_atts(Attribute *att,int flag,LaxFiles::DumpContext *con
 
 
 //! Called from constructors, configure the viewport.
-/*! Adds local copies of all the interfaces in laidout->interfacepool.
+/*! Adds local copies of all the interfaces in laidout->InterfacePool().
  */
 void ViewWindow::setup()
 {
 	if (viewport) viewport->dp->NewBG(rgbcolor(255,255,255));
 
 	int i=-1;
-	for (int c=0; c<laidout->interfacepool.n; c++) {
-		if (!strcmp(laidout->interfacepool.e[c]->whattype(),"PageMarkerInterface"))
-			i=laidout->interfacepool.e[c]->id;
-		AddTool(laidout->interfacepool.e[c]->duplicate(NULL),0,1);
+	for (int c=0; c<laidout->InterfacePool().n; c++) {
+		if (!strcmp(laidout->InterfacePool().e[c]->whattype(),"PageMarkerInterface"))
+			i=laidout->InterfacePool().e[c]->id;
+		AddTool(laidout->InterfacePool().e[c]->duplicate(NULL),0,1);
 	}
 	SelectTool(0);
 	if (i>=0) SelectTool(i);
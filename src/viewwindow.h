@@ -83,6 +83,16 @@ class LaidoutViewport : public LaxInterfaces::ViewportWindow,
 	double ectm[6];
 	Group *limbo;
 
+	 //for recording undo of whatever gets done to curobj
+	LaxInterfaces::SomeData *undo_obj;
+	UndoHistory *undo_history;  //where edits to undo_obj go
+	unsigned long undo_marker;  //undo_history->Marker() when undo_before was made
+	char *undo_before;
+	long undo_beforelen;
+	int undo_inedit; //nonzero while handling input that might edit curobj
+	virtual void CommitObjectUndo();
+	virtual void SnapshotObjectUndo();
+
 	virtual void setupthings(int tospread=-1,int topage=-1);
 	virtual void UpdateMarkers();
 	virtual void setCurobj(VObjContext *voc);
@@ -121,6 +131,7 @@ class LaidoutViewport : public LaxInterfaces::ViewportWindow,
 	virtual int Event(const Laxkit::EventData *data,const char *mes);
 	virtual int FocusOn(const Laxkit::FocusChangeData *e);
 	virtual int UseTheseRulers(Laxkit::RulerWindow *x,Laxkit::RulerWindow *y);
+	virtual UndoHistory *GetUndoHistory();
 	virtual double *transformToContext(double *m,LaxInterfaces::ObjectContext *oc,int invert,int full);
 	virtual void DrawSomeData(Laxkit::Displayer *ddp,LaxInterfaces::SomeData *ndata,
 			                        Laxkit::anObject *a1=NULL,Laxkit::anObject *a2=NULL,int info=0);
@@ -0,0 +1,225 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+
+
+#include <unistd.h>
+
+#include "workerpool.h"
+
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+namespace Laidout {
+
+
+//------------------------------------- WorkerJob ------------------------------------
+/*! \class WorkerJob
+ * \brief Base class for a piece of work to be done by a WorkerPool.
+ *
+ * Run() is called from a worker thread, so it must not touch the display, Imlib, or any
+ * other state that is not safe to share between threads. Jobs are not owned by the pool.
+ * Calling code must keep them around until they are done or canceled.
+ */
+
+WorkerJob::WorkerJob()
+{
+	state=0;
+	next_job=NULL;
+	pool=NULL;
+}
+
+WorkerJob::~WorkerJob()
+{
+}
+
+//! Return whether Run() has finished. Safe to call while a worker thread is running the job.
+bool WorkerJob::IsDone()
+{
+	if (!pool) return state==3;
+
+	pthread_mutex_lock(&pool->mutex);
+	bool done=(state==3);
+	pthread_mutex_unlock(&pool->mutex);
+	return done;
+}
+
+
+//------------------------------------- WorkerPool ------------------------------------
+/*! \class WorkerPool
+ * \brief A fixed number of threads working through a first in, first out queue of WorkerJob objects.
+ */
+
+
+//! Return the number of online processors, or 1 if that cannot be found.
+int WorkerPool::NumCpus()
+{
+	long n=sysconf(_SC_NPROCESSORS_ONLN);
+	return n>0 ? (int)n : 1;
+}
+
+/*! If nthreads<=0, then use NumCpus() threads.
+ */
+WorkerPool::WorkerPool(int nthreads)
+{
+	if (nthreads<=0) nthreads=NumCpus();
+
+	quit=false;
+	first=last=NULL;
+	num_pending=0;
+	pthread_mutex_init(&mutex,NULL);
+	pthread_cond_init(&has_work,NULL);
+	pthread_cond_init(&job_done,NULL);
+
+	threads=new pthread_t[nthreads];
+	numthreads=0;
+	for (int c=0; c<nthreads; c++) {
+		if (pthread_create(&threads[numthreads],NULL,ThreadMain,this)==0) numthreads++;
+		else { DBG cerr <<"WorkerPool could not create thread "<<c<<endl; }
+	}
+}
+
+/*! Jobs that have not started yet are dropped. Waits for running jobs to finish.
+ */
+WorkerPool::~WorkerPool()
+{
+	pthread_mutex_lock(&mutex);
+	quit=true;
+	while (first) {
+		WorkerJob *job=first;
+		first=first->next_job;
+		job->next_job=NULL;
+		job->state=0;
+	}
+	last=NULL;
+	pthread_cond_broadcast(&has_work);
+	pthread_mutex_unlock(&mutex);
+
+	for (int c=0; c<numthreads; c++) pthread_join(threads[c],NULL);
+	delete[] threads;
+
+	pthread_cond_destroy(&job_done);
+	pthread_cond_destroy(&has_work);
+	pthread_mutex_destroy(&mutex);
+}
+
+void *WorkerPool::ThreadMain(void *data)
+{
+	WorkerPool *pool=(WorkerPool*)data;
+	WorkerJob *job;
+
+	pthread_mutex_lock(&pool->mutex);
+	while (1) {
+		while (!pool->first && !pool->quit) pthread_cond_wait(&pool->has_work,&pool->mutex);
+		if (pool->quit) break;
+
+		job=pool->first;
+		pool->first=job->next_job;
+		if (!pool->first) pool->last=NULL;
+		job->next_job=NULL;
+		job->state=2;
+		pthread_mutex_unlock(&pool->mutex);
+
+		job->Run();
+
+		pthread_mutex_lock(&pool->mutex);
+		job->state=3;
+		pool->num_pending--;
+		pthread_cond_broadcast(&pool->job_done);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+//! Queue job. If there are no threads, the job is run immediately.
+/*! Returns 0 for queued, 1 for run right now, or -1 for job already queued or running.
+ */
+int WorkerPool::Add(WorkerJob *job)
+{
+	if (!job) return -1;
+
+	pthread_mutex_lock(&mutex);
+	if (job->state==1 || job->state==2) {
+		pthread_mutex_unlock(&mutex);
+		return -1;
+	}
+	job->pool=this;
+
+	if (numthreads==0) {
+		job->state=2;
+		pthread_mutex_unlock(&mutex);
+		job->Run();
+		pthread_mutex_lock(&mutex);
+		job->state=3;
+		pthread_mutex_unlock(&mutex);
+		return 1;
+	}
+
+	job->state=1;
+	job->next_job=NULL;
+	if (last) last->next_job=job; else first=job;
+	last=job;
+	num_pending++;
+	pthread_cond_signal(&has_work);
+	pthread_mutex_unlock(&mutex);
+	return 0;
+}
+
+//! Remove job from the queue if it has not started yet.
+/*! Returns 0 for removed, or 1 for job was not in the queue (it may be running or done).
+ */
+int WorkerPool::Cancel(WorkerJob *job)
+{
+	int status=1;
+	pthread_mutex_lock(&mutex);
+	if (job->state==1) {
+		WorkerJob *prev=NULL, *j=first;
+		while (j && j!=job) { prev=j; j=j->next_job; }
+		if (j) {
+			if (prev) prev->next_job=j->next_job; else first=j->next_job;
+			if (last==j) last=prev;
+			j->next_job=NULL;
+			j->state=0;
+			num_pending--;
+			status=0;
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+	return status;
+}
+
+//! Block until job is done. Returns right away if job was never queued.
+void WorkerPool::Wait(WorkerJob *job)
+{
+	pthread_mutex_lock(&mutex);
+	while (job->state==1 || job->state==2) pthread_cond_wait(&job_done,&mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+//! Block until the queue is empty and no jobs are running.
+void WorkerPool::WaitAll()
+{
+	pthread_mutex_lock(&mutex);
+	while (num_pending>0) pthread_cond_wait(&job_done,&mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+
+} // namespace Laidout
+
@@ -0,0 +1,78 @@
+//
+// $Id$
+//
+// Laidout, for laying out
+// Please consult http://www.laidout.org about where to send any
+// correspondence about this software.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+// For more details, consult the COPYING file in the top directory.
+//
+// Copyright (C) 2026 by Tom Lechner
+//
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <pthread.h>
+
+
+namespace Laidout {
+
+
+class WorkerPool;
+
+//------------------------------------- WorkerJob ------------------------------------
+class WorkerJob
+{
+	friend class WorkerPool;
+  protected:
+	int state; //0 not queued, 1 queued, 2 running, 3 done. Guarded by pool->mutex
+	WorkerJob *next_job;
+	WorkerPool *pool; //what the job was last added to
+
+  public:
+	WorkerJob();
+	virtual ~WorkerJob();
+	virtual void Run() = 0;
+	virtual bool IsDone();
+};
+
+
+//------------------------------------- WorkerPool ------------------------------------
+class WorkerPool
+{
+	friend class WorkerJob;
+  protected:
+	pthread_t *threads;
+	int numthreads;
+	bool quit;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t has_work;
+	pthread_cond_t job_done;
+	WorkerJob *first, *last;
+	int num_pending;
+
+	static void *ThreadMain(void *data);
+
+  public:
+	static int NumCpus();
+
+	WorkerPool(int nthreads=0);
+	virtual ~WorkerPool();
+	virtual int NumThreads() { return numthreads; }
+
+	virtual int Add(WorkerJob *job);
+	virtual int Cancel(WorkerJob *job);
+	virtual void Wait(WorkerJob *job);
+	virtual void WaitAll();
+};
+
+
+} // namespace Laidout
+
+#endif
+